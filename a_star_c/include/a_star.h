@@ -4,6 +4,7 @@ typedef struct intlist intlist_t;
 
 struct intlist {
    int num;
+   int edge_num;   // fills the padding before next, see add_edge
    intlist_t *next;
 };
 
@@ -11,6 +12,10 @@ struct intlist {
 
 typedef struct node node_t;
 typedef struct graph graph_t;
+typedef struct search_ctx search_ctx_t;
+typedef struct search_pool search_pool_t;
+typedef struct search_mask search_mask_t;
+typedef struct name_pool name_pool_t;
 
 struct node {
     int node_num;
@@ -33,8 +38,49 @@ struct node {
 struct graph {
     int num_nodes;
     node_t **nodes;
+
+    // edges are numbered in the order they are added
+    int num_edges;
+
+    // bumped by every change to the nodes or edges, see route_cache
+    unsigned long version;
+
+    // search contexts kept for reuse, see search_ctx_acquire
+    search_pool_t *pool;
+
+    // copies of the city names, indexed by name, see graph_find_node
+    name_pool_t *names;
+};
+
+/* Edges dropped by graph_clean and csr_builder_finish */
+typedef struct graph_clean graph_clean_t;
+
+struct graph_clean {
+    long duplicates;    // another edge joins the same nodes the same way
+    long self_loops;    // the edge leads from a node to itself
 };
 
+/********* SEARCH STATISTICS *********/
+
+typedef struct a_star_stats a_star_stats_t;
+
+struct a_star_stats {
+    long nodes_expanded;
+    long pushes;
+    long decrease_keys;
+    long stale_pops;
+    long max_open_size;
+    long heuristic_evals;
+    double wall_time;   // seconds
+};
+
+/* a_star_expand_fn: called by a_star_traced for every expanded node
+ *
+ * node: the node being expanded
+ * data: the data pointer passed to a_star_traced
+ */
+typedef void (*a_star_expand_fn)(node_t *node, void *data);
+
 /********* GRAPH *********/
 
 /* graph_create: create a graph
@@ -47,12 +93,12 @@ graph_t *graph_create(int num_nodes);
  *
  * graph: the graph
  * node_num: node number
- * city_name: the city
+ * city_name: the city, copied into the graph, may be NULL
  * latitude: city latitude
  * longitude: city longitude
  * 
  */ 
-void node_create(graph_t *graph, int node_num, char *city_name, 
+void node_create(graph_t *graph, int node_num, const char *city_name, 
                  double latitude, double longitude);
 
 /* add_edge: add an edge between two nodes
@@ -61,17 +107,91 @@ void node_create(graph_t *graph, int node_num, char *city_name,
  * node_num1: the first node
  * node_num2: the second node
  * 
+ * The edge gets the next edge number, stored in the edge_num field of
+ * both neighbor list entries.
  */ 
 void add_edge(graph_t* graph, int node_num1, int node_num2);
 
+/* add_arc: add a one-way edge between two nodes
+ *
+ * graph: the graph
+ * from_node_num: the node the edge leaves
+ * to_node_num: the node the edge enters
+ * 
+ * The edge gets the next edge number, like add_edge, but only appears in
+ * the neighbor list of from_node_num, so searches can only follow it in
+ * that direction.
+ */ 
+void add_arc(graph_t* graph, int from_node_num, int to_node_num);
+
+/* graph_clean: remove self-loops and duplicate edges, which searches would
+ *     otherwise scan again on every expansion
+ *
+ * graph: the graph
+ * report: set to the number of edges removed for each reason, may be NULL
+ * 
+ * Between two nodes, a two-way edge is kept in place of any other edge or
+ * arc, and otherwise one arc in each direction, the one added first. Costs
+ * come from the coordinates, so the edges kept are as short as the ones
+ * removed. Edge numbers of the edges kept do not change, and num_edges
+ * still counts the numbers of the removed edges.
+ */ 
+void graph_clean(graph_t *graph, graph_clean_t *report);
+
 /* graph_free: free a graph and its nodes
  *
  * graph: the graph
  */ 
 void graph_free(graph_t* graph);
 
+/* graph_find_node: look up a node by its city name
+ *
+ * graph: the graph
+ * city_name: the city
+ * 
+ * Returns: the number of the first node created with that name, -1 if
+ *     there is none
+ */ 
+int graph_find_node(graph_t *graph, const char *city_name);
+
+/********* MEMORY REPORT *********/
+
+typedef struct graph_memory graph_memory_t;
+
+/* Bytes held by a graph, by component. Each component counts the bytes
+ * asked of malloc, and overhead the headers and rounding malloc adds to
+ * all of them, estimated with malloc_bytes. The same struct describes the
+ * compact graphs of compact.h.
+ */
+struct graph_memory {
+    size_t table;       // the graph struct and its array of node pointers
+    size_t nodes;       // node structs, or the coordinates of a compact graph
+    size_t neighbors;   // neighbor list entries, or rows and their offsets
+    size_t names;       // the city names and the index on them
+    size_t search;      // search contexts kept for reuse
+    size_t overhead;
+    size_t total;       // all of the above
+};
+
+/* graph_memory_report: break down the memory held by a graph
+ *
+ * graph: the graph
+ * report: filled with the bytes of each component
+ */ 
+void graph_memory_report(graph_t *graph, graph_memory_t *report);
+
 /********* A* SEARCH *********/
 
+/* h_calc: straight-line distance between two nodes, used both as the
+ *     cost of the edge between neighbors and as the A* heuristic
+ *
+ * root: the first node
+ * end: the second node
+ * 
+ * Returns: the distance between the nodes
+ */ 
+double h_calc(node_t *root, node_t *end);
+
 /* a_star: performs A* search
  *
  * graph: the graph
@@ -80,4 +200,251 @@ void graph_free(graph_t* graph);
  * 
  * Returns: the distance of the path between the start node and end node
  */ 
-double a_star(graph_t *graph, int start_node_num, int end_node_num);
\ No newline at end of file
+double a_star(graph_t *graph, int start_node_num, int end_node_num);
+
+/* a_star_traced: performs A* search and reports search statistics
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * stats: filled in with search statistics, may be NULL
+ * expand: called once for every expanded node, may be NULL
+ * data: passed through to expand
+ *
+ * Statistics and the expand callback are only active when the library
+ * is built with -DA_STAR_STATS. Otherwise stats is zeroed and the search
+ * runs exactly like a_star().
+ * 
+ * Returns: the distance of the path between the start node and end node
+ */ 
+double a_star_traced(graph_t *graph, int start_node_num, int end_node_num,
+                     a_star_stats_t *stats, a_star_expand_fn expand, void *data);
+
+/********* SEARCH CONTEXTS *********/
+
+/* A search context holds the per-node state of one search (costs,
+ * parents, open and closed sets) outside of node_t, so searches using
+ * contexts can run concurrently on the same graph. Released contexts are
+ * kept by the graph and reset by clearing only the nodes the search
+ * touched, so a small search on a large graph stays cheap.
+ */
+
+/* search_ctx_acquire: take a search context from the graph's pool,
+ *     creating one if the pool is empty. Thread-safe.
+ *
+ * graph: the graph
+ * 
+ * Returns: a reset search context
+ */ 
+search_ctx_t *search_ctx_acquire(graph_t *graph);
+
+/* search_ctx_release: return a search context to the graph's pool. 
+ *     Thread-safe.
+ *
+ * graph: the graph the context was acquired from
+ * ctx: the search context
+ */ 
+void search_ctx_release(graph_t *graph, search_ctx_t *ctx);
+
+/* A context runs one search between being acquired and released. */
+
+/* search_ctx_exclude: keep a node out of the next search on a context
+ *
+ * ctx: the search context
+ * node_num: the node to exclude
+ */ 
+void search_ctx_exclude(search_ctx_t *ctx, int node_num);
+
+/* search_ctx_a_star: performs A* search on a search context
+ *
+ * graph: the graph
+ * ctx: the search context, acquired from graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * skip: neighbors of the start node the path must not continue to,
+ *     may be NULL
+ * num_skip: number of entries in skip
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */ 
+double search_ctx_a_star(graph_t *graph, search_ctx_t *ctx, int start_node_num,
+                         int end_node_num, const int *skip, int num_skip);
+
+/* search_ctx_path: the path to a node found by the last search on ctx
+ *
+ * ctx: the search context
+ * end_node_num: the node the path leads to, it must have been reached
+ * path: set to a new array with the node numbers from the start to
+ *     end_node_num, to be freed by the caller
+ * 
+ * Returns: the number of nodes on the path
+ */ 
+int search_ctx_path(search_ctx_t *ctx, int end_node_num, int **path);
+
+/********* RESUMABLE SEARCH *********/
+
+/* A search split into slices of a bounded number of node expansions, so
+ * a long query can be interleaved with other work on the same thread.
+ * The search state lives in a search context between the slices.
+ */
+
+enum search_status {
+    SEARCH_IN_PROGRESS,
+    SEARCH_FOUND,
+    SEARCH_UNREACHABLE
+};
+
+typedef enum search_status search_status_t;
+
+/* search_begin: start an A* search that runs in slices, see search_step
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * 
+ * Returns: a search context from the graph's pool holding the search,
+ *     to be released with search_end
+ */ 
+search_ctx_t *search_begin(graph_t *graph, int start_node_num, int end_node_num);
+
+/* search_step: continue a search started by search_begin
+ *
+ * ctx: the search context
+ * max_expansions: the most nodes to expand before returning, at least 1
+ * 
+ * Returns: SEARCH_IN_PROGRESS if the search needs more steps, otherwise
+ *     whether it found the end node. Once the search is over, further
+ *     steps return the same.
+ */ 
+search_status_t search_step(search_ctx_t *ctx, long max_expansions);
+
+/* search_result: the outcome of a search run by search_step
+ *
+ * ctx: the search context
+ * path: set to a new array with the node numbers from the start to the
+ *     end, to be freed by the caller, NULL if there is no path. May be
+ *     NULL when the path is not needed.
+ * path_len: set to the number of nodes on the path, 0 if there is no
+ *     path, may be NULL
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path or the search is still in progress
+ */ 
+double search_result(search_ctx_t *ctx, int **path, int *path_len);
+
+/* search_end: release the context of a search started by search_begin,
+ *     finished or not
+ *
+ * ctx: the search context
+ */ 
+void search_end(search_ctx_t *ctx);
+
+/********* REACHABILITY *********/
+
+/* reachable_within: finds every node whose shortest path from the
+ *     start node costs at most budget
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * budget: the largest path cost to include
+ * out: filled with the node numbers found, in order of increasing cost,
+ *     starting with start_node_num
+ * n: on input the number of entries out can hold, on return the number
+ *     of nodes found. Only the first (input) *n nodes are written.
+ */ 
+void reachable_within(graph_t *graph, int start_node_num, double budget,
+                      int *out, size_t *n);
+
+/********* NEAREST TARGET *********/
+
+/* a_star_nearest: performs one A* search towards a set of targets,
+ *     stopping at the first target it settles
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * targets: the target node numbers
+ * n: number of targets
+ * which: set to the nearest target, -1 if none is reachable, may be NULL
+ * 
+ * Returns: the distance of the path to the nearest target, -1 if no
+ *     target is reachable
+ */ 
+double a_star_nearest(graph_t *graph, int start_node_num, const int *targets,
+                      int n, int *which);
+
+/********* SEARCH MASKS *********/
+
+/* A search mask excludes nodes and edges from a search without changing
+ * the graph, so each query can carry its own restrictions.
+ */
+
+/* mask_create: create an empty search mask for a graph
+ *
+ * graph: the graph
+ * 
+ * Returns: a mask that excludes nothing
+ */ 
+search_mask_t *mask_create(graph_t *graph);
+
+/* mask_exclude_node: exclude a node from searches using the mask
+ *
+ * mask: the search mask
+ * node_num: the node
+ */ 
+void mask_exclude_node(search_mask_t *mask, int node_num);
+
+/* mask_exclude_edge: exclude every edge between two nodes from searches
+ *     using the mask
+ *
+ * mask: the search mask
+ * graph: the graph the mask was created for
+ * node_num1: the first node
+ * node_num2: the second node
+ */ 
+void mask_exclude_edge(search_mask_t *mask, graph_t *graph, int node_num1, 
+                       int node_num2);
+
+/* mask_clear: stop excluding anything
+ *
+ * mask: the search mask
+ */ 
+void mask_clear(search_mask_t *mask);
+
+/* mask_free: free a search mask
+ *
+ * mask: the search mask
+ */ 
+void mask_free(search_mask_t *mask);
+
+/* mask_hash: hash of what a mask excludes, to tell masks apart without
+ *     comparing them
+ *
+ * mask: the search mask, NULL for none
+ * 
+ * Returns: the hash, 0 for NULL and for masks that exclude nothing
+ */ 
+unsigned long mask_hash(const search_mask_t *mask);
+
+/* search_ctx_set_mask: apply a mask to the next search on a context
+ *
+ * ctx: the search context
+ * mask: the search mask, NULL for none. It must outlive the search.
+ *     If it excludes the start or end node, there is no path.
+ */ 
+void search_ctx_set_mask(search_ctx_t *ctx, const search_mask_t *mask);
+
+/* a_star_masked: performs A* search, avoiding the nodes and edges 
+ *     excluded by a mask
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * mask: the search mask, NULL for none
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path. Like a_star(), the parent fields of the
+ *     nodes on the path are set.
+ */ 
+double a_star_masked(graph_t *graph, int start_node_num, int end_node_num,
+                     const search_mask_t *mask);
@@ -0,0 +1,495 @@
+/********* A* ENGINE TEMPLATE *********/
+
+/* Header-only C++ A* search, specialized at compile time on
+ *
+ * - Graph: the graph storage, ListGraph over the neighbor lists of a
+ *   graph_t or CsrGraph, a flat snapshot with stored edge costs
+ * - Heuristic: Euclidean, the straight-line distance like h_calc, or
+ *   ZeroHeuristic, which makes the search Dijkstra's
+ * - OpenList: BinaryHeap, or RadixHeap for integer costs
+ * - CostT: double, float or an integer type
+ *
+ * Every call in the search loop is a template parameter, so the compiler
+ * inlines the heuristic, the edge iteration and the open list operations
+ * into one loop per configuration, without function pointers.
+ *
+ * Costs are straight-line distances converted to CostT. Edge costs are
+ * rounded up and heuristic values down, so the heuristic stays consistent
+ * and the search finds shortest paths in the converted costs. Integer
+ * costs count units of 1 / scale, so a path can cost at most one unit
+ * per edge more than its exact length.
+ *
+ * The C entry points in a_star_engine.h use these templates, a_star()
+ * keeps its own C implementation.
+ *
+ * Requires a_star.h to be included first, inside extern "C".
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace astar {
+
+/********* COSTS *********/
+
+/* CostTraits: conversions between straight-line distances and CostT
+ *
+ * infinity: the cost of an unreachable node
+ * edge: a distance rounded up, for edge costs
+ * bound: a distance rounded down, for heuristic values
+ * to_double: a cost back in distance units
+ */
+template <typename CostT, bool integral = std::is_integral<CostT>::value>
+struct CostTraits {
+    static CostT infinity()
+    {
+        return std::numeric_limits<CostT>::infinity();
+    }
+
+    static CostT edge(double dist, double scale)
+    {
+        CostT c = (CostT)(dist * scale);
+        return (double)c < dist * scale ? std::nextafter(c, infinity()) : c;
+    }
+
+    static CostT bound(double dist, double scale)
+    {
+        CostT c = (CostT)(dist * scale);
+        return (double)c > dist * scale ? std::nextafter(c, (CostT)0) : c;
+    }
+
+    static double to_double(CostT cost, double scale)
+    {
+        return cost / scale;
+    }
+};
+
+template <typename CostT>
+struct CostTraits<CostT, true> {
+    static CostT infinity()
+    {
+        return std::numeric_limits<CostT>::max();
+    }
+
+    static CostT edge(double dist, double scale)
+    {
+        return (CostT)std::ceil(dist * scale);
+    }
+
+    static CostT bound(double dist, double scale)
+    {
+        return (CostT)std::floor(dist * scale);
+    }
+
+    static double to_double(CostT cost, double scale)
+    {
+        return cost / scale;
+    }
+};
+
+/* straight_line: the distance h_calc computes, from coordinates
+ *
+ * x1, y1: longitude and latitude of the first node
+ * x2, y2: longitude and latitude of the second node
+ *
+ * Returns: the distance
+ */
+inline double straight_line(double x1, double y1, double x2, double y2)
+{
+    return std::sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
+}
+
+/********* GRAPHS *********/
+
+/* A Graph provides
+ *
+ *     typedef ... cost_type;
+ *     int num_nodes() const;
+ *     bool exists(int v) const;
+ *     double x(int v) const, y(int v) const;   // longitude, latitude
+ *     double scale() const;                    // cost units per distance
+ *     void for_each_edge(int u, F f) const;    // f(v, cost) per edge u -> v
+ */
+
+/* ListGraph: the neighbor lists of a graph_t, with edge costs computed
+ *     from the coordinates during the search, like the C search
+ */
+template <typename CostT>
+class ListGraph {
+public:
+    typedef CostT cost_type;
+
+    explicit ListGraph(graph_t *graph, double scale = 1)
+        : graph_(graph), scale_(scale)
+    {
+    }
+
+    graph_t *graph() const { return graph_; }
+    int num_nodes() const { return graph_->num_nodes; }
+    bool exists(int v) const { return graph_->nodes[v] != nullptr; }
+    double x(int v) const { return graph_->nodes[v]->longitude; }
+    double y(int v) const { return graph_->nodes[v]->latitude; }
+    double scale() const { return scale_; }
+
+    template <typename F>
+    void for_each_edge(int u, F f) const
+    {
+        const node_t *a = graph_->nodes[u];
+        for(const intlist_t *nb = a->neighbors; nb; nb = nb->next){
+            const node_t *b = graph_->nodes[nb->num];
+            double d = straight_line(a->longitude, a->latitude,
+                                     b->longitude, b->latitude);
+            f(nb->num, CostTraits<CostT>::edge(d, scale_));
+        }
+    }
+
+private:
+    graph_t *graph_;
+    double scale_;
+};
+
+/* CsrGraph: a snapshot of a graph_t in flat arrays, with each edge cost
+ *     converted to CostT once when the snapshot is built
+ */
+template <typename CostT>
+class CsrGraph {
+public:
+    typedef CostT cost_type;
+
+    explicit CsrGraph(graph_t *graph, double scale = 1)
+        : scale_(scale)
+    {
+        int n = graph->num_nodes;
+        offsets_.assign(n + 1, 0);
+        xs_.assign(n, 0);
+        ys_.assign(n, 0);
+        exists_.assign(n, 0);
+        for(int u = 0; u < n; u++){
+            const node_t *a = graph->nodes[u];
+            offsets_[u + 1] = offsets_[u];
+            if(a == nullptr){
+                continue;
+            }
+            exists_[u] = 1;
+            xs_[u] = a->longitude;
+            ys_[u] = a->latitude;
+            for(const intlist_t *nb = a->neighbors; nb; nb = nb->next){
+                const node_t *b = graph->nodes[nb->num];
+                double d = straight_line(a->longitude, a->latitude,
+                                         b->longitude, b->latitude);
+                targets_.push_back(nb->num);
+                costs_.push_back(CostTraits<CostT>::edge(d, scale_));
+                offsets_[u + 1]++;
+            }
+        }
+    }
+
+    int num_nodes() const { return (int)exists_.size(); }
+    bool exists(int v) const { return exists_[v] != 0; }
+    double x(int v) const { return xs_[v]; }
+    double y(int v) const { return ys_[v]; }
+    double scale() const { return scale_; }
+
+    /* bytes: memory used by the adjacency, offsets included */
+    size_t bytes() const
+    {
+        return offsets_.size() * sizeof(long) +
+               targets_.size() * (sizeof(int) + sizeof(CostT));
+    }
+
+    template <typename F>
+    void for_each_edge(int u, F f) const
+    {
+        for(long i = offsets_[u]; i < offsets_[u + 1]; i++){
+            f(targets_[i], costs_[i]);
+        }
+    }
+
+private:
+    std::vector<long> offsets_;
+    std::vector<int> targets_;
+    std::vector<CostT> costs_;
+    std::vector<double> xs_;
+    std::vector<double> ys_;
+    std::vector<unsigned char> exists_;
+    double scale_;
+};
+
+/********* HEURISTICS *********/
+
+/* A Heuristic is called as h(graph, v, goal) and returns a lower bound
+ * on the cost from v to goal in the graph's cost type.
+ */
+
+/* Euclidean: the straight-line distance, rounded down */
+struct Euclidean {
+    template <typename Graph>
+    typename Graph::cost_type operator()(const Graph &g, int v, int goal) const
+    {
+        double d = straight_line(g.x(v), g.y(v), g.x(goal), g.y(goal));
+        return CostTraits<typename Graph::cost_type>::bound(d, g.scale());
+    }
+};
+
+/* ZeroHeuristic: no estimate, the search runs as Dijkstra's */
+struct ZeroHeuristic {
+    template <typename Graph>
+    typename Graph::cost_type operator()(const Graph &, int, int) const
+    {
+        return 0;
+    }
+};
+
+/********* OPEN LISTS *********/
+
+/* An OpenList provides push(node, key), pop() returning the node with
+ * the smallest key, empty() and clear(). Keys of nodes already popped
+ * are never decreased, a node is pushed again instead and the search
+ * skips the stale copies.
+ */
+
+/* BinaryHeap: binary min-heap for any cost type */
+template <typename CostT>
+class BinaryHeap {
+public:
+    void push(int node, CostT key)
+    {
+        size_t i = heap_.size();
+        heap_.push_back(entry_t(key, node));
+        while(i > 0){
+            size_t parent = (i - 1) / 2;
+            if(!(key < heap_[parent].first)){
+                break;
+            }
+            heap_[i] = heap_[parent];
+            i = parent;
+        }
+        heap_[i] = entry_t(key, node);
+    }
+
+    int pop()
+    {
+        int top = heap_[0].second;
+        entry_t last = heap_.back();
+        heap_.pop_back();
+        size_t n = heap_.size();
+        size_t i = 0;
+        while(n > 0){
+            size_t child = 2 * i + 1;
+            if(child >= n){
+                break;
+            }
+            if(child + 1 < n && heap_[child + 1].first < heap_[child].first){
+                child++;
+            }
+            if(!(heap_[child].first < last.first)){
+                break;
+            }
+            heap_[i] = heap_[child];
+            i = child;
+        }
+        if(n > 0){
+            heap_[i] = last;
+        }
+        return top;
+    }
+
+    bool empty() const { return heap_.empty(); }
+    void clear() { heap_.clear(); }
+
+private:
+    typedef std::pair<CostT, int> entry_t;
+    std::vector<entry_t> heap_;
+};
+
+/* RadixHeap: monotone priority queue for integer costs. Keys are kept in
+ *     buckets by the highest bit in which they differ from the last key
+ *     popped, so each entry moves between buckets at most once per bit.
+ *     Keys pushed must not be smaller than the last key popped, which
+ *     holds for A* with a consistent heuristic.
+ */
+template <typename CostT>
+class RadixHeap {
+    static_assert(std::is_integral<CostT>::value,
+                  "RadixHeap needs an integer cost type");
+
+public:
+    RadixHeap() : last_(0), size_(0) {}
+
+    void push(int node, CostT key)
+    {
+        assert(key >= 0 && (key_t)key >= last_);
+        buckets_[bucket_of((key_t)key)].push_back(entry_t((key_t)key, node));
+        size_++;
+    }
+
+    int pop()
+    {
+        if(buckets_[0].empty()){
+            int b = 1;
+            while(buckets_[b].empty()){
+                b++;
+            }
+            // the smallest key of the bucket becomes the last key, and
+            // its entries spread over lower buckets
+            key_t min = buckets_[b][0].first;
+            for(const entry_t &e : buckets_[b]){
+                min = e.first < min ? e.first : min;
+            }
+            last_ = min;
+            for(const entry_t &e : buckets_[b]){
+                buckets_[bucket_of(e.first)].push_back(e);
+            }
+            buckets_[b].clear();
+        }
+        int top = buckets_[0].back().second;
+        buckets_[0].pop_back();
+        size_--;
+        return top;
+    }
+
+    bool empty() const { return size_ == 0; }
+
+    void clear()
+    {
+        for(std::vector<entry_t> &bucket : buckets_){
+            bucket.clear();
+        }
+        last_ = 0;
+        size_ = 0;
+    }
+
+private:
+    typedef typename std::make_unsigned<CostT>::type key_t;
+    typedef std::pair<key_t, int> entry_t;
+    static const int NUM_BUCKETS = std::numeric_limits<key_t>::digits + 1;
+
+    int bucket_of(key_t key) const
+    {
+        unsigned long long diff = key ^ last_;
+        return diff ? 64 - __builtin_clzll(diff) : 0;
+    }
+
+    std::vector<entry_t> buckets_[NUM_BUCKETS];
+    key_t last_;
+    size_t size_;
+};
+
+/********* A* SEARCH *********/
+
+/* AStar: A* search on one graph, reusable for many queries. The per-node
+ *     state is stamped with the query it belongs to, so a new query does
+ *     not clear it. Not thread-safe, use one AStar per thread.
+ */
+template <typename Graph, typename Heuristic = Euclidean,
+          typename OpenList = BinaryHeap<typename Graph::cost_type>,
+          typename CostT = typename Graph::cost_type>
+class AStar {
+    static_assert(std::is_same<CostT, typename Graph::cost_type>::value,
+                  "CostT must be the cost type of the graph");
+
+public:
+    explicit AStar(const Graph &graph, Heuristic heuristic = Heuristic())
+        : graph_(graph), heuristic_(heuristic),
+          g_cost_(graph.num_nodes()), parent_(graph.num_nodes()),
+          seen_(graph.num_nodes(), 0), closed_(graph.num_nodes(), 0),
+          stamp_(0)
+    {
+    }
+
+    const Graph &graph() const { return graph_; }
+
+    /* search: find a shortest path
+     *
+     * start: the staring node number
+     * end: the ending node number
+     *
+     * Returns: the cost of the path, CostTraits<CostT>::infinity() if
+     *     there is none
+     */
+    CostT search(int start, int end)
+    {
+        assert(graph_.exists(start) && graph_.exists(end));
+        next_stamp();
+        open_.clear();
+        open(start, 0, -1, end);
+
+        while(!open_.empty()){
+            int u = open_.pop();
+            if(closed_[u] == stamp_){
+                continue;
+            }
+            closed_[u] = stamp_;
+            if(u == end){
+                return g_cost_[u];
+            }
+
+            CostT g = g_cost_[u];
+            graph_.for_each_edge(u, [&](int v, CostT cost){
+                if(closed_[v] != stamp_){
+                    open(v, g + cost, u, end);
+                }
+            });
+        }
+        return CostTraits<CostT>::infinity();
+    }
+
+    /* path: the path to a node settled by the last search
+     *
+     * end: the node, it must have been reached
+     * out: replaced by the node numbers from the start to end
+     */
+    void path(int end, std::vector<int> &out) const
+    {
+        assert(seen_[end] == stamp_);
+        out.clear();
+        for(int v = end; v >= 0; v = parent_[v]){
+            out.push_back(v);
+        }
+        for(size_t i = 0, j = out.size() - 1; i < j; i++, j--){
+            std::swap(out[i], out[j]);
+        }
+    }
+
+private:
+    /* open: offer a path to a node, pushing it if it is the cheapest so far */
+    void open(int v, CostT g, int parent, int end)
+    {
+        if(seen_[v] == stamp_ && !(g < g_cost_[v])){
+            return;
+        }
+        seen_[v] = stamp_;
+        g_cost_[v] = g;
+        parent_[v] = parent;
+        open_.push(v, g + heuristic_(graph_, v, end));
+    }
+
+    /* next_stamp: start a new query, clearing the stamps when they wrap */
+    void next_stamp()
+    {
+        if(++stamp_ == 0){
+            std::fill(seen_.begin(), seen_.end(), 0);
+            std::fill(closed_.begin(), closed_.end(), 0);
+            stamp_ = 1;
+        }
+    }
+
+    const Graph &graph_;
+    Heuristic heuristic_;
+    OpenList open_;
+
+    // valid only for nodes whose stamp matches stamp_
+    std::vector<CostT> g_cost_;
+    std::vector<int> parent_;
+    std::vector<uint32_t> seen_;
+    std::vector<uint32_t> closed_;
+    uint32_t stamp_;
+};
+
+}
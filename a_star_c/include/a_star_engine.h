@@ -0,0 +1,73 @@
+/********* SPECIALIZED ENGINES *********/
+
+/* C entry points to instantiations of the A* template in a_star.hpp,
+ * for callers that cannot use C++. Building them needs a C++ compiler
+ * and linking the C++ standard library.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct csr_engine csr_engine_t;
+
+enum csr_engine_cost {
+    CSR_ENGINE_DOUBLE,   // binary heap
+    CSR_ENGINE_FLOAT,    // binary heap, half the memory per edge cost
+    CSR_ENGINE_INT       // radix heap, 64-bit costs in units of 1 / scale
+};
+
+typedef enum csr_engine_cost csr_engine_cost_t;
+
+/* a_star_engine: performs A* search with the default instantiation, on
+ *     the neighbor lists of the graph with double costs and a binary heap.
+ *     Thread-safe, each thread keeps its own search state.
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */
+double a_star_engine(graph_t *graph, int start_node_num, int end_node_num);
+
+/* csr_engine_create: build a flat snapshot of a graph with edge costs
+ *     stored in the chosen cost type, and a search for it
+ *
+ * graph: the graph
+ * cost: the cost type
+ * scale: cost units per unit of distance, used by CSR_ENGINE_INT, 1 for
+ *     the others. CSR_ENGINE_INT needs the lengths of all edges plus the
+ *     diagonal of the graph's bounding box, times scale, to stay below
+ *     2^63 units, so no path cost can overflow.
+ *
+ * Returns: the engine, NULL if scale is so large that the cost of a path
+ *     could overflow CSR_ENGINE_INT costs
+ */
+csr_engine_t *csr_engine_create(graph_t *graph, csr_engine_cost_t cost,
+                                double scale);
+
+/* csr_engine_query: performs A* search on an engine. Not thread-safe.
+ *
+ * engine: the engine
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the cost of the path between the start node and end node in
+ *     units of distance, -1 if there is no path
+ */
+double csr_engine_query(csr_engine_t *engine, int start_node_num,
+                        int end_node_num);
+
+/* csr_engine_bytes: memory used by the adjacency of an engine
+ *
+ * engine: the engine
+ *
+ * Returns: the number of bytes, offsets and edge costs included
+ */
+size_t csr_engine_bytes(csr_engine_t *engine);
+
+/* csr_engine_free: free an engine
+ *
+ * engine: the engine
+ */
+void csr_engine_free(csr_engine_t *engine);
@@ -0,0 +1,56 @@
+/********* ALL-PAIRS SHORTEST PATHS *********/
+
+/* Distance matrix for small graphs, up to a few thousand nodes, filled
+ * by Floyd-Warshall. The matrix is split into square tiles that fit in
+ * the cache. Each round updates the diagonal tile, then the tiles in its
+ * row and column, then all the others, with the tiles of a phase
+ * processed in parallel. The inner loop runs over contiguous rows
+ * without branches so the compiler can vectorize it.
+ *
+ * Only distances are stored, which keeps the inner loop a plain minimum.
+ * Paths are read back by stepping to the neighbor that leaves the least
+ * distance to go, without a search.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct apsp apsp_t;
+
+/* apsp_create: compute the distance between every pair of nodes
+ *
+ * graph: the graph, which must outlive the matrix and not change
+ * num_threads: number of worker threads, 0 for one per core
+ *
+ * Returns: the distance matrix, which takes 8 bytes for every pair of
+ *     nodes
+ */
+apsp_t *apsp_create(graph_t *graph, int num_threads);
+
+/* apsp_query: look up the distance between two nodes
+ *
+ * apsp: the distance matrix
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the distance of the path between the start node and end node,
+ *     like a_star, -1 if there is no path
+ */
+double apsp_query(apsp_t *apsp, int start_node_num, int end_node_num);
+
+/* apsp_path: read back a shortest path between two nodes
+ *
+ * apsp: the distance matrix
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * path: set to a new array with the node numbers from the start to the
+ *     end, to be freed by the caller, NULL if there is no path
+ *
+ * Returns: the number of nodes on the path, 0 if there is no path
+ */
+int apsp_path(apsp_t *apsp, int start_node_num, int end_node_num, int **path);
+
+/* apsp_free: free a distance matrix
+ *
+ * apsp: the distance matrix
+ */
+void apsp_free(apsp_t *apsp);
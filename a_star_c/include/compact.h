@@ -0,0 +1,74 @@
+/********* COMPACT GRAPH *********/
+
+/* A read-only snapshot of a graph_t that keeps everything a search or a
+ * caller needs in as few bytes per node as it can: a node of a graph_t
+ * takes about 88 bytes with malloc headers and its pointer in the table,
+ * plus 32 per neighbor list entry, a compact node about 16 bytes plus 4
+ * per neighbor. graph_memory_report and compact_memory_report show where
+ * the bytes go.
+ *
+ * Coordinates are 32-bit fixed-point offsets from the corner of the box
+ * around the graph, with the same step on both axes, so they are rounded
+ * to 1 / 2^32 of the longer side of the box. Costs and the heuristic are
+ * both computed from the rounded coordinates, so searches stay exact on
+ * the rounded graph. Neighbors are stored in rows like a CSR graph, names
+ * once each in one string pool, and the search state lives in arrays made
+ * for each search instead of in the nodes.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct compact compact_t;
+
+/* compact_create: build a compact snapshot of a graph
+ *
+ * graph: the graph, with fewer than 2^32 neighbor list entries
+ *
+ * Returns: the compact graph
+ */
+compact_t *compact_create(graph_t *graph);
+
+/* compact_node_name: the city name of a node
+ *
+ * cg: the compact graph
+ * node_num: the node
+ *
+ * Returns: the name, NULL if the node has none. Nodes with the same name
+ *     share the string, which lives as long as the compact graph.
+ */
+const char *compact_node_name(compact_t *cg, int node_num);
+
+/* compact_coordinates: the rounded coordinates of a node
+ *
+ * cg: the compact graph
+ * node_num: the node
+ * latitude: set to the latitude
+ * longitude: set to the longitude
+ */
+void compact_coordinates(compact_t *cg, int node_num, double *latitude,
+                         double *longitude);
+
+/* compact_memory_report: break down the memory held by a compact graph,
+ *     like graph_memory_report
+ *
+ * cg: the compact graph
+ * report: filled with the bytes of each component
+ */
+void compact_memory_report(compact_t *cg, graph_memory_t *report);
+
+/* compact_free: free a compact graph
+ *
+ * cg: the compact graph
+ */
+void compact_free(compact_t *cg);
+
+/* a_star_compact: performs A* search on a compact graph
+ *
+ * cg: the compact graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the distance of the path between the start node and end node
+ *     on the rounded coordinates, -1 if there is no path
+ */
+double a_star_compact(compact_t *cg, int start_node_num, int end_node_num);
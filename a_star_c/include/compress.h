@@ -0,0 +1,65 @@
+/********* COMPRESSED GRAPH *********/
+
+/* A read-only snapshot of a graph_t with compact adjacency. The neighbors
+ * of each node are sorted and stored as varint-encoded gaps: the first
+ * as a zigzag-encoded offset from the node's own number, the rest as the
+ * difference from the previous neighbor. When neighbors have nearby node
+ * numbers, as in graphs numbered in spatial order, most edges take one
+ * byte. Coordinates are kept in
+ * flat arrays next to the adjacency.
+ *
+ * Edge costs can optionally be stored, rounded up to a multiple of a
+ * quantum, which saves the square root per edge during the search. Since
+ * they are rounded up, the straight-line heuristic stays consistent and
+ * the result overestimates the true cost by at most quantum per edge.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct cgraph cgraph_t;
+
+/* cgraph_create: build a compressed snapshot of a graph
+ *
+ * graph: the graph
+ * quantum: store edge costs rounded up to multiples of quantum, 0 to
+ *     compute them from the coordinates instead. Each edge is stored as
+ *     a 32-bit count of quanta, so quantum must be at least the longest
+ *     edge divided by 2^32 - 1, the program exits otherwise.
+ * 
+ * Returns: the compressed graph
+ */ 
+cgraph_t *cgraph_create(graph_t *graph, double quantum);
+
+/* cgraph_num_edges: number of directed edges in a compressed graph
+ *
+ * cg: the compressed graph
+ * 
+ * Returns: the number of neighbor entries, each undirected edge counts
+ *     twice
+ */ 
+long cgraph_num_edges(cgraph_t *cg);
+
+/* cgraph_adjacency_bytes: memory used for the adjacency, offsets included
+ *
+ * cg: the compressed graph
+ * 
+ * Returns: the number of bytes
+ */ 
+size_t cgraph_adjacency_bytes(cgraph_t *cg);
+
+/* cgraph_free: free a compressed graph
+ *
+ * cg: the compressed graph
+ */ 
+void cgraph_free(cgraph_t *cg);
+
+/* a_star_compressed: performs A* search on a compressed graph
+ *
+ * cg: the compressed graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */ 
+double a_star_compressed(cgraph_t *cg, int start_node_num, int end_node_num);
@@ -0,0 +1,68 @@
+/********* MULTILEVEL OVERLAY *********/
+
+/* Customizable route planning. Nodes are split into cells by recursive
+ * bisection on their coordinates, and cells are grouped four at a time
+ * into the cells of the next level. A node is a boundary node of a cell
+ * if an edge crosses the cell border there. For every cell, the overlay
+ * keeps a clique: the distance between each pair of its boundary nodes
+ * without leaving the cell.
+ *
+ * The partition only depends on the graph, while the cliques depend on
+ * the edge costs. Customization recomputes the cliques for new costs,
+ * level by level, with the clique rows of a level computed in parallel.
+ * Each level is built from the cliques of the level below, so nothing
+ * but the cliques is redone when costs change.
+ *
+ * A query runs Dijkstra on the original edges near the start and end,
+ * and on the cliques of ever larger cells further away.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct crp crp_t;
+
+/* crp_create: partition a graph and customize it with straight-line
+ *     edge costs
+ *
+ * graph: the graph, which must outlive the overlay and not change
+ * cell_size: maximum number of nodes in a cell of the lowest level
+ * num_threads: number of worker threads, 0 for one per core
+ *
+ * Returns: the overlay
+ */
+crp_t *crp_create(graph_t *graph, int cell_size, int num_threads);
+
+/* crp_num_levels: number of overlay levels
+ *
+ * crp: the overlay
+ *
+ * Returns: the number of levels above the original graph
+ */
+int crp_num_levels(crp_t *crp);
+
+/* crp_customize: recompute the cliques for new edge costs
+ *
+ * crp: the overlay
+ * costs: cost of every edge by edge number, graph->num_edges entries, at
+ *     least 0, NULL for straight-line costs
+ * num_threads: number of worker threads, 0 for one per core
+ */
+void crp_customize(crp_t *crp, const double *costs, int num_threads);
+
+/* crp_query: shortest path cost under the current customization.
+ *     Thread-safe, though not while crp_customize runs.
+ *
+ * crp: the overlay
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the cost of the shortest path between the start node and end
+ *     node, -1 if there is no path
+ */
+double crp_query(crp_t *crp, int start_node_num, int end_node_num);
+
+/* crp_free: free an overlay
+ *
+ * crp: the overlay
+ */
+void crp_free(crp_t *crp);
@@ -0,0 +1,241 @@
+/********* CSR GRAPH *********/
+
+/* A read-only snapshot of a graph_t in compressed sparse row form that
+ * keeps the direction of every edge. Each edge is stored once, whether it
+ * is a two-way edge from add_edge or a one-way arc from add_arc, and
+ * appears in two sets of rows: the out row of the node it leaves and the
+ * in row of the node it enters. A two-way edge is stored leaving its
+ * lower-numbered node and is flagged in both rows, so the neighbors of a
+ * node are its whole out row plus the flagged edges of its in row.
+ *
+ * A reversed view swaps the out and in rows without copying them, so
+ * searching it follows every arc backwards, as backward and bidirectional
+ * searches need.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct csr csr_t;
+
+/* Edges a_star_csr looks ahead in a row to prefetch the coordinates and
+ * search state of the neighbor it will relax then, which on graphs larger
+ * than the last level cache would otherwise be fetched from memory one at
+ * a time. Rows of road graphs are short, so a row is usually prefetched
+ * whole before its first edge is relaxed. Build with `make PREFETCH=0` to
+ * turn prefetching off.
+ */
+#ifndef CSR_PREFETCH_DISTANCE
+#define CSR_PREFETCH_DISTANCE (4)
+#endif
+
+typedef enum {
+    CSR_ALLOC_DEFAULT,      // malloc
+    CSR_ALLOC_HUGE_PAGES    // huge_alloc, see util.h
+} csr_alloc_t;
+
+/* csr_create: build a CSR snapshot of a graph
+ *
+ * graph: the graph
+ * 
+ * Returns: the CSR graph
+ */ 
+csr_t *csr_create(graph_t *graph);
+
+/* csr_create_alloc: build a CSR snapshot of a graph with a choice of
+ *     memory for its arrays
+ *
+ * graph: the graph
+ * alloc: where the arrays of the snapshot, and of each search on it, live
+ * 
+ * Returns: the CSR graph
+ */ 
+csr_t *csr_create_alloc(graph_t *graph, csr_alloc_t alloc);
+
+/* csr_reverse: reversed view of a CSR graph, sharing its arrays
+ *
+ * csr: the CSR graph or a view of it
+ * 
+ * Returns: a view in which every edge points the other way, to be freed
+ *     with csr_free before the graph it was made from
+ */ 
+csr_t *csr_reverse(csr_t *csr);
+
+/* csr_num_nodes: number of node slots
+ *
+ * csr: the CSR graph
+ * 
+ * Returns: the number of nodes of the graph it was made from, including
+ *     numbers without a node
+ */ 
+int csr_num_nodes(csr_t *csr);
+
+/* csr_has_node: determines whether a node number is in the graph
+ *
+ * csr: the CSR graph
+ * node_num: any number
+ * 
+ * Returns: true if node_num is in range and has a node, false otherwise
+ */ 
+bool csr_has_node(csr_t *csr, int node_num);
+
+/* csr_num_edges: number of stored edges
+ *
+ * csr: the CSR graph
+ * 
+ * Returns: the number of edges, each two-way edge counts once
+ */ 
+long csr_num_edges(csr_t *csr);
+
+/* csr_adjacency_bytes: memory used for the out and in rows, offsets and
+ *     two-way flags included
+ *
+ * csr: the CSR graph
+ * 
+ * Returns: the number of bytes
+ */ 
+size_t csr_adjacency_bytes(csr_t *csr);
+
+/* csr_neighbors: nodes reachable from a node over one edge
+ *
+ * csr: the CSR graph
+ * node_num: the node
+ * out: filled with the neighbors, room for every edge of the node
+ * 
+ * Returns: the number of neighbors written to out
+ */ 
+int csr_neighbors(csr_t *csr, int node_num, int *out);
+
+/* csr_free: free a CSR graph, or only the view if csr came from
+ *     csr_reverse
+ *
+ * csr: the CSR graph
+ */ 
+void csr_free(csr_t *csr);
+
+/* csr_save: write a CSR graph to a file
+ *
+ * csr: the CSR graph, a reversed view is written as the graph it shows
+ * file: a file open for binary writing
+ * 
+ * Returns: 0 on success, -1 if a write failed
+ */ 
+int csr_save(csr_t *csr, FILE *file);
+
+/* csr_load: read a CSR graph written by csr_save on the same kind of
+ *     machine, without the graph_t it was made from. Sizes are checked
+ *     against the rest of the file before anything is allocated, when
+ *     the file can seek, and offsets and node numbers are checked before
+ *     use. That the in rows mirror the out rows and their two-way flags
+ *     is not checked, the file is trusted for it. A mismatch gives
+ *     wrong paths on reversed views and wrong neighbors, never reads out
+ *     of bounds.
+ *
+ * file: a file open for binary reading
+ * alloc: where the arrays of the graph, and of each search on it, live
+ * 
+ * Returns: the CSR graph, NULL if the file is not valid
+ */ 
+csr_t *csr_load(FILE *file, csr_alloc_t alloc);
+
+/********* CSR BUILDER *********/
+
+/* Builds a CSR graph straight from a stream of nodes and edges, on many
+ * threads, without a graph_t in between. Each producing thread appends
+ * its edges to a buffer of its own, so adding edges takes no lock.
+ * csr_builder_finish then counts the edges of every row, places them
+ * with a parallel counting sort and sorts each row, so the graph does not
+ * depend on how the edges were split between buffers or threads. It is
+ * the graph csr_create makes from a graph_t with the same nodes, edges
+ * and arcs, up to the order of the edges in each row. Asked to, it drops
+ * self-loops and duplicate edges on the way, once the rows are sorted and
+ * duplicates sit next to each other, and then builds the graph csr_create
+ * makes after graph_clean.
+ *
+ * Programs using the builder link parallel.c.
+ */
+
+typedef struct csr_builder csr_builder_t;
+
+/* csr_builder_create: create an empty builder
+ *
+ * num_nodes: number of node slots, like graph_create
+ * num_threads: threads of the pool csr_builder_finish runs on, and the
+ *     number of edge buffers, 0 for one per core
+ * 
+ * Returns: the builder
+ */ 
+csr_builder_t *csr_builder_create(int num_nodes, int num_threads);
+
+/* csr_builder_num_buffers: number of edge buffers of a builder
+ *
+ * b: the builder
+ * 
+ * Returns: the number of buffers, the number of threads of its pool
+ */ 
+int csr_builder_num_buffers(csr_builder_t *b);
+
+/* csr_builder_add_node: add a node, like node_create without a name.
+ *     Threads may add different nodes at the same time.
+ *
+ * b: the builder
+ * node_num: node number
+ * latitude: node latitude
+ * longitude: node longitude
+ */ 
+void csr_builder_add_node(csr_builder_t *b, int node_num, double latitude,
+                          double longitude);
+
+/* csr_builder_add_edge: add a two-way edge, like add_edge. Threads may
+ *     add edges at the same time, each to a different buffer.
+ *
+ * b: the builder
+ * buffer: the buffer of the calling thread, 0 to
+ *     csr_builder_num_buffers(b) - 1
+ * node_num1: the first node
+ * node_num2: the second node
+ * 
+ * The nodes may be added later, but before csr_builder_finish.
+ */ 
+void csr_builder_add_edge(csr_builder_t *b, int buffer, int node_num1,
+                          int node_num2);
+
+/* csr_builder_add_arc: add a one-way edge, like add_arc, see
+ *     csr_builder_add_edge
+ *
+ * b: the builder
+ * buffer: the buffer of the calling thread
+ * from_node_num: the node the edge leaves
+ * to_node_num: the node the edge enters
+ */ 
+void csr_builder_add_arc(csr_builder_t *b, int buffer, int from_node_num,
+                         int to_node_num);
+
+/* csr_builder_finish: build the CSR graph and free the builder, once no
+ *     thread is adding to it
+ *
+ * b: the builder
+ * alloc: where the arrays of the graph, and of each search on it, live
+ * clean: NULL to keep every edge, or set to the number of edges dropped
+ *     for each reason as self-loops and duplicates are dropped, keeping
+ *     the edges graph_clean keeps
+ * 
+ * Returns: the CSR graph
+ */ 
+csr_t *csr_builder_finish(csr_builder_t *b, csr_alloc_t alloc, graph_clean_t *clean);
+
+/* csr_builder_free: free a builder without building the graph
+ *
+ * b: the builder
+ */ 
+void csr_builder_free(csr_builder_t *b);
+
+/* a_star_csr: performs A* search on a CSR graph
+ *
+ * csr: the CSR graph, or a reversed view to search against the edges
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */ 
+double a_star_csr(csr_t *csr, int start_node_num, int end_node_num);
@@ -0,0 +1,25 @@
+/********* DELTA-STEPPING SSSP *********/
+
+/* Parallel single-source shortest paths. Tentative distances are kept
+ * in buckets of width delta, and the nodes of the lowest non-empty
+ * bucket are relaxed together by a thread pool. Light edges (cost at
+ * most delta) can put nodes back into the current bucket and are relaxed
+ * until it stays empty. Heavy edges can only reach later buckets, so
+ * they are relaxed once per bucket.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+/* delta_stepping: computes shortest paths from one node to every node
+ *
+ * graph: the graph
+ * source_node_num: the source node number
+ * delta: bucket width, 0 to use the average edge cost
+ * num_threads: number of worker threads, 0 for one per core
+ * dist: filled with the distance to every node, -1 if unreachable,
+ *     graph->num_nodes entries
+ * parent: filled with the previous node on a shortest path, -1 for the
+ *     source and unreachable nodes, graph->num_nodes entries, may be NULL
+ */ 
+void delta_stepping(graph_t *graph, int source_node_num, double delta,
+                    int num_threads, double *dist, int *parent);
@@ -0,0 +1,24 @@
+/********* HASH-DISTRIBUTED A* *********/
+
+/* Parallel A* for a single query. Every node is owned by one worker
+ * thread, chosen by hashing its node number. Each worker keeps its own
+ * open list, and nodes generated for another worker are sent to its
+ * lock-free inbox. The search ends once no worker has open nodes that
+ * could still improve the best path and no message is in flight.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+/* hda_star: performs hash-distributed parallel A* search
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * num_threads: number of worker threads, 0 for one per core
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path. Like a_star(), the parent fields of the
+ *     nodes on the path are set.
+ */ 
+double hda_star(graph_t *graph, int start_node_num, int end_node_num, 
+                int num_threads);
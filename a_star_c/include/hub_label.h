@@ -0,0 +1,76 @@
+/********* HUB LABELS *********/
+
+/* Distance oracle built by pruned landmark labeling. Every node gets a
+ * label: a list of hubs with the distance to (out label) or from (in
+ * label) each of them, such that every shortest path s -> t passes
+ * through a hub in both the out label of s and the in label of t. A
+ * query only merges those two lists, no graph search is needed.
+ *
+ * Hubs are ranked by how many nodes lie below them in a few sampled
+ * shortest path trees, so nodes on many shortest paths come first. Their
+ * pruned Dijkstra searches run in batches of one hub per thread. A search
+ * is pruned at nodes whose distance is already answered by the labels of
+ * earlier batches, which keeps the labels correct though slightly larger
+ * than a sequential build. Graphs without one-way arcs share one label
+ * for both directions.
+ *
+ * Labels are kept sorted by hub rank in flat arrays, each ending with a
+ * sentinel hub, so the merge is a single loop without bounds checks.
+ *
+ * Requires a_star.h and stdio.h to be included first.
+ */
+
+typedef struct hub_labels hub_labels_t;
+
+/* hub_labels_create: compute hub labels for a graph
+ *
+ * graph: the graph
+ * num_threads: number of worker threads, 0 for one per core
+ *
+ * Returns: the labels
+ */
+hub_labels_t *hub_labels_create(graph_t *graph, int num_threads);
+
+/* hub_labels_query: distance between two nodes
+ *
+ * hl: the labels
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the distance of the shortest path between the start node and
+ *     end node, -1 if there is no path
+ */
+double hub_labels_query(hub_labels_t *hl, int start_node_num, int end_node_num);
+
+/* hub_labels_size: total number of label entries
+ *
+ * hl: the labels
+ *
+ * Returns: the number of hub and distance pairs over all labels, shared
+ *     labels counted once, sentinels not counted
+ */
+long hub_labels_size(hub_labels_t *hl);
+
+/* hub_labels_save: write labels to a file
+ *
+ * hl: the labels
+ * file: a file open for binary writing
+ *
+ * Returns: 0 on success, -1 if a write failed
+ */
+int hub_labels_save(hub_labels_t *hl, FILE *file);
+
+/* hub_labels_load: read labels written by hub_labels_save on the same
+ *     kind of machine
+ *
+ * file: a file open for binary reading
+ *
+ * Returns: the labels, NULL if the file is not valid
+ */
+hub_labels_t *hub_labels_load(FILE *file);
+
+/* hub_labels_free: free hub labels
+ *
+ * hl: the labels
+ */
+void hub_labels_free(hub_labels_t *hl);
@@ -0,0 +1,30 @@
+/********* K SHORTEST PATHS *********/
+
+/* Yen's algorithm for the k shortest loopless paths. Every new path
+ * branches off the previous one at some spur node. The spur searches for
+ * one round are independent, so they run in parallel, each on its own
+ * pooled search context. The root path nodes are excluded by marking
+ * them closed, and the edges used by earlier paths with the same root
+ * are skipped at the spur node.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+/* k_shortest_paths: finds up to k loopless paths between two nodes, in
+ *     order of increasing cost
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * k: number of paths wanted
+ * num_threads: number of threads for the spur searches, 0 for one per core
+ * costs: filled with the cost of each path, k entries
+ * paths: filled with a new array of node numbers, start to end, for each
+ *     path, k entries. The caller frees each array.
+ * lengths: filled with the number of nodes on each path, k entries
+ * 
+ * Returns: the number of paths found, at most k
+ */ 
+int k_shortest_paths(graph_t *graph, int start_node_num, int end_node_num, 
+                     int k, int num_threads, double *costs, int **paths,
+                     int *lengths);
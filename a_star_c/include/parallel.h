@@ -0,0 +1,67 @@
+/********* THREAD POOL *********/
+
+typedef struct tpool tpool_t;
+
+/* tpool_fn: work run by every thread of a pool
+ *
+ * tid: thread index, 0 to tpool_size(pool) - 1
+ * arg: the argument passed to tpool_run
+ */
+typedef void (*tpool_fn)(int tid, void *arg);
+
+/* tpool_range_fn: work on the index range [lo, hi)
+ *
+ * lo: first index
+ * hi: one past the last index
+ * tid: index of the thread doing the work
+ * arg: the argument passed to tpool_for
+ */
+typedef void (*tpool_range_fn)(long lo, long hi, int tid, void *arg);
+
+/* num_cores: number of online processors
+ *
+ * Returns: the number of cores, at least 1
+ */
+int num_cores(void);
+
+/* tpool_create: create a pool of threads
+ *
+ * num_threads: number of threads, 0 for one per core
+ *
+ * Returns: a thread pool
+ */
+tpool_t *tpool_create(int num_threads);
+
+/* tpool_size: number of threads in a pool
+ *
+ * pool: the thread pool
+ *
+ * Returns: the number of threads, including the calling thread
+ */
+int tpool_size(tpool_t *pool);
+
+/* tpool_run: run fn once on every thread of the pool and wait for all
+ *     of them to return. The calling thread runs tid 0.
+ *
+ * pool: the thread pool
+ * fn: the work
+ * arg: passed through to fn
+ */
+void tpool_run(tpool_t *pool, tpool_fn fn, void *arg);
+
+/* tpool_for: split [0, n) into chunks and hand them out to the threads
+ *     of the pool as they become free
+ *
+ * pool: the thread pool
+ * n: number of indices
+ * chunk: indices per chunk, 0 to pick one
+ * fn: the work
+ * arg: passed through to fn
+ */
+void tpool_for(tpool_t *pool, long n, long chunk, tpool_range_fn fn, void *arg);
+
+/* tpool_free: stop and free a pool of threads
+ *
+ * pool: the thread pool
+ */
+void tpool_free(tpool_t *pool);
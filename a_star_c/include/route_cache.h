@@ -0,0 +1,81 @@
+/********* ROUTE CACHE *********/
+
+/* Bounded cache of search results in front of A*, for traffic that keeps
+ * asking for the same routes. Results are keyed by start node, end node
+ * and the hash of the search mask, and keep the cost and the path, which
+ * is stored as varint-encoded gaps between consecutive nodes. Searches
+ * that find no path are cached too.
+ *
+ * The cache is split into shards, each with its own lock and least
+ * recently used list, so threads asking for different routes rarely wait
+ * on each other. Misses run the search outside the lock on a search
+ * context, so concurrent misses run in parallel.
+ *
+ * Every change to the graph bumps its version, and a shard that sees a
+ * new version drops its entries. Changes must not run concurrently with
+ * queries, as for the graph itself. Masks are told apart by their hash
+ * only, two masks with the same hash share entries.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct route_cache route_cache_t;
+typedef struct route_cache_stats route_cache_stats_t;
+
+struct route_cache_stats {
+    long hits;
+    long misses;
+    long evictions;       // entries dropped to make room
+    long invalidations;   // entries dropped because the graph changed
+    long entries;
+    size_t path_bytes;    // memory used by the encoded paths
+};
+
+/* route_cache_create: create an empty cache for a graph
+ *
+ * graph: the graph, which must outlive the cache
+ * capacity: the most results the cache holds
+ *
+ * Returns: the cache
+ */
+route_cache_t *route_cache_create(graph_t *graph, int capacity);
+
+/* route_cache_a_star: performs A* search, or looks up the result of an
+ *     earlier search with the same start, end and mask. Thread-safe.
+ *
+ * cache: the cache
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * mask: the search mask, NULL for none
+ * path: set to a new array with the node numbers from the start to the
+ *     end, to be freed by the caller, NULL if there is no path. May be
+ *     NULL when the path is not needed.
+ * path_len: set to the number of nodes on the path, 0 if there is no
+ *     path, may be NULL
+ *
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */
+double route_cache_a_star(route_cache_t *cache, int start_node_num,
+                          int end_node_num, const search_mask_t *mask,
+                          int **path, int *path_len);
+
+/* route_cache_clear: drop every cached result, for changes the graph
+ *     version does not track, like moving a node. Thread-safe.
+ *
+ * cache: the cache
+ */
+void route_cache_clear(route_cache_t *cache);
+
+/* route_cache_get_stats: read the counters of a cache. Thread-safe.
+ *
+ * cache: the cache
+ * stats: filled in with the counters since the cache was created
+ */
+void route_cache_get_stats(route_cache_t *cache, route_cache_stats_t *stats);
+
+/* route_cache_free: free a cache
+ *
+ * cache: the cache
+ */
+void route_cache_free(route_cache_t *cache);
@@ -0,0 +1,99 @@
+/********* ROUTE SERVER *********/
+
+/* A server that answers batches of route queries on a CSR graph over a
+ * Unix domain socket, so programs can share one loaded graph without
+ * linking the library. One thread runs an epoll loop over every
+ * connection and hands complete batches to the other threads of a pool,
+ * which run a_star_csr on them. A connection has at most one batch in
+ * flight, so its answers come back in order.
+ *
+ * Requests and answers are frames of native-endian integers, for clients
+ * on the same machine:
+ *
+ *     request:  uint32 ROUTE_MAGIC, uint32 count, count x (int32 start,
+ *               int32 end)
+ *     answer:   uint32 ROUTE_MAGIC, uint32 count, count x double cost
+ *
+ * A cost is -1 when there is no path or a node does not exist. An empty
+ * request is answered with the number of nodes of the graph in place of
+ * the count and no costs. A request with a bad magic or more than
+ * ROUTE_MAX_BATCH queries closes the connection.
+ *
+ * Linux only. Requires a_star.h and csr.h to be included first.
+ */
+
+#define ROUTE_MAGIC (0x54554f52)    // "ROUT"
+#define ROUTE_MAX_BATCH (4096)
+
+typedef struct route_server route_server_t;
+typedef struct route_client route_client_t;
+
+/* route_server_create: create a server listening on a socket path
+ *
+ * csr: the graph, which must outlive the server
+ * path: the socket path, replaced if a socket is already there. Any
+ *     other kind of file there is left alone.
+ * num_threads: number of threads, including the one running the event
+ *     loop, 0 for one per core. With 1 the loop runs the searches itself.
+ *
+ * Returns: the server, NULL if the socket could not be set up or path
+ *     is a file other than a socket
+ */
+route_server_t *route_server_create(csr_t *csr, const char *path, int num_threads);
+
+/* route_server_run: serve queries until route_server_stop is called
+ *
+ * server: the server
+ *
+ * Returns: 0 once stopped, -1 if the event loop failed
+ */
+int route_server_run(route_server_t *server);
+
+/* route_server_stop: make route_server_run return, once the batches in
+ *     flight are answered. Safe to call from other threads and from
+ *     signal handlers.
+ *
+ * server: the server
+ */
+void route_server_stop(route_server_t *server);
+
+/* route_server_free: free a server and remove its socket
+ *
+ * server: the server, not running
+ */
+void route_server_free(route_server_t *server);
+
+/* route_client_connect: connect to a server
+ *
+ * path: the socket path
+ *
+ * Returns: the client, NULL if the connection failed
+ */
+route_client_t *route_client_connect(const char *path);
+
+/* route_client_num_nodes: number of node slots of the graph of a server
+ *
+ * client: the client
+ *
+ * Returns: the number of nodes, -1 on a connection error
+ */
+int route_client_num_nodes(route_client_t *client);
+
+/* route_client_query: send a batch of queries and wait for the answers
+ *
+ * client: the client
+ * count: the number of queries, 1 to ROUTE_MAX_BATCH
+ * starts: the starting node of each query
+ * ends: the ending node of each query
+ * costs: filled with the cost of each query, -1 if there is no path
+ *
+ * Returns: 0 on success, -1 on a connection error
+ */
+int route_client_query(route_client_t *client, int count, const int *starts,
+                       const int *ends, double *costs);
+
+/* route_client_close: close a connection
+ *
+ * client: the client
+ */
+void route_client_close(route_client_t *client);
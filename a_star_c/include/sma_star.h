@@ -0,0 +1,55 @@
+/********* MEMORY-BOUNDED SEARCH *********/
+
+/* SMA*, simplified memory-bounded A*, for queries whose open list would
+ * not fit in memory. The search holds at most a fixed number of search
+ * nodes. Each one generates its successors one at a time, and when the
+ * store is full the leaf with the highest f-cost, the shallowest of
+ * those, is dropped to make room. Its parent keeps the least f-cost of
+ * the leaves it lost, and generates them again once that is the best
+ * cost left in the search.
+ *
+ * All the memory of a search is allocated up front from the number of
+ * search nodes, none of it depends on the size of the graph. The cost is
+ * the shortest one when the optimal path fits in the store, otherwise it
+ * is the best one found in the room there is, or -1 when no path fits.
+ * The tighter the store, the more often pruned nodes are generated again,
+ * and a store barely longer than the path can take exponential time, so
+ * the work can be bounded too.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct sma_star_stats sma_star_stats_t;
+
+struct sma_star_stats {
+    long generated;     // successors generated, again after regenerations
+    long pruned;        // leaves dropped to make room
+    long regenerated;   // nodes that went over their successors again
+    long max_stored;    // most search nodes held at once
+    bool truncated;     // a successor had no room, the cost may not be
+                        // the shortest
+    bool gave_up;       // max_generated was reached
+};
+
+/* sma_star: performs SMA* search, holding at most max_nodes search nodes
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * max_nodes: the most search nodes to hold at once, at least 1
+ * max_generated: the most successors to generate before giving up, 0
+ *     for no limit
+ * path: set to a new array with the node numbers from the start to the
+ *     end, to be freed by the caller, NULL if there is no path. May be
+ *     NULL when the path is not needed.
+ * path_len: set to the number of nodes on the path, 0 if there is no
+ *     path, may be NULL
+ * stats: filled in with search statistics, may be NULL
+ * 
+ * Returns: the distance of the path found between the start node and end
+ *     node, -1 if there is no path, none fits in max_nodes or the search
+ *     gave up
+ */ 
+double sma_star(graph_t *graph, int start_node_num, int end_node_num,
+                int max_nodes, long max_generated, int **path, int *path_len,
+                sma_star_stats_t *stats);
@@ -0,0 +1,79 @@
+/********* TIME-DEPENDENT GRAPH *********/
+
+/* A snapshot of a graph_t whose edges take a travel time that depends on
+ * when they are entered. Each edge has a periodic piecewise-linear travel
+ * time function, given by breakpoints (time of day, travel time) and
+ * interpolated linearly between them, wrapping from the last breakpoint
+ * of one period to the first of the next. An edge without breakpoints
+ * takes its straight-line length at any time, like in a_star(). A two-way
+ * edge from add_edge has the same function in both directions.
+ *
+ * Functions must have the FIFO property: leaving later never arrives
+ * earlier, so no segment may fall faster than time passes. Under it the
+ * earliest arrival at every node is found by an A* that evaluates each
+ * edge at the arrival time at its tail.
+ *
+ * Breakpoints are kept as floats in one pool shared by all edges, with an
+ * offset and count per edge, 8 bytes per breakpoint.
+ *
+ * Requires a_star.h to be included first.
+ */
+
+typedef struct td_graph td_graph_t;
+
+/* td_graph_create: build a time-dependent snapshot of a graph, with every
+ *     edge taking its straight-line length
+ *
+ * graph: the graph
+ * period: length of the period the travel time functions repeat over,
+ *     like 86400 for a day in seconds
+ *
+ * Returns: the time-dependent graph
+ */
+td_graph_t *td_graph_create(graph_t *graph, double period);
+
+/* td_set_profile: set the travel time function of an edge
+ *
+ * td: the time-dependent graph
+ * edge_num: the edge, numbered as in the graph
+ * num_points: the number of breakpoints, at most 65535, 0 for the
+ *     straight-line length
+ * times: time of each breakpoint, increasing, in [0, period)
+ * costs: travel time when entering the edge at each breakpoint, not
+ *     negative
+ *
+ * Returns: 0 on success, -1 if the breakpoints are out of order or out of
+ *     range, a cost is negative, or the function is not FIFO. The edge
+ *     keeps its old function then.
+ */
+int td_set_profile(td_graph_t *td, int edge_num, int num_points,
+                   const double *times, const double *costs);
+
+/* td_travel_time: travel time of an edge
+ *
+ * td: the time-dependent graph
+ * edge_num: the edge
+ * depart: the time the edge is entered, any time, not only in one period
+ *
+ * Returns: the travel time
+ */
+double td_travel_time(td_graph_t *td, int edge_num, double depart);
+
+/* td_a_star: performs time-dependent A* search for the earliest arrival
+ *
+ * td: the time-dependent graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * depart: the time of departure from the start node
+ *
+ * Returns: the earliest arrival time at the end node, -1 if there is no
+ *     path
+ */
+double td_a_star(td_graph_t *td, int start_node_num, int end_node_num,
+                 double depart);
+
+/* td_graph_free: free a time-dependent graph
+ *
+ * td: the time-dependent graph
+ */
+void td_graph_free(td_graph_t *td);
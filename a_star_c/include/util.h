@@ -2,6 +2,7 @@
 
 typedef struct set set_t;
 typedef struct queue queue_t;
+typedef struct heap heap_t;
 
 /********* SET *********/
 
@@ -41,6 +42,115 @@ void set_free(set_t *set);
  */ 
 void set_print(set_t *set);
 
+/********* BITSETS *********/
+
+/* One bit per number in an array of 64-bit words, n / 64 + 1 of them for
+ * numbers below n. These sit in the inner loops of searches, so they are
+ * inline here rather than in util.c, and need stdint.h included first.
+ */
+
+/* bit_get: test a bit
+ *
+ * bits: the bitset
+ * i: the bit
+ * 
+ * Returns: true if the bit is set
+ */ 
+static inline bool bit_get(const uint64_t *bits, long i)
+{
+    return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+/* bit_set: set a bit
+ *
+ * bits: the bitset
+ * i: the bit
+ */ 
+static inline void bit_set(uint64_t *bits, long i)
+{
+    bits[i / 64] |= (uint64_t)1 << (i % 64);
+}
+
+/* bit_clear: clear a bit
+ *
+ * bits: the bitset
+ * i: the bit
+ */ 
+static inline void bit_clear(uint64_t *bits, long i)
+{
+    bits[i / 64] &= ~((uint64_t)1 << (i % 64));
+}
+
+/********* SEARCH LABELS *********/
+
+/* The cost of the best path found to each node of a search, with a
+ * bitset of the nodes that have one and a bitset of the nodes that are
+ * closed. Only the bitsets are cleared, so a search touches the costs of
+ * the nodes it reaches and no others.
+ */
+
+typedef struct search_labels search_labels_t;
+
+struct search_labels {
+    double *g;
+    uint64_t *seen;
+    uint64_t *closed;
+};
+
+/* search_labels_init: allocate labels for a search with none seen
+ *
+ * labels: the labels
+ * num_nodes: the number of nodes in the graph
+ */ 
+void search_labels_init(search_labels_t *labels, int num_nodes);
+
+/* search_labels_free: free the arrays of labels from search_labels_init
+ *
+ * labels: the labels
+ */ 
+void search_labels_free(search_labels_t *labels);
+
+/* search_labels_close: close a node as it leaves the open list
+ *
+ * labels: the labels
+ * num: the node
+ * 
+ * Returns: false if the node was already closed, a stale open list
+ *     entry to skip, true otherwise
+ */ 
+static inline bool search_labels_close(search_labels_t *labels, int num)
+{
+    if(bit_get(labels->closed, num)){
+        return false;
+    }
+    bit_set(labels->closed, num);
+    return true;
+}
+
+/* search_labels_improve: offer a path cost to a node that is not closed,
+ *     callers test labels->closed first so they do not work out the cost
+ *     of an edge to a closed node
+ *
+ * labels: the labels
+ * num: the node
+ * g: the cost of the path
+ * 
+ * Returns: true if the node had no path as cheap, its cost is then g and
+ *     it goes on the open list, false otherwise
+ */ 
+static inline bool search_labels_improve(search_labels_t *labels, int num, double g)
+{
+    if(bit_get(labels->seen, num)){
+        if(g >= labels->g[num]){
+            return false;
+        }
+    }else{
+        bit_set(labels->seen, num);
+    }
+    labels->g[num] = g;
+    return true;
+}
+
 /********* PRIORITY QUEUE *********/
 
 /* queue_create: create a priority queue
@@ -102,4 +212,234 @@ void queue_free(queue_t *q);
  * 
  * q: the priority queue
  */ 
-void queue_print(queue_t *q);
\ No newline at end of file
+void queue_print(queue_t *q);
+
+/********* BINARY HEAP *********/
+
+/* The list-based priority queue above keeps one entry per number and
+ * costs O(n) per operation. The heap below is O(log n) and allows
+ * duplicate numbers, callers skip stale entries when they pop them.
+ */
+
+/* heap_create: create a binary min-heap
+ *
+ * capacity: initial number of elements, the heap grows past it
+ * 
+ * Returns: a heap
+ */ 
+heap_t *heap_create(int capacity);
+
+/* heap_push: add an element to the heap
+ * 
+ * h: the heap
+ * num: the number to add to the heap
+ * priority: priority of num, smaller comes out first
+ */ 
+void heap_push(heap_t *h, int num, double priority);
+
+/* heap_pop: remove the element with the smallest priority
+ * 
+ * h: the heap
+ * priority: set to the priority of the removed element, may be NULL
+ * 
+ * Returns: the number removed from the heap
+ */ 
+int heap_pop(heap_t *h, double *priority);
+
+/* heap_min_priority: the smallest priority in the heap
+ * 
+ * h: the heap, must not be empty
+ * 
+ * Returns: the priority of the element heap_pop would remove
+ */ 
+double heap_min_priority(heap_t *h);
+
+/* heap_min_num: the number with the smallest priority in the heap
+ * 
+ * h: the heap, must not be empty
+ * 
+ * Returns: the number heap_pop would remove
+ */ 
+int heap_min_num(heap_t *h);
+
+/* heap_size: number of elements in the heap
+ * 
+ * h: the heap
+ * 
+ * Returns: the number of elements
+ */ 
+int heap_size(heap_t *h);
+
+/* heap_is_empty: determines whether or not the heap is empty
+ * 
+ * h: the heap
+ * 
+ * Returns: true if the heap is empty, false otherwise
+ */ 
+bool heap_is_empty(heap_t *h);
+
+/* heap_clear: remove every element, keeping the allocation
+ * 
+ * h: the heap
+ */ 
+void heap_clear(heap_t *h);
+
+/* heap_bytes: memory held by a heap, its element array included
+ * 
+ * h: the heap
+ * 
+ * Returns: the number of bytes, without malloc headers
+ */ 
+size_t heap_bytes(heap_t *h);
+
+/* heap_free: free a heap
+ * 
+ * h: the heap
+ */ 
+void heap_free(heap_t *h);
+
+/********* HUGE PAGES *********/
+
+/* Large read-mostly arrays spread over many 4 KB pages and miss the TLB
+ * on nearly every random access. huge_alloc places them on 2 MB pages
+ * instead, by aligning the block and asking Linux for transparent huge
+ * pages with madvise. Where that is not available the memory comes from
+ * the usual small pages, so callers need no fallback of their own.
+ */
+
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+/* huge_alloc: allocate zeroed memory backed by huge pages where possible
+ *
+ * bytes: the size, rounded up to whole huge pages
+ * 
+ * Returns: a block aligned to HUGE_PAGE_SIZE, to be freed with huge_free
+ */ 
+void *huge_alloc(size_t bytes);
+
+/* huge_free: free memory from huge_alloc
+ * 
+ * ptr: the block, may be NULL
+ * bytes: the size it was allocated with
+ */ 
+void huge_free(void *ptr, size_t bytes);
+
+/********* MEMORY ACCOUNTING *********/
+
+/* malloc_bytes: memory one malloc call takes from the heap, the size
+ *     asked for plus the header and rounding of a 64-bit glibc malloc.
+ *     Other allocators differ a little, so reports built on it are
+ *     estimates.
+ *
+ * bytes: the size asked for
+ * 
+ * Returns: the number of bytes
+ */ 
+size_t malloc_bytes(size_t bytes);
+
+/********* FILES *********/
+
+/* file_bytes_left: the number of bytes from the position of a file to its
+ *     end, so loaders can bound the sizes a header claims before they
+ *     allocate anything
+ *
+ * file: a file open for binary reading, left at the same position
+ * 
+ * Returns: the number of bytes, -1 if the file cannot seek
+ */ 
+long file_bytes_left(FILE *file);
+
+/********* VARINTS *********/
+
+/* Small unsigned numbers in as few bytes as they need, seven bits to a
+ * byte with the high bit set on every byte but the last. Signed gaps go
+ * through zigzag first, so small negative ones stay small. These run in
+ * the decoding loops of searches, so they are inline here rather than
+ * in util.c, and need stdint.h included first.
+ */
+
+/* zigzag: map a signed number to an unsigned one, 0, -1, 1, -2 to 0, 1,
+ *     2, 3 and so on
+ *
+ * x: the number
+ * 
+ * Returns: the unsigned number
+ */ 
+static inline uint32_t zigzag(int32_t x)
+{
+    return ((uint32_t)x << 1) ^ (uint32_t)(x >> 31);
+}
+
+/* unzigzag: undo zigzag
+ *
+ * x: the unsigned number
+ * 
+ * Returns: the signed number
+ */ 
+static inline int32_t unzigzag(uint32_t x)
+{
+    return (int32_t)(x >> 1) ^ -(int32_t)(x & 1);
+}
+
+/* varint_len: number of bytes varint_put writes for a number
+ *
+ * x: the number
+ * 
+ * Returns: the number of bytes, 1 to 5
+ */ 
+static inline int varint_len(uint32_t x)
+{
+    int n = 1;
+    while(x >= 0x80){
+        x >>= 7;
+        n++;
+    }
+    return n;
+}
+
+/* varint_put: write a number as a varint
+ *
+ * out: where to write, with room for varint_len(x) bytes
+ * x: the number
+ * 
+ * Returns: the number of bytes written
+ */ 
+static inline int varint_put(uint8_t *out, uint32_t x)
+{
+    int n = 0;
+    while(x >= 0x80){
+        out[n++] = (uint8_t)(x | 0x80);
+        x >>= 7;
+    }
+    out[n++] = (uint8_t)x;
+    return n;
+}
+
+/* varint_get: read a varint
+ *
+ * cursor: the first byte of the varint, moved past its last byte
+ * 
+ * Returns: the number
+ */ 
+static inline uint32_t varint_get(const uint8_t **cursor)
+{
+    const uint8_t *p = *cursor;
+
+    // most gaps fit in one byte
+    if(p[0] < 0x80){
+        *cursor = p + 1;
+        return p[0];
+    }
+
+    uint32_t x = p[0] & 0x7f;
+    int shift = 7;
+    p++;
+    while(*p >= 0x80){
+        x |= (uint32_t)(*p & 0x7f) << shift;
+        shift += 7;
+        p++;
+    }
+    x |= (uint32_t)*p << shift;
+    *cursor = p + 1;
+    return x;
+}
@@ -1,12 +1,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <assert.h>
 #include <math.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <pthread.h>
 
 #include "util.h"
 #include "a_star.h"
 
+static search_pool_t *search_pool_create();
+static void search_pool_free(search_pool_t *pool);
+static name_pool_t *name_pool_create();
+static void name_pool_free(name_pool_t *names);
+static char *name_intern(name_pool_t *names, const char *name, int node_num);
+
+typedef struct targets targets_t;
+static void targets_free(targets_t *t);
+
 /********* GRAPH *********/
 
 /* graph_create: create a graph
@@ -32,6 +46,10 @@ graph_t *graph_create(int num_nodes)
     }
     graph->num_nodes = num_nodes;
     graph->nodes = nodes;
+    graph->num_edges = 0;
+    graph->version = 0;
+    graph->pool = search_pool_create();
+    graph->names = name_pool_create();
 
     return graph;
 }
@@ -40,12 +58,12 @@ graph_t *graph_create(int num_nodes)
  *
  * graph: the graph
  * node_num: node number
- * city_name: the city
+ * city_name: the city, copied into the graph, may be NULL
  * latitude: city latitude
  * longitude: city longitude
  * 
  */ 
-void node_create(graph_t *graph, int node_num, char *city_name, 
+void node_create(graph_t *graph, int node_num, const char *city_name, 
                  double latitude, double longitude)
 {    
     node_t* node = (node_t*)malloc(sizeof(node_t));
@@ -55,7 +73,7 @@ void node_create(graph_t *graph, int node_num, char *city_name,
     }
 
     node->node_num = node_num;
-    node->city_name = city_name;
+    node->city_name = city_name ? name_intern(graph->names, city_name, node_num) : NULL;
     node->latitude = latitude;
     node->longitude = longitude;
     node->neighbors = NULL;
@@ -65,6 +83,7 @@ void node_create(graph_t *graph, int node_num, char *city_name,
     node->h_cost = 0;
     
     graph->nodes[node_num] = node;
+    graph->version++;
 }
 
 /* Helper for add_edge below:
@@ -74,10 +93,11 @@ void node_create(graph_t *graph, int node_num, char *city_name,
  * Inputs: 
  * - node: pointer to node (node_t*)
  * - edgenum: node number of neighbor node (int)
+ * - edge_num: number of the edge (int)
  * 
  * Output: none. function is void.
  */
-void edge_help(node_t* node, int edgenum)
+void edge_help(node_t* node, int edgenum, int edge_num)
 {
     intlist_t* neighbor = (intlist_t*)malloc(sizeof(intlist_t));
     if(neighbor == NULL){
@@ -86,6 +106,7 @@ void edge_help(node_t* node, int edgenum)
     }
 
     neighbor->num = edgenum;
+    neighbor->edge_num = edge_num;
     neighbor->next = NULL;
 
     if(!node->neighbors){
@@ -113,8 +134,145 @@ void add_edge(graph_t* graph, int node_num1, int node_num2)
     node_t* node1 = graph->nodes[node_num1];
     node_t* node2 = graph->nodes[node_num2];
 
-    edge_help(node1, node_num2);
-    edge_help(node2, node_num1);
+    int edge_num = graph->num_edges++;
+    edge_help(node1, node_num2, edge_num);
+    edge_help(node2, node_num1, edge_num);
+    graph->version++;
+}
+
+/* add_arc: add a one-way edge between two nodes
+ *
+ * graph: the graph
+ * from_node_num: the node the edge leaves
+ * to_node_num: the node the edge enters
+ * 
+ * The edge gets the next edge number, like add_edge, but only appears in
+ * the neighbor list of from_node_num.
+ */ 
+void add_arc(graph_t* graph, int from_node_num, int to_node_num)
+{
+    node_t* from = graph->nodes[from_node_num];
+    assert(graph->nodes[to_node_num] != NULL);
+
+    int edge_num = graph->num_edges++;
+    edge_help(from, to_node_num, edge_num);
+    graph->version++;
+}
+
+/* Helpers for graph_clean below:
+ *
+ * clean_entry_t: a neighbor list entry with what it is sorted by
+ * clean_cmp: qsort order, by neighbor, two-way edges first, then by edge
+ *     number
+ */
+typedef struct {
+    int num;
+    int two_way;
+    int edge_num;
+    intlist_t *entry;
+} clean_entry_t;
+
+static int clean_cmp(const void *a, const void *b)
+{
+    const clean_entry_t *x = (const clean_entry_t*)a;
+    const clean_entry_t *y = (const clean_entry_t*)b;
+    if(x->num != y->num){
+        return (x->num > y->num) - (x->num < y->num);
+    }
+    if(x->two_way != y->two_way){
+        return y->two_way - x->two_way;
+    }
+    return (x->edge_num > y->edge_num) - (x->edge_num < y->edge_num);
+}
+
+/* graph_clean: remove self-loops and duplicate edges, which searches would
+ *     otherwise scan again on every expansion
+ *
+ * graph: the graph
+ * report: set to the number of edges removed for each reason, may be NULL
+ * 
+ * Between two nodes, a two-way edge is kept in place of any other edge or
+ * arc, and otherwise one arc in each direction, the one added first. Costs
+ * come from the coordinates, so the edges kept are as short as the ones
+ * removed. Edge numbers of the edges kept do not change, and num_edges
+ * still counts the numbers of the removed edges.
+ */ 
+void graph_clean(graph_t *graph, graph_clean_t *report)
+{
+    // add_edge puts its edge number in two neighbor lists, add_arc in one
+    int n = graph->num_nodes;
+    uint8_t *uses = (uint8_t*)calloc(graph->num_edges + 1, 1);
+    uint8_t *removed = (uint8_t*)calloc(graph->num_edges + 1, 1);
+    if(!uses || !removed){
+        fprintf(stderr, "graph_clean: calloc failed\n");
+        exit(1);
+    }
+    int max_degree = 0;
+    for(int u = 0; u < n; u++){
+        int degree = 0;
+        for(intlist_t *nb = graph->nodes[u] ? graph->nodes[u]->neighbors : NULL; nb; nb = nb->next){
+            uses[nb->edge_num] += uses[nb->edge_num] < 2;
+            degree++;
+        }
+        max_degree = degree > max_degree ? degree : max_degree;
+    }
+
+    // both lists of a two-way edge see every two-way edge between its
+    // nodes, so they pick the same one to keep
+    enum {KEPT, DUPLICATE, SELF_LOOP};
+    clean_entry_t *sorted = (clean_entry_t*)malloc(sizeof(clean_entry_t) * (max_degree + 1));
+    if(sorted == NULL){
+        fprintf(stderr, "graph_clean: malloc failed\n");
+        exit(1);
+    }
+    for(int u = 0; u < n; u++){
+        int degree = 0;
+        for(intlist_t *nb = graph->nodes[u] ? graph->nodes[u]->neighbors : NULL; nb; nb = nb->next){
+            clean_entry_t e = {nb->num, uses[nb->edge_num] > 1, nb->edge_num, nb};
+            sorted[degree++] = e;
+        }
+        qsort(sorted, degree, sizeof(clean_entry_t), clean_cmp);
+        for(int i = 0; i < degree; i++){
+            if(sorted[i].num == u){
+                removed[sorted[i].edge_num] = SELF_LOOP;
+            }else if(i > 0 && sorted[i].num == sorted[i - 1].num){
+                removed[sorted[i].edge_num] = DUPLICATE;
+            }
+        }
+    }
+    free(sorted);
+
+    long duplicates = 0;
+    long self_loops = 0;
+    for(int e = 0; e < graph->num_edges; e++){
+        duplicates += removed[e] == DUPLICATE;
+        self_loops += removed[e] == SELF_LOOP;
+    }
+    for(int u = 0; u < n && duplicates + self_loops > 0; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        intlist_t **link = &graph->nodes[u]->neighbors;
+        while(*link){
+            intlist_t *nb = *link;
+            if(removed[nb->edge_num]){
+                *link = nb->next;
+                free(nb);
+            }else{
+                link = &nb->next;
+            }
+        }
+    }
+    if(duplicates + self_loops > 0){
+        graph->version++;
+    }
+
+    free(uses);
+    free(removed);
+    if(report){
+        report->duplicates = duplicates;
+        report->self_loops = self_loops;
+    }
 }
 
 /* graph_free: free a graph and its nodes
@@ -135,12 +293,27 @@ void graph_free(graph_t* graph)
             free(graph->nodes[i]);
         }
     }
+    search_pool_free(graph->pool);
+    name_pool_free(graph->names);
     free(graph->nodes);
     free(graph);
 }
 
 /********* A* SEARCH *********/
 
+/* Search statistics are only collected when built with -DA_STAR_STATS,
+ * otherwise every STAT_* macro expands to nothing and the search loop
+ * is identical to the uninstrumented one.
+ */
+#ifdef A_STAR_STATS
+#define STAT_INC(stats, field) do { if(stats) (stats)->field++; } while(0)
+#define STAT_MAX(stats, field, val) \
+    do { if((stats) && (val) > (stats)->field) (stats)->field = (val); } while(0)
+#else
+#define STAT_INC(stats, field) ((void)0)
+#define STAT_MAX(stats, field, val) ((void)0)
+#endif
+
 /* Helpers for a_star below:
  *
  * h_calc: calculates h_cost of node
@@ -169,6 +342,7 @@ double h_calc(node_t* root, node_t* end)
  * - fin: pointer to final node (node_t*)
  * - q: pointer to priority queue (queue_t*)
  * - s: pointer to closed set (set_t*) 
+ * - stats: search statistics, may be NULL (a_star_stats_t*)
  * 
  * Output: returns true if function meets exit conditions, 
  * false otherwise (bool)
@@ -176,9 +350,11 @@ double h_calc(node_t* root, node_t* end)
  *  - if given node exists in priority queue with lower f_cost
  *  - if given node exists in closed set 
  */
-bool dist(node_t* node, node_t* curr, node_t* fin, queue_t* q, set_t* s)
+bool dist(node_t* node, node_t* curr, node_t* fin, queue_t* q, set_t* s,
+          a_star_stats_t* stats)
 {
     double h_cost = h_calc(node, fin);
+    STAT_INC(stats, heuristic_evals);
     double g_cost = h_calc(curr, node) + curr->g_cost;
     double f_cost = h_cost + g_cost;
 
@@ -187,6 +363,7 @@ bool dist(node_t* node, node_t* curr, node_t* fin, queue_t* q, set_t* s)
             return true;
         }else{
             queue_change_priority(q, node->node_num, f_cost);
+            STAT_INC(stats, decrease_keys);
         }
     }
 
@@ -201,16 +378,36 @@ bool dist(node_t* node, node_t* curr, node_t* fin, queue_t* q, set_t* s)
     return false;
 }
 
-/* a_star: performs A* search
+/* a_star_run: performs A* search, optionally recording statistics
  *
- * graph: the graph
- * start_node_num: the staring node number
- * end_node_num: the ending node number
+ * Inputs: 
+ * - graph: the graph (graph_t*)
+ * - start_node_num: the staring node number (int)
+ * - end_node_num: the ending node number (int)
+ * - stats: search statistics to fill in, may be NULL (a_star_stats_t*)
+ * - expand: callback invoked per expansion, may be NULL (a_star_expand_fn)
+ * - data: passed through to expand (void*)
  * 
- * Returns: the distance of the path between the start node and end node
- */ 
-double a_star(graph_t *graph, int start_node_num, int end_node_num)
+ * Output: the distance of the path between the start node and end node,
+ * -1 if there is no path (double)
+ */
+static double a_star_run(graph_t *graph, int start_node_num, int end_node_num,
+                         a_star_stats_t *stats, a_star_expand_fn expand,
+                         void *data)
 {
+#ifdef A_STAR_STATS
+    struct timespec t_start, t_end;
+    long open_size = 1;
+    if(stats){
+        *stats = (a_star_stats_t){0};
+        timespec_get(&t_start, TIME_UTC);
+    }
+#else
+    (void)stats;
+    (void)expand;
+    (void)data;
+#endif
+
     queue_t* q = queue_create();
     set_t* s = set_create();
    
@@ -220,26 +417,54 @@ double a_star(graph_t *graph, int start_node_num, int end_node_num)
     node_t* curr = graph->nodes[start_node_num];
     node_t* final = graph->nodes[end_node_num];
 
-    queue_add(q, start_node_num, h_calc(curr, final));
+    // costs left over from an earlier search must not leak into this one
+    curr->g_cost = 0;
+    curr->h_cost = h_calc(curr, final);
+    curr->f_cost = curr->h_cost;
+
+    queue_add(q, start_node_num, curr->f_cost);
+    STAT_INC(stats, heuristic_evals);
+    STAT_INC(stats, pushes);
+    STAT_MAX(stats, max_open_size, open_size);
 
     while(!queue_is_empty(q)){
         curr = graph->nodes[queue_remove(q)];
+#ifdef A_STAR_STATS
+        open_size--;
+#endif
+        // duplicates of expanded nodes are left behind in the queue
+        if(set_query(s, curr->node_num)){
+            STAT_INC(stats, stale_pops);
+            continue;
+        }
         if(curr->node_num == end_node_num){
             breakbool = true;
             break;
         }
 
+        STAT_INC(stats, nodes_expanded);
+#ifdef A_STAR_STATS
+        if(expand){
+            expand(curr, data);
+        }
+#endif
+
         neighbor_pt = curr->neighbors;
 
         while(neighbor_pt){
             neighbor = graph->nodes[neighbor_pt->num];
-            if(dist(neighbor, curr, final, q, s)){
+            if(dist(neighbor, curr, final, q, s, stats)){
                 neighbor_pt = neighbor_pt->next;
                 continue;
             }
 
             neighbor->parent = curr;
             queue_add(q, neighbor_pt->num, neighbor->f_cost);
+            STAT_INC(stats, pushes);
+#ifdef A_STAR_STATS
+            open_size++;
+            STAT_MAX(stats, max_open_size, open_size);
+#endif
             neighbor_pt = neighbor_pt->next;
         }
         
@@ -249,9 +474,1230 @@ double a_star(graph_t *graph, int start_node_num, int end_node_num)
     set_free(s);
     queue_free(q);
 
+#ifdef A_STAR_STATS
+    if(stats){
+        timespec_get(&t_end, TIME_UTC);
+        stats->wall_time = (t_end.tv_sec - t_start.tv_sec)
+                         + (t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+    }
+#endif
+
     if(breakbool){
         return curr->g_cost;
     }else{    
         return -1;
     }
-}
\ No newline at end of file
+}
+
+/* a_star: performs A* search
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * 
+ * Returns: the distance of the path between the start node and end node
+ */ 
+double a_star(graph_t *graph, int start_node_num, int end_node_num)
+{
+    return a_star_run(graph, start_node_num, end_node_num, NULL, NULL, NULL);
+}
+
+/* a_star_traced: performs A* search and reports search statistics
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * stats: filled in with search statistics, may be NULL
+ * expand: called once for every expanded node, may be NULL
+ * data: passed through to expand
+ * 
+ * Returns: the distance of the path between the start node and end node
+ */ 
+double a_star_traced(graph_t *graph, int start_node_num, int end_node_num,
+                     a_star_stats_t *stats, a_star_expand_fn expand, void *data)
+{
+#ifndef A_STAR_STATS
+    if(stats){
+        *stats = (a_star_stats_t){0};
+    }
+#endif
+    return a_star_run(graph, start_node_num, end_node_num, stats, expand, data);
+}
+
+/********* SEARCH CONTEXTS *********/
+
+#define WORD_BITS 64
+
+// returned by ctx_search when it runs out of expansions
+#define PAUSED (-2)
+
+struct search_ctx {
+    int capacity;
+
+    // valid only for nodes in seen
+    double *g_cost;
+    int *parent;
+
+    uint64_t *seen;
+    uint64_t *closed;
+
+    // nodes in seen, so a reset only clears what the search used
+    int *touched;
+    int num_touched;
+
+    heap_t *open;
+
+    // nodes and edges excluded for this search, may be NULL
+    const search_mask_t *mask;
+
+    // neighbors of skip_from that the search must not step to
+    int skip_from;
+    const int *skip;
+    int num_skip;
+
+    // a search run by search_step, see search_begin
+    graph_t *graph;
+    targets_t *goal;
+    search_status_t status;
+
+    search_ctx_t *next;
+};
+
+struct search_pool {
+    pthread_mutex_t lock;
+    search_ctx_t *free;
+};
+
+struct search_mask {
+    int num_nodes;
+    int num_edges;
+    uint64_t *nodes;
+    uint64_t *edges;
+};
+
+/* search_pool_create: create an empty pool of search contexts
+ *
+ * Output: the pool (search_pool_t*)
+ */
+static search_pool_t *search_pool_create()
+{
+    search_pool_t *pool = (search_pool_t*)malloc(sizeof(search_pool_t));
+    if(pool == NULL){
+        fprintf(stderr, "search_pool_create: malloc failed\n");
+        exit(5);
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->free = NULL;
+    return pool;
+}
+
+/* search_ctx_create: create a search context for a graph
+ *
+ * Inputs: 
+ * - graph: the graph (graph_t*)
+ * 
+ * Output: the search context (search_ctx_t*)
+ */
+static search_ctx_t *search_ctx_create(graph_t *graph)
+{
+    int n = graph->num_nodes;
+    int words = n / WORD_BITS + 1;
+
+    search_ctx_t *ctx = (search_ctx_t*)malloc(sizeof(search_ctx_t));
+    if(ctx == NULL){
+        fprintf(stderr, "search_ctx_create: malloc failed\n");
+        exit(5);
+    }
+    ctx->capacity = n;
+    ctx->g_cost = (double*)malloc(sizeof(double) * (n + 1));
+    ctx->parent = (int*)malloc(sizeof(int) * (n + 1));
+    ctx->seen = (uint64_t*)calloc(words, sizeof(uint64_t));
+    ctx->closed = (uint64_t*)calloc(words, sizeof(uint64_t));
+    ctx->touched = (int*)malloc(sizeof(int) * (n + 1));
+    if(!ctx->g_cost || !ctx->parent || !ctx->seen || !ctx->closed || !ctx->touched){
+        fprintf(stderr, "search_ctx_create - arrays: malloc failed\n");
+        exit(5);
+    }
+    ctx->num_touched = 0;
+    ctx->open = heap_create(64);
+    ctx->mask = NULL;
+    ctx->skip_from = -1;
+    ctx->skip = NULL;
+    ctx->num_skip = 0;
+    ctx->graph = graph;
+    ctx->goal = NULL;
+    ctx->status = SEARCH_UNREACHABLE;
+    ctx->next = NULL;
+
+    return ctx;
+}
+
+/* search_ctx_reset: forget the previous search
+ *
+ * Inputs: 
+ * - ctx: the search context (search_ctx_t*)
+ * 
+ * Output: none. function is void.
+ */
+static void search_ctx_reset(search_ctx_t *ctx)
+{
+    for(int i = 0; i < ctx->num_touched; i++){
+        bit_clear(ctx->seen, ctx->touched[i]);
+        bit_clear(ctx->closed, ctx->touched[i]);
+    }
+    ctx->num_touched = 0;
+    heap_clear(ctx->open);
+    ctx->mask = NULL;
+    ctx->skip_from = -1;
+    ctx->skip = NULL;
+    ctx->num_skip = 0;
+    if(ctx->goal){
+        targets_free(ctx->goal);
+        ctx->goal = NULL;
+    }
+}
+
+/* search_ctx_free: free a search context
+ *
+ * Inputs: 
+ * - ctx: the search context (search_ctx_t*)
+ * 
+ * Output: none. function is void.
+ */
+static void search_ctx_free(search_ctx_t *ctx)
+{
+    free(ctx->g_cost);
+    free(ctx->parent);
+    free(ctx->seen);
+    free(ctx->closed);
+    free(ctx->touched);
+    heap_free(ctx->open);
+    free(ctx);
+}
+
+/* search_pool_free: free a pool and the contexts in it
+ *
+ * Inputs: 
+ * - pool: the pool (search_pool_t*)
+ * 
+ * Output: none. function is void.
+ */
+static void search_pool_free(search_pool_t *pool)
+{
+    search_ctx_t *ctx = pool->free;
+    while(ctx){
+        search_ctx_t *next = ctx->next;
+        search_ctx_free(ctx);
+        ctx = next;
+    }
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+/* search_ctx_acquire: take a search context from the graph's pool,
+ *     creating one if the pool is empty. Thread-safe.
+ *
+ * graph: the graph
+ * 
+ * Returns: a reset search context
+ */ 
+search_ctx_t *search_ctx_acquire(graph_t *graph)
+{
+    search_pool_t *pool = graph->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    search_ctx_t *ctx = pool->free;
+    if(ctx){
+        pool->free = ctx->next;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if(ctx == NULL){
+        ctx = search_ctx_create(graph);
+    }
+    ctx->next = NULL;
+    return ctx;
+}
+
+/* search_ctx_release: return a search context to the graph's pool. 
+ *     Thread-safe.
+ *
+ * graph: the graph the context was acquired from
+ * ctx: the search context
+ */ 
+void search_ctx_release(graph_t *graph, search_ctx_t *ctx)
+{
+    search_pool_t *pool = graph->pool;
+    search_ctx_reset(ctx);
+
+    pthread_mutex_lock(&pool->lock);
+    ctx->next = pool->free;
+    pool->free = ctx;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* ctx_open: offer a path to a node, opening it if it is cheaper than
+ *     any path seen so far
+ *
+ * Inputs: 
+ * - ctx: the search context (search_ctx_t*)
+ * - node_num: the node (int)
+ * - g_cost: cost of the offered path (double)
+ * - parent: previous node on the offered path (int)
+ * - h_cost: heuristic estimate from node_num to the goal (double)
+ * 
+ * Output: none. function is void.
+ */
+static inline void ctx_open(search_ctx_t *ctx, int node_num, double g_cost,
+                            int parent, double h_cost)
+{
+    if(!bit_get(ctx->seen, node_num)){
+        bit_set(ctx->seen, node_num);
+        ctx->touched[ctx->num_touched++] = node_num;
+    }else if(g_cost >= ctx->g_cost[node_num]){
+        return;
+    }
+    ctx->g_cost[node_num] = g_cost;
+    ctx->parent[node_num] = parent;
+    heap_push(ctx->open, node_num, g_cost + h_cost);
+}
+
+/* ctx_skipped: determines whether the step from skip_from to a node
+ *     is excluded
+ *
+ * Inputs: 
+ * - ctx: the search context (search_ctx_t*)
+ * - node_num: the neighbor of skip_from (int)
+ * 
+ * Output: true if the step is excluded, false otherwise (bool)
+ */
+static bool ctx_skipped(search_ctx_t *ctx, int node_num)
+{
+    for(int i = 0; i < ctx->num_skip; i++){
+        if(ctx->skip[i] == node_num){
+            return true;
+        }
+    }
+    return false;
+}
+
+/* mask_excludes: determines whether a mask excludes stepping along a
+ *     neighbor list entry
+ *
+ * Inputs: 
+ * - mask: the search mask (const search_mask_t*)
+ * - nb: the neighbor list entry (intlist_t*)
+ * 
+ * Output: true if the edge or the neighbor is excluded (bool)
+ */
+static inline bool mask_excludes(const search_mask_t *mask, intlist_t *nb)
+{
+    // edges added after the mask was created are never excluded
+    return bit_get(mask->nodes, nb->num) ||
+           (nb->edge_num < mask->num_edges && bit_get(mask->edges, nb->edge_num));
+}
+
+/********* TARGET SETS *********/
+
+typedef struct target target_t;
+
+struct target {
+    double longitude;
+    double latitude;
+};
+
+// goals of a search, with their coordinates sorted by longitude so the
+// nearest one to a point can be found without scanning all of them
+struct targets {
+    int num_targets;
+    int *nums;          // sorted node numbers, for membership
+    target_t *coords;   // sorted by longitude
+};
+
+/* Helpers for targets_create below:
+ *
+ * cmp_int, cmp_target: qsort comparators
+ */
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_target(const void *a, const void *b)
+{
+    double x = ((const target_t*)a)->longitude;
+    double y = ((const target_t*)b)->longitude;
+    return (x > y) - (x < y);
+}
+
+/* targets_create: index a set of goal nodes
+ *
+ * Inputs: 
+ * - graph: the graph (graph_t*)
+ * - nums: the goal node numbers (const int*)
+ * - n: number of goals (int)
+ * 
+ * Output: the target set (targets_t*)
+ */
+static targets_t *targets_create(graph_t *graph, const int *nums, int n)
+{
+    targets_t *t = (targets_t*)malloc(sizeof(targets_t));
+    if(t == NULL){
+        fprintf(stderr, "targets_create: malloc failed\n");
+        exit(6);
+    }
+    t->num_targets = n;
+    t->nums = (int*)malloc(sizeof(int) * (n + 1));
+    t->coords = (target_t*)malloc(sizeof(target_t) * (n + 1));
+    if(!t->nums || !t->coords){
+        fprintf(stderr, "targets_create - arrays: malloc failed\n");
+        exit(6);
+    }
+    for(int i = 0; i < n; i++){
+        node_t *node = graph->nodes[nums[i]];
+        assert(node != NULL);
+        t->nums[i] = nums[i];
+        t->coords[i].longitude = node->longitude;
+        t->coords[i].latitude = node->latitude;
+    }
+    qsort(t->nums, n, sizeof(int), cmp_int);
+    qsort(t->coords, n, sizeof(target_t), cmp_target);
+    return t;
+}
+
+/* targets_free: free a target set
+ *
+ * Inputs: 
+ * - t: the target set (targets_t*)
+ * 
+ * Output: none. function is void.
+ */
+static void targets_free(targets_t *t)
+{
+    free(t->nums);
+    free(t->coords);
+    free(t);
+}
+
+/* targets_contains: determines whether a node is one of the targets
+ *
+ * Inputs: 
+ * - t: the target set (targets_t*)
+ * - num: node number (int)
+ * 
+ * Output: true if num is a target, false otherwise (bool)
+ */
+static bool targets_contains(const targets_t *t, int num)
+{
+    int lo = 0, hi = t->num_targets;
+    while(lo < hi){
+        int mid = (lo + hi) / 2;
+        if(t->nums[mid] < num){
+            lo = mid + 1;
+        }else{
+            hi = mid;
+        }
+    }
+    return lo < t->num_targets && t->nums[lo] == num;
+}
+
+/* targets_h: distance from a node to the nearest target, the minimum 
+ *     over targets of h_calc. Admissible and consistent like h_calc.
+ *
+ * Inputs: 
+ * - t: the target set (targets_t*)
+ * - node: the node (node_t*)
+ * 
+ * Output: the distance (double)
+ */
+static double targets_h(const targets_t *t, node_t *node)
+{
+    double x = node->longitude;
+    double y = node->latitude;
+
+    // first target at or right of x
+    int lo = 0, hi = t->num_targets;
+    while(lo < hi){
+        int mid = (lo + hi) / 2;
+        if(t->coords[mid].longitude < x){
+            lo = mid + 1;
+        }else{
+            hi = mid;
+        }
+    }
+
+    // sweep outwards, stopping once the longitude gap alone is too big
+    double best = INFINITY;
+    for(int i = lo; i < t->num_targets; i++){
+        double dx = t->coords[i].longitude - x;
+        if(dx * dx >= best){
+            break;
+        }
+        double dy = t->coords[i].latitude - y;
+        if(dx * dx + dy * dy < best){
+            best = dx * dx + dy * dy;
+        }
+    }
+    for(int i = lo - 1; i >= 0; i--){
+        double dx = x - t->coords[i].longitude;
+        if(dx * dx >= best){
+            break;
+        }
+        double dy = t->coords[i].latitude - y;
+        if(dx * dx + dy * dy < best){
+            best = dx * dx + dy * dy;
+        }
+    }
+    return sqrt(best);
+}
+
+/* ctx_search: best-first search from the nodes already opened in ctx
+ *
+ * Inputs: 
+ * - graph: the graph (graph_t*)
+ * - ctx: the search context (search_ctx_t*)
+ * - goals: the search stops at the first of these it settles, NULL to
+ *   settle every node within budget (const targets_t*)
+ * - budget: paths costing more than this are not followed (double)
+ * - max_expansions: the search pauses after expanding this many nodes,
+ *   and can be continued by calling ctx_search again (long)
+ * 
+ * Output: the goal that was reached, -1 if none was, PAUSED if the
+ * search stopped after max_expansions (int)
+ */
+static int ctx_search(graph_t *graph, search_ctx_t *ctx, const targets_t *goals,
+                      double budget, long max_expansions)
+{
+    long expanded = 0;
+    while(!heap_is_empty(ctx->open)){
+        if(expanded == max_expansions){
+            return PAUSED;
+        }
+        int curr_num = heap_pop(ctx->open, NULL);
+        if(bit_get(ctx->closed, curr_num)){
+            continue;
+        }
+        bit_set(ctx->closed, curr_num);
+        if(goals && targets_contains(goals, curr_num)){
+            return curr_num;
+        }
+        expanded++;
+
+        node_t *curr = graph->nodes[curr_num];
+        double g_cost = ctx->g_cost[curr_num];
+        bool skipping = curr_num == ctx->skip_from;
+
+        for(intlist_t *nb = curr->neighbors; nb; nb = nb->next){
+            if(bit_get(ctx->closed, nb->num)){
+                continue;
+            }
+            if(skipping && ctx_skipped(ctx, nb->num)){
+                continue;
+            }
+            if(ctx->mask && mask_excludes(ctx->mask, nb)){
+                continue;
+            }
+            node_t *neighbor = graph->nodes[nb->num];
+            double ng = g_cost + h_calc(curr, neighbor);
+            if(ng > budget){
+                continue;
+            }
+            ctx_open(ctx, nb->num, ng, curr_num, 
+                     goals ? targets_h(goals, neighbor) : 0);
+        }
+    }
+
+    return -1;
+}
+
+/* search_ctx_exclude: keep a node out of the next search on a context
+ *
+ * ctx: the search context
+ * node_num: the node to exclude
+ */ 
+void search_ctx_exclude(search_ctx_t *ctx, int node_num)
+{
+    assert(node_num >= 0 && node_num < ctx->capacity);
+
+    // an excluded node is a closed node that was never opened
+    if(!bit_get(ctx->seen, node_num)){
+        bit_set(ctx->seen, node_num);
+        ctx->touched[ctx->num_touched++] = node_num;
+    }
+    ctx->g_cost[node_num] = INFINITY;
+    ctx->parent[node_num] = -1;
+    bit_set(ctx->closed, node_num);
+}
+
+/* search_ctx_a_star: performs A* search on a search context
+ *
+ * graph: the graph
+ * ctx: the search context, acquired from graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * skip: neighbors of the start node the path must not continue to,
+ *     may be NULL
+ * num_skip: number of entries in skip
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */ 
+double search_ctx_a_star(graph_t *graph, search_ctx_t *ctx, int start_node_num,
+                         int end_node_num, const int *skip, int num_skip)
+{
+    assert(graph->nodes[start_node_num] != NULL);
+    assert(!bit_get(ctx->closed, start_node_num));
+
+    if(ctx->mask && (bit_get(ctx->mask->nodes, start_node_num) || 
+                     bit_get(ctx->mask->nodes, end_node_num))){
+        return -1;
+    }
+
+    targets_t *goal = targets_create(graph, &end_node_num, 1);
+    ctx->skip_from = start_node_num;
+    ctx->skip = skip;
+    ctx->num_skip = skip ? num_skip : 0;
+
+    ctx_open(ctx, start_node_num, 0, -1, 
+             targets_h(goal, graph->nodes[start_node_num]));
+    int found = ctx_search(graph, ctx, goal, INFINITY, LONG_MAX);
+    targets_free(goal);
+
+    return found >= 0 ? ctx->g_cost[found] : -1;
+}
+
+/* search_ctx_path: the path to a node found by the last search on ctx
+ *
+ * ctx: the search context
+ * end_node_num: the node the path leads to, it must have been reached
+ * path: set to a new array with the node numbers from the start to
+ *     end_node_num, to be freed by the caller
+ * 
+ * Returns: the number of nodes on the path
+ */ 
+int search_ctx_path(search_ctx_t *ctx, int end_node_num, int **path)
+{
+    assert(bit_get(ctx->seen, end_node_num));
+
+    int len = 0;
+    for(int v = end_node_num; v >= 0; v = ctx->parent[v]){
+        len++;
+    }
+
+    int *nodes = (int*)malloc(sizeof(int) * len);
+    if(nodes == NULL){
+        fprintf(stderr, "search_ctx_path: malloc failed\n");
+        exit(5);
+    }
+    int i = len;
+    for(int v = end_node_num; v >= 0; v = ctx->parent[v]){
+        nodes[--i] = v;
+    }
+
+    *path = nodes;
+    return len;
+}
+
+/********* RESUMABLE SEARCH *********/
+
+/* search_begin: start an A* search that runs in slices, see search_step
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * 
+ * Returns: a search context from the graph's pool holding the search,
+ *     to be released with search_end
+ */ 
+search_ctx_t *search_begin(graph_t *graph, int start_node_num, int end_node_num)
+{
+    assert(graph->nodes[start_node_num] != NULL);
+    search_ctx_t *ctx = search_ctx_acquire(graph);
+
+    ctx->graph = graph;
+    ctx->goal = targets_create(graph, &end_node_num, 1);
+    ctx->status = SEARCH_IN_PROGRESS;
+    ctx_open(ctx, start_node_num, 0, -1, 
+             targets_h(ctx->goal, graph->nodes[start_node_num]));
+    return ctx;
+}
+
+/* search_step: continue a search started by search_begin
+ *
+ * ctx: the search context
+ * max_expansions: the most nodes to expand before returning, at least 1
+ * 
+ * Returns: SEARCH_IN_PROGRESS if the search needs more steps, otherwise
+ *     whether it found the end node. Once the search is over, further
+ *     steps return the same.
+ */ 
+search_status_t search_step(search_ctx_t *ctx, long max_expansions)
+{
+    assert(max_expansions > 0);
+    if(ctx->status != SEARCH_IN_PROGRESS){
+        return ctx->status;
+    }
+
+    int found = ctx_search(ctx->graph, ctx, ctx->goal, INFINITY, max_expansions);
+    if(found >= 0){
+        ctx->status = SEARCH_FOUND;
+    }else if(found == -1){
+        ctx->status = SEARCH_UNREACHABLE;
+    }
+    return ctx->status;
+}
+
+/* search_result: the outcome of a search run by search_step
+ *
+ * ctx: the search context
+ * path: set to a new array with the node numbers from the start to the
+ *     end, to be freed by the caller, NULL if there is no path. May be
+ *     NULL when the path is not needed.
+ * path_len: set to the number of nodes on the path, 0 if there is no
+ *     path, may be NULL
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path or the search is still in progress
+ */ 
+double search_result(search_ctx_t *ctx, int **path, int *path_len)
+{
+    bool found = ctx->status == SEARCH_FOUND;
+    int end_node_num = found ? ctx->goal->nums[0] : -1;
+
+    int len = 0;
+    if(path){
+        *path = NULL;
+        if(found){
+            len = search_ctx_path(ctx, end_node_num, path);
+        }
+    }else if(found){
+        for(int v = end_node_num; v >= 0; v = ctx->parent[v]){
+            len++;
+        }
+    }
+    if(path_len){
+        *path_len = len;
+    }
+    return found ? ctx->g_cost[end_node_num] : -1;
+}
+
+/* search_end: release the context of a search started by search_begin,
+ *     finished or not
+ *
+ * ctx: the search context
+ */ 
+void search_end(search_ctx_t *ctx)
+{
+    search_ctx_release(ctx->graph, ctx);
+}
+
+/********* REACHABILITY *********/
+
+/* reachable_within: finds every node whose shortest path from the
+ *     start node costs at most budget
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * budget: the largest path cost to include
+ * out: filled with the node numbers found, in order of increasing cost,
+ *     starting with start_node_num
+ * n: on input the number of entries out can hold, on return the number
+ *     of nodes found. Only the first (input) *n nodes are written.
+ */ 
+void reachable_within(graph_t *graph, int start_node_num, double budget,
+                      int *out, size_t *n)
+{
+    assert(graph->nodes[start_node_num] != NULL);
+    search_ctx_t *ctx = search_ctx_acquire(graph);
+
+    if(budget >= 0){
+        ctx_open(ctx, start_node_num, 0, -1, 0);
+        ctx_search(graph, ctx, NULL, budget, LONG_MAX);
+    }
+
+    // paths over budget are never opened, so every touched node was
+    // settled within it. They are touched in discovery order, sort them.
+    size_t found = 0;
+    for(int i = 0; i < ctx->num_touched; i++){
+        int v = ctx->touched[i];
+        heap_push(ctx->open, v, ctx->g_cost[v]);
+    }
+    while(!heap_is_empty(ctx->open)){
+        int v = heap_pop(ctx->open, NULL);
+        if(found < *n){
+            out[found] = v;
+        }
+        found++;
+    }
+    *n = found;
+
+    search_ctx_release(graph, ctx);
+}
+
+/********* NEAREST TARGET *********/
+
+/* a_star_nearest: performs one A* search towards a set of targets,
+ *     stopping at the first target it settles
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * targets: the target node numbers
+ * n: number of targets
+ * which: set to the nearest target, -1 if none is reachable, may be NULL
+ * 
+ * Returns: the distance of the path to the nearest target, -1 if no
+ *     target is reachable
+ */ 
+double a_star_nearest(graph_t *graph, int start_node_num, const int *targets,
+                      int n, int *which)
+{
+    assert(graph->nodes[start_node_num] != NULL);
+
+    double cost = -1;
+    int found = -1;
+
+    if(n > 0){
+        targets_t *goals = targets_create(graph, targets, n);
+        search_ctx_t *ctx = search_ctx_acquire(graph);
+
+        ctx_open(ctx, start_node_num, 0, -1, 
+                 targets_h(goals, graph->nodes[start_node_num]));
+        found = ctx_search(graph, ctx, goals, INFINITY, LONG_MAX);
+        if(found >= 0){
+            cost = ctx->g_cost[found];
+        }
+
+        search_ctx_release(graph, ctx);
+        targets_free(goals);
+    }
+
+    if(which){
+        *which = found;
+    }
+    return cost;
+}
+
+/********* SEARCH MASKS *********/
+
+/* mask_create: create an empty search mask for a graph
+ *
+ * graph: the graph
+ * 
+ * Returns: a mask that excludes nothing
+ */ 
+search_mask_t *mask_create(graph_t *graph)
+{
+    search_mask_t *mask = (search_mask_t*)malloc(sizeof(search_mask_t));
+    if(mask == NULL){
+        fprintf(stderr, "mask_create: malloc failed\n");
+        exit(7);
+    }
+    mask->num_nodes = graph->num_nodes;
+    mask->num_edges = graph->num_edges;
+    mask->nodes = (uint64_t*)calloc(mask->num_nodes / WORD_BITS + 1, sizeof(uint64_t));
+    mask->edges = (uint64_t*)calloc(mask->num_edges / WORD_BITS + 1, sizeof(uint64_t));
+    if(!mask->nodes || !mask->edges){
+        fprintf(stderr, "mask_create - bits: calloc failed\n");
+        exit(7);
+    }
+    return mask;
+}
+
+/* mask_exclude_node: exclude a node from searches using the mask
+ *
+ * mask: the search mask
+ * node_num: the node
+ */ 
+void mask_exclude_node(search_mask_t *mask, int node_num)
+{
+    assert(node_num >= 0 && node_num < mask->num_nodes);
+    bit_set(mask->nodes, node_num);
+}
+
+/* mask_exclude_edge: exclude every edge between two nodes from searches
+ *     using the mask
+ *
+ * mask: the search mask
+ * graph: the graph the mask was created for
+ * node_num1: the first node
+ * node_num2: the second node
+ */ 
+void mask_exclude_edge(search_mask_t *mask, graph_t *graph, int node_num1, 
+                       int node_num2)
+{
+    for(intlist_t *nb = graph->nodes[node_num1]->neighbors; nb; nb = nb->next){
+        if(nb->num == node_num2 && nb->edge_num < mask->num_edges){
+            bit_set(mask->edges, nb->edge_num);
+        }
+    }
+    // one-way arcs back from node_num2 are only in its own list
+    for(intlist_t *nb = graph->nodes[node_num2]->neighbors; nb; nb = nb->next){
+        if(nb->num == node_num1 && nb->edge_num < mask->num_edges){
+            bit_set(mask->edges, nb->edge_num);
+        }
+    }
+}
+
+/* mask_clear: stop excluding anything
+ *
+ * mask: the search mask
+ */ 
+void mask_clear(search_mask_t *mask)
+{
+    memset(mask->nodes, 0, sizeof(uint64_t) * (mask->num_nodes / WORD_BITS + 1));
+    memset(mask->edges, 0, sizeof(uint64_t) * (mask->num_edges / WORD_BITS + 1));
+}
+
+/* mask_free: free a search mask
+ *
+ * mask: the search mask
+ */ 
+void mask_free(search_mask_t *mask)
+{
+    free(mask->nodes);
+    free(mask->edges);
+    free(mask);
+}
+
+/* mask_hash: hash of what a mask excludes, to tell masks apart without
+ *     comparing them
+ *
+ * mask: the search mask, NULL for none
+ * 
+ * Returns: the hash, 0 for NULL and for masks that exclude nothing
+ */ 
+unsigned long mask_hash(const search_mask_t *mask)
+{
+    if(mask == NULL){
+        return 0;
+    }
+
+    // empty words are skipped, so an empty mask hashes like no mask
+    uint64_t h = 0;
+    int node_words = mask->num_nodes / WORD_BITS + 1;
+    int edge_words = mask->num_edges / WORD_BITS + 1;
+    for(int w = 0; w < node_words + edge_words; w++){
+        bool edges = w >= node_words;
+        uint64_t bits = edges ? mask->edges[w - node_words] : mask->nodes[w];
+        if(bits == 0){
+            continue;
+        }
+        // splitmix64 finalizer of the word and its position
+        uint64_t pos = edges ? ~(uint64_t)(w - node_words) : (uint64_t)w;
+        uint64_t x = bits + (pos + 1) * 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        h += x ^ (x >> 31);
+    }
+    return (unsigned long)h;
+}
+
+/* search_ctx_set_mask: apply a mask to the next search on a context
+ *
+ * ctx: the search context
+ * mask: the search mask, NULL for none. It must outlive the search.
+ *     If it excludes the start or end node, there is no path.
+ */ 
+void search_ctx_set_mask(search_ctx_t *ctx, const search_mask_t *mask)
+{
+    ctx->mask = mask;
+}
+
+/* a_star_masked: performs A* search, avoiding the nodes and edges 
+ *     excluded by a mask
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * mask: the search mask, NULL for none
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path. Like a_star(), the parent fields of the
+ *     nodes on the path are set.
+ */ 
+double a_star_masked(graph_t *graph, int start_node_num, int end_node_num,
+                     const search_mask_t *mask)
+{
+    search_ctx_t *ctx = search_ctx_acquire(graph);
+    search_ctx_set_mask(ctx, mask);
+
+    double cost = search_ctx_a_star(graph, ctx, start_node_num, end_node_num,
+                                    NULL, 0);
+    if(cost >= 0){
+        for(int v = end_node_num; ctx->parent[v] >= 0; v = ctx->parent[v]){
+            graph->nodes[v]->parent = graph->nodes[ctx->parent[v]];
+        }
+    }
+
+    search_ctx_release(graph, ctx);
+    return cost;
+}
+
+/********* NAME LOOKUP *********/
+
+// strings are copied into blocks of this size, longer ones get their own
+#define NAME_BLOCK_BYTES (64 * 1024)
+
+typedef struct name_block name_block_t;
+typedef struct name_slot name_slot_t;
+
+struct name_block {
+    name_block_t *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+struct name_slot {
+    const char *name;   // NULL for an empty slot
+    uint32_t hash;
+    int node_num;       // first node created with the name
+};
+
+// every distinct name is stored once, and the hash table of stored names
+// is also the index from name to node
+struct name_pool {
+    name_block_t *blocks;   // newest first, strings never move
+    name_slot_t *slots;     // open addressing with linear probing
+    int num_slots;          // a power of two
+    int num_names;
+};
+
+/* name_hash: FNV-1a hash of a string
+ *
+ * Inputs: 
+ * - name: the string (const char*)
+ * 
+ * Output: the hash (uint32_t)
+ */
+static uint32_t name_hash(const char *name)
+{
+    uint32_t h = 2166136261u;
+    for(const unsigned char *c = (const unsigned char*)name; *c; c++){
+        h = (h ^ *c) * 16777619u;
+    }
+    return h;
+}
+
+/* name_pool_create: create an empty name pool
+ *
+ * Output: the pool (name_pool_t*)
+ */
+static name_pool_t *name_pool_create()
+{
+    name_pool_t *names = (name_pool_t*)malloc(sizeof(name_pool_t));
+    if(names == NULL){
+        fprintf(stderr, "name_pool_create: malloc failed\n");
+        exit(8);
+    }
+    names->blocks = NULL;
+    names->num_slots = 16;
+    names->num_names = 0;
+    names->slots = (name_slot_t*)calloc(names->num_slots, sizeof(name_slot_t));
+    if(names->slots == NULL){
+        fprintf(stderr, "name_pool_create - slots: calloc failed\n");
+        exit(8);
+    }
+    return names;
+}
+
+/* name_pool_free: free a name pool and its strings
+ *
+ * Inputs: 
+ * - names: the pool (name_pool_t*)
+ * 
+ * Output: none. function is void.
+ */
+static void name_pool_free(name_pool_t *names)
+{
+    name_block_t *block = names->blocks;
+    while(block){
+        name_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(names->slots);
+    free(names);
+}
+
+/* name_slot_find: the slot holding a name, or the empty slot it would go in
+ *
+ * Inputs: 
+ * - names: the pool (name_pool_t*)
+ * - name: the name (const char*)
+ * - hash: name_hash of the name (uint32_t)
+ * 
+ * Output: the slot (name_slot_t*)
+ */
+static name_slot_t *name_slot_find(name_pool_t *names, const char *name, 
+                                   uint32_t hash)
+{
+    int mask = names->num_slots - 1;
+    for(int i = hash & mask; ; i = (i + 1) & mask){
+        name_slot_t *slot = &names->slots[i];
+        if(slot->name == NULL || 
+           (slot->hash == hash && strcmp(slot->name, name) == 0)){
+            return slot;
+        }
+    }
+}
+
+/* name_store: copy a string into the pool's blocks
+ *
+ * Inputs: 
+ * - names: the pool (name_pool_t*)
+ * - name: the string (const char*)
+ * 
+ * Output: the copy, which stays valid until the pool is freed (char*)
+ */
+static char *name_store(name_pool_t *names, const char *name)
+{
+    size_t len = strlen(name) + 1;
+    name_block_t *block = names->blocks;
+    if(block == NULL || block->size - block->used < len){
+        size_t size = len > NAME_BLOCK_BYTES ? len : NAME_BLOCK_BYTES;
+        block = (name_block_t*)malloc(sizeof(name_block_t) + size);
+        if(block == NULL){
+            fprintf(stderr, "name_store: malloc failed\n");
+            exit(8);
+        }
+        block->used = 0;
+        block->size = size;
+        block->next = names->blocks;
+        names->blocks = block;
+    }
+
+    char *copy = block->data + block->used;
+    memcpy(copy, name, len);
+    block->used += len;
+    return copy;
+}
+
+/* name_intern: the pool's copy of a name, storing it the first time
+ *
+ * Inputs: 
+ * - names: the pool (name_pool_t*)
+ * - name: the name (const char*)
+ * - node_num: the node being created with the name (int)
+ * 
+ * Output: the copy (char*)
+ */
+static char *name_intern(name_pool_t *names, const char *name, int node_num)
+{
+    uint32_t hash = name_hash(name);
+    name_slot_t *slot = name_slot_find(names, name, hash);
+    if(slot->name){
+        return (char*)slot->name;
+    }
+
+    // keep the table at most half full, so probes stay short
+    if(2 * (names->num_names + 1) > names->num_slots){
+        name_slot_t *old = names->slots;
+        int old_slots = names->num_slots;
+        names->num_slots *= 2;
+        names->slots = (name_slot_t*)calloc(names->num_slots, sizeof(name_slot_t));
+        if(names->slots == NULL){
+            fprintf(stderr, "name_intern: calloc failed\n");
+            exit(8);
+        }
+        for(int i = 0; i < old_slots; i++){
+            if(old[i].name){
+                *name_slot_find(names, old[i].name, old[i].hash) = old[i];
+            }
+        }
+        free(old);
+        slot = name_slot_find(names, name, hash);
+    }
+
+    slot->name = name_store(names, name);
+    slot->hash = hash;
+    slot->node_num = node_num;
+    names->num_names++;
+    return (char*)slot->name;
+}
+
+/* graph_find_node: look up a node by its city name
+ *
+ * graph: the graph
+ * city_name: the city
+ * 
+ * Returns: the number of the first node created with that name, -1 if
+ *     there is none
+ */ 
+int graph_find_node(graph_t *graph, const char *city_name)
+{
+    name_slot_t *slot = name_slot_find(graph->names, city_name, 
+                                       name_hash(city_name));
+    return slot->name ? slot->node_num : -1;
+}
+
+/********* MEMORY REPORT *********/
+
+/* account: add allocations of one size to a component of a memory report
+ *
+ * Inputs: 
+ * - report: the report (graph_memory_t*)
+ * - component: the field of the report to add to (size_t*)
+ * - count: the number of allocations (long)
+ * - bytes: the size of each (size_t)
+ * 
+ * Output: none. function is void.
+ */
+static void account(graph_memory_t *report, size_t *component, long count, 
+                    size_t bytes)
+{
+    *component += count * bytes;
+    report->overhead += count * (malloc_bytes(bytes) - bytes);
+}
+
+/* graph_memory_report: break down the memory held by a graph
+ *
+ * graph: the graph
+ * report: filled with the bytes of each component
+ */ 
+void graph_memory_report(graph_t *graph, graph_memory_t *report)
+{
+    memset(report, 0, sizeof(graph_memory_t));
+    int n = graph->num_nodes;
+    account(report, &report->table, 1, sizeof(graph_t));
+    account(report, &report->table, 1, sizeof(node_t*) * n);
+
+    long num_nodes = 0;
+    long num_entries = 0;
+    for(int i = 0; i < n; i++){
+        if(graph->nodes[i]){
+            num_nodes++;
+            for(intlist_t *nb = graph->nodes[i]->neighbors; nb; nb = nb->next){
+                num_entries++;
+            }
+        }
+    }
+    account(report, &report->nodes, num_nodes, sizeof(node_t));
+    account(report, &report->neighbors, num_entries, sizeof(intlist_t));
+
+    name_pool_t *names = graph->names;
+    account(report, &report->names, 1, sizeof(name_pool_t));
+    account(report, &report->names, 1, sizeof(name_slot_t) * names->num_slots);
+    for(name_block_t *block = names->blocks; block; block = block->next){
+        account(report, &report->names, 1, sizeof(name_block_t) + block->size);
+    }
+
+    // a heap is two allocations, counted here as one
+    account(report, &report->search, 1, sizeof(search_pool_t));
+    pthread_mutex_lock(&graph->pool->lock);
+    for(search_ctx_t *ctx = graph->pool->free; ctx; ctx = ctx->next){
+        int cap = ctx->capacity;
+        int words = cap / WORD_BITS + 1;
+        account(report, &report->search, 1, sizeof(search_ctx_t));
+        account(report, &report->search, 1, sizeof(double) * (cap + 1));
+        account(report, &report->search, 2, sizeof(int) * (cap + 1));
+        account(report, &report->search, 2, sizeof(uint64_t) * words);
+        account(report, &report->search, 1, heap_bytes(ctx->open));
+    }
+    pthread_mutex_unlock(&graph->pool->lock);
+
+    report->total = report->table + report->nodes + report->neighbors + 
+                    report->names + report->search + report->overhead;
+}
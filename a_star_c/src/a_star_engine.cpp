@@ -0,0 +1,197 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+extern "C" {
+#include "a_star.h"
+#include "a_star_engine.h"
+}
+#include "a_star.hpp"
+
+using namespace astar;
+
+/********* DEFAULT ENGINE *********/
+
+typedef AStar<ListGraph<double>, Euclidean, BinaryHeap<double>, double> default_search_t;
+
+// the search and the graph view it reads, kept per thread between calls
+struct default_engine {
+    int num_nodes;   // the graph may since be freed, never read through it
+    ListGraph<double> graph;
+    default_search_t search;
+
+    explicit default_engine(graph_t *g)
+        : num_nodes(g->num_nodes), graph(g), search(graph) {}
+};
+
+/* a_star_engine: performs A* search with the default instantiation, on
+ *     the neighbor lists of the graph with double costs and a binary heap.
+ *     Thread-safe, each thread keeps its own search state.
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */
+extern "C" double a_star_engine(graph_t *graph, int start_node_num, int end_node_num)
+{
+    static thread_local std::unique_ptr<default_engine> engine;
+
+    // the state is sized for the graph, so a different graph needs new
+    // state. A new graph at the address of a freed one can keep it, as
+    // long as it has as many nodes.
+    if(!engine || engine->graph.graph() != graph ||
+       engine->num_nodes != graph->num_nodes){
+        engine.reset(new default_engine(graph));
+    }
+
+    double cost = engine->search.search(start_node_num, end_node_num);
+    return cost == CostTraits<double>::infinity() ? -1 : cost;
+}
+
+/********* CSR ENGINES *********/
+
+// the C handle, with one subclass per instantiation. Only the call into
+// the search is virtual, the search loop itself is fully specialized.
+struct csr_engine {
+    virtual ~csr_engine() {}
+    virtual double query(int start, int end) = 0;
+    virtual size_t bytes() const = 0;
+};
+
+template <typename CostT, typename OpenList>
+struct csr_engine_impl : csr_engine {
+    CsrGraph<CostT> graph;
+    AStar<CsrGraph<CostT>, Euclidean, OpenList, CostT> search;
+
+    csr_engine_impl(graph_t *g, double scale) : graph(g, scale), search(graph) {}
+
+    double query(int start, int end) override
+    {
+        CostT cost = search.search(start, end);
+        if(cost == CostTraits<CostT>::infinity()){
+            return -1;
+        }
+        return CostTraits<CostT>::to_double(cost, graph.scale());
+    }
+
+    size_t bytes() const override
+    {
+        return graph.bytes();
+    }
+};
+
+/* max_key: a bound on every key an integer search pushes, path cost plus
+ *     heuristic. No shortest path takes an edge twice, and no heuristic
+ *     value is longer than the diagonal of the bounding box.
+ *
+ * graph: the graph
+ * scale: cost units per unit of distance
+ *
+ * Returns: the bound in cost units
+ */
+static double max_key(graph_t *graph, double scale)
+{
+    double total = 0;
+    double min_x = INFINITY, max_x = -INFINITY, min_y = INFINITY, max_y = -INFINITY;
+    for(int u = 0; u < graph->num_nodes; u++){
+        const node_t *a = graph->nodes[u];
+        if(a == nullptr){
+            continue;
+        }
+        min_x = std::fmin(min_x, a->longitude);
+        max_x = std::fmax(max_x, a->longitude);
+        min_y = std::fmin(min_y, a->latitude);
+        max_y = std::fmax(max_y, a->latitude);
+        for(const intlist_t *nb = a->neighbors; nb; nb = nb->next){
+            const node_t *b = graph->nodes[nb->num];
+            // one unit more per edge for rounding up
+            total += straight_line(a->longitude, a->latitude, b->longitude, b->latitude) * scale + 1;
+        }
+    }
+    if(min_x > max_x){
+        return 0;
+    }
+    return total + straight_line(min_x, min_y, max_x, max_y) * scale + 1;
+}
+
+/* csr_engine_create: build a flat snapshot of a graph with edge costs
+ *     stored in the chosen cost type, and a search for it
+ *
+ * graph: the graph
+ * cost: the cost type
+ * scale: cost units per unit of distance, used by CSR_ENGINE_INT, 1 for
+ *     the others. CSR_ENGINE_INT needs the lengths of all edges plus the
+ *     diagonal of the graph's bounding box, times scale, to stay below
+ *     2^63 units, so no path cost can overflow.
+ *
+ * Returns: the engine, NULL if scale is so large that the cost of a path
+ *     could overflow CSR_ENGINE_INT costs
+ */
+extern "C" csr_engine_t *csr_engine_create(graph_t *graph, csr_engine_cost_t cost,
+                                           double scale)
+{
+    csr_engine_t *engine = nullptr;
+    switch(cost){
+    case CSR_ENGINE_DOUBLE:
+        engine = new(std::nothrow) csr_engine_impl<double, BinaryHeap<double> >(graph, 1);
+        break;
+    case CSR_ENGINE_FLOAT:
+        engine = new(std::nothrow) csr_engine_impl<float, BinaryHeap<float> >(graph, 1);
+        break;
+    case CSR_ENGINE_INT:
+        // a key of 2^63 or more would overflow int64_t, checked before the
+        // snapshot converts any edge cost
+        if(!(max_key(graph, scale) < 0x1p63)){
+            return nullptr;
+        }
+        engine = new(std::nothrow) csr_engine_impl<int64_t, RadixHeap<int64_t> >(graph, scale);
+        break;
+    }
+    if(engine == nullptr){
+        fprintf(stderr, "csr_engine_create: malloc failed\n");
+        exit(1);
+    }
+    return engine;
+}
+
+/* csr_engine_query: performs A* search on an engine. Not thread-safe.
+ *
+ * engine: the engine
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the cost of the path between the start node and end node in
+ *     units of distance, -1 if there is no path
+ */
+extern "C" double csr_engine_query(csr_engine_t *engine, int start_node_num,
+                                   int end_node_num)
+{
+    return engine->query(start_node_num, end_node_num);
+}
+
+/* csr_engine_bytes: memory used by the adjacency of an engine
+ *
+ * engine: the engine
+ *
+ * Returns: the number of bytes, offsets and edge costs included
+ */
+extern "C" size_t csr_engine_bytes(csr_engine_t *engine)
+{
+    return engine->bytes();
+}
+
+/* csr_engine_free: free an engine
+ *
+ * engine: the engine
+ */
+extern "C" void csr_engine_free(csr_engine_t *engine)
+{
+    delete engine;
+}
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "a_star.h"
+#include "apsp.h"
+#include "parallel.h"
+
+// a tile of distances takes 32 KB, three of them fit in L2
+#define TILE (64)
+
+/********* ALL-PAIRS SHORTEST PATHS *********/
+
+struct apsp {
+    graph_t *graph;
+    int num_nodes;
+    int num_tiles;
+    long stride;      // row length, num_nodes rounded up to whole tiles
+    double *dist;
+};
+
+typedef struct {
+    apsp_t *apsp;
+    int round;        // the tile row and column of the round
+} fw_t;
+
+/* relax_row: shorten the distances of one tile row through node k
+ *
+ * Inputs:
+ * - di: the row of node i within the tile (double*)
+ * - dk: the row of node k within the same tile column (const double*)
+ * - dik: the distance from node i to node k (double)
+ *
+ * Output: none. function is void.
+ */
+static inline void relax_row(double *restrict di, const double *restrict dk,
+                             double dik)
+{
+    // a branch-free minimum over rows that do not alias vectorizes
+    for(int j = 0; j < TILE; j++){
+        double nd = dik + dk[j];
+        di[j] = nd < di[j] ? nd : di[j];
+    }
+}
+
+/* tile_update: relax tile (ti, tj) through the nodes of tile round,
+ *     the Floyd-Warshall step restricted to one tile
+ *
+ * Inputs:
+ * - a: the distance matrix (apsp_t*)
+ * - ti, tj: the tile row and column (int)
+ * - round: the tile holding the intermediate nodes (int)
+ *
+ * Output: none. function is void.
+ */
+static void tile_update(apsp_t *a, int ti, int tj, int round)
+{
+    long stride = a->stride;
+    for(long k = (long)round * TILE; k < (long)(round + 1) * TILE; k++){
+        const double *dk = a->dist + k * stride + (long)tj * TILE;
+        for(long i = (long)ti * TILE; i < (long)(ti + 1) * TILE; i++){
+            double dik = a->dist[i * stride + k];
+            // row k itself cannot get shorter through k
+            if(dik == INFINITY || i == k){
+                continue;
+            }
+            relax_row(a->dist + i * stride + (long)tj * TILE, dk, dik);
+        }
+    }
+}
+
+/* Phases of a round, as tpool_range_fn over tiles:
+ *
+ * cross_tiles: the tiles in the row and column of the diagonal tile,
+ *     the first num_tiles - 1 indices for the row, the rest the column
+ * other_tiles: every tile outside that row and column
+ */
+static void cross_tiles(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    fw_t *fw = (fw_t*)arg;
+    int r = fw->round;
+    int others = fw->apsp->num_tiles - 1;
+    for(long t = lo; t < hi; t++){
+        int o = (int)(t % others);
+        o += o >= r;
+        if(t < others){
+            tile_update(fw->apsp, r, o, r);
+        }else{
+            tile_update(fw->apsp, o, r, r);
+        }
+    }
+}
+
+static void other_tiles(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    fw_t *fw = (fw_t*)arg;
+    int r = fw->round;
+    int others = fw->apsp->num_tiles - 1;
+    for(long t = lo; t < hi; t++){
+        int ti = (int)(t / others);
+        int tj = (int)(t % others);
+        ti += ti >= r;
+        tj += tj >= r;
+        tile_update(fw->apsp, ti, tj, r);
+    }
+}
+
+/* apsp_create: compute the distance between every pair of nodes
+ *
+ * graph: the graph
+ * num_threads: number of worker threads, 0 for one per core
+ *
+ * Returns: the distance matrix, which takes 8 bytes for every pair of
+ *     nodes
+ */
+apsp_t *apsp_create(graph_t *graph, int num_threads)
+{
+    int n = graph->num_nodes;
+
+    apsp_t *a = (apsp_t*)malloc(sizeof(apsp_t));
+    if(a == NULL){
+        fprintf(stderr, "apsp_create: malloc failed\n");
+        exit(1);
+    }
+    a->graph = graph;
+    a->num_nodes = n;
+    a->num_tiles = n / TILE + (n % TILE != 0);
+    a->num_tiles = a->num_tiles > 0 ? a->num_tiles : 1;
+    a->stride = (long)a->num_tiles * TILE;
+
+    size_t cells = (size_t)a->stride * a->stride;
+    a->dist = (double*)aligned_alloc(64, sizeof(double) * cells);
+    if(a->dist == NULL){
+        fprintf(stderr, "apsp_create - matrix: malloc failed\n");
+        exit(1);
+    }
+    for(size_t c = 0; c < cells; c++){
+        a->dist[c] = INFINITY;
+    }
+
+    // padding nodes have no edges, so they never shorten a path
+    for(long v = 0; v < a->stride; v++){
+        a->dist[v * a->stride + v] = 0;
+    }
+    for(int u = 0; u < n; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next){
+            double cost = h_calc(graph->nodes[u], graph->nodes[nb->num]);
+            long c = (long)u * a->stride + nb->num;
+            if(cost < a->dist[c]){
+                a->dist[c] = cost;
+            }
+        }
+    }
+
+    tpool_t *pool = tpool_create(num_threads);
+    fw_t fw;
+    fw.apsp = a;
+    int others = a->num_tiles - 1;
+    for(fw.round = 0; fw.round < a->num_tiles; fw.round++){
+        // the row and column tiles need the diagonal tile, and every
+        // other tile needs the row and column tiles
+        tile_update(a, fw.round, fw.round, fw.round);
+        tpool_for(pool, 2L * others, 1, cross_tiles, &fw);
+        tpool_for(pool, (long)others * others, 1, other_tiles, &fw);
+    }
+    tpool_free(pool);
+
+    return a;
+}
+
+/********* QUERIES *********/
+
+/* apsp_query: look up the distance between two nodes
+ *
+ * apsp: the distance matrix
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the distance of the path between the start node and end node,
+ *     like a_star, -1 if there is no path
+ */
+double apsp_query(apsp_t *apsp, int start_node_num, int end_node_num)
+{
+    double d = apsp->dist[(long)start_node_num * apsp->stride + end_node_num];
+    return d == INFINITY ? -1 : d;
+}
+
+/* apsp_path: read back a shortest path between two nodes
+ *
+ * apsp: the distance matrix
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * path: set to a new array with the node numbers from the start to the
+ *     end, to be freed by the caller, NULL if there is no path
+ *
+ * Returns: the number of nodes on the path, 0 if there is no path
+ */
+int apsp_path(apsp_t *apsp, int start_node_num, int end_node_num, int **path)
+{
+    *path = NULL;
+    long stride = apsp->stride;
+    if(apsp->dist[(long)start_node_num * stride + end_node_num] == INFINITY){
+        return 0;
+    }
+
+    int *nodes = (int*)malloc(sizeof(int) * (apsp->num_nodes + 1));
+    if(nodes == NULL){
+        fprintf(stderr, "apsp_path: malloc failed\n");
+        exit(1);
+    }
+
+    // the next node is the neighbor that leaves the least distance to go,
+    // and a shortest path visits every node at most once
+    graph_t *graph = apsp->graph;
+    int len = 0;
+    int curr = start_node_num;
+    nodes[len++] = curr;
+    while(curr != end_node_num && len <= apsp->num_nodes){
+        int best = -1;
+        double best_dist = INFINITY;
+        for(intlist_t *nb = graph->nodes[curr]->neighbors; nb; nb = nb->next){
+            double d = h_calc(graph->nodes[curr], graph->nodes[nb->num]) +
+                       apsp->dist[(long)nb->num * stride + end_node_num];
+            if(d < best_dist){
+                best_dist = d;
+                best = nb->num;
+            }
+        }
+        curr = best;
+        nodes[len++] = curr;
+    }
+
+    *path = nodes;
+    return len;
+}
+
+/* apsp_free: free a distance matrix
+ *
+ * apsp: the distance matrix
+ */
+void apsp_free(apsp_t *apsp)
+{
+    free(apsp->dist);
+    free(apsp);
+}
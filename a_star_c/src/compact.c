@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "util.h"
+#include "a_star.h"
+#include "compact.h"
+
+/********* COMPACT GRAPH *********/
+
+#define NO_NAME (UINT32_MAX)
+
+struct compact {
+    int num_nodes;
+    long num_entries;
+
+    // coordinate = origin + fixed * step
+    double origin_lat;
+    double origin_lon;
+    double step;
+    uint32_t *lat;
+    uint32_t *lon;
+    uint64_t *exists;
+
+    // node u's neighbors are nbr[off[u]] .. nbr[off[u + 1]]
+    uint32_t *off;
+    int32_t *nbr;
+
+    // node u's name starts at names[name_off[u]], NO_NAME if it has none
+    uint32_t *name_off;
+    char *names;
+    size_t names_bytes;
+};
+
+/* to_fixed: round a coordinate to the fixed-point grid
+ *
+ * Inputs:
+ * - x: the coordinate (double)
+ * - origin: the smallest coordinate on its axis (double)
+ * - step: the grid step (double)
+ *
+ * Output: the fixed-point coordinate (uint32_t)
+ */
+static uint32_t to_fixed(double x, double origin, double step)
+{
+    double f = step > 0 ? round((x - origin) / step) : 0;
+    return f > UINT32_MAX ? UINT32_MAX : (uint32_t)f;
+}
+
+/* name_put: copy a name into the string pool
+ *
+ * Inputs:
+ * - cg: the compact graph, with room for the name (compact_t*)
+ * - name: the name (const char*)
+ *
+ * Output: the offset of the copy (uint32_t)
+ */
+static uint32_t name_put(compact_t *cg, const char *name)
+{
+    size_t len = strlen(name) + 1;
+    uint32_t pos = (uint32_t)cg->names_bytes;
+    memcpy(cg->names + pos, name, len);
+    cg->names_bytes += len;
+    return pos;
+}
+
+/* name_owner: the node whose copy of a name a compact graph keeps, the
+ *     first node created with it, which graph_find_node finds
+ *
+ * Inputs:
+ * - graph: the graph (graph_t*)
+ * - node: a node with a name (node_t*)
+ *
+ * Output: the owner's number, node's own number if the first node
+ *     created with the name has been replaced since (int)
+ */
+static int name_owner(graph_t *graph, node_t *node)
+{
+    int owner = graph_find_node(graph, node->city_name);
+    if(owner < 0 || !graph->nodes[owner] ||
+       graph->nodes[owner]->city_name != node->city_name){
+        return node->node_num;
+    }
+    return owner;
+}
+
+/* compact_create: build a compact snapshot of a graph
+ *
+ * graph: the graph, with fewer than 2^32 neighbor list entries
+ *
+ * Returns: the compact graph
+ */
+compact_t *compact_create(graph_t *graph)
+{
+    int n = graph->num_nodes;
+    int words = n / 64 + 1;
+
+    compact_t *cg = (compact_t*)malloc(sizeof(compact_t));
+    if(cg == NULL){
+        fprintf(stderr, "compact_create: malloc failed\n");
+        exit(1);
+    }
+    cg->num_nodes = n;
+    cg->lat = (uint32_t*)malloc(sizeof(uint32_t) * (n + 1));
+    cg->lon = (uint32_t*)malloc(sizeof(uint32_t) * (n + 1));
+    cg->exists = (uint64_t*)calloc(words, sizeof(uint64_t));
+    cg->off = (uint32_t*)malloc(sizeof(uint32_t) * (n + 1));
+    cg->name_off = (uint32_t*)malloc(sizeof(uint32_t) * (n + 1));
+    if(!cg->lat || !cg->lon || !cg->exists || !cg->off || !cg->name_off){
+        fprintf(stderr, "compact_create - arrays: malloc failed\n");
+        exit(1);
+    }
+
+    // the box around the graph, and the bytes of the distinct names
+    double min_lat = 0, max_lat = 0, min_lon = 0, max_lon = 0;
+    bool first = true;
+    long entries = 0;
+    size_t name_bytes = 0;
+    for(int u = 0; u < n; u++){
+        node_t *node = graph->nodes[u];
+        if(!node){
+            continue;
+        }
+        if(first || node->latitude < min_lat) min_lat = node->latitude;
+        if(first || node->latitude > max_lat) max_lat = node->latitude;
+        if(first || node->longitude < min_lon) min_lon = node->longitude;
+        if(first || node->longitude > max_lon) max_lon = node->longitude;
+        first = false;
+        for(intlist_t *nb = node->neighbors; nb; nb = nb->next){
+            entries++;
+        }
+        if(node->city_name && name_owner(graph, node) == u){
+            name_bytes += strlen(node->city_name) + 1;
+        }
+    }
+    if(entries >= UINT32_MAX || name_bytes >= UINT32_MAX){
+        fprintf(stderr, "compact_create: graph too large\n");
+        exit(1);
+    }
+    double extent = fmax(max_lat - min_lat, max_lon - min_lon);
+    cg->origin_lat = min_lat;
+    cg->origin_lon = min_lon;
+    cg->step = extent / UINT32_MAX;
+    cg->num_entries = entries;
+
+    cg->nbr = (int32_t*)malloc(sizeof(int32_t) * (entries + 1));
+    cg->names = (char*)malloc(name_bytes + 1);
+    if(!cg->nbr || !cg->names){
+        fprintf(stderr, "compact_create - rows: malloc failed\n");
+        exit(1);
+    }
+    cg->names_bytes = 0;
+
+    uint32_t pos = 0;
+    for(int u = 0; u < n; u++){
+        node_t *node = graph->nodes[u];
+        cg->off[u] = pos;
+        cg->lat[u] = node ? to_fixed(node->latitude, min_lat, cg->step) : 0;
+        cg->lon[u] = node ? to_fixed(node->longitude, min_lon, cg->step) : 0;
+        cg->name_off[u] = NO_NAME;
+        if(!node){
+            continue;
+        }
+        bit_set(cg->exists, u);
+        for(intlist_t *nb = node->neighbors; nb; nb = nb->next){
+            cg->nbr[pos++] = nb->num;
+        }
+
+        // names are interned by the graph, so the owner of a name stores
+        // it and the other nodes with the name point at its copy
+        if(node->city_name && name_owner(graph, node) == u){
+            cg->name_off[u] = name_put(cg, node->city_name);
+        }
+    }
+    cg->off[n] = pos;
+
+    for(int u = 0; u < n; u++){
+        node_t *node = graph->nodes[u];
+        if(node && node->city_name && cg->name_off[u] == NO_NAME){
+            cg->name_off[u] = cg->name_off[name_owner(graph, node)];
+        }
+    }
+
+    return cg;
+}
+
+/* compact_node_name: the city name of a node
+ *
+ * cg: the compact graph
+ * node_num: the node
+ *
+ * Returns: the name, NULL if the node has none. Nodes with the same name
+ *     share the string, which lives as long as the compact graph.
+ */
+const char *compact_node_name(compact_t *cg, int node_num)
+{
+    assert(node_num >= 0 && node_num < cg->num_nodes);
+    uint32_t pos = cg->name_off[node_num];
+    return pos == NO_NAME ? NULL : cg->names + pos;
+}
+
+/* compact_coordinates: the rounded coordinates of a node
+ *
+ * cg: the compact graph
+ * node_num: the node
+ * latitude: set to the latitude
+ * longitude: set to the longitude
+ */
+void compact_coordinates(compact_t *cg, int node_num, double *latitude,
+                         double *longitude)
+{
+    assert(node_num >= 0 && node_num < cg->num_nodes);
+    *latitude = cg->origin_lat + cg->lat[node_num] * cg->step;
+    *longitude = cg->origin_lon + cg->lon[node_num] * cg->step;
+}
+
+/* account: add one allocation to a component of a memory report
+ *
+ * Inputs:
+ * - report: the report (graph_memory_t*)
+ * - component: the field of the report to add to (size_t*)
+ * - bytes: the size of the allocation (size_t)
+ *
+ * Output: none. function is void.
+ */
+static void account(graph_memory_t *report, size_t *component, size_t bytes)
+{
+    *component += bytes;
+    report->overhead += malloc_bytes(bytes) - bytes;
+}
+
+/* compact_memory_report: break down the memory held by a compact graph,
+ *     like graph_memory_report
+ *
+ * cg: the compact graph
+ * report: filled with the bytes of each component
+ */
+void compact_memory_report(compact_t *cg, graph_memory_t *report)
+{
+    int n = cg->num_nodes;
+    memset(report, 0, sizeof(graph_memory_t));
+    account(report, &report->table, sizeof(compact_t));
+    account(report, &report->nodes, sizeof(uint32_t) * (n + 1));
+    account(report, &report->nodes, sizeof(uint32_t) * (n + 1));
+    account(report, &report->nodes, sizeof(uint64_t) * (n / 64 + 1));
+    account(report, &report->neighbors, sizeof(uint32_t) * (n + 1));
+    account(report, &report->neighbors, sizeof(int32_t) * (cg->num_entries + 1));
+    account(report, &report->names, sizeof(uint32_t) * (n + 1));
+    account(report, &report->names, cg->names_bytes + 1);
+    report->total = report->table + report->nodes + report->neighbors +
+                    report->names + report->search + report->overhead;
+}
+
+/* compact_free: free a compact graph
+ *
+ * cg: the compact graph
+ */
+void compact_free(compact_t *cg)
+{
+    free(cg->lat);
+    free(cg->lon);
+    free(cg->exists);
+    free(cg->off);
+    free(cg->nbr);
+    free(cg->name_off);
+    free(cg->names);
+    free(cg);
+}
+
+/********* A* SEARCH *********/
+
+/* dist_between: straight-line distance between two nodes on the rounded
+ *     coordinates, like h_calc
+ *
+ * Inputs:
+ * - cg: the compact graph (compact_t*)
+ * - u, v: node numbers (int)
+ *
+ * Output: the distance (double)
+ */
+static inline double dist_between(compact_t *cg, int u, int v)
+{
+    // differences of 32-bit integers are exact in a double
+    double dx = (double)cg->lon[u] - (double)cg->lon[v];
+    double dy = (double)cg->lat[u] - (double)cg->lat[v];
+    return sqrt(dx * dx + dy * dy) * cg->step;
+}
+
+/* a_star_compact: performs A* search on a compact graph
+ *
+ * cg: the compact graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the distance of the path between the start node and end node
+ *     on the rounded coordinates, -1 if there is no path
+ */
+double a_star_compact(compact_t *cg, int start_node_num, int end_node_num)
+{
+    assert(bit_get(cg->exists, start_node_num) && bit_get(cg->exists, end_node_num));
+
+    search_labels_t labels;
+    search_labels_init(&labels, cg->num_nodes);
+    heap_t *open = heap_create(1024);
+    double cost = -1;
+
+    search_labels_improve(&labels, start_node_num, 0);
+    heap_push(open, start_node_num, dist_between(cg, start_node_num, end_node_num));
+
+    while(!heap_is_empty(open)){
+        int curr = heap_pop(open, NULL);
+        if(!search_labels_close(&labels, curr)){
+            continue;
+        }
+        if(curr == end_node_num){
+            cost = labels.g[curr];
+            break;
+        }
+
+        double g = labels.g[curr];
+        for(uint32_t i = cg->off[curr]; i < cg->off[curr + 1]; i++){
+            int v = cg->nbr[i];
+            if(bit_get(labels.closed, v)){
+                continue;
+            }
+            double ng = g + dist_between(cg, curr, v);
+            if(search_labels_improve(&labels, v, ng)){
+                heap_push(open, v, ng + dist_between(cg, v, end_node_num));
+            }
+        }
+    }
+
+    heap_free(open);
+    search_labels_free(&labels);
+
+    return cost;
+}
@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "util.h"
+#include "a_star.h"
+#include "compress.h"
+
+/********* COMPRESSED GRAPH *********/
+
+struct cgraph {
+    int num_nodes;
+    long num_edges;
+
+    // node v's neighbors are encoded in adj[offsets[v]] .. adj[offsets[v + 1]]
+    uint64_t *offsets;
+    uint8_t *adj;
+    size_t adj_bytes;
+
+    double quantum;    // 0 if costs are not stored
+    double *latitude;
+    double *longitude;
+    uint8_t *exists;
+};
+
+/* Helper for cgraph_create below:
+ *
+ * cmp_int: qsort comparator
+ */
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+/* cgraph_create: build a compressed snapshot of a graph
+ *
+ * graph: the graph
+ * quantum: store edge costs rounded up to multiples of quantum, 0 to
+ *     compute them from the coordinates instead
+ * 
+ * Returns: the compressed graph
+ */ 
+cgraph_t *cgraph_create(graph_t *graph, double quantum)
+{
+    int n = graph->num_nodes;
+
+    cgraph_t *cg = (cgraph_t*)malloc(sizeof(cgraph_t));
+    if(cg == NULL){
+        fprintf(stderr, "cgraph_create: malloc failed\n");
+        exit(1);
+    }
+    cg->num_nodes = n;
+    cg->num_edges = 0;
+    cg->quantum = quantum > 0 ? quantum : 0;
+    cg->offsets = (uint64_t*)malloc(sizeof(uint64_t) * (n + 1));
+    cg->latitude = (double*)malloc(sizeof(double) * (n + 1));
+    cg->longitude = (double*)malloc(sizeof(double) * (n + 1));
+    cg->exists = (uint8_t*)malloc(n + 1);
+    if(!cg->offsets || !cg->latitude || !cg->longitude || !cg->exists){
+        fprintf(stderr, "cgraph_create - arrays: malloc failed\n");
+        exit(1);
+    }
+
+    // worst case: 5 bytes per gap and per cost
+    int max_degree = 0;
+    for(int v = 0; v < n; v++){
+        int degree = 0;
+        if(graph->nodes[v]){
+            for(intlist_t *nb = graph->nodes[v]->neighbors; nb; nb = nb->next){
+                degree++;
+            }
+        }
+        cg->num_edges += degree;
+        max_degree = degree > max_degree ? degree : max_degree;
+    }
+    size_t capacity = (size_t)cg->num_edges * (cg->quantum ? 10 : 5) + 1;
+    cg->adj = (uint8_t*)malloc(capacity);
+    int *sorted = (int*)malloc(sizeof(int) * (max_degree + 1));
+    if(!cg->adj || !sorted){
+        fprintf(stderr, "cgraph_create - adjacency: malloc failed\n");
+        exit(1);
+    }
+
+    size_t pos = 0;
+    for(int v = 0; v < n; v++){
+        node_t *node = graph->nodes[v];
+        cg->offsets[v] = pos;
+        cg->exists[v] = node != NULL;
+        cg->latitude[v] = node ? node->latitude : 0;
+        cg->longitude[v] = node ? node->longitude : 0;
+        if(!node){
+            continue;
+        }
+
+        int degree = 0;
+        for(intlist_t *nb = node->neighbors; nb; nb = nb->next){
+            sorted[degree++] = nb->num;
+        }
+        qsort(sorted, degree, sizeof(int), cmp_int);
+
+        int prev = v;
+        for(int i = 0; i < degree; i++){
+            uint32_t gap = i == 0 ? zigzag(sorted[i] - v) 
+                                  : (uint32_t)(sorted[i] - prev);
+            pos += varint_put(cg->adj + pos, gap);
+            if(cg->quantum){
+                double units = ceil(h_calc(node, graph->nodes[sorted[i]]) / cg->quantum);
+                if(units > UINT32_MAX){
+                    fprintf(stderr, "cgraph_create: edge %d -> %d takes more than 2^32 - 1 quanta\n",
+                            v, sorted[i]);
+                    exit(1);
+                }
+                pos += varint_put(cg->adj + pos, (uint32_t)units);
+            }
+            prev = sorted[i];
+        }
+    }
+    cg->offsets[n] = pos;
+    cg->adj_bytes = pos;
+
+    free(sorted);
+    uint8_t *shrunk = (uint8_t*)realloc(cg->adj, pos + 1);
+    if(shrunk){
+        cg->adj = shrunk;
+    }
+
+    return cg;
+}
+
+/* cgraph_num_edges: number of directed edges in a compressed graph
+ *
+ * cg: the compressed graph
+ * 
+ * Returns: the number of neighbor entries, each undirected edge counts
+ *     twice
+ */ 
+long cgraph_num_edges(cgraph_t *cg)
+{
+    return cg->num_edges;
+}
+
+/* cgraph_adjacency_bytes: memory used for the adjacency, offsets included
+ *
+ * cg: the compressed graph
+ * 
+ * Returns: the number of bytes
+ */ 
+size_t cgraph_adjacency_bytes(cgraph_t *cg)
+{
+    return cg->adj_bytes + sizeof(uint64_t) * (cg->num_nodes + 1);
+}
+
+/* cgraph_free: free a compressed graph
+ *
+ * cg: the compressed graph
+ */ 
+void cgraph_free(cgraph_t *cg)
+{
+    free(cg->offsets);
+    free(cg->adj);
+    free(cg->latitude);
+    free(cg->longitude);
+    free(cg->exists);
+    free(cg);
+}
+
+/********* A* SEARCH *********/
+
+/* dist_between: straight-line distance between two nodes, like h_calc
+ *
+ * Inputs:
+ * - cg: the compressed graph (cgraph_t*)
+ * - u, v: node numbers (int)
+ *
+ * Output: the distance (double)
+ */
+static inline double dist_between(cgraph_t *cg, int u, int v)
+{
+    double dx = cg->longitude[u] - cg->longitude[v];
+    double dy = cg->latitude[u] - cg->latitude[v];
+    return sqrt(dx * dx + dy * dy);
+}
+
+/* a_star_compressed: performs A* search on a compressed graph
+ *
+ * cg: the compressed graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */ 
+double a_star_compressed(cgraph_t *cg, int start_node_num, int end_node_num)
+{
+    assert(cg->exists[start_node_num] && cg->exists[end_node_num]);
+
+    search_labels_t labels;
+    search_labels_init(&labels, cg->num_nodes);
+    heap_t *open = heap_create(1024);
+    double cost = -1;
+
+    search_labels_improve(&labels, start_node_num, 0);
+    heap_push(open, start_node_num, dist_between(cg, start_node_num, end_node_num));
+
+    while(!heap_is_empty(open)){
+        int curr = heap_pop(open, NULL);
+        if(!search_labels_close(&labels, curr)){
+            continue;
+        }
+        if(curr == end_node_num){
+            cost = labels.g[curr];
+            break;
+        }
+
+        double g = labels.g[curr];
+        const uint8_t *p = cg->adj + cg->offsets[curr];
+        const uint8_t *stop = cg->adj + cg->offsets[curr + 1];
+        int v = curr;
+        bool first = true;
+
+        while(p < stop){
+            uint32_t gap = varint_get(&p);
+            v = first ? curr + unzigzag(gap) : v + (int)gap;
+            first = false;
+
+            double w = cg->quantum ? varint_get(&p) * cg->quantum
+                                   : dist_between(cg, curr, v);
+            if(bit_get(labels.closed, v)){
+                continue;
+            }
+            double ng = g + w;
+            if(search_labels_improve(&labels, v, ng)){
+                heap_push(open, v, ng + dist_between(cg, v, end_node_num));
+            }
+        }
+    }
+
+    heap_free(open);
+    search_labels_free(&labels);
+
+    return cost;
+}
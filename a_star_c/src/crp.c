@@ -0,0 +1,646 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "util.h"
+#include "a_star.h"
+#include "crp.h"
+#include "parallel.h"
+
+// each level groups 2^BITS_PER_LEVEL cells of the level below
+#define BITS_PER_LEVEL (2)
+#define MAX_DEPTH (30)
+
+/********* OVERLAY *********/
+
+typedef struct {
+    int num_cells;
+
+    // boundary nodes of cell c are bnd[bnd_off[c]] .. bnd[bnd_off[c + 1]]
+    long *bnd_off;
+    int *bnd;
+    int *bnd_index;     // position of a node in that list, -1 if none
+
+    // the clique of cell c is a k x k row-major matrix at
+    // clique[clique_off[c]], k the number of boundary nodes
+    long *clique_off;
+    double *clique;
+} level_t;
+
+struct crp {
+    graph_t *graph;
+    int num_nodes;
+    int depth;          // number of bisections
+    int num_levels;
+    int *leaf;          // lowest-level cell of each node
+
+    // edges out of node u are to[off[u]] .. to[off[u + 1]]
+    long *off;
+    int *to;
+    int *edge_num;
+    double *cost;
+
+    level_t *levels;    // levels[l - 1] is level l
+
+    // search scratch space not in use, kept between customizations and
+    // queries
+    pthread_mutex_t lock;
+    struct worker *free_workers;
+};
+
+/* cell_of: the cell of a node at a level
+ *
+ * Inputs:
+ * - crp: the overlay (crp_t*)
+ * - node_num: the node (int)
+ * - level: the level, at least 1 (int)
+ *
+ * Output: the cell number (int)
+ */
+static inline int cell_of(crp_t *crp, int node_num, int level)
+{
+    // the first bisection gives the highest bit, so the cells of a level
+    // are the leaf numbers without their lowest bits
+    return crp->leaf[node_num] >> (BITS_PER_LEVEL * (level - 1));
+}
+
+/********* PARTITION *********/
+
+typedef struct {
+    double key;
+    int node;
+} keyed_t;
+
+/* cmp_key: qsort comparator, by key then node number
+ */
+static int cmp_key(const void *a, const void *b)
+{
+    const keyed_t *x = (const keyed_t*)a;
+    const keyed_t *y = (const keyed_t*)b;
+    if(x->key != y->key){
+        return x->key < y->key ? -1 : 1;
+    }
+    return (x->node > y->node) - (x->node < y->node);
+}
+
+/* bisect: split nodes in half across their longer extent, recursively,
+ *     numbering the leaves
+ *
+ * Inputs:
+ * - crp: the overlay (crp_t*)
+ * - items: the nodes to split (keyed_t*)
+ * - count: number of nodes (int)
+ * - depth: bisections so far (int)
+ * - leaf: leaf number prefix so far (int)
+ *
+ * Output: none. function is void.
+ */
+static void bisect(crp_t *crp, keyed_t *items, int count, int depth, int leaf)
+{
+    node_t **nodes = crp->graph->nodes;
+    if(depth == crp->depth){
+        for(int i = 0; i < count; i++){
+            crp->leaf[items[i].node] = leaf;
+        }
+        return;
+    }
+
+    double min_x = INFINITY, max_x = -INFINITY;
+    double min_y = INFINITY, max_y = -INFINITY;
+    for(int i = 0; i < count; i++){
+        node_t *node = nodes[items[i].node];
+        min_x = fmin(min_x, node->longitude);
+        max_x = fmax(max_x, node->longitude);
+        min_y = fmin(min_y, node->latitude);
+        max_y = fmax(max_y, node->latitude);
+    }
+    bool by_x = max_x - min_x >= max_y - min_y;
+    for(int i = 0; i < count; i++){
+        node_t *node = nodes[items[i].node];
+        items[i].key = by_x ? node->longitude : node->latitude;
+    }
+    qsort(items, count, sizeof(keyed_t), cmp_key);
+
+    int half = count / 2;
+    bisect(crp, items, half, depth + 1, leaf * 2);
+    bisect(crp, items + half, count - half, depth + 1, leaf * 2 + 1);
+}
+
+/* build_level: find the boundary nodes of every cell of a level and
+ *     allocate its cliques
+ *
+ * Inputs:
+ * - crp: the overlay (crp_t*)
+ * - level: the level, at least 1 (int)
+ *
+ * Output: none. function is void.
+ */
+static void build_level(crp_t *crp, int level)
+{
+    int n = crp->num_nodes;
+    level_t *lv = &crp->levels[level - 1];
+    int shift = BITS_PER_LEVEL * (level - 1);
+    lv->num_cells = (((1 << crp->depth) - 1) >> shift) + 1;
+
+    lv->bnd_off = (long*)calloc(lv->num_cells + 1, sizeof(long));
+    lv->bnd_index = (int*)malloc(sizeof(int) * (n + 1));
+    lv->clique_off = (long*)malloc(sizeof(long) * (lv->num_cells + 1));
+    if(!lv->bnd_off || !lv->bnd_index || !lv->clique_off){
+        fprintf(stderr, "crp_create - build_level: malloc failed\n");
+        exit(1);
+    }
+
+    // an edge between cells makes both of its ends boundary nodes
+    for(int u = 0; u < n; u++){
+        lv->bnd_index[u] = -1;
+    }
+    for(int u = 0; u < n; u++){
+        for(long e = crp->off[u]; e < crp->off[u + 1]; e++){
+            int w = crp->to[e];
+            if(cell_of(crp, u, level) != cell_of(crp, w, level)){
+                lv->bnd_index[u] = 0;
+                lv->bnd_index[w] = 0;
+            }
+        }
+    }
+
+    for(int u = 0; u < n; u++){
+        if(lv->bnd_index[u] == 0){
+            lv->bnd_off[cell_of(crp, u, level) + 1]++;
+        }
+    }
+    lv->clique_off[0] = 0;
+    for(int c = 0; c < lv->num_cells; c++){
+        long k = lv->bnd_off[c + 1];
+        lv->bnd_off[c + 1] += lv->bnd_off[c];
+        lv->clique_off[c + 1] = lv->clique_off[c] + k * k;
+    }
+
+    lv->bnd = (int*)malloc(sizeof(int) * (lv->bnd_off[lv->num_cells] + 1));
+    lv->clique = (double*)malloc(sizeof(double) * (lv->clique_off[lv->num_cells] + 1));
+    long *pos = (long*)malloc(sizeof(long) * (lv->num_cells + 1));
+    if(!lv->bnd || !lv->clique || !pos){
+        fprintf(stderr, "crp_create - build_level: malloc failed\n");
+        exit(1);
+    }
+    memcpy(pos, lv->bnd_off, sizeof(long) * (lv->num_cells + 1));
+    for(int u = 0; u < n; u++){
+        if(lv->bnd_index[u] == 0){
+            int c = cell_of(crp, u, level);
+            lv->bnd_index[u] = (int)(pos[c] - lv->bnd_off[c]);
+            lv->bnd[pos[c]++] = u;
+        }
+    }
+    free(pos);
+}
+
+/* crp_create: partition a graph and customize it with straight-line
+ *     edge costs
+ *
+ * graph: the graph, which must outlive the overlay and not change
+ * cell_size: maximum number of nodes in a cell of the lowest level
+ * num_threads: number of worker threads, 0 for one per core
+ *
+ * Returns: the overlay
+ */
+crp_t *crp_create(graph_t *graph, int cell_size, int num_threads)
+{
+    int n = graph->num_nodes;
+    cell_size = cell_size > 0 ? cell_size : 1;
+
+    crp_t *crp = (crp_t*)malloc(sizeof(crp_t));
+    if(crp == NULL){
+        fprintf(stderr, "crp_create: malloc failed\n");
+        exit(1);
+    }
+    crp->graph = graph;
+    crp->num_nodes = n;
+    pthread_mutex_init(&crp->lock, NULL);
+    crp->free_workers = NULL;
+    crp->leaf = (int*)calloc(n + 1, sizeof(int));
+    crp->off = (long*)calloc(n + 1, sizeof(long));
+    keyed_t *items = (keyed_t*)malloc(sizeof(keyed_t) * (n + 1));
+    if(!crp->leaf || !crp->off || !items){
+        fprintf(stderr, "crp_create: malloc failed\n");
+        exit(1);
+    }
+
+    int count = 0;
+    for(int u = 0; u < n; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        items[count++].node = u;
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next){
+            crp->off[u + 1]++;
+        }
+    }
+    for(int u = 0; u < n; u++){
+        crp->off[u + 1] += crp->off[u];
+    }
+
+    long m = crp->off[n];
+    crp->to = (int*)malloc(sizeof(int) * (m + 1));
+    crp->edge_num = (int*)malloc(sizeof(int) * (m + 1));
+    crp->cost = (double*)malloc(sizeof(double) * (m + 1));
+    if(!crp->to || !crp->edge_num || !crp->cost){
+        fprintf(stderr, "crp_create - edges: malloc failed\n");
+        exit(1);
+    }
+    for(int u = 0; u < n; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        long e = crp->off[u];
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next){
+            crp->to[e] = nb->num;
+            crp->edge_num[e++] = nb->edge_num;
+        }
+    }
+
+    crp->depth = 0;
+    while(crp->depth < MAX_DEPTH &&
+          ((long)count + (1L << crp->depth) - 1) >> crp->depth > cell_size){
+        crp->depth++;
+    }
+    bisect(crp, items, count, 0, 0);
+    free(items);
+
+    crp->num_levels = (crp->depth + BITS_PER_LEVEL - 1) / BITS_PER_LEVEL;
+    crp->num_levels = crp->num_levels > 0 ? crp->num_levels : 1;
+    crp->levels = (level_t*)calloc(crp->num_levels, sizeof(level_t));
+    if(crp->levels == NULL){
+        fprintf(stderr, "crp_create - levels: malloc failed\n");
+        exit(1);
+    }
+    for(int level = 1; level <= crp->num_levels; level++){
+        build_level(crp, level);
+    }
+
+    crp_customize(crp, NULL, num_threads);
+
+    return crp;
+}
+
+/* crp_num_levels: number of overlay levels
+ *
+ * crp: the overlay
+ *
+ * Returns: the number of levels above the original graph
+ */
+int crp_num_levels(crp_t *crp)
+{
+    return crp->num_levels;
+}
+
+/********* CUSTOMIZATION *********/
+
+// scratch space of one search, reset after each search
+typedef struct worker {
+    _Alignas(64) double *dist;
+    uint8_t *by_clique;  // whether the distance came over a clique
+    int *touched;
+    long num_touched;
+    heap_t *open;
+    struct worker *next;
+} worker_t;
+
+typedef struct {
+    crp_t *crp;
+    int level;
+    worker_t **workers;
+} custom_t;
+
+/* worker_acquire: take a worker from the overlay's pool, creating one
+ *     if the pool is empty. Thread-safe.
+ *
+ * Inputs:
+ * - crp: the overlay (crp_t*)
+ *
+ * Output: a worker with every distance INFINITY (worker_t*)
+ */
+static worker_t *worker_acquire(crp_t *crp)
+{
+    pthread_mutex_lock(&crp->lock);
+    worker_t *w = crp->free_workers;
+    if(w){
+        crp->free_workers = w->next;
+    }
+    pthread_mutex_unlock(&crp->lock);
+    if(w){
+        return w;
+    }
+
+    int n = crp->num_nodes;
+    w = (worker_t*)aligned_alloc(64, sizeof(worker_t));
+    if(w == NULL){
+        fprintf(stderr, "worker_acquire: malloc failed\n");
+        exit(1);
+    }
+    w->dist = (double*)malloc(sizeof(double) * (n + 1));
+    w->by_clique = (uint8_t*)malloc(n + 1);
+    w->touched = (int*)malloc(sizeof(int) * (n + 1));
+    if(!w->dist || !w->by_clique || !w->touched){
+        fprintf(stderr, "worker_acquire - arrays: malloc failed\n");
+        exit(1);
+    }
+    for(int v = 0; v <= n; v++){
+        w->dist[v] = INFINITY;
+    }
+    w->num_touched = 0;
+    w->open = heap_create(1024);
+    return w;
+}
+
+/* worker_reset: forget the previous search, clearing only the nodes it
+ *     reached
+ *
+ * Inputs:
+ * - w: the worker (worker_t*)
+ *
+ * Output: none. function is void.
+ */
+static inline void worker_reset(worker_t *w)
+{
+    for(long t = 0; t < w->num_touched; t++){
+        w->dist[w->touched[t]] = INFINITY;
+    }
+    w->num_touched = 0;
+    heap_clear(w->open);
+}
+
+/* worker_release: reset a worker and return it to the overlay's pool.
+ *     Thread-safe.
+ *
+ * Inputs:
+ * - crp: the overlay (crp_t*)
+ * - w: the worker (worker_t*)
+ *
+ * Output: none. function is void.
+ */
+static void worker_release(crp_t *crp, worker_t *w)
+{
+    worker_reset(w);
+    pthread_mutex_lock(&crp->lock);
+    w->next = crp->free_workers;
+    crp->free_workers = w;
+    pthread_mutex_unlock(&crp->lock);
+}
+
+/* Helper for the searches below:
+ *
+ * relax: offer a distance to a node, and record whether it came over a
+ *     clique. A node reached over a clique does not need that clique
+ *     relaxed again: clique distances are shortest paths in their cell,
+ *     so the node the search came from already offered shorter ones.
+ */
+static inline void relax(worker_t *w, int node_num, double dist, bool by_clique)
+{
+    if(dist < w->dist[node_num]){
+        if(w->dist[node_num] == INFINITY){
+            w->touched[w->num_touched++] = node_num;
+        }
+        w->dist[node_num] = dist;
+        w->by_clique[node_num] = by_clique;
+        heap_push(w->open, node_num, dist);
+    }
+}
+
+/* customize_rows: fill some rows of the cliques of a level, with one
+ *     search per boundary node that stays inside its cell and stops once
+ *     every boundary node of the cell is settled. On level 1 it uses the
+ *     original edges, above that the cliques of the level below and the
+ *     edges between its cells. The rows are split over the threads
+ *     rather than whole cells, since the top levels have few cells.
+ *
+ * Inputs: tpool_range_fn over boundary nodes of the level, arg is a
+ *     custom_t
+ *
+ * Output: none. function is void.
+ */
+static void customize_rows(long lo, long hi, int tid, void *arg)
+{
+    custom_t *cu = (custom_t*)arg;
+    crp_t *crp = cu->crp;
+    worker_t *w = cu->workers[tid];
+    int level = cu->level;
+    level_t *lv = &crp->levels[level - 1];
+    level_t *sub = level > 1 ? &crp->levels[level - 2] : NULL;
+
+    for(long r = lo; r < hi; r++){
+        int source = lv->bnd[r];
+        int c = cell_of(crp, source, level);
+        int k = (int)(lv->bnd_off[c + 1] - lv->bnd_off[c]);
+        int *bnd = lv->bnd + lv->bnd_off[c];
+        int left = k;
+
+        relax(w, source, 0, false);
+        while(left && !heap_is_empty(w->open)){
+            double d;
+            int v = heap_pop(w->open, &d);
+            if(d > w->dist[v]){
+                continue;
+            }
+            left -= lv->bnd_index[v] >= 0;
+
+            if(sub == NULL){
+                for(long e = crp->off[v]; e < crp->off[v + 1]; e++){
+                    if(cell_of(crp, crp->to[e], 1) == c){
+                        relax(w, crp->to[e], d + crp->cost[e], false);
+                    }
+                }
+                continue;
+            }
+
+            // every node reached is a boundary node of its subcell
+            int sc = cell_of(crp, v, level - 1);
+            if(!w->by_clique[v]){
+                int sk = (int)(sub->bnd_off[sc + 1] - sub->bnd_off[sc]);
+                int *sbnd = sub->bnd + sub->bnd_off[sc];
+                double *row = sub->clique + sub->clique_off[sc] +
+                              (long)sub->bnd_index[v] * sk;
+                for(int j = 0; j < sk; j++){
+                    relax(w, sbnd[j], d + row[j], true);
+                }
+            }
+            for(long e = crp->off[v]; e < crp->off[v + 1]; e++){
+                int u = crp->to[e];
+                if(cell_of(crp, u, level - 1) != sc && cell_of(crp, u, level) == c){
+                    relax(w, u, d + crp->cost[e], false);
+                }
+            }
+        }
+
+        double *clique = lv->clique + lv->clique_off[c] + (long)lv->bnd_index[source] * k;
+        for(int j = 0; j < k; j++){
+            clique[j] = w->dist[bnd[j]];
+        }
+        worker_reset(w);
+    }
+}
+
+/* crp_customize: recompute the cliques for new edge costs
+ *
+ * crp: the overlay
+ * costs: cost of every edge by edge number, graph->num_edges entries, at
+ *     least 0, NULL for straight-line costs
+ * num_threads: number of worker threads, 0 for one per core
+ */
+void crp_customize(crp_t *crp, const double *costs, int num_threads)
+{
+    int n = crp->num_nodes;
+    node_t **nodes = crp->graph->nodes;
+    for(int u = 0; u < n; u++){
+        for(long e = crp->off[u]; e < crp->off[u + 1]; e++){
+            crp->cost[e] = costs ? costs[crp->edge_num[e]]
+                                 : h_calc(nodes[u], nodes[crp->to[e]]);
+        }
+    }
+
+    tpool_t *pool = tpool_create(num_threads);
+    int threads = tpool_size(pool);
+    custom_t cu;
+    cu.crp = crp;
+    cu.workers = (worker_t**)malloc(sizeof(worker_t*) * threads);
+    if(cu.workers == NULL){
+        fprintf(stderr, "crp_customize: malloc failed\n");
+        exit(1);
+    }
+    for(int t = 0; t < threads; t++){
+        cu.workers[t] = worker_acquire(crp);
+    }
+
+    // each level reads the cliques of the level below
+    for(cu.level = 1; cu.level <= crp->num_levels; cu.level++){
+        level_t *lv = &crp->levels[cu.level - 1];
+        tpool_for(pool, lv->bnd_off[lv->num_cells], 0, customize_rows, &cu);
+    }
+
+    tpool_free(pool);
+    for(int t = 0; t < threads; t++){
+        worker_release(crp, cu.workers[t]);
+    }
+    free(cu.workers);
+}
+
+/********* QUERIES *********/
+
+/* query_level: the level a query searches at a node, the highest level
+ *     whose cell holds neither the start nor the end
+ *
+ * Inputs:
+ * - crp: the overlay (crp_t*)
+ * - node_num: the node (int)
+ * - start, end: the query (int)
+ *
+ * Output: the level, 0 for the original edges (int)
+ */
+static inline int query_level(crp_t *crp, int node_num, int start, int end)
+{
+    int level = 0;
+    while(level < crp->num_levels &&
+          cell_of(crp, node_num, level + 1) != cell_of(crp, start, level + 1) &&
+          cell_of(crp, node_num, level + 1) != cell_of(crp, end, level + 1)){
+        level++;
+    }
+    return level;
+}
+
+/* crp_query: shortest path cost under the current customization.
+ *     Thread-safe, though not while crp_customize runs.
+ *
+ * crp: the overlay
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the cost of the shortest path between the start node and end
+ *     node, -1 if there is no path
+ */
+double crp_query(crp_t *crp, int start_node_num, int end_node_num)
+{
+    assert(crp->graph->nodes[start_node_num] && crp->graph->nodes[end_node_num]);
+
+    worker_t *w = worker_acquire(crp);
+    double cost = -1;
+
+    relax(w, start_node_num, 0, false);
+    while(!heap_is_empty(w->open)){
+        double d;
+        int v = heap_pop(w->open, &d);
+        if(d > w->dist[v]){
+            continue;
+        }
+        if(v == end_node_num){
+            cost = d;
+            break;
+        }
+
+        int level = query_level(crp, v, start_node_num, end_node_num);
+        if(level == 0){
+            for(long e = crp->off[v]; e < crp->off[v + 1]; e++){
+                relax(w, crp->to[e], d + crp->cost[e], false);
+            }
+            continue;
+        }
+
+        // across the clique of the cell, then out of it
+        level_t *lv = &crp->levels[level - 1];
+        int c = cell_of(crp, v, level);
+        assert(lv->bnd_index[v] >= 0);
+        if(!w->by_clique[v]){
+            int k = (int)(lv->bnd_off[c + 1] - lv->bnd_off[c]);
+            int *bnd = lv->bnd + lv->bnd_off[c];
+            double *row = lv->clique + lv->clique_off[c] + (long)lv->bnd_index[v] * k;
+            for(int j = 0; j < k; j++){
+                relax(w, bnd[j], d + row[j], true);
+            }
+        }
+        for(long e = crp->off[v]; e < crp->off[v + 1]; e++){
+            if(cell_of(crp, crp->to[e], level) != c){
+                relax(w, crp->to[e], d + crp->cost[e], false);
+            }
+        }
+    }
+
+    worker_release(crp, w);
+
+    return cost;
+}
+
+/* crp_free: free an overlay
+ *
+ * crp: the overlay
+ */
+void crp_free(crp_t *crp)
+{
+    for(int l = 0; l < crp->num_levels; l++){
+        free(crp->levels[l].bnd_off);
+        free(crp->levels[l].bnd);
+        free(crp->levels[l].bnd_index);
+        free(crp->levels[l].clique_off);
+        free(crp->levels[l].clique);
+    }
+    free(crp->levels);
+    free(crp->leaf);
+    free(crp->off);
+    free(crp->to);
+    free(crp->edge_num);
+    free(crp->cost);
+    worker_t *w = crp->free_workers;
+    while(w){
+        worker_t *next = w->next;
+        free(w->dist);
+        free(w->by_clique);
+        free(w->touched);
+        heap_free(w->open);
+        free(w);
+        w = next;
+    }
+    pthread_mutex_destroy(&crp->lock);
+    free(crp);
+}
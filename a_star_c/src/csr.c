@@ -0,0 +1,1234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <math.h>
+
+#include "util.h"
+#include "a_star.h"
+#include "csr.h"
+#include "parallel.h"
+
+/********* CSR GRAPH *********/
+
+struct csr {
+    int num_nodes;
+    long num_edges;
+    csr_t *base;       // the graph a reversed view shares arrays with
+
+    // edges leaving node u are out_to[out_off[u]] .. out_to[out_off[u + 1]]
+    long *out_off;
+    int *out_to;
+    uint64_t *out_two_way;
+
+    // edges entering node v, as the node they leave
+    long *in_off;
+    int *in_from;
+    uint64_t *in_two_way;
+
+    double *latitude;
+    double *longitude;
+    uint8_t *exists;
+
+    // with CSR_ALLOC_HUGE_PAGES every array above lives in this one block,
+    // and the search state of the last finished search is kept for the
+    // next one, as faulting in fresh huge pages costs more than a search
+    void *slab;
+    size_t slab_bytes;
+    _Atomic(void*) spare_state;
+};
+
+#define SLAB_ALIGN (64)
+
+/* slab_part: place one array in the huge page block, or measure it
+ *
+ * Inputs:
+ * - slab: the block, NULL to only add up the size (char*)
+ * - used: bytes of the block taken so far, advanced past the array (size_t*)
+ * - array: the array, moved into the block and freed (void**)
+ * - bytes: the size of the array (size_t)
+ *
+ * Output: none. function is void.
+ */
+static void slab_part(char *slab, size_t *used, void **array, size_t bytes)
+{
+    if(slab != NULL){
+        memcpy(slab + *used, *array, bytes);
+        free(*array);
+        *array = slab + *used;
+    }
+    *used += (bytes + SLAB_ALIGN - 1) & ~(size_t)(SLAB_ALIGN - 1);
+}
+
+/* csr_move_to_huge_pages: move every array of a CSR graph into one block
+ *     of huge pages, so a search touches few TLB entries
+ *
+ * Inputs:
+ * - csr: the CSR graph, built with malloc (csr_t*)
+ *
+ * Output: none. function is void.
+ */
+static void csr_move_to_huge_pages(csr_t *csr)
+{
+    int n = csr->num_nodes;
+    long m = csr->num_edges;
+    size_t offsets = sizeof(long) * (n + 1);
+    size_t edges = sizeof(int) * (m + 1);
+    size_t flags = sizeof(uint64_t) * (m / 64 + 1);
+    size_t coords = sizeof(double) * (n + 1);
+
+    // the first pass adds up the size, the second moves the arrays
+    char *slab = NULL;
+    for(int pass = 0; pass < 2; pass++){
+        size_t used = 0;
+        slab_part(slab, &used, (void**)&csr->out_off, offsets);
+        slab_part(slab, &used, (void**)&csr->in_off, offsets);
+        slab_part(slab, &used, (void**)&csr->out_to, edges);
+        slab_part(slab, &used, (void**)&csr->in_from, edges);
+        slab_part(slab, &used, (void**)&csr->out_two_way, flags);
+        slab_part(slab, &used, (void**)&csr->in_two_way, flags);
+        slab_part(slab, &used, (void**)&csr->longitude, coords);
+        slab_part(slab, &used, (void**)&csr->latitude, coords);
+        slab_part(slab, &used, (void**)&csr->exists, n + 1);
+        if(pass == 0){
+            csr->slab_bytes = used;
+            slab = (char*)huge_alloc(used);
+        }
+    }
+    csr->slab = slab;
+}
+
+/* csr_create: build a CSR snapshot of a graph
+ *
+ * graph: the graph
+ * 
+ * Returns: the CSR graph
+ */ 
+csr_t *csr_create(graph_t *graph)
+{
+    return csr_create_alloc(graph, CSR_ALLOC_DEFAULT);
+}
+
+/* csr_create_alloc: build a CSR snapshot of a graph with a choice of
+ *     memory for its arrays
+ *
+ * graph: the graph
+ * alloc: where the arrays of the snapshot, and of each search on it, live
+ * 
+ * Returns: the CSR graph
+ */ 
+csr_t *csr_create_alloc(graph_t *graph, csr_alloc_t alloc)
+{
+    int n = graph->num_nodes;
+
+    csr_t *csr = (csr_t*)malloc(sizeof(csr_t));
+    if(csr == NULL){
+        fprintf(stderr, "csr_create: malloc failed\n");
+        exit(1);
+    }
+    csr->num_nodes = n;
+    csr->base = NULL;
+    csr->slab = NULL;
+    csr->slab_bytes = 0;
+    atomic_init(&csr->spare_state, NULL);
+    csr->out_off = (long*)calloc(n + 1, sizeof(long));
+    csr->in_off = (long*)calloc(n + 1, sizeof(long));
+    csr->latitude = (double*)malloc(sizeof(double) * (n + 1));
+    csr->longitude = (double*)malloc(sizeof(double) * (n + 1));
+    csr->exists = (uint8_t*)malloc(n + 1);
+
+    // add_edge puts its edge number in two neighbor lists, add_arc in one
+    int *uses = (int*)calloc(graph->num_edges + 1, sizeof(int));
+    if(!csr->out_off || !csr->in_off || !csr->latitude || !csr->longitude ||
+       !csr->exists || !uses){
+        fprintf(stderr, "csr_create - arrays: malloc failed\n");
+        exit(1);
+    }
+
+    for(int u = 0; u < n; u++){
+        node_t *node = graph->nodes[u];
+        csr->exists[u] = node != NULL;
+        csr->latitude[u] = node ? node->latitude : 0;
+        csr->longitude[u] = node ? node->longitude : 0;
+        if(!node){
+            continue;
+        }
+        for(intlist_t *nb = node->neighbors; nb; nb = nb->next){
+            uses[nb->edge_num]++;
+        }
+    }
+
+    // count each edge at the first of its entries, in node order, so a
+    // two-way edge leaves its lower-numbered node
+    int *kept = (int*)calloc(graph->num_edges + 1, sizeof(int));
+    if(kept == NULL){
+        fprintf(stderr, "csr_create - arrays: malloc failed\n");
+        exit(1);
+    }
+    for(int u = 0; u < n; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next){
+            if(kept[nb->edge_num]){
+                continue;
+            }
+            kept[nb->edge_num] = 1;
+            csr->out_off[u + 1]++;
+            csr->in_off[nb->num + 1]++;
+        }
+    }
+    for(int u = 0; u < n; u++){
+        csr->out_off[u + 1] += csr->out_off[u];
+        csr->in_off[u + 1] += csr->in_off[u];
+    }
+
+    long m = csr->out_off[n];
+    long words = m / 64 + 1;
+    csr->num_edges = m;
+    csr->out_to = (int*)malloc(sizeof(int) * (m + 1));
+    csr->in_from = (int*)malloc(sizeof(int) * (m + 1));
+    csr->out_two_way = (uint64_t*)calloc(words, sizeof(uint64_t));
+    csr->in_two_way = (uint64_t*)calloc(words, sizeof(uint64_t));
+    long *in_pos = (long*)malloc(sizeof(long) * (n + 1));
+    if(!csr->out_to || !csr->in_from || !csr->out_two_way ||
+       !csr->in_two_way || !in_pos){
+        fprintf(stderr, "csr_create - edges: malloc failed\n");
+        exit(1);
+    }
+    memcpy(in_pos, csr->in_off, sizeof(long) * (n + 1));
+
+    memset(kept, 0, sizeof(int) * (graph->num_edges + 1));
+    for(int u = 0; u < n; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        long out = csr->out_off[u];
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next){
+            if(kept[nb->edge_num]){
+                continue;
+            }
+            kept[nb->edge_num] = 1;
+
+            long in = in_pos[nb->num]++;
+            csr->out_to[out] = nb->num;
+            csr->in_from[in] = u;
+            if(uses[nb->edge_num] > 1){
+                bit_set(csr->out_two_way, out);
+                bit_set(csr->in_two_way, in);
+            }
+            out++;
+        }
+    }
+
+    free(uses);
+    free(kept);
+    free(in_pos);
+
+    if(alloc == CSR_ALLOC_HUGE_PAGES){
+        csr_move_to_huge_pages(csr);
+    }
+
+    return csr;
+}
+
+/* csr_reverse: reversed view of a CSR graph, sharing its arrays
+ *
+ * csr: the CSR graph or a view of it
+ * 
+ * Returns: a view in which every edge points the other way, to be freed
+ *     with csr_free before the graph it was made from
+ */ 
+csr_t *csr_reverse(csr_t *csr)
+{
+    csr_t *view = (csr_t*)malloc(sizeof(csr_t));
+    if(view == NULL){
+        fprintf(stderr, "csr_reverse: malloc failed\n");
+        exit(1);
+    }
+    *view = *csr;
+    view->base = csr->base ? csr->base : csr;
+
+    // the in rows become the out rows and the other way around
+    view->out_off = csr->in_off;
+    view->out_to = csr->in_from;
+    view->out_two_way = csr->in_two_way;
+    view->in_off = csr->out_off;
+    view->in_from = csr->out_to;
+    view->in_two_way = csr->out_two_way;
+
+    return view;
+}
+
+/* csr_num_nodes: number of node slots
+ *
+ * csr: the CSR graph
+ * 
+ * Returns: the number of nodes of the graph it was made from, including
+ *     numbers without a node
+ */ 
+int csr_num_nodes(csr_t *csr)
+{
+    return csr->num_nodes;
+}
+
+/* csr_has_node: determines whether a node number is in the graph
+ *
+ * csr: the CSR graph
+ * node_num: any number
+ * 
+ * Returns: true if node_num is in range and has a node, false otherwise
+ */ 
+bool csr_has_node(csr_t *csr, int node_num)
+{
+    return node_num >= 0 && node_num < csr->num_nodes && csr->exists[node_num];
+}
+
+/* csr_num_edges: number of stored edges
+ *
+ * csr: the CSR graph
+ * 
+ * Returns: the number of edges, each two-way edge counts once
+ */ 
+long csr_num_edges(csr_t *csr)
+{
+    return csr->num_edges;
+}
+
+/* csr_adjacency_bytes: memory used for the out and in rows, offsets and
+ *     two-way flags included
+ *
+ * csr: the CSR graph
+ * 
+ * Returns: the number of bytes
+ */ 
+size_t csr_adjacency_bytes(csr_t *csr)
+{
+    size_t offsets = sizeof(long) * (csr->num_nodes + 1);
+    size_t flags = sizeof(uint64_t) * (csr->num_edges / 64 + 1);
+    return 2 * (offsets + sizeof(int) * csr->num_edges + flags);
+}
+
+/* csr_neighbors: nodes reachable from a node over one edge
+ *
+ * csr: the CSR graph
+ * node_num: the node
+ * out: filled with the neighbors, room for every edge of the node
+ * 
+ * Returns: the number of neighbors written to out
+ */ 
+int csr_neighbors(csr_t *csr, int node_num, int *out)
+{
+    int count = 0;
+    for(long e = csr->out_off[node_num]; e < csr->out_off[node_num + 1]; e++){
+        out[count++] = csr->out_to[e];
+    }
+    for(long e = csr->in_off[node_num]; e < csr->in_off[node_num + 1]; e++){
+        // a two-way self-loop is already in the out row
+        if(bit_get(csr->in_two_way, e) && csr->in_from[e] != node_num){
+            out[count++] = csr->in_from[e];
+        }
+    }
+    return count;
+}
+
+/* csr_free: free a CSR graph, or only the view if csr came from
+ *     csr_reverse
+ *
+ * csr: the CSR graph
+ */ 
+void csr_free(csr_t *csr)
+{
+    if(csr->base == NULL && csr->slab != NULL){
+        size_t words = csr->num_nodes / 64 + 1;
+        huge_free(atomic_load(&csr->spare_state), sizeof(double) * (csr->num_nodes + 1) +
+                  2 * sizeof(uint64_t) * words);
+        huge_free(csr->slab, csr->slab_bytes);
+    }else if(csr->base == NULL){
+        free(csr->out_off);
+        free(csr->out_to);
+        free(csr->out_two_way);
+        free(csr->in_off);
+        free(csr->in_from);
+        free(csr->in_two_way);
+        free(csr->latitude);
+        free(csr->longitude);
+        free(csr->exists);
+    }
+    free(csr);
+}
+
+/********* FILES *********/
+
+#define FILE_MAGIC (0x47525343)    // "CSRG"
+#define FILE_VERSION (1)
+
+/* Helpers for csr_save and csr_load below:
+ *
+ * write_rows: write the offsets, targets and flags of one set of rows,
+ *     false on error
+ * read_rows: read them back, false on error or if the offsets or targets
+ *     are not consistent
+ */
+static bool write_rows(long *off, int *to, uint64_t *two_way, int n, long m, FILE *file)
+{
+    size_t words = m / 64 + 1;
+    return fwrite(off, sizeof(long), n + 1, file) == (size_t)n + 1 &&
+           fwrite(to, sizeof(int), m, file) == (size_t)m &&
+           fwrite(two_way, sizeof(uint64_t), words, file) == words;
+}
+
+static bool read_rows(long *off, int *to, uint64_t *two_way, int n, long m, FILE *file)
+{
+    size_t words = m / 64 + 1;
+    if(fread(off, sizeof(long), n + 1, file) != (size_t)n + 1 ||
+       fread(to, sizeof(int), m, file) != (size_t)m ||
+       fread(two_way, sizeof(uint64_t), words, file) != words){
+        return false;
+    }
+    if(off[0] != 0 || off[n] != m){
+        return false;
+    }
+    for(int u = 0; u < n; u++){
+        if(off[u + 1] < off[u]){
+            return false;
+        }
+    }
+    for(long e = 0; e < m; e++){
+        if(to[e] < 0 || to[e] >= n){
+            return false;
+        }
+    }
+    return true;
+}
+
+/* csr_save: write a CSR graph to a file
+ *
+ * csr: the CSR graph, a reversed view is written as the graph it shows
+ * file: a file open for binary writing
+ * 
+ * Returns: 0 on success, -1 if a write failed
+ */ 
+int csr_save(csr_t *csr, FILE *file)
+{
+    int n = csr->num_nodes;
+    int32_t header[3] = { FILE_MAGIC, FILE_VERSION, n };
+    int64_t m = csr->num_edges;
+    if(fwrite(header, sizeof(int32_t), 3, file) != 3 ||
+       fwrite(&m, sizeof(int64_t), 1, file) != 1 ||
+       !write_rows(csr->out_off, csr->out_to, csr->out_two_way, n, m, file) ||
+       !write_rows(csr->in_off, csr->in_from, csr->in_two_way, n, m, file) ||
+       fwrite(csr->latitude, sizeof(double), n, file) != (size_t)n ||
+       fwrite(csr->longitude, sizeof(double), n, file) != (size_t)n ||
+       fwrite(csr->exists, 1, n, file) != (size_t)n){
+        return -1;
+    }
+    return fflush(file) == 0 ? 0 : -1;
+}
+
+/* csr_load: read a CSR graph written by csr_save on the same kind of
+ *     machine, without the graph_t it was made from
+ *
+ * file: a file open for binary reading
+ * alloc: where the arrays of the graph, and of each search on it, live
+ * 
+ * Returns: the CSR graph, NULL if the file is not valid
+ */ 
+csr_t *csr_load(FILE *file, csr_alloc_t alloc)
+{
+    int32_t header[3];
+    int64_t m;
+    if(fread(header, sizeof(int32_t), 3, file) != 3 || header[0] != FILE_MAGIC ||
+       header[1] != FILE_VERSION || header[2] < 0 ||
+       fread(&m, sizeof(int64_t), 1, file) != 1 || m < 0 || m > LONG_MAX / 16){
+        return NULL;
+    }
+    int n = header[2];
+
+    // the rest of the file must hold every array, checked before any of
+    // them is allocated
+    long left = file_bytes_left(file);
+    long words = m / 64 + 1;
+    if(left >= 0 && (m > left / (2 * (long)sizeof(int)) ||
+                     2 * ((n + 1L) * (long)sizeof(long) + m * (long)sizeof(int) +
+                          words * (long)sizeof(uint64_t)) +
+                     n * (2L * (long)sizeof(double) + 1) > left)){
+        return NULL;
+    }
+
+    csr_t *csr = (csr_t*)malloc(sizeof(csr_t));
+    if(csr == NULL){
+        fprintf(stderr, "csr_load: malloc failed\n");
+        exit(1);
+    }
+    csr->num_nodes = n;
+    csr->num_edges = m;
+    csr->base = NULL;
+    csr->slab = NULL;
+    csr->slab_bytes = 0;
+    atomic_init(&csr->spare_state, NULL);
+    csr->out_off = (long*)malloc(sizeof(long) * (n + 1));
+    csr->in_off = (long*)malloc(sizeof(long) * (n + 1));
+    csr->out_to = (int*)malloc(sizeof(int) * (m + 1));
+    csr->in_from = (int*)malloc(sizeof(int) * (m + 1));
+    csr->out_two_way = (uint64_t*)malloc(sizeof(uint64_t) * words);
+    csr->in_two_way = (uint64_t*)malloc(sizeof(uint64_t) * words);
+    csr->latitude = (double*)malloc(sizeof(double) * (n + 1));
+    csr->longitude = (double*)malloc(sizeof(double) * (n + 1));
+    csr->exists = (uint8_t*)malloc(n + 1);
+    if(!csr->out_off || !csr->in_off || !csr->out_to || !csr->in_from ||
+       !csr->out_two_way || !csr->in_two_way || !csr->latitude ||
+       !csr->longitude || !csr->exists){
+        fprintf(stderr, "csr_load - arrays: malloc failed\n");
+        exit(1);
+    }
+
+    if(!read_rows(csr->out_off, csr->out_to, csr->out_two_way, n, m, file) ||
+       !read_rows(csr->in_off, csr->in_from, csr->in_two_way, n, m, file) ||
+       fread(csr->latitude, sizeof(double), n, file) != (size_t)n ||
+       fread(csr->longitude, sizeof(double), n, file) != (size_t)n ||
+       fread(csr->exists, 1, n, file) != (size_t)n){
+        csr_free(csr);
+        return NULL;
+    }
+
+    if(alloc == CSR_ALLOC_HUGE_PAGES){
+        csr_move_to_huge_pages(csr);
+    }
+    return csr;
+}
+
+/********* CSR BUILDER *********/
+
+#define BUFFER_MIN (1024)
+#define ROW_INSERTION_SORT (16)
+
+/* Edges waiting in a builder, one buffer per thread, each on its own
+ * cache line. A two-way edge is kept once, leaving its lower-numbered
+ * node like in csr_create, with ~to in place of to. The rows mark
+ * two-way edges the same way until their flags are set, as threads
+ * cannot set bits of a shared flag word without atomics.
+ */
+typedef struct {
+    _Alignas(64) int *from;
+    int *to;
+    long count;
+    long capacity;
+} buffer_t;
+
+struct csr_builder {
+    int num_nodes;
+    int num_buffers;
+    tpool_t *pool;
+    buffer_t *buffers;
+
+    double *latitude;
+    double *longitude;
+    uint8_t *exists;
+
+    // row cursors of csr_builder_finish, counts first and then positions
+    atomic_long *out_pos;
+    atomic_long *in_pos;
+    csr_t *csr;
+
+    // the out rows without self-loops and duplicates, see clean_out
+    uint8_t *keep;
+    long *clean_off;
+    int *clean_to;
+    atomic_long duplicates;
+    atomic_long self_loops;
+};
+
+/* csr_builder_create: create an empty builder
+ *
+ * num_nodes: number of node slots, like graph_create
+ * num_threads: threads of the pool csr_builder_finish runs on, and the
+ *     number of edge buffers, 0 for one per core
+ * 
+ * Returns: the builder
+ */ 
+csr_builder_t *csr_builder_create(int num_nodes, int num_threads)
+{
+    csr_builder_t *b = (csr_builder_t*)malloc(sizeof(csr_builder_t));
+    if(b == NULL){
+        fprintf(stderr, "csr_builder_create: malloc failed\n");
+        exit(1);
+    }
+    b->num_nodes = num_nodes;
+    b->pool = tpool_create(num_threads);
+    b->num_buffers = tpool_size(b->pool);
+    b->buffers = (buffer_t*)aligned_alloc(64, sizeof(buffer_t) * b->num_buffers);
+    b->latitude = (double*)calloc(num_nodes + 1, sizeof(double));
+    b->longitude = (double*)calloc(num_nodes + 1, sizeof(double));
+    b->exists = (uint8_t*)calloc(num_nodes + 1, 1);
+    if(!b->buffers || !b->latitude || !b->longitude || !b->exists){
+        fprintf(stderr, "csr_builder_create - arrays: malloc failed\n");
+        exit(1);
+    }
+    memset(b->buffers, 0, sizeof(buffer_t) * b->num_buffers);
+    b->out_pos = NULL;
+    b->in_pos = NULL;
+    b->csr = NULL;
+    b->keep = NULL;
+    b->clean_off = NULL;
+    b->clean_to = NULL;
+    atomic_init(&b->duplicates, 0);
+    atomic_init(&b->self_loops, 0);
+    return b;
+}
+
+/* csr_builder_num_buffers: number of edge buffers of a builder
+ *
+ * b: the builder
+ * 
+ * Returns: the number of buffers, the number of threads of its pool
+ */ 
+int csr_builder_num_buffers(csr_builder_t *b)
+{
+    return b->num_buffers;
+}
+
+/* csr_builder_add_node: add a node, like node_create without a name.
+ *     Threads may add different nodes at the same time.
+ *
+ * b: the builder
+ * node_num: node number
+ * latitude: node latitude
+ * longitude: node longitude
+ */ 
+void csr_builder_add_node(csr_builder_t *b, int node_num, double latitude,
+                          double longitude)
+{
+    assert(node_num >= 0 && node_num < b->num_nodes);
+    b->latitude[node_num] = latitude;
+    b->longitude[node_num] = longitude;
+    b->exists[node_num] = 1;
+}
+
+/* buffer_push: append an edge to a buffer
+ *
+ * Inputs:
+ * - buf: the buffer (buffer_t*)
+ * - from: the node the edge leaves (int)
+ * - to: the node it enters, ~to for a two-way edge (int)
+ *
+ * Output: none. function is void.
+ */
+static void buffer_push(buffer_t *buf, int from, int to)
+{
+    if(buf->count == buf->capacity){
+        buf->capacity = buf->capacity ? 2 * buf->capacity : BUFFER_MIN;
+        buf->from = (int*)realloc(buf->from, sizeof(int) * buf->capacity);
+        buf->to = (int*)realloc(buf->to, sizeof(int) * buf->capacity);
+        if(!buf->from || !buf->to){
+            fprintf(stderr, "buffer_push: realloc failed\n");
+            exit(1);
+        }
+    }
+    buf->from[buf->count] = from;
+    buf->to[buf->count] = to;
+    buf->count++;
+}
+
+/* csr_builder_add_edge: add a two-way edge, like add_edge. Threads may
+ *     add edges at the same time, each to a different buffer.
+ *
+ * b: the builder
+ * buffer: the buffer of the calling thread, 0 to
+ *     csr_builder_num_buffers(b) - 1
+ * node_num1: the first node
+ * node_num2: the second node
+ * 
+ * The nodes may be added later, but before csr_builder_finish.
+ */ 
+void csr_builder_add_edge(csr_builder_t *b, int buffer, int node_num1,
+                          int node_num2)
+{
+    assert(buffer >= 0 && buffer < b->num_buffers);
+    assert(node_num1 >= 0 && node_num1 < b->num_nodes);
+    assert(node_num2 >= 0 && node_num2 < b->num_nodes);
+    int lo = node_num1 < node_num2 ? node_num1 : node_num2;
+    int hi = node_num1 < node_num2 ? node_num2 : node_num1;
+    buffer_push(&b->buffers[buffer], lo, ~hi);
+}
+
+/* csr_builder_add_arc: add a one-way edge, like add_arc, see
+ *     csr_builder_add_edge
+ *
+ * b: the builder
+ * buffer: the buffer of the calling thread
+ * from_node_num: the node the edge leaves
+ * to_node_num: the node the edge enters
+ */ 
+void csr_builder_add_arc(csr_builder_t *b, int buffer, int from_node_num,
+                         int to_node_num)
+{
+    assert(buffer >= 0 && buffer < b->num_buffers);
+    assert(from_node_num >= 0 && from_node_num < b->num_nodes);
+    assert(to_node_num >= 0 && to_node_num < b->num_nodes);
+    buffer_push(&b->buffers[buffer], from_node_num, to_node_num);
+}
+
+/* cmp_int: qsort comparator
+ *
+ * Inputs:
+ * - a, b: pointers to the ints (const void*)
+ *
+ * Output: negative, zero or positive (int)
+ */
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+/* sort_row: sort one row of marked node numbers
+ *
+ * Inputs:
+ * - row: the row (int*)
+ * - len: its length (long)
+ *
+ * Output: none. function is void.
+ */
+static void sort_row(int *row, long len)
+{
+    // rows of road graphs are short
+    if(len > ROW_INSERTION_SORT){
+        qsort(row, len, sizeof(int), cmp_int);
+        return;
+    }
+    for(long i = 1; i < len; i++){
+        int x = row[i];
+        long j = i;
+        while(j > 0 && row[j - 1] > x){
+            row[j] = row[j - 1];
+            j--;
+        }
+        row[j] = x;
+    }
+}
+
+/* row_has: determines whether a sorted row holds a marked node number
+ *
+ * Inputs:
+ * - row: the row (const int*)
+ * - len: its length (long)
+ * - x: the marked node number (int)
+ *
+ * Output: true if x is in the row (bool)
+ */
+static bool row_has(const int *row, long len, int x)
+{
+    long lo = 0, hi = len;
+    while(lo < hi){
+        long mid = (lo + hi) / 2;
+        if(row[mid] < x){
+            lo = mid + 1;
+        }else{
+            hi = mid;
+        }
+    }
+    return lo < len && row[lo] == x;
+}
+
+/* Steps of csr_builder_finish. The out rows are built from the buffers
+ * and cleaned, then the in rows are built from the out rows:
+ *
+ * count_out: count the edges of every out row, from the buffer of the
+ *     thread
+ * start_out, start_in: turn the counts of a range of nodes into row
+ *     positions
+ * place_out: put the edges of the buffer of the thread in their out rows
+ * sort_out, sort_in: sort the rows of a range of nodes
+ * clean_out: mark the self-loops and duplicates in the out rows of a
+ *     range of nodes, and count the edges kept in each row
+ * move_out: copy the kept edges of a range of nodes to the cleaned rows
+ * count_in: count the in row edges of the out rows of a range of nodes
+ * place_in: put the edges of the out rows of a range of nodes in their
+ *     in rows
+ * set_flags: set the two-way flags of a range of flag words, and clear
+ *     the marks of the edges they cover
+ */
+static void count_out(int tid, void *arg)
+{
+    csr_builder_t *b = (csr_builder_t*)arg;
+    buffer_t *buf = &b->buffers[tid];
+    for(long i = 0; i < buf->count; i++){
+        assert(b->exists[buf->from[i]] && b->exists[buf->to[i] < 0 ? ~buf->to[i] : buf->to[i]]);
+        atomic_fetch_add_explicit(&b->out_pos[buf->from[i]], 1, memory_order_relaxed);
+    }
+}
+
+static void start_out(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_builder_t *b = (csr_builder_t*)arg;
+    for(long u = lo; u < hi; u++){
+        atomic_store_explicit(&b->out_pos[u], b->csr->out_off[u], memory_order_relaxed);
+    }
+}
+
+static void start_in(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_builder_t *b = (csr_builder_t*)arg;
+    for(long u = lo; u < hi; u++){
+        atomic_store_explicit(&b->in_pos[u], b->csr->in_off[u], memory_order_relaxed);
+    }
+}
+
+static void place_out(int tid, void *arg)
+{
+    csr_builder_t *b = (csr_builder_t*)arg;
+    buffer_t *buf = &b->buffers[tid];
+    for(long i = 0; i < buf->count; i++){
+        long out = atomic_fetch_add_explicit(&b->out_pos[buf->from[i]], 1, memory_order_relaxed);
+        b->csr->out_to[out] = buf->to[i];
+    }
+}
+
+static void sort_out(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_t *csr = ((csr_builder_t*)arg)->csr;
+    for(long u = lo; u < hi; u++){
+        sort_row(csr->out_to + csr->out_off[u], csr->out_off[u + 1] - csr->out_off[u]);
+    }
+}
+
+static void sort_in(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_t *csr = ((csr_builder_t*)arg)->csr;
+    for(long u = lo; u < hi; u++){
+        sort_row(csr->in_from + csr->in_off[u], csr->in_off[u + 1] - csr->in_off[u]);
+    }
+}
+
+static void clean_out(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_builder_t *b = (csr_builder_t*)arg;
+    csr_t *csr = b->csr;
+    long duplicates = 0;
+    long self_loops = 0;
+    for(long u = lo; u < hi; u++){
+        long kept = 0;
+        for(long e = csr->out_off[u]; e < csr->out_off[u + 1]; e++){
+            int x = csr->out_to[e];
+            int v = x < 0 ? ~x : x;
+
+            // an arc is covered by a two-way edge between its nodes, kept
+            // in the row of the lower-numbered one
+            int low = u < v ? (int)u : v;
+            int high = u < v ? v : (int)u;
+            bool drop = true;
+            if(v == u){
+                self_loops++;
+            }else if((e > csr->out_off[u] && csr->out_to[e - 1] == x) ||
+                     (x >= 0 && row_has(csr->out_to + csr->out_off[low], 
+                                        csr->out_off[low + 1] - csr->out_off[low], ~high))){
+                duplicates++;
+            }else{
+                drop = false;
+                kept++;
+            }
+            b->keep[e] = !drop;
+        }
+        atomic_store_explicit(&b->out_pos[u], kept, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&b->duplicates, duplicates, memory_order_relaxed);
+    atomic_fetch_add_explicit(&b->self_loops, self_loops, memory_order_relaxed);
+}
+
+static void move_out(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_builder_t *b = (csr_builder_t*)arg;
+    csr_t *csr = b->csr;
+    for(long u = lo; u < hi; u++){
+        long pos = b->clean_off[u];
+        for(long e = csr->out_off[u]; e < csr->out_off[u + 1]; e++){
+            if(b->keep[e]){
+                b->clean_to[pos++] = csr->out_to[e];
+            }
+        }
+    }
+}
+
+static void count_in(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_builder_t *b = (csr_builder_t*)arg;
+    csr_t *csr = b->csr;
+    for(long u = lo; u < hi; u++){
+        for(long e = csr->out_off[u]; e < csr->out_off[u + 1]; e++){
+            int v = csr->out_to[e] < 0 ? ~csr->out_to[e] : csr->out_to[e];
+            atomic_fetch_add_explicit(&b->in_pos[v], 1, memory_order_relaxed);
+        }
+    }
+}
+
+static void place_in(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_builder_t *b = (csr_builder_t*)arg;
+    csr_t *csr = b->csr;
+    for(long u = lo; u < hi; u++){
+        for(long e = csr->out_off[u]; e < csr->out_off[u + 1]; e++){
+            int x = csr->out_to[e];
+            int v = x < 0 ? ~x : x;
+            long in = atomic_fetch_add_explicit(&b->in_pos[v], 1, memory_order_relaxed);
+            csr->in_from[in] = x < 0 ? ~(int)u : (int)u;
+        }
+    }
+}
+
+static void set_flags(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    csr_t *csr = ((csr_builder_t*)arg)->csr;
+    long end = hi * 64 < csr->num_edges ? hi * 64 : csr->num_edges;
+    for(long e = lo * 64; e < end; e++){
+        if(csr->out_to[e] < 0){
+            csr->out_to[e] = ~csr->out_to[e];
+            bit_set(csr->out_two_way, e);
+        }
+        if(csr->in_from[e] < 0){
+            csr->in_from[e] = ~csr->in_from[e];
+            bit_set(csr->in_two_way, e);
+        }
+    }
+}
+
+/* prefix_rows: turn per-node counts into row offsets
+ *
+ * Inputs:
+ * - counts: the count of each node, n entries (atomic_long*)
+ * - off: filled with the offsets, n + 1 entries (long*)
+ * - n: the number of nodes (int)
+ *
+ * Output: the total, off[n] (long)
+ */
+static long prefix_rows(atomic_long *counts, long *off, int n)
+{
+    off[0] = 0;
+    for(int u = 0; u < n; u++){
+        off[u + 1] = off[u] + atomic_load_explicit(&counts[u], memory_order_relaxed);
+    }
+    return off[n];
+}
+
+/* csr_builder_finish: build the CSR graph and free the builder, once no
+ *     thread is adding to it
+ *
+ * b: the builder
+ * alloc: where the arrays of the graph, and of each search on it, live
+ * clean: NULL to keep every edge, or set to the number of edges dropped
+ *     for each reason as self-loops and duplicates are dropped, keeping
+ *     the edges graph_clean keeps
+ * 
+ * Returns: the CSR graph
+ */ 
+csr_t *csr_builder_finish(csr_builder_t *b, csr_alloc_t alloc, graph_clean_t *clean)
+{
+    int n = b->num_nodes;
+    long m = 0;
+    for(int i = 0; i < b->num_buffers; i++){
+        m += b->buffers[i].count;
+    }
+
+    csr_t *csr = (csr_t*)malloc(sizeof(csr_t));
+    if(csr == NULL){
+        fprintf(stderr, "csr_builder_finish: malloc failed\n");
+        exit(1);
+    }
+    csr->num_nodes = n;
+    csr->base = NULL;
+    csr->slab = NULL;
+    csr->slab_bytes = 0;
+    atomic_init(&csr->spare_state, NULL);
+    csr->out_off = (long*)malloc(sizeof(long) * (n + 1));
+    csr->in_off = (long*)malloc(sizeof(long) * (n + 1));
+    csr->out_to = (int*)malloc(sizeof(int) * (m + 1));
+    b->out_pos = (atomic_long*)calloc(n + 1, sizeof(atomic_long));
+    b->in_pos = (atomic_long*)calloc(n + 1, sizeof(atomic_long));
+    if(!csr->out_off || !csr->in_off || !csr->out_to || !b->out_pos || !b->in_pos){
+        fprintf(stderr, "csr_builder_finish - arrays: malloc failed\n");
+        exit(1);
+    }
+    b->csr = csr;
+
+    tpool_run(b->pool, count_out, b);
+    prefix_rows(b->out_pos, csr->out_off, n);
+    tpool_for(b->pool, n, 0, start_out, b);
+    tpool_run(b->pool, place_out, b);
+    tpool_for(b->pool, n, 0, sort_out, b);
+    for(int i = 0; i < b->num_buffers; i++){
+        free(b->buffers[i].from);
+        free(b->buffers[i].to);
+        b->buffers[i].from = b->buffers[i].to = NULL;
+    }
+
+    if(clean){
+        b->keep = (uint8_t*)malloc(m + 1);
+        b->clean_off = (long*)malloc(sizeof(long) * (n + 1));
+        if(!b->keep || !b->clean_off){
+            fprintf(stderr, "csr_builder_finish - clean: malloc failed\n");
+            exit(1);
+        }
+        tpool_for(b->pool, n, 0, clean_out, b);
+        m = prefix_rows(b->out_pos, b->clean_off, n);
+        b->clean_to = (int*)malloc(sizeof(int) * (m + 1));
+        if(b->clean_to == NULL){
+            fprintf(stderr, "csr_builder_finish - clean: malloc failed\n");
+            exit(1);
+        }
+        tpool_for(b->pool, n, 0, move_out, b);
+
+        long *off = csr->out_off;
+        int *to = csr->out_to;
+        csr->out_off = b->clean_off;
+        csr->out_to = b->clean_to;
+        b->clean_off = off;
+        b->clean_to = to;
+        clean->duplicates = atomic_load(&b->duplicates);
+        clean->self_loops = atomic_load(&b->self_loops);
+    }
+
+    long words = m / 64 + 1;
+    csr->num_edges = m;
+    csr->in_from = (int*)malloc(sizeof(int) * (m + 1));
+    csr->out_two_way = (uint64_t*)calloc(words, sizeof(uint64_t));
+    csr->in_two_way = (uint64_t*)calloc(words, sizeof(uint64_t));
+    if(!csr->in_from || !csr->out_two_way || !csr->in_two_way){
+        fprintf(stderr, "csr_builder_finish - edges: malloc failed\n");
+        exit(1);
+    }
+    tpool_for(b->pool, n, 0, count_in, b);
+    prefix_rows(b->in_pos, csr->in_off, n);
+    tpool_for(b->pool, n, 0, start_in, b);
+    tpool_for(b->pool, n, 0, place_in, b);
+    tpool_for(b->pool, n, 0, sort_in, b);
+    tpool_for(b->pool, words, 0, set_flags, b);
+
+    // the coordinates move to the graph as they are
+    csr->latitude = b->latitude;
+    csr->longitude = b->longitude;
+    csr->exists = b->exists;
+    b->latitude = NULL;
+    b->longitude = NULL;
+    b->exists = NULL;
+    csr_builder_free(b);
+
+    if(alloc == CSR_ALLOC_HUGE_PAGES){
+        csr_move_to_huge_pages(csr);
+    }
+    return csr;
+}
+
+/* csr_builder_free: free a builder without building the graph
+ *
+ * b: the builder
+ */ 
+void csr_builder_free(csr_builder_t *b)
+{
+    for(int i = 0; i < b->num_buffers; i++){
+        free(b->buffers[i].from);
+        free(b->buffers[i].to);
+    }
+    free(b->buffers);
+    free(b->latitude);
+    free(b->longitude);
+    free(b->exists);
+    free(b->out_pos);
+    free(b->in_pos);
+    free(b->keep);
+    free(b->clean_off);
+    free(b->clean_to);
+    tpool_free(b->pool);
+    free(b);
+}
+
+/********* A* SEARCH *********/
+
+typedef struct {
+    csr_t *csr;
+    int end;
+    search_labels_t labels;
+    heap_t *open;
+} csr_search_t;
+
+/* dist_between: straight-line distance between two nodes, like h_calc
+ *
+ * Inputs:
+ * - csr: the CSR graph (csr_t*)
+ * - u, v: node numbers (int)
+ *
+ * Output: the distance (double)
+ */
+static inline double dist_between(csr_t *csr, int u, int v)
+{
+    double dx = csr->longitude[u] - csr->longitude[v];
+    double dy = csr->latitude[u] - csr->latitude[v];
+    return sqrt(dx * dx + dy * dy);
+}
+
+/* relax: offer a path through curr to one of its neighbors
+ *
+ * Inputs:
+ * - s: the search state (csr_search_t*)
+ * - curr: the node being expanded (int)
+ * - v: the neighbor (int)
+ *
+ * Output: none. function is void.
+ */
+static inline void relax(csr_search_t *s, int curr, int v)
+{
+    if(bit_get(s->labels.closed, v)){
+        return;
+    }
+    double ng = s->labels.g[curr] + dist_between(s->csr, curr, v);
+    if(search_labels_improve(&s->labels, v, ng)){
+        heap_push(s->open, v, ng + dist_between(s->csr, v, s->end));
+    }
+}
+
+/* prefetch_node: start loading what relaxing an edge to a node reads
+ *
+ * Inputs:
+ * - s: the search state (csr_search_t*)
+ * - v: the node (int)
+ *
+ * Output: none. function is void.
+ */
+static inline void prefetch_node(csr_search_t *s, int v)
+{
+#if CSR_PREFETCH_DISTANCE > 0 && defined(__GNUC__)
+    __builtin_prefetch(&s->csr->longitude[v]);
+    __builtin_prefetch(&s->csr->latitude[v]);
+    __builtin_prefetch(&s->labels.g[v], 1);
+#else
+    (void)s;
+    (void)v;
+#endif
+}
+
+/* prefetch_row: start loading the row offsets of the node likely to be
+ *     expanded next, the top of the open list
+ *
+ * Inputs:
+ * - s: the search state (csr_search_t*)
+ *
+ * Output: none. function is void.
+ */
+static inline void prefetch_row(csr_search_t *s)
+{
+#if CSR_PREFETCH_DISTANCE > 0 && defined(__GNUC__)
+    if(!heap_is_empty(s->open)){
+        int next = heap_min_num(s->open);
+        __builtin_prefetch(&s->csr->out_off[next]);
+        __builtin_prefetch(&s->csr->in_off[next]);
+    }
+#else
+    (void)s;
+#endif
+}
+
+/* a_star_csr: performs A* search on a CSR graph
+ *
+ * csr: the CSR graph, or a reversed view to search against the edges
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */ 
+double a_star_csr(csr_t *csr, int start_node_num, int end_node_num)
+{
+    assert(csr->exists[start_node_num] && csr->exists[end_node_num]);
+
+    int n = csr->num_nodes;
+    int words = n / 64 + 1;
+    csr_search_t s;
+    s.csr = csr;
+    s.end = end_node_num;
+
+    // a graph on huge pages gets its search state on huge pages too, taken
+    // from the spare if no other search holds it
+    csr_t *base = csr->base ? csr->base : csr;
+    bool huge = base->slab != NULL;
+    size_t state_bytes = sizeof(double) * (n + 1) + 2 * sizeof(uint64_t) * words;
+    if(huge){
+        s.labels.g = (double*)atomic_exchange(&base->spare_state, NULL);
+        if(s.labels.g == NULL){
+            s.labels.g = (double*)huge_alloc(state_bytes);
+        }
+        s.labels.seen = (uint64_t*)(s.labels.g + n + 1);
+        s.labels.closed = s.labels.seen + words;
+        memset(s.labels.seen, 0, 2 * sizeof(uint64_t) * words);
+    }else{
+        search_labels_init(&s.labels, n);
+    }
+    s.open = heap_create(1024);
+    double cost = -1;
+
+    search_labels_improve(&s.labels, start_node_num, 0);
+    heap_push(s.open, start_node_num, dist_between(csr, start_node_num, end_node_num));
+
+    while(!heap_is_empty(s.open)){
+        int curr = heap_pop(s.open, NULL);
+        if(!search_labels_close(&s.labels, curr)){
+            continue;
+        }
+        if(curr == end_node_num){
+            cost = s.labels.g[curr];
+            break;
+        }
+
+        // every edge out of curr, then the two-way edges into it, with the
+        // neighbor CSR_PREFETCH_DISTANCE edges ahead already on its way
+        long out_begin = csr->out_off[curr], out_end = csr->out_off[curr + 1];
+        long in_begin = csr->in_off[curr], in_end = csr->in_off[curr + 1];
+        if(CSR_PREFETCH_DISTANCE > 0){
+            for(long e = out_begin; e < out_end && e < out_begin + CSR_PREFETCH_DISTANCE; e++){
+                prefetch_node(&s, csr->out_to[e]);
+            }
+            for(long e = in_begin; e < in_end && e < in_begin + CSR_PREFETCH_DISTANCE; e++){
+                prefetch_node(&s, csr->in_from[e]);
+            }
+        }
+        for(long e = out_begin; e < out_end; e++){
+            if(CSR_PREFETCH_DISTANCE > 0 && e + CSR_PREFETCH_DISTANCE < out_end){
+                prefetch_node(&s, csr->out_to[e + CSR_PREFETCH_DISTANCE]);
+            }
+            relax(&s, curr, csr->out_to[e]);
+        }
+        for(long e = in_begin; e < in_end; e++){
+            if(CSR_PREFETCH_DISTANCE > 0 && e + CSR_PREFETCH_DISTANCE < in_end){
+                prefetch_node(&s, csr->in_from[e + CSR_PREFETCH_DISTANCE]);
+            }
+            if(bit_get(csr->in_two_way, e)){
+                relax(&s, curr, csr->in_from[e]);
+            }
+        }
+        prefetch_row(&s);
+    }
+
+    heap_free(s.open);
+    if(huge){
+        void *none = NULL;
+        if(!atomic_compare_exchange_strong(&base->spare_state, &none, (void*)s.labels.g)){
+            huge_free(s.labels.g, state_bytes);
+        }
+    }else{
+        search_labels_free(&s.labels);
+    }
+
+    return cost;
+}
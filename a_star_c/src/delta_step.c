@@ -0,0 +1,596 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "a_star.h"
+#include "delta_step.h"
+#include "parallel.h"
+
+/********* INT VECTOR *********/
+
+typedef struct vec vec_t;
+
+struct vec {
+    int *items;
+    long size;
+    long capacity;
+};
+
+/* vec_push: append to a vector
+ *
+ * Inputs:
+ * - v: the vector (vec_t*)
+ * - num: the number to append (int)
+ *
+ * Output: none. function is void.
+ */
+static void vec_push(vec_t *v, int num)
+{
+    if(v->size == v->capacity){
+        v->capacity = v->capacity ? v->capacity * 2 : 64;
+        v->items = (int*)realloc(v->items, sizeof(int) * v->capacity);
+        if(v->items == NULL){
+            fprintf(stderr, "delta_stepping - vec_push: realloc failed\n");
+            exit(1);
+        }
+    }
+    v->items[v->size++] = num;
+}
+
+/********* SEARCH STATE *********/
+
+// buckets and settled nodes of one worker, on their own cache lines
+typedef struct {
+    _Alignas(64) vec_t *bins;
+    long num_bins;
+    vec_t settled;
+} local_t;
+
+typedef struct delta delta_t;
+
+struct delta {
+    graph_t *graph;
+    int source;
+    double delta;
+    int num_threads;
+
+    // light and heavy adjacency with cached edge costs
+    long *light_off;
+    int *light_to;
+    double *light_cost;
+    long *heavy_off;
+    int *heavy_to;
+    double *heavy_cost;
+
+    _Atomic double *dist;
+    atomic_char *done;
+
+    local_t *local;
+    vec_t frontier;
+    long bucket;
+
+    // partial sums of the first pass, one per thread
+    double *cost_sum;
+    long *edge_count;
+};
+
+/* bucket_of: bucket that holds a distance
+ *
+ * Inputs:
+ * - d: the search state (delta_t*)
+ * - dist: the distance (double)
+ *
+ * Output: bucket index (long)
+ */
+static inline long bucket_of(delta_t *d, double dist)
+{
+    return (long)(dist / d->delta);
+}
+
+/* local_insert: put a node into a worker's bucket
+ *
+ * Inputs:
+ * - l: the worker's buckets (local_t*)
+ * - bucket: bucket index (long)
+ * - node_num: the node (int)
+ *
+ * Output: none. function is void.
+ */
+static void local_insert(local_t *l, long bucket, int node_num)
+{
+    if(bucket >= l->num_bins){
+        long num_bins = l->num_bins ? l->num_bins : 16;
+        while(num_bins <= bucket){
+            num_bins *= 2;
+        }
+        l->bins = (vec_t*)realloc(l->bins, sizeof(vec_t) * num_bins);
+        if(l->bins == NULL){
+            fprintf(stderr, "delta_stepping - local_insert: realloc failed\n");
+            exit(1);
+        }
+        memset(l->bins + l->num_bins, 0, sizeof(vec_t) * (num_bins - l->num_bins));
+        l->num_bins = num_bins;
+    }
+    vec_push(&l->bins[bucket], node_num);
+}
+
+/* relax: offer a distance to a node, lock-free
+ *
+ * Inputs:
+ * - d: the search state (delta_t*)
+ * - tid: the calling worker (int)
+ * - node_num: the node (int)
+ * - dist: the offered distance (double)
+ *
+ * Output: none. function is void.
+ */
+static inline void relax(delta_t *d, int tid, int node_num, double dist)
+{
+    double old = atomic_load_explicit(&d->dist[node_num], memory_order_relaxed);
+    while(dist < old){
+        if(atomic_compare_exchange_weak_explicit(&d->dist[node_num], &old, dist,
+                                                 memory_order_relaxed,
+                                                 memory_order_relaxed)){
+            local_insert(&d->local[tid], bucket_of(d, dist), node_num);
+            return;
+        }
+    }
+}
+
+/********* EDGE CLASSIFICATION *********/
+
+/* sum_costs: first pass, total edge cost for the default delta
+ *
+ * Inputs: tpool_range_fn over node numbers
+ *
+ * Output: none. function is void.
+ */
+static void sum_costs(long lo, long hi, int tid, void *arg)
+{
+    delta_t *d = (delta_t*)arg;
+    node_t **nodes = d->graph->nodes;
+    double total = 0;
+    long count = 0;
+    for(long u = lo; u < hi; u++){
+        if(!nodes[u]){
+            continue;
+        }
+        for(intlist_t *nb = nodes[u]->neighbors; nb; nb = nb->next){
+            total += h_calc(nodes[u], nodes[nb->num]);
+            count++;
+        }
+    }
+    d->cost_sum[tid] += total;
+    d->edge_count[tid] += count;
+}
+
+/* count_edges: second pass, light and heavy degree of every node
+ *
+ * Inputs: tpool_range_fn over node numbers
+ *
+ * Output: none. function is void.
+ */
+static void count_edges(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    delta_t *d = (delta_t*)arg;
+    node_t **nodes = d->graph->nodes;
+    for(long u = lo; u < hi; u++){
+        long light = 0, heavy = 0;
+        if(nodes[u]){
+            for(intlist_t *nb = nodes[u]->neighbors; nb; nb = nb->next){
+                if(h_calc(nodes[u], nodes[nb->num]) <= d->delta){
+                    light++;
+                }else{
+                    heavy++;
+                }
+            }
+        }
+        d->light_off[u + 1] = light;
+        d->heavy_off[u + 1] = heavy;
+    }
+}
+
+/* fill_edges: third pass, copy edges into the light and heavy arrays
+ *
+ * Inputs: tpool_range_fn over node numbers
+ *
+ * Output: none. function is void.
+ */
+static void fill_edges(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    delta_t *d = (delta_t*)arg;
+    node_t **nodes = d->graph->nodes;
+    for(long u = lo; u < hi; u++){
+        if(!nodes[u]){
+            continue;
+        }
+        long light = d->light_off[u];
+        long heavy = d->heavy_off[u];
+        for(intlist_t *nb = nodes[u]->neighbors; nb; nb = nb->next){
+            double cost = h_calc(nodes[u], nodes[nb->num]);
+            if(cost <= d->delta){
+                d->light_to[light] = nb->num;
+                d->light_cost[light++] = cost;
+            }else{
+                d->heavy_to[heavy] = nb->num;
+                d->heavy_cost[heavy++] = cost;
+            }
+        }
+    }
+}
+
+/* classify_edges: split every adjacency list into light and heavy edges
+ *
+ * Inputs:
+ * - d: the search state (delta_t*)
+ * - pool: the thread pool (tpool_t*)
+ * - delta: requested bucket width, 0 for the average edge cost (double)
+ *
+ * Output: none. function is void.
+ */
+static void classify_edges(delta_t *d, tpool_t *pool, double delta)
+{
+    long n = d->graph->num_nodes;
+
+    if(delta <= 0){
+        d->cost_sum = (double*)calloc(d->num_threads, sizeof(double));
+        d->edge_count = (long*)calloc(d->num_threads, sizeof(long));
+        if(!d->cost_sum || !d->edge_count){
+            fprintf(stderr, "delta_stepping - classify_edges: calloc failed\n");
+            exit(1);
+        }
+        tpool_for(pool, n, 0, sum_costs, d);
+
+        double total = 0;
+        long count = 0;
+        for(int i = 0; i < d->num_threads; i++){
+            total += d->cost_sum[i];
+            count += d->edge_count[i];
+        }
+        delta = count && total > 0 ? total / count : 1;
+        free(d->cost_sum);
+        free(d->edge_count);
+    }
+    d->delta = delta;
+
+    d->light_off = (long*)malloc(sizeof(long) * (n + 1));
+    d->heavy_off = (long*)malloc(sizeof(long) * (n + 1));
+    if(!d->light_off || !d->heavy_off){
+        fprintf(stderr, "delta_stepping - classify_edges: malloc failed\n");
+        exit(1);
+    }
+    d->light_off[0] = 0;
+    d->heavy_off[0] = 0;
+    tpool_for(pool, n, 0, count_edges, d);
+    for(long u = 0; u < n; u++){
+        d->light_off[u + 1] += d->light_off[u];
+        d->heavy_off[u + 1] += d->heavy_off[u];
+    }
+
+    long num_light = d->light_off[n];
+    long num_heavy = d->heavy_off[n];
+    d->light_to = (int*)malloc(sizeof(int) * (num_light + 1));
+    d->light_cost = (double*)malloc(sizeof(double) * (num_light + 1));
+    d->heavy_to = (int*)malloc(sizeof(int) * (num_heavy + 1));
+    d->heavy_cost = (double*)malloc(sizeof(double) * (num_heavy + 1));
+    if(!d->light_to || !d->light_cost || !d->heavy_to || !d->heavy_cost){
+        fprintf(stderr, "delta_stepping - classify_edges: malloc failed\n");
+        exit(1);
+    }
+    tpool_for(pool, n, 0, fill_edges, d);
+}
+
+/********* PHASES *********/
+
+/* init_nodes: reset the distances
+ *
+ * Inputs: tpool_range_fn over node numbers
+ *
+ * Output: none. function is void.
+ */
+static void init_nodes(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    delta_t *d = (delta_t*)arg;
+    for(long u = lo; u < hi; u++){
+        atomic_init(&d->dist[u], INFINITY);
+        atomic_init(&d->done[u], 0);
+    }
+}
+
+/* relax_light: relax the light edges of the nodes in the frontier
+ *
+ * Inputs: tpool_range_fn over frontier positions
+ *
+ * Output: none. function is void.
+ */
+static void relax_light(long lo, long hi, int tid, void *arg)
+{
+    delta_t *d = (delta_t*)arg;
+    for(long i = lo; i < hi; i++){
+        int u = d->frontier.items[i];
+        double du = atomic_load_explicit(&d->dist[u], memory_order_relaxed);
+
+        // the node moved to an earlier bucket after it was queued here
+        if(bucket_of(d, du) != d->bucket){
+            continue;
+        }
+        vec_push(&d->local[tid].settled, u);
+
+        for(long e = d->light_off[u]; e < d->light_off[u + 1]; e++){
+            relax(d, tid, d->light_to[e], du + d->light_cost[e]);
+        }
+    }
+}
+
+/* relax_heavy: relax the heavy edges of the nodes settled in the 
+ *     current bucket, once per node
+ *
+ * Inputs:
+ * - tid: worker index (int)
+ * - arg: the search state (delta_t*)
+ *
+ * Output: none. function is void.
+ */
+static void relax_heavy(int tid, void *arg)
+{
+    delta_t *d = (delta_t*)arg;
+    vec_t *settled = &d->local[tid].settled;
+    for(long i = 0; i < settled->size; i++){
+        int u = settled->items[i];
+        if(atomic_exchange_explicit(&d->done[u], 1, memory_order_relaxed)){
+            continue;
+        }
+        double du = atomic_load_explicit(&d->dist[u], memory_order_relaxed);
+        for(long e = d->heavy_off[u]; e < d->heavy_off[u + 1]; e++){
+            relax(d, tid, d->heavy_to[e], du + d->heavy_cost[e]);
+        }
+    }
+    settled->size = 0;
+}
+
+/* collect_bucket: move the current bucket of every worker into the
+ *     shared frontier
+ *
+ * Inputs:
+ * - d: the search state (delta_t*)
+ *
+ * Output: the number of nodes in the frontier (long)
+ */
+static long collect_bucket(delta_t *d)
+{
+    d->frontier.size = 0;
+    for(int t = 0; t < d->num_threads; t++){
+        local_t *l = &d->local[t];
+        if(d->bucket >= l->num_bins){
+            continue;
+        }
+        vec_t *bin = &l->bins[d->bucket];
+        for(long i = 0; i < bin->size; i++){
+            vec_push(&d->frontier, bin->items[i]);
+        }
+        // buckets are not revisited once the search moves past them
+        free(bin->items);
+        bin->items = NULL;
+        bin->size = 0;
+        bin->capacity = 0;
+    }
+    return d->frontier.size;
+}
+
+/* next_bucket: find the lowest non-empty bucket after the current one
+ *
+ * Inputs:
+ * - d: the search state (delta_t*)
+ *
+ * Output: the bucket index, -1 if every bucket is empty (long)
+ */
+static long next_bucket(delta_t *d)
+{
+    long best = -1;
+    for(int t = 0; t < d->num_threads; t++){
+        local_t *l = &d->local[t];
+        long limit = best >= 0 && best < l->num_bins ? best : l->num_bins;
+        for(long b = d->bucket + 1; b < limit; b++){
+            if(l->bins[b].size){
+                best = b;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+typedef struct {
+    delta_t *d;
+    atomic_int *parent;
+} parents_t;
+
+/* find_parents: pick a shortest-path predecessor for every node, by
+ *     scanning the edges out of each node, since with one-way arcs the
+ *     neighbors of a node need not be its predecessors. Only nodes with
+ *     a strictly smaller distance are taken, so the parents cannot form
+ *     a cycle through zero-length edges, adopt_orphans does the rest.
+ *
+ * Inputs: tpool_range_fn over node numbers, arg is a parents_t
+ *
+ * Output: none. function is void.
+ */
+static void find_parents(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    parents_t *p = (parents_t*)arg;
+    delta_t *d = p->d;
+    for(long u = lo; u < hi; u++){
+        double du = atomic_load_explicit(&d->dist[u], memory_order_relaxed);
+        if(du == INFINITY){
+            continue;
+        }
+        for(int pass = 0; pass < 2; pass++){
+            long *off = pass ? d->heavy_off : d->light_off;
+            int *to = pass ? d->heavy_to : d->light_to;
+            double *cost = pass ? d->heavy_cost : d->light_cost;
+            for(long e = off[u]; e < off[u + 1]; e++){
+                int v = to[e];
+                double dv = atomic_load_explicit(&d->dist[v], memory_order_relaxed);
+                if(v == d->source || du + cost[e] != dv || du == dv){
+                    continue;
+                }
+                // first predecessor found wins
+                int none = -1;
+                atomic_compare_exchange_strong_explicit(&p->parent[v], &none, (int)u,
+                                                        memory_order_relaxed,
+                                                        memory_order_relaxed);
+            }
+        }
+    }
+}
+
+/* adopt_orphans: give a parent to the nodes find_parents left without
+ *     one, those only reached over zero-length edges from nodes at the
+ *     same distance, by a search over such edges from the nodes that
+ *     have a parent. Each orphan is reached once, so there is no cycle.
+ *
+ * Inputs:
+ * - d: the search state (delta_t*)
+ * - parent: the parents found so far, filled in (int*)
+ *
+ * Output: none. function is void.
+ */
+static void adopt_orphans(delta_t *d, int *parent)
+{
+    long n = d->graph->num_nodes;
+    bool orphans = false;
+    for(long v = 0; v < n && !orphans; v++){
+        double dv = atomic_load_explicit(&d->dist[v], memory_order_relaxed);
+        orphans = v != d->source && dv != INFINITY && parent[v] < 0;
+    }
+    if(!orphans){
+        return;
+    }
+
+    vec_t queue = { NULL, 0, 0 };
+    for(long u = 0; u < n; u++){
+        if(u == d->source || parent[u] >= 0){
+            vec_push(&queue, (int)u);
+        }
+    }
+    for(long i = 0; i < queue.size; i++){
+        int u = queue.items[i];
+        double du = atomic_load_explicit(&d->dist[u], memory_order_relaxed);
+        for(int pass = 0; pass < 2; pass++){
+            long *off = pass ? d->heavy_off : d->light_off;
+            int *to = pass ? d->heavy_to : d->light_to;
+            double *cost = pass ? d->heavy_cost : d->light_cost;
+            for(long e = off[u]; e < off[u + 1]; e++){
+                int v = to[e];
+                double dv = atomic_load_explicit(&d->dist[v], memory_order_relaxed);
+                if(v != d->source && parent[v] < 0 && du + cost[e] == dv){
+                    parent[v] = u;
+                    vec_push(&queue, v);
+                }
+            }
+        }
+    }
+    free(queue.items);
+}
+
+/********* DELTA-STEPPING *********/
+
+/* delta_stepping: computes shortest paths from one node to every node
+ *
+ * graph: the graph
+ * source_node_num: the source node number
+ * delta: bucket width, 0 to use the average edge cost
+ * num_threads: number of worker threads, 0 for one per core
+ * dist: filled with the distance to every node, -1 if unreachable,
+ *     graph->num_nodes entries
+ * parent: filled with the previous node on a shortest path, -1 for the
+ *     source and unreachable nodes, graph->num_nodes entries, may be NULL
+ */ 
+void delta_stepping(graph_t *graph, int source_node_num, double delta,
+                    int num_threads, double *dist, int *parent)
+{
+    assert(graph->nodes[source_node_num] != NULL);
+
+    tpool_t *pool = tpool_create(num_threads);
+    long n = graph->num_nodes;
+
+    delta_t d;
+    memset(&d, 0, sizeof(d));
+    d.graph = graph;
+    d.source = source_node_num;
+    d.num_threads = tpool_size(pool);
+    d.dist = (_Atomic double*)malloc(sizeof(_Atomic double) * n);
+    d.done = (atomic_char*)malloc(sizeof(atomic_char) * n);
+    d.local = (local_t*)aligned_alloc(64, sizeof(local_t) * d.num_threads);
+    if(!d.dist || !d.done || !d.local){
+        fprintf(stderr, "delta_stepping: malloc failed\n");
+        exit(1);
+    }
+    memset(d.local, 0, sizeof(local_t) * d.num_threads);
+
+    classify_edges(&d, pool, delta);
+    tpool_for(pool, n, 0, init_nodes, &d);
+
+    atomic_store(&d.dist[source_node_num], 0);
+    local_insert(&d.local[0], 0, source_node_num);
+    d.bucket = 0;
+
+    while(d.bucket >= 0){
+        // light edges until the bucket stays empty
+        while(collect_bucket(&d)){
+            tpool_for(pool, d.frontier.size, 0, relax_light, &d);
+        }
+        // then heavy edges, which only reach later buckets
+        tpool_run(pool, relax_heavy, &d);
+        d.bucket = next_bucket(&d);
+    }
+
+    for(long v = 0; v < n; v++){
+        double dv = atomic_load(&d.dist[v]);
+        dist[v] = dv == INFINITY ? -1 : dv;
+    }
+    if(parent){
+        parents_t p = { &d, (atomic_int*)malloc(sizeof(atomic_int) * n) };
+        if(p.parent == NULL){
+            fprintf(stderr, "delta_stepping - parents: malloc failed\n");
+            exit(1);
+        }
+        for(long v = 0; v < n; v++){
+            atomic_init(&p.parent[v], -1);
+        }
+        tpool_for(pool, n, 0, find_parents, &p);
+        for(long v = 0; v < n; v++){
+            parent[v] = atomic_load_explicit(&p.parent[v], memory_order_relaxed);
+        }
+        free(p.parent);
+        adopt_orphans(&d, parent);
+    }
+
+    tpool_free(pool);
+
+    for(int t = 0; t < d.num_threads; t++){
+        for(long b = 0; b < d.local[t].num_bins; b++){
+            free(d.local[t].bins[b].items);
+        }
+        free(d.local[t].bins);
+        free(d.local[t].settled.items);
+    }
+    free(d.local);
+    free(d.frontier.items);
+    free(d.dist);
+    free(d.done);
+    free(d.light_off);
+    free(d.light_to);
+    free(d.light_cost);
+    free(d.heavy_off);
+    free(d.heavy_to);
+    free(d.heavy_cost);
+}
@@ -0,0 +1,317 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <math.h>
+#include <sched.h>
+
+#include "util.h"
+#include "a_star.h"
+#include "hda_star.h"
+#include "parallel.h"
+
+/********* MESSAGES *********/
+
+typedef struct hda_msg hda_msg_t;
+
+// a generated node sent to its owner
+struct hda_msg {
+    int node_num;
+    int parent;
+    double g_cost;
+    hda_msg_t *next;
+};
+
+/* Multiple producers push with a CAS on the head, the single consumer
+ * takes the whole list with one exchange, so there is no ABA problem.
+ * Each inbox sits on its own cache line.
+ */
+typedef struct {
+    _Alignas(64) _Atomic(hda_msg_t*) head;
+} inbox_t;
+
+/********* SEARCH STATE *********/
+
+typedef struct hda hda_t;
+
+struct hda {
+    graph_t *graph;
+    int start;
+    int end;
+    int num_threads;
+
+    // per node, only written by the owning worker
+    double *g_cost;
+    double *f_cost;
+    int *parent;
+
+    inbox_t *inboxes;
+
+    // nodes in open lists plus messages in flight
+    _Alignas(64) atomic_long outstanding;
+    // best path cost found so far
+    _Alignas(64) _Atomic double incumbent;
+};
+
+/* owner: worker that owns a node
+ *
+ * Inputs:
+ * - hda: search state (hda_t*)
+ * - node_num: node number (int)
+ *
+ * Output: worker index (int)
+ */
+static inline int owner(hda_t *hda, int node_num)
+{
+    uint32_t x = (uint32_t)node_num * 2654435761u;
+    return (int)((x ^ (x >> 16)) % (uint32_t)hda->num_threads);
+}
+
+/* send: hand a generated node to its owner
+ *
+ * Inputs:
+ * - hda: search state (hda_t*)
+ * - to: owning worker (int)
+ * - node_num, parent, g_cost: the generated node
+ *
+ * Output: none. function is void.
+ */
+static void send(hda_t *hda, int to, int node_num, int parent, double g_cost)
+{
+    hda_msg_t *msg = (hda_msg_t*)malloc(sizeof(hda_msg_t));
+    if(msg == NULL){
+        fprintf(stderr, "hda_star - send: malloc failed\n");
+        exit(1);
+    }
+    msg->node_num = node_num;
+    msg->parent = parent;
+    msg->g_cost = g_cost;
+
+    // count the message before it becomes visible to its owner
+    atomic_fetch_add(&hda->outstanding, 1);
+
+    inbox_t *inbox = &hda->inboxes[to];
+    hda_msg_t *head = atomic_load_explicit(&inbox->head, memory_order_relaxed);
+    do{
+        msg->next = head;
+    }while(!atomic_compare_exchange_weak_explicit(&inbox->head, &head, msg,
+                                                  memory_order_release,
+                                                  memory_order_relaxed));
+}
+
+/* improve_incumbent: record a cheaper path to the end node
+ *
+ * Inputs:
+ * - hda: search state (hda_t*)
+ * - cost: cost of the new path (double)
+ *
+ * Output: none. function is void.
+ */
+static void improve_incumbent(hda_t *hda, double cost)
+{
+    double best = atomic_load(&hda->incumbent);
+    while(cost < best && 
+          !atomic_compare_exchange_weak(&hda->incumbent, &best, cost)){
+    }
+}
+
+/* relax: offer a path to a node owned by the calling worker
+ *
+ * Inputs:
+ * - hda: search state (hda_t*)
+ * - open: the worker's open list (heap_t*)
+ * - node_num, parent, g_cost: the offered path
+ *
+ * Output: none. function is void.
+ */
+static void relax(hda_t *hda, heap_t *open, int node_num, int parent, 
+                  double g_cost)
+{
+    if(g_cost >= hda->g_cost[node_num]){
+        return;
+    }
+    hda->g_cost[node_num] = g_cost;
+    hda->parent[node_num] = parent;
+
+    if(node_num == hda->end){
+        improve_incumbent(hda, g_cost);
+        return;
+    }
+
+    node_t *fin = hda->graph->nodes[hda->end];
+    double f_cost = g_cost + h_calc(hda->graph->nodes[node_num], fin);
+    if(f_cost >= atomic_load_explicit(&hda->incumbent, memory_order_relaxed)){
+        return;
+    }
+    hda->f_cost[node_num] = f_cost;
+    atomic_fetch_add(&hda->outstanding, 1);
+    heap_push(open, node_num, f_cost);
+}
+
+/* init_worker: reset the per-node arrays, one slice per worker
+ *
+ * Inputs:
+ * - tid: worker index (int)
+ * - arg: search state (hda_t*)
+ *
+ * Output: none. function is void.
+ */
+static void init_worker(int tid, void *arg)
+{
+    hda_t *hda = (hda_t*)arg;
+    long n = hda->graph->num_nodes;
+    int lo = (int)(n * tid / hda->num_threads);
+    int hi = (int)(n * (tid + 1) / hda->num_threads);
+
+    for(int i = lo; i < hi; i++){
+        hda->g_cost[i] = INFINITY;
+        hda->f_cost[i] = INFINITY;
+        hda->parent[i] = -1;
+    }
+}
+
+/* search_worker: expand the nodes owned by one worker until the whole
+ *     search has run out of work
+ *
+ * Inputs:
+ * - tid: worker index (int)
+ * - arg: search state (hda_t*)
+ *
+ * Output: none. function is void.
+ */
+static void search_worker(int tid, void *arg)
+{
+    hda_t *hda = (hda_t*)arg;
+    graph_t *graph = hda->graph;
+    node_t *fin = graph->nodes[hda->end];
+    inbox_t *inbox = &hda->inboxes[tid];
+    heap_t *open = heap_create(1024);
+
+    if(owner(hda, hda->start) == tid){
+        relax(hda, open, hda->start, -1, 0);
+        // the start node was counted as a message by hda_star
+        atomic_fetch_sub(&hda->outstanding, 1);
+    }
+
+    while(true){
+        // drain the inbox
+        hda_msg_t *msg = atomic_exchange_explicit(&inbox->head, NULL, 
+                                                  memory_order_acquire);
+        long received = 0;
+        while(msg){
+            hda_msg_t *next = msg->next;
+            relax(hda, open, msg->node_num, msg->parent, msg->g_cost);
+            free(msg);
+            received++;
+            msg = next;
+        }
+        if(received){
+            atomic_fetch_sub(&hda->outstanding, received);
+        }
+
+        if(heap_is_empty(open)){
+            if(atomic_load(&hda->outstanding) == 0){
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+
+        double f_cost;
+        int curr_num = heap_pop(open, &f_cost);
+        node_t *curr = graph->nodes[curr_num];
+        double incumbent = atomic_load_explicit(&hda->incumbent, 
+                                                memory_order_relaxed);
+
+        // skip stale entries and nodes that cannot beat the incumbent
+        if(f_cost <= hda->f_cost[curr_num] && f_cost < incumbent){
+            hda->f_cost[curr_num] = -INFINITY;  // expanded
+            double g_cost = hda->g_cost[curr_num];
+
+            for(intlist_t *nb = curr->neighbors; nb; nb = nb->next){
+                node_t *neighbor = graph->nodes[nb->num];
+                double ng = g_cost + h_calc(curr, neighbor);
+                if(ng + h_calc(neighbor, fin) >= incumbent){
+                    continue;
+                }
+                int to = owner(hda, nb->num);
+                if(to == tid){
+                    relax(hda, open, nb->num, curr_num, ng);
+                }else{
+                    send(hda, to, nb->num, curr_num, ng);
+                }
+            }
+        }
+
+        atomic_fetch_sub(&hda->outstanding, 1);
+    }
+
+    heap_free(open);
+}
+
+/********* HDA* SEARCH *********/
+
+/* hda_star: performs hash-distributed parallel A* search
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * num_threads: number of worker threads, 0 for one per core
+ * 
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path. Like a_star(), the parent fields of the
+ *     nodes on the path are set.
+ */ 
+double hda_star(graph_t *graph, int start_node_num, int end_node_num, 
+                int num_threads)
+{
+    assert(graph->nodes[start_node_num] != NULL);
+    assert(graph->nodes[end_node_num] != NULL);
+
+    tpool_t *pool = tpool_create(num_threads);
+    int n = graph->num_nodes;
+
+    hda_t hda;
+    hda.graph = graph;
+    hda.start = start_node_num;
+    hda.end = end_node_num;
+    hda.num_threads = tpool_size(pool);
+    hda.g_cost = (double*)malloc(sizeof(double) * n);
+    hda.f_cost = (double*)malloc(sizeof(double) * n);
+    hda.parent = (int*)malloc(sizeof(int) * n);
+    hda.inboxes = (inbox_t*)aligned_alloc(64, sizeof(inbox_t) * hda.num_threads);
+    if(!hda.g_cost || !hda.f_cost || !hda.parent || !hda.inboxes){
+        fprintf(stderr, "hda_star: malloc failed\n");
+        exit(1);
+    }
+    for(int i = 0; i < hda.num_threads; i++){
+        atomic_init(&hda.inboxes[i].head, NULL);
+    }
+    // the start node counts as work until its owner has opened it
+    atomic_init(&hda.outstanding, 1);
+    atomic_init(&hda.incumbent, INFINITY);
+
+    tpool_run(pool, init_worker, &hda);
+    tpool_run(pool, search_worker, &hda);
+    tpool_free(pool);
+
+    double cost = atomic_load(&hda.incumbent);
+
+    // mirror a_star() by linking the path through the node parents
+    if(cost != INFINITY){
+        for(int v = end_node_num; hda.parent[v] >= 0; v = hda.parent[v]){
+            graph->nodes[v]->parent = graph->nodes[hda.parent[v]];
+        }
+    }
+
+    free(hda.g_cost);
+    free(hda.f_cost);
+    free(hda.parent);
+    free(hda.inboxes);
+
+    return cost == INFINITY ? -1 : cost;
+}
@@ -0,0 +1,768 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "util.h"
+#include "a_star.h"
+#include "hub_label.h"
+#include "parallel.h"
+
+#define SENTINEL (INT_MAX)
+#define FILE_MAGIC (0x4c425548)    // "HUBL"
+#define FILE_VERSION (1)
+#define NUM_SAMPLES (32)
+
+/********* HUB LABELS *********/
+
+// one direction of labels: node v's label is hub[off[v]] .. the sentinel
+typedef struct {
+    long *off;
+    int *hub;
+    double *dist;
+} label_set_t;
+
+struct hub_labels {
+    int num_nodes;
+    bool directed;
+    label_set_t out;
+    label_set_t in;    // same arrays as out if the graph has no arcs
+};
+
+/********* CONSTRUCTION *********/
+
+// label of one node while it grows, sorted by hub rank
+typedef struct {
+    int *hub;
+    double *dist;
+    long size;
+    long capacity;
+} label_t;
+
+// nodes settled by one pruned search
+typedef struct {
+    int *node;
+    double *dist;
+    long size;
+    long capacity;
+} found_t;
+
+// scratch space of one worker, reset after each search
+typedef struct {
+    _Alignas(64) double *dist;
+    double *hub_dist;    // by hub rank, the label of the search's hub
+    int *touched;
+    long num_touched;
+    heap_t *open;
+} worker_t;
+
+typedef struct build build_t;
+
+struct build {
+    int num_nodes;
+    int *order;          // node of each rank
+
+    // adjacency with cached edge costs, forward and, for arcs, backward
+    long *fwd_off;
+    int *fwd_to;
+    double *fwd_cost;
+    long *bwd_off;
+    int *bwd_to;
+    double *bwd_cost;
+
+    label_t *out;
+    label_t *in;         // same as out if the graph has no arcs
+
+    worker_t *workers;
+    int *roots;          // sample roots for the ranking
+    long **scores;       // ranking scores, one array per thread
+    found_t *found;      // one per hub of the batch
+    int batch;           // rank of the first hub in the batch
+    bool backward;       // searching against the edges
+};
+
+/* Helpers for the growing arrays below:
+ *
+ * label_push: append a hub to a label
+ * found_push: append a settled node to a search result
+ */
+static void label_push(label_t *l, int hub, double dist)
+{
+    if(l->size == l->capacity){
+        l->capacity = l->capacity ? l->capacity * 2 : 8;
+        l->hub = (int*)realloc(l->hub, sizeof(int) * l->capacity);
+        l->dist = (double*)realloc(l->dist, sizeof(double) * l->capacity);
+        if(!l->hub || !l->dist){
+            fprintf(stderr, "hub_labels_create - label_push: realloc failed\n");
+            exit(1);
+        }
+    }
+    l->hub[l->size] = hub;
+    l->dist[l->size++] = dist;
+}
+
+static void found_push(found_t *f, int node, double dist)
+{
+    if(f->size == f->capacity){
+        f->capacity = f->capacity ? f->capacity * 2 : 64;
+        f->node = (int*)realloc(f->node, sizeof(int) * f->capacity);
+        f->dist = (double*)realloc(f->dist, sizeof(double) * f->capacity);
+        if(!f->node || !f->dist){
+            fprintf(stderr, "hub_labels_create - found_push: realloc failed\n");
+            exit(1);
+        }
+    }
+    f->node[f->size] = node;
+    f->dist[f->size++] = dist;
+}
+
+/* build_adjacency: flat forward adjacency with edge costs, plus the
+ *     backward adjacency if some edges are one-way arcs
+ *
+ * Inputs:
+ * - b: the build state (build_t*)
+ * - graph: the graph (graph_t*)
+ *
+ * Output: true if the graph has one-way arcs (bool)
+ */
+static bool build_adjacency(build_t *b, graph_t *graph)
+{
+    int n = graph->num_nodes;
+    int *uses = (int*)calloc(graph->num_edges + 1, sizeof(int));
+    b->fwd_off = (long*)calloc(n + 1, sizeof(long));
+    b->bwd_off = (long*)calloc(n + 1, sizeof(long));
+    if(!uses || !b->fwd_off || !b->bwd_off){
+        fprintf(stderr, "hub_labels_create - adjacency: malloc failed\n");
+        exit(1);
+    }
+
+    for(int u = 0; u < n; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next){
+            uses[nb->edge_num]++;
+            b->fwd_off[u + 1]++;
+            b->bwd_off[nb->num + 1]++;
+        }
+    }
+    bool directed = false;
+    for(int e = 0; e < graph->num_edges; e++){
+        // add_edge puts its edge number in two neighbor lists, add_arc in one
+        directed = directed || uses[e] == 1;
+    }
+    free(uses);
+
+    for(int u = 0; u < n; u++){
+        b->fwd_off[u + 1] += b->fwd_off[u];
+        b->bwd_off[u + 1] += b->bwd_off[u];
+    }
+    long m = b->fwd_off[n];
+    b->fwd_to = (int*)malloc(sizeof(int) * (m + 1));
+    b->fwd_cost = (double*)malloc(sizeof(double) * (m + 1));
+    b->bwd_to = directed ? (int*)malloc(sizeof(int) * (m + 1)) : NULL;
+    b->bwd_cost = directed ? (double*)malloc(sizeof(double) * (m + 1)) : NULL;
+    long *bwd_pos = (long*)malloc(sizeof(long) * (n + 1));
+    if(!b->fwd_to || !b->fwd_cost || !bwd_pos ||
+       (directed && (!b->bwd_to || !b->bwd_cost))){
+        fprintf(stderr, "hub_labels_create - adjacency: malloc failed\n");
+        exit(1);
+    }
+    memcpy(bwd_pos, b->bwd_off, sizeof(long) * (n + 1));
+
+    for(int u = 0; u < n; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        long e = b->fwd_off[u];
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next){
+            double cost = h_calc(graph->nodes[u], graph->nodes[nb->num]);
+            b->fwd_to[e] = nb->num;
+            b->fwd_cost[e++] = cost;
+            if(directed){
+                long r = bwd_pos[nb->num]++;
+                b->bwd_to[r] = u;
+                b->bwd_cost[r] = cost;
+            }
+        }
+    }
+    free(bwd_pos);
+
+    return directed;
+}
+
+typedef struct {
+    long score;
+    long degree;
+    int node;
+} ranked_t;
+
+/* cmp_rank: qsort comparator, higher score first, then higher degree,
+ *     then lower node number
+ */
+static int cmp_rank(const void *a, const void *b)
+{
+    const ranked_t *x = (const ranked_t*)a;
+    const ranked_t *y = (const ranked_t*)b;
+    if(x->score != y->score){
+        return x->score < y->score ? 1 : -1;
+    }
+    if(x->degree != y->degree){
+        return x->degree < y->degree ? 1 : -1;
+    }
+    return (x->node > y->node) - (x->node < y->node);
+}
+
+/* sample_trees: shortest path trees from sample roots, adding to the
+ *     score of every node the number of nodes below it in the tree. Nodes
+ *     that many shortest paths pass through get high scores, which makes
+ *     them good hubs to label with first.
+ *
+ * Inputs: tpool_range_fn over samples, arg is a build_t
+ *
+ * Output: none. function is void.
+ */
+static void sample_trees(long lo, long hi, int tid, void *arg)
+{
+    build_t *b = (build_t*)arg;
+    worker_t *w = &b->workers[tid];
+    long *score = b->scores[tid];
+    int n = b->num_nodes;
+
+    int *parent = (int*)malloc(sizeof(int) * (n + 1));
+    int *settled = (int*)malloc(sizeof(int) * (n + 1));
+    long *below = (long*)malloc(sizeof(long) * (n + 1));
+    if(!parent || !settled || !below){
+        fprintf(stderr, "hub_labels_create - sample_trees: malloc failed\n");
+        exit(1);
+    }
+
+    for(long i = lo; i < hi; i++){
+        int root = b->roots[i];
+        int num_settled = 0;
+
+        w->dist[root] = 0;
+        parent[root] = -1;
+        w->touched[w->num_touched++] = root;
+        heap_push(w->open, root, 0);
+
+        while(!heap_is_empty(w->open)){
+            double d;
+            int v = heap_pop(w->open, &d);
+            if(d > w->dist[v]){
+                continue;
+            }
+            settled[num_settled++] = v;
+            below[v] = 1;
+
+            for(long e = b->fwd_off[v]; e < b->fwd_off[v + 1]; e++){
+                int u = b->fwd_to[e];
+                double nd = d + b->fwd_cost[e];
+                if(nd < w->dist[u]){
+                    if(w->dist[u] == INFINITY){
+                        w->touched[w->num_touched++] = u;
+                    }
+                    w->dist[u] = nd;
+                    parent[u] = v;
+                    heap_push(w->open, u, nd);
+                }
+            }
+        }
+
+        // children are settled after their parents
+        for(int k = num_settled - 1; k >= 0; k--){
+            int v = settled[k];
+            score[v] += below[v];
+            if(parent[v] >= 0){
+                below[parent[v]] += below[v];
+            }
+        }
+
+        for(long k = 0; k < w->num_touched; k++){
+            w->dist[w->touched[k]] = INFINITY;
+        }
+        w->num_touched = 0;
+    }
+
+    free(parent);
+    free(settled);
+    free(below);
+}
+
+/* pruned_search: pruned Dijkstra from one hub of the batch
+ *
+ * Inputs: tpool_range_fn over hubs of the batch, arg is a build_t
+ *
+ * Output: none. function is void.
+ */
+static void pruned_search(long lo, long hi, int tid, void *arg)
+{
+    build_t *b = (build_t*)arg;
+    worker_t *w = &b->workers[tid];
+
+    // searching forward finds d(hub, v), which goes to the in label of v
+    // and is pruned by the out label of the hub, backward the other way
+    long *off = b->backward ? b->bwd_off : b->fwd_off;
+    int *to = b->backward ? b->bwd_to : b->fwd_to;
+    double *cost = b->backward ? b->bwd_cost : b->fwd_cost;
+    label_t *own = b->backward ? b->in : b->out;
+    label_t *other = b->backward ? b->out : b->in;
+
+    for(long i = lo; i < hi; i++){
+        int r = b->batch + (int)i;
+        int hub = b->order[r];
+        found_t *found = &b->found[i];
+        found->size = 0;
+
+        label_t *hl = &own[hub];
+        for(long k = 0; k < hl->size; k++){
+            w->hub_dist[hl->hub[k]] = hl->dist[k];
+        }
+
+        w->dist[hub] = 0;
+        w->touched[w->num_touched++] = hub;
+        heap_push(w->open, hub, 0);
+
+        while(!heap_is_empty(w->open)){
+            double d;
+            int v = heap_pop(w->open, &d);
+            if(d > w->dist[v]){
+                continue;
+            }
+
+            // prune if earlier hubs already give a path this short
+            label_t *vl = &other[v];
+            bool covered = false;
+            for(long k = 0; k < vl->size && !covered; k++){
+                covered = w->hub_dist[vl->hub[k]] + vl->dist[k] <= d;
+            }
+            if(covered){
+                continue;
+            }
+            found_push(found, v, d);
+
+            for(long e = off[v]; e < off[v + 1]; e++){
+                int u = to[e];
+                double nd = d + cost[e];
+                if(nd < w->dist[u]){
+                    if(w->dist[u] == INFINITY){
+                        w->touched[w->num_touched++] = u;
+                    }
+                    w->dist[u] = nd;
+                    heap_push(w->open, u, nd);
+                }
+            }
+        }
+
+        for(long k = 0; k < hl->size; k++){
+            w->hub_dist[hl->hub[k]] = INFINITY;
+        }
+        for(long k = 0; k < w->num_touched; k++){
+            w->dist[w->touched[k]] = INFINITY;
+        }
+        w->num_touched = 0;
+    }
+}
+
+/* merge_batch: add the nodes found by each search of the batch to their
+ *     labels, in hub rank order so labels stay sorted
+ *
+ * Inputs:
+ * - b: the build state (build_t*)
+ * - size: number of hubs in the batch (int)
+ *
+ * Output: none. function is void.
+ */
+static void merge_batch(build_t *b, int size)
+{
+    label_t *labels = b->backward ? b->out : b->in;
+    for(int i = 0; i < size; i++){
+        found_t *found = &b->found[i];
+        for(long k = 0; k < found->size; k++){
+            label_push(&labels[found->node[k]], b->batch + i, found->dist[k]);
+        }
+    }
+}
+
+/* flatten: copy growing labels into a flat label set with sentinels
+ *
+ * Inputs:
+ * - labels: one label per node (label_t*)
+ * - n: number of nodes (int)
+ * - set: the label set to fill (label_set_t*)
+ *
+ * Output: none. function is void.
+ */
+static void flatten(label_t *labels, int n, label_set_t *set)
+{
+    set->off = (long*)malloc(sizeof(long) * (n + 1));
+    if(set->off == NULL){
+        fprintf(stderr, "hub_labels_create - flatten: malloc failed\n");
+        exit(1);
+    }
+    set->off[0] = 0;
+    for(int v = 0; v < n; v++){
+        set->off[v + 1] = set->off[v] + labels[v].size + 1;
+    }
+    set->hub = (int*)malloc(sizeof(int) * set->off[n]);
+    set->dist = (double*)malloc(sizeof(double) * set->off[n]);
+    if(!set->hub || !set->dist){
+        fprintf(stderr, "hub_labels_create - flatten: malloc failed\n");
+        exit(1);
+    }
+    for(int v = 0; v < n; v++){
+        long pos = set->off[v];
+        if(labels[v].size){
+            memcpy(set->hub + pos, labels[v].hub, sizeof(int) * labels[v].size);
+            memcpy(set->dist + pos, labels[v].dist, sizeof(double) * labels[v].size);
+        }
+        set->hub[pos + labels[v].size] = SENTINEL;
+        set->dist[pos + labels[v].size] = INFINITY;
+    }
+}
+
+/* hub_labels_create: compute hub labels for a graph
+ *
+ * graph: the graph
+ * num_threads: number of worker threads, 0 for one per core
+ *
+ * Returns: the labels
+ */
+hub_labels_t *hub_labels_create(graph_t *graph, int num_threads)
+{
+    int n = graph->num_nodes;
+    tpool_t *pool = tpool_create(num_threads);
+    int threads = tpool_size(pool);
+
+    build_t b;
+    memset(&b, 0, sizeof(b));
+    b.num_nodes = n;
+    bool directed = build_adjacency(&b, graph);
+
+    b.order = (int*)malloc(sizeof(int) * (n + 1));
+    b.out = (label_t*)calloc(n + 1, sizeof(label_t));
+    b.in = directed ? (label_t*)calloc(n + 1, sizeof(label_t)) : b.out;
+    b.workers = (worker_t*)aligned_alloc(64, sizeof(worker_t) * threads);
+    b.found = (found_t*)calloc(threads, sizeof(found_t));
+    if(!b.order || !b.out || !b.in || !b.workers || !b.found){
+        fprintf(stderr, "hub_labels_create: malloc failed\n");
+        exit(1);
+    }
+    for(int t = 0; t < threads; t++){
+        worker_t *w = &b.workers[t];
+        w->dist = (double*)malloc(sizeof(double) * (n + 1));
+        w->hub_dist = (double*)malloc(sizeof(double) * (n + 1));
+        w->touched = (int*)malloc(sizeof(int) * (n + 1));
+        if(!w->dist || !w->hub_dist || !w->touched){
+            fprintf(stderr, "hub_labels_create - workers: malloc failed\n");
+            exit(1);
+        }
+        for(int v = 0; v <= n; v++){
+            w->dist[v] = INFINITY;
+            w->hub_dist[v] = INFINITY;
+        }
+        w->num_touched = 0;
+        w->open = heap_create(1024);
+    }
+
+    // rank nodes on many sampled shortest paths first, they cover the
+    // most pairs, and break ties by degree
+    ranked_t *ranked = (ranked_t*)malloc(sizeof(ranked_t) * (n + 1));
+    b.roots = (int*)malloc(sizeof(int) * NUM_SAMPLES);
+    b.scores = (long**)malloc(sizeof(long*) * threads);
+    if(!ranked || !b.roots || !b.scores){
+        fprintf(stderr, "hub_labels_create - ranking: malloc failed\n");
+        exit(1);
+    }
+    int num_ranked = 0;
+    for(int v = 0; v < n; v++){
+        if(graph->nodes[v]){
+            ranked[num_ranked++].node = v;
+        }
+    }
+    int num_samples = num_ranked < NUM_SAMPLES ? num_ranked : NUM_SAMPLES;
+    for(int i = 0; i < num_samples; i++){
+        b.roots[i] = ranked[(long)i * num_ranked / num_samples].node;
+    }
+    for(int t = 0; t < threads; t++){
+        b.scores[t] = (long*)calloc(n + 1, sizeof(long));
+        if(b.scores[t] == NULL){
+            fprintf(stderr, "hub_labels_create - ranking: malloc failed\n");
+            exit(1);
+        }
+    }
+    tpool_for(pool, num_samples, 1, sample_trees, &b);
+
+    for(int r = 0; r < num_ranked; r++){
+        int v = ranked[r].node;
+        ranked[r].degree = (b.fwd_off[v + 1] - b.fwd_off[v]) + 
+                           (b.bwd_off[v + 1] - b.bwd_off[v]);
+        ranked[r].score = 0;
+        for(int t = 0; t < threads; t++){
+            ranked[r].score += b.scores[t][v];
+        }
+    }
+    qsort(ranked, num_ranked, sizeof(ranked_t), cmp_rank);
+    for(int r = 0; r < num_ranked; r++){
+        b.order[r] = ranked[r].node;
+    }
+    for(int t = 0; t < threads; t++){
+        free(b.scores[t]);
+    }
+    free(b.scores);
+    free(b.roots);
+    free(ranked);
+
+    for(b.batch = 0; b.batch < num_ranked; b.batch += threads){
+        int size = num_ranked - b.batch < threads ? num_ranked - b.batch : threads;
+        for(int pass = 0; pass < (directed ? 2 : 1); pass++){
+            b.backward = pass == 1;
+            tpool_for(pool, size, 1, pruned_search, &b);
+            merge_batch(&b, size);
+        }
+    }
+    tpool_free(pool);
+
+    hub_labels_t *hl = (hub_labels_t*)malloc(sizeof(hub_labels_t));
+    if(hl == NULL){
+        fprintf(stderr, "hub_labels_create: malloc failed\n");
+        exit(1);
+    }
+    hl->num_nodes = n;
+    hl->directed = directed;
+    flatten(b.out, n, &hl->out);
+    if(directed){
+        flatten(b.in, n, &hl->in);
+    }else{
+        hl->in = hl->out;
+    }
+
+    for(int v = 0; v <= n; v++){
+        free(b.out[v].hub);
+        free(b.out[v].dist);
+        if(directed){
+            free(b.in[v].hub);
+            free(b.in[v].dist);
+        }
+    }
+    if(directed){
+        free(b.in);
+    }
+    free(b.out);
+    for(int t = 0; t < threads; t++){
+        free(b.workers[t].dist);
+        free(b.workers[t].hub_dist);
+        free(b.workers[t].touched);
+        heap_free(b.workers[t].open);
+        free(b.found[t].node);
+        free(b.found[t].dist);
+    }
+    free(b.workers);
+    free(b.found);
+    free(b.order);
+    free(b.fwd_off);
+    free(b.fwd_to);
+    free(b.fwd_cost);
+    free(b.bwd_off);
+    free(b.bwd_to);
+    free(b.bwd_cost);
+
+    return hl;
+}
+
+/********* QUERIES *********/
+
+/* hub_labels_query: distance between two nodes
+ *
+ * hl: the labels
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ *
+ * Returns: the distance of the shortest path between the start node and
+ *     end node, -1 if there is no path
+ */
+double hub_labels_query(hub_labels_t *hl, int start_node_num, int end_node_num)
+{
+    const int *a = hl->out.hub + hl->out.off[start_node_num];
+    const double *da = hl->out.dist + hl->out.off[start_node_num];
+    const int *b = hl->in.hub + hl->in.off[end_node_num];
+    const double *db = hl->in.dist + hl->in.off[end_node_num];
+    double best = INFINITY;
+
+    // both labels end with the sentinel, which is larger than any rank,
+    // so the cursors advance without branching on which list is behind
+    while(true){
+        int x = *a;
+        int y = *b;
+        if(x == y){
+            if(x == SENTINEL){
+                break;
+            }
+            double d = *da + *db;
+            best = d < best ? d : best;
+        }
+        int step_a = x <= y;
+        int step_b = y <= x;
+        a += step_a;
+        da += step_a;
+        b += step_b;
+        db += step_b;
+    }
+
+    return best == INFINITY ? -1 : best;
+}
+
+/* hub_labels_size: total number of label entries
+ *
+ * hl: the labels
+ *
+ * Returns: the number of hub and distance pairs over all labels, shared
+ *     labels counted once, sentinels not counted
+ */
+long hub_labels_size(hub_labels_t *hl)
+{
+    long size = hl->out.off[hl->num_nodes] - hl->num_nodes;
+    if(hl->directed){
+        size += hl->in.off[hl->num_nodes] - hl->num_nodes;
+    }
+    return size;
+}
+
+/********* FILES *********/
+
+/* Helpers for hub_labels_save and hub_labels_load below:
+ *
+ * write_set: write the arrays of a label set, false on error
+ * read_set: read the arrays of a label set, false on error or if the
+ *     offsets are not consistent or claim more than is left in the file
+ */
+static bool write_set(label_set_t *set, int n, FILE *file)
+{
+    long total = set->off[n];
+    return fwrite(set->off, sizeof(long), n + 1, file) == (size_t)n + 1 &&
+           fwrite(set->hub, sizeof(int), total, file) == (size_t)total &&
+           fwrite(set->dist, sizeof(double), total, file) == (size_t)total;
+}
+
+static bool read_set(label_set_t *set, int n, FILE *file)
+{
+    set->off = NULL;
+    set->hub = NULL;
+    set->dist = NULL;
+    long left = file_bytes_left(file);
+    if(left >= 0 && (long)sizeof(long) * (n + 1L) > left){
+        return false;
+    }
+    set->off = (long*)malloc(sizeof(long) * (n + 1));
+    if(set->off == NULL){
+        fprintf(stderr, "hub_labels_load: malloc failed\n");
+        exit(1);
+    }
+    if(fread(set->off, sizeof(long), n + 1, file) != (size_t)n + 1 || set->off[0] != 0){
+        return false;
+    }
+    for(int v = 0; v < n; v++){
+        if(set->off[v + 1] <= set->off[v]){
+            return false;
+        }
+    }
+
+    // the offsets only grow, so bounding the last bounds them all
+    long total = set->off[n];
+    long pair = sizeof(int) + sizeof(double);
+    if(total > LONG_MAX / pair ||
+       (left >= 0 && total * pair > left - (long)sizeof(long) * (n + 1L))){
+        return false;
+    }
+    set->hub = (int*)malloc(sizeof(int) * total);
+    set->dist = (double*)malloc(sizeof(double) * total);
+    if(!set->hub || !set->dist){
+        fprintf(stderr, "hub_labels_load: malloc failed\n");
+        exit(1);
+    }
+    if(fread(set->hub, sizeof(int), total, file) != (size_t)total ||
+       fread(set->dist, sizeof(double), total, file) != (size_t)total){
+        return false;
+    }
+    // every label must end with the sentinel, which stops the query merge
+    for(int v = 0; v < n; v++){
+        if(set->hub[set->off[v + 1] - 1] != SENTINEL){
+            return false;
+        }
+    }
+    return true;
+}
+
+/* hub_labels_save: write labels to a file
+ *
+ * hl: the labels
+ * file: a file open for binary writing
+ *
+ * Returns: 0 on success, -1 if a write failed
+ */
+int hub_labels_save(hub_labels_t *hl, FILE *file)
+{
+    int32_t header[4] = { FILE_MAGIC, FILE_VERSION, hl->num_nodes, hl->directed };
+    if(fwrite(header, sizeof(int32_t), 4, file) != 4 ||
+       !write_set(&hl->out, hl->num_nodes, file) ||
+       (hl->directed && !write_set(&hl->in, hl->num_nodes, file))){
+        return -1;
+    }
+    return fflush(file) == 0 ? 0 : -1;
+}
+
+/* hub_labels_load: read labels written by hub_labels_save on the same
+ *     kind of machine
+ *
+ * file: a file open for binary reading
+ *
+ * Returns: the labels, NULL if the file is not valid
+ */
+hub_labels_t *hub_labels_load(FILE *file)
+{
+    int32_t header[4];
+    if(fread(header, sizeof(int32_t), 4, file) != 4 || header[0] != FILE_MAGIC ||
+       header[1] != FILE_VERSION || header[2] < 0){
+        return NULL;
+    }
+
+    hub_labels_t *hl = (hub_labels_t*)calloc(1, sizeof(hub_labels_t));
+    if(hl == NULL){
+        fprintf(stderr, "hub_labels_load: malloc failed\n");
+        exit(1);
+    }
+    hl->num_nodes = header[2];
+    hl->directed = header[3] != 0;
+
+    bool ok = read_set(&hl->out, hl->num_nodes, file);
+    if(ok && hl->directed){
+        ok = read_set(&hl->in, hl->num_nodes, file);
+    }else if(!hl->directed){
+        hl->in = hl->out;
+    }
+    if(!ok){
+        hub_labels_free(hl);
+        return NULL;
+    }
+    return hl;
+}
+
+/* hub_labels_free: free hub labels
+ *
+ * hl: the labels
+ */
+void hub_labels_free(hub_labels_t *hl)
+{
+    free(hl->out.off);
+    free(hl->out.hub);
+    free(hl->out.dist);
+    if(hl->directed){
+        free(hl->in.off);
+        free(hl->in.hub);
+        free(hl->in.dist);
+    }
+    free(hl);
+}
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "a_star.h"
+#include "ksp.h"
+#include "parallel.h"
+
+/********* PATHS *********/
+
+typedef struct path path_t;
+
+struct path {
+    double cost;
+    int len;
+    int *nodes;
+};
+
+/* path_equal: determines whether two paths visit the same nodes
+ *
+ * Inputs:
+ * - a, b: the paths (path_t*)
+ *
+ * Output: true if the paths are equal, false otherwise (bool)
+ */
+static bool path_equal(path_t *a, path_t *b)
+{
+    return a->len == b->len && 
+           memcmp(a->nodes, b->nodes, sizeof(int) * a->len) == 0;
+}
+
+/* path_contains: determines whether a path is already in a list
+ *
+ * Inputs:
+ * - list: the paths (path_t*)
+ * - n: number of paths in list (int)
+ * - p: the path to look for (path_t*)
+ *
+ * Output: true if p is in list, false otherwise (bool)
+ */
+static bool path_contains(path_t *list, int n, path_t *p)
+{
+    for(int i = 0; i < n; i++){
+        if(path_equal(&list[i], p)){
+            return true;
+        }
+    }
+    return false;
+}
+
+/********* SPUR SEARCHES *********/
+
+typedef struct yen yen_t;
+
+struct yen {
+    graph_t *graph;
+    int end;
+
+    // paths found so far
+    path_t *found;
+    int num_found;
+
+    // cost of the previous path up to each of its nodes
+    double *root_cost;
+
+    // one candidate per spur node of the previous path, len 0 if none
+    path_t *spurs;
+};
+
+/* spur_search: finds the cheapest deviation from the previous path at
+ *     each spur node in a range
+ *
+ * Inputs: tpool_range_fn over spur node positions on the previous path
+ *
+ * Output: none. function is void.
+ */
+static void spur_search(long lo, long hi, int tid, void *arg)
+{
+    (void)tid;
+    yen_t *y = (yen_t*)arg;
+    path_t *prev = &y->found[y->num_found - 1];
+    int *skip = (int*)malloc(sizeof(int) * y->num_found);
+    if(skip == NULL){
+        fprintf(stderr, "k_shortest_paths - spur_search: malloc failed\n");
+        exit(1);
+    }
+
+    for(long i = lo; i < hi; i++){
+        int spur = prev->nodes[i];
+        path_t *cand = &y->spurs[i];
+        cand->len = 0;
+
+        // edges leaving the spur node on paths that share this root
+        int num_skip = 0;
+        for(int p = 0; p < y->num_found; p++){
+            path_t *other = &y->found[p];
+            if(other->len > i + 1 &&
+               memcmp(other->nodes, prev->nodes, sizeof(int) * (i + 1)) == 0){
+                skip[num_skip++] = other->nodes[i + 1];
+            }
+        }
+
+        search_ctx_t *ctx = search_ctx_acquire(y->graph);
+        for(long j = 0; j < i; j++){
+            search_ctx_exclude(ctx, prev->nodes[j]);
+        }
+
+        double cost = search_ctx_a_star(y->graph, ctx, spur, y->end, 
+                                        skip, num_skip);
+        if(cost >= 0){
+            int *spur_path;
+            int spur_len = search_ctx_path(ctx, y->end, &spur_path);
+
+            cand->len = (int)i + spur_len;
+            cand->cost = y->root_cost[i] + cost;
+            cand->nodes = (int*)malloc(sizeof(int) * cand->len);
+            if(cand->nodes == NULL){
+                fprintf(stderr, "k_shortest_paths - spur_search: malloc failed\n");
+                exit(1);
+            }
+            memcpy(cand->nodes, prev->nodes, sizeof(int) * i);
+            memcpy(cand->nodes + i, spur_path, sizeof(int) * spur_len);
+            free(spur_path);
+        }
+
+        search_ctx_release(y->graph, ctx);
+    }
+
+    free(skip);
+}
+
+/********* YEN'S ALGORITHM *********/
+
+/* k_shortest_paths: finds up to k loopless paths between two nodes, in
+ *     order of increasing cost
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * k: number of paths wanted
+ * num_threads: number of threads for the spur searches, 0 for one per core
+ * costs: filled with the cost of each path, k entries
+ * paths: filled with a new array of node numbers, start to end, for each
+ *     path, k entries. The caller frees each array.
+ * lengths: filled with the number of nodes on each path, k entries
+ * 
+ * Returns: the number of paths found, at most k
+ */ 
+int k_shortest_paths(graph_t *graph, int start_node_num, int end_node_num, 
+                     int k, int num_threads, double *costs, int **paths,
+                     int *lengths)
+{
+    if(k <= 0){
+        return 0;
+    }
+
+    yen_t y;
+    y.graph = graph;
+    y.end = end_node_num;
+    y.found = (path_t*)malloc(sizeof(path_t) * k);
+    y.num_found = 0;
+    y.root_cost = NULL;
+    y.spurs = NULL;
+    if(y.found == NULL){
+        fprintf(stderr, "k_shortest_paths: malloc failed\n");
+        exit(1);
+    }
+
+    // the shortest path
+    search_ctx_t *ctx = search_ctx_acquire(graph);
+    double cost = search_ctx_a_star(graph, ctx, start_node_num, end_node_num,
+                                    NULL, 0);
+    if(cost >= 0){
+        path_t *first = &y.found[y.num_found++];
+        first->cost = cost;
+        first->len = search_ctx_path(ctx, end_node_num, &first->nodes);
+    }
+    search_ctx_release(graph, ctx);
+
+    // candidates for the next path
+    path_t *cands = NULL;
+    int num_cands = 0;
+    int cap_cands = 0;
+
+    tpool_t *pool = y.num_found && k > 1 ? tpool_create(num_threads) : NULL;
+
+    while(y.num_found > 0 && y.num_found < k){
+        path_t *prev = &y.found[y.num_found - 1];
+        int num_spurs = prev->len - 1;
+
+        y.root_cost = (double*)realloc(y.root_cost, sizeof(double) * prev->len);
+        y.spurs = (path_t*)realloc(y.spurs, sizeof(path_t) * prev->len);
+        if(y.root_cost == NULL || y.spurs == NULL){
+            fprintf(stderr, "k_shortest_paths: realloc failed\n");
+            exit(1);
+        }
+        y.root_cost[0] = 0;
+        for(int i = 1; i < prev->len; i++){
+            y.root_cost[i] = y.root_cost[i - 1] + 
+                             h_calc(graph->nodes[prev->nodes[i - 1]], 
+                                    graph->nodes[prev->nodes[i]]);
+        }
+
+        tpool_for(pool, num_spurs, 1, spur_search, &y);
+
+        for(int i = 0; i < num_spurs; i++){
+            path_t *cand = &y.spurs[i];
+            if(cand->len == 0){
+                continue;
+            }
+            if(path_contains(cands, num_cands, cand) || 
+               path_contains(y.found, y.num_found, cand)){
+                free(cand->nodes);
+                continue;
+            }
+            if(num_cands == cap_cands){
+                cap_cands = cap_cands ? cap_cands * 2 : 16;
+                cands = (path_t*)realloc(cands, sizeof(path_t) * cap_cands);
+                if(cands == NULL){
+                    fprintf(stderr, "k_shortest_paths: realloc failed\n");
+                    exit(1);
+                }
+            }
+            cands[num_cands++] = *cand;
+        }
+
+        if(num_cands == 0){
+            break;
+        }
+
+        // the cheapest candidate is the next path
+        int best = 0;
+        for(int i = 1; i < num_cands; i++){
+            if(cands[i].cost < cands[best].cost){
+                best = i;
+            }
+        }
+        y.found[y.num_found++] = cands[best];
+        cands[best] = cands[--num_cands];
+    }
+
+    if(pool){
+        tpool_free(pool);
+    }
+    for(int i = 0; i < num_cands; i++){
+        free(cands[i].nodes);
+    }
+    free(cands);
+    free(y.root_cost);
+    free(y.spurs);
+
+    for(int i = 0; i < y.num_found; i++){
+        costs[i] = y.found[i].cost;
+        paths[i] = y.found[i].nodes;
+        lengths[i] = y.found[i].len;
+    }
+    int num_found = y.num_found;
+    free(y.found);
+
+    return num_found;
+}
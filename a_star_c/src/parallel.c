@@ -0,0 +1,267 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "parallel.h"
+
+/********* THREAD POOL *********/
+
+typedef struct worker worker_t;
+
+struct worker {
+    tpool_t *pool;
+    int tid;
+};
+
+struct tpool {
+    int num_threads;
+    pthread_t *threads;
+    worker_t *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+
+    // current job, guarded by lock
+    tpool_fn fn;
+    void *arg;
+    long generation;
+    int running;
+    bool stop;
+};
+
+/* num_cores: number of online processors
+ *
+ * Returns: the number of cores, at least 1
+ */
+int num_cores(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/* worker_loop: body of every pool thread except tid 0
+ *
+ * Inputs:
+ * - data: the worker (worker_t*)
+ *
+ * Output: NULL
+ */
+static void *worker_loop(void *data)
+{
+    worker_t *w = (worker_t*)data;
+    tpool_t *pool = w->pool;
+    long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while(true){
+        while(!pool->stop && pool->generation == seen){
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if(pool->stop){
+            break;
+        }
+        seen = pool->generation;
+        tpool_fn fn = pool->fn;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        fn(w->tid, arg);
+
+        pthread_mutex_lock(&pool->lock);
+        if(--pool->running == 0){
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/* tpool_create: create a pool of threads
+ *
+ * num_threads: number of threads, 0 for one per core
+ *
+ * Returns: a thread pool
+ */
+tpool_t *tpool_create(int num_threads)
+{
+    if(num_threads <= 0){
+        num_threads = num_cores();
+    }
+
+    tpool_t *pool = (tpool_t*)malloc(sizeof(tpool_t));
+    if(pool == NULL){
+        fprintf(stderr, "tpool_create: malloc failed\n");
+        exit(1);
+    }
+    pool->num_threads = num_threads;
+    pool->threads = (pthread_t*)malloc(sizeof(pthread_t) * num_threads);
+    pool->workers = (worker_t*)malloc(sizeof(worker_t) * num_threads);
+    if(pool->threads == NULL || pool->workers == NULL){
+        fprintf(stderr, "tpool_create - threads: malloc failed\n");
+        exit(1);
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->fn = NULL;
+    pool->arg = NULL;
+    pool->generation = 0;
+    pool->running = 0;
+    pool->stop = false;
+
+    // thread 0 is whoever calls tpool_run
+    for(int i = 1; i < num_threads; i++){
+        pool->workers[i].pool = pool;
+        pool->workers[i].tid = i;
+        if(pthread_create(&pool->threads[i], NULL, worker_loop, &pool->workers[i])){
+            fprintf(stderr, "tpool_create: pthread_create failed\n");
+            exit(1);
+        }
+    }
+
+    return pool;
+}
+
+/* tpool_size: number of threads in a pool
+ *
+ * pool: the thread pool
+ *
+ * Returns: the number of threads, including the calling thread
+ */
+int tpool_size(tpool_t *pool)
+{
+    assert(pool != NULL);
+    return pool->num_threads;
+}
+
+/* tpool_run: run fn once on every thread of the pool and wait for all
+ *     of them to return. The calling thread runs tid 0.
+ *
+ * pool: the thread pool
+ * fn: the work
+ * arg: passed through to fn
+ */
+void tpool_run(tpool_t *pool, tpool_fn fn, void *arg)
+{
+    assert(pool != NULL);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->running = pool->num_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    fn(0, arg);
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->running > 0){
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+typedef struct range range_t;
+
+struct range {
+    atomic_long next;
+    long n;
+    long chunk;
+    tpool_range_fn fn;
+    void *arg;
+};
+
+/* range_worker: take chunks of a range until it is used up
+ *
+ * Inputs:
+ * - tid: thread index (int)
+ * - data: the range (range_t*)
+ *
+ * Output: none. function is void.
+ */
+static void range_worker(int tid, void *data)
+{
+    range_t *r = (range_t*)data;
+    while(true){
+        long lo = atomic_fetch_add_explicit(&r->next, r->chunk, 
+                                            memory_order_relaxed);
+        if(lo >= r->n){
+            break;
+        }
+        long hi = lo + r->chunk < r->n ? lo + r->chunk : r->n;
+        r->fn(lo, hi, tid, r->arg);
+    }
+}
+
+/* tpool_for: split [0, n) into chunks and hand them out to the threads
+ *     of the pool as they become free
+ *
+ * pool: the thread pool
+ * n: number of indices
+ * chunk: indices per chunk, 0 to pick one
+ * fn: the work
+ * arg: passed through to fn
+ */
+void tpool_for(tpool_t *pool, long n, long chunk, tpool_range_fn fn, void *arg)
+{
+    assert(pool != NULL);
+    if(n <= 0){
+        return;
+    }
+    if(chunk <= 0){
+        // about 8 chunks per thread balances load without much contention
+        chunk = n / (8L * pool->num_threads);
+        if(chunk < 64){
+            chunk = 64;
+        }
+    }
+
+    // small ranges are not worth waking the pool
+    if(n <= chunk){
+        fn(0, n, 0, arg);
+        return;
+    }
+
+    range_t r;
+    atomic_init(&r.next, 0);
+    r.n = n;
+    r.chunk = chunk;
+    r.fn = fn;
+    r.arg = arg;
+    tpool_run(pool, range_worker, &r);
+}
+
+/* tpool_free: stop and free a pool of threads
+ *
+ * pool: the thread pool
+ */
+void tpool_free(tpool_t *pool)
+{
+    assert(pool != NULL);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(int i = 1; i < pool->num_threads; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+}
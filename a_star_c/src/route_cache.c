@@ -0,0 +1,424 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "util.h"
+#include "a_star.h"
+#include "route_cache.h"
+
+// enough shards that a handful of threads rarely share a lock, each big
+// enough that a few hot keys landing in the same one do not evict each other
+#define NUM_SHARDS (16)
+#define MIN_SHARD_SIZE (8)
+
+/********* ROUTE CACHE *********/
+
+typedef struct entry entry_t;
+typedef struct shard shard_t;
+
+struct entry {
+    uint64_t hash;
+    int start;
+    int end;
+    unsigned long mask_hash;
+
+    double cost;
+    int path_len;        // 0 if there is no path
+    size_t path_bytes;
+
+    entry_t *chain;      // next entry in the same bucket
+    entry_t *newer;      // neighbors in the least recently used list
+    entry_t *older;
+
+    // the nodes after the start, each as the zigzag gap from the one before
+    uint8_t path[];
+};
+
+struct shard {
+    pthread_mutex_t lock;
+
+    int capacity;
+    int size;
+    unsigned long version;   // graph version the entries were found on
+
+    entry_t **buckets;
+    int num_buckets;         // a power of two
+    entry_t *newest;
+    entry_t *oldest;
+
+    long hits;
+    long misses;
+    long evictions;
+    long invalidations;
+    size_t path_bytes;
+};
+
+struct route_cache {
+    graph_t *graph;
+    int num_shards;
+    shard_t *shards;
+};
+
+/* key_hash: hash of a cache key
+ *
+ * Inputs:
+ * - start, end: the start and end node numbers (int)
+ * - mh: the mask hash (unsigned long)
+ *
+ * Output: the hash, the low bits pick the shard and the high bits the
+ * bucket (uint64_t)
+ */
+static uint64_t key_hash(int start, int end, unsigned long mh)
+{
+    uint64_t x = ((uint64_t)(uint32_t)start << 32 | (uint32_t)end) ^
+                 (uint64_t)mh * 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/* entry_create: encode a search result as a cache entry
+ *
+ * Inputs:
+ * - hash, start, end, mh: the key (uint64_t, int, int, unsigned long)
+ * - cost: the path cost, -1 if there is no path (double)
+ * - nodes: the path, NULL if there is none (const int*)
+ * - len: number of nodes on the path (int)
+ *
+ * Output: the entry, not in any list yet (entry_t*)
+ */
+static entry_t *entry_create(uint64_t hash, int start, int end, unsigned long mh,
+                             double cost, const int *nodes, int len)
+{
+    size_t bytes = 0;
+    for(int i = 1; i < len; i++){
+        bytes += varint_len(zigzag(nodes[i] - nodes[i - 1]));
+    }
+
+    entry_t *e = (entry_t*)malloc(sizeof(entry_t) + bytes);
+    if(e == NULL){
+        fprintf(stderr, "entry_create: malloc failed\n");
+        exit(1);
+    }
+    e->hash = hash;
+    e->start = start;
+    e->end = end;
+    e->mask_hash = mh;
+    e->cost = cost;
+    e->path_len = len;
+    e->path_bytes = bytes;
+    e->chain = e->newer = e->older = NULL;
+
+    uint8_t *out = e->path;
+    for(int i = 1; i < len; i++){
+        out += varint_put(out, zigzag(nodes[i] - nodes[i - 1]));
+    }
+    return e;
+}
+
+/* entry_path: decode the path of an entry
+ *
+ * Inputs:
+ * - e: the entry, with a path (entry_t*)
+ *
+ * Output: a new array with the nodes from the start to the end (int*)
+ */
+static int *entry_path(const entry_t *e)
+{
+    int *nodes = (int*)malloc(sizeof(int) * e->path_len);
+    if(nodes == NULL){
+        fprintf(stderr, "entry_path: malloc failed\n");
+        exit(1);
+    }
+    const uint8_t *cursor = e->path;
+    nodes[0] = e->start;
+    for(int i = 1; i < e->path_len; i++){
+        nodes[i] = nodes[i - 1] + unzigzag(varint_get(&cursor));
+    }
+    return nodes;
+}
+
+/* Helpers for the shards below, all called with the shard locked:
+ *
+ * shard_find: the entry for a key, NULL if there is none
+ * shard_unlink: take an entry out of its bucket and the list
+ * shard_push: add an entry to its bucket and the front of the list
+ * shard_drop_all: free every entry, counting them as invalidations
+ * shard_sync: drop every entry if the graph changed since they were found
+ */
+static entry_t *shard_find(shard_t *s, uint64_t hash, int start, int end,
+                           unsigned long mh)
+{
+    entry_t *e = s->buckets[(hash >> 32) & (s->num_buckets - 1)];
+    for(; e; e = e->chain){
+        if(e->hash == hash && e->start == start && e->end == end &&
+           e->mask_hash == mh){
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void shard_unlink(shard_t *s, entry_t *e)
+{
+    entry_t **link = &s->buckets[(e->hash >> 32) & (s->num_buckets - 1)];
+    while(*link != e){
+        link = &(*link)->chain;
+    }
+    *link = e->chain;
+
+    if(e->newer){
+        e->newer->older = e->older;
+    }else{
+        s->newest = e->older;
+    }
+    if(e->older){
+        e->older->newer = e->newer;
+    }else{
+        s->oldest = e->newer;
+    }
+    s->size--;
+    s->path_bytes -= e->path_bytes;
+}
+
+static void shard_push(shard_t *s, entry_t *e)
+{
+    entry_t **bucket = &s->buckets[(e->hash >> 32) & (s->num_buckets - 1)];
+    e->chain = *bucket;
+    *bucket = e;
+
+    e->newer = NULL;
+    e->older = s->newest;
+    if(s->newest){
+        s->newest->newer = e;
+    }else{
+        s->oldest = e;
+    }
+    s->newest = e;
+    s->size++;
+    s->path_bytes += e->path_bytes;
+}
+
+static void shard_drop_all(shard_t *s)
+{
+    entry_t *e = s->newest;
+    while(e){
+        entry_t *older = e->older;
+        free(e);
+        e = older;
+    }
+    memset(s->buckets, 0, sizeof(entry_t*) * s->num_buckets);
+    s->invalidations += s->size;
+    s->newest = s->oldest = NULL;
+    s->size = 0;
+    s->path_bytes = 0;
+}
+
+static void shard_sync(shard_t *s, graph_t *graph)
+{
+    if(s->version != graph->version){
+        shard_drop_all(s);
+        s->version = graph->version;
+    }
+}
+
+/* route_cache_create: create an empty cache for a graph
+ *
+ * graph: the graph, which must outlive the cache
+ * capacity: the most results the cache holds
+ *
+ * Returns: the cache
+ */
+route_cache_t *route_cache_create(graph_t *graph, int capacity)
+{
+    assert(capacity > 0);
+
+    route_cache_t *cache = (route_cache_t*)malloc(sizeof(route_cache_t));
+    if(cache == NULL){
+        fprintf(stderr, "route_cache_create: malloc failed\n");
+        exit(1);
+    }
+    cache->graph = graph;
+    cache->num_shards = capacity / MIN_SHARD_SIZE;
+    cache->num_shards = cache->num_shards < 1 ? 1 : cache->num_shards;
+    cache->num_shards = cache->num_shards > NUM_SHARDS ? NUM_SHARDS : cache->num_shards;
+    cache->shards = (shard_t*)malloc(sizeof(shard_t) * cache->num_shards);
+    if(cache->shards == NULL){
+        fprintf(stderr, "route_cache_create - shards: malloc failed\n");
+        exit(1);
+    }
+
+    for(int i = 0; i < cache->num_shards; i++){
+        shard_t *s = &cache->shards[i];
+        pthread_mutex_init(&s->lock, NULL);
+
+        // the shard capacities add up to exactly capacity
+        s->capacity = capacity / cache->num_shards +
+                      (i < capacity % cache->num_shards);
+        s->size = 0;
+        s->version = graph->version;
+
+        s->num_buckets = 1;
+        while(s->num_buckets < 2 * s->capacity){
+            s->num_buckets *= 2;
+        }
+        s->buckets = (entry_t**)calloc(s->num_buckets, sizeof(entry_t*));
+        if(s->buckets == NULL){
+            fprintf(stderr, "route_cache_create - buckets: calloc failed\n");
+            exit(1);
+        }
+        s->newest = s->oldest = NULL;
+
+        s->hits = s->misses = s->evictions = s->invalidations = 0;
+        s->path_bytes = 0;
+    }
+
+    return cache;
+}
+
+/* route_cache_a_star: performs A* search, or looks up the result of an
+ *     earlier search with the same start, end and mask. Thread-safe.
+ *
+ * cache: the cache
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * mask: the search mask, NULL for none
+ * path: set to a new array with the node numbers from the start to the
+ *     end, to be freed by the caller, NULL if there is no path. May be
+ *     NULL when the path is not needed.
+ * path_len: set to the number of nodes on the path, 0 if there is no
+ *     path, may be NULL
+ *
+ * Returns: the distance of the path between the start node and end node,
+ *     -1 if there is no path
+ */
+double route_cache_a_star(route_cache_t *cache, int start_node_num,
+                          int end_node_num, const search_mask_t *mask,
+                          int **path, int *path_len)
+{
+    graph_t *graph = cache->graph;
+    unsigned long mh = mask_hash(mask);
+    uint64_t hash = key_hash(start_node_num, end_node_num, mh);
+    shard_t *s = &cache->shards[hash % cache->num_shards];
+
+    pthread_mutex_lock(&s->lock);
+    shard_sync(s, graph);
+    entry_t *e = shard_find(s, hash, start_node_num, end_node_num, mh);
+    if(e){
+        s->hits++;
+        shard_unlink(s, e);
+        shard_push(s, e);
+
+        double cost = e->cost;
+        if(path){
+            *path = e->path_len ? entry_path(e) : NULL;
+        }
+        if(path_len){
+            *path_len = e->path_len;
+        }
+        pthread_mutex_unlock(&s->lock);
+        return cost;
+    }
+    s->misses++;
+    unsigned long version = s->version;
+    pthread_mutex_unlock(&s->lock);
+
+    // search without holding the lock, so misses run concurrently
+    search_ctx_t *ctx = search_ctx_acquire(graph);
+    search_ctx_set_mask(ctx, mask);
+    double cost = search_ctx_a_star(graph, ctx, start_node_num, end_node_num,
+                                    NULL, 0);
+    int *nodes = NULL;
+    int len = 0;
+    if(cost >= 0){
+        len = search_ctx_path(ctx, end_node_num, &nodes);
+    }
+    search_ctx_release(graph, ctx);
+
+    e = entry_create(hash, start_node_num, end_node_num, mh, cost, nodes, len);
+
+    pthread_mutex_lock(&s->lock);
+    shard_sync(s, graph);
+
+    // another thread may have filled the same key in the meantime
+    if(s->version == version &&
+       !shard_find(s, hash, start_node_num, end_node_num, mh)){
+        if(s->size == s->capacity){
+            entry_t *oldest = s->oldest;
+            shard_unlink(s, oldest);
+            free(oldest);
+            s->evictions++;
+        }
+        shard_push(s, e);
+    }else{
+        free(e);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    if(path){
+        *path = nodes;
+    }else{
+        free(nodes);
+    }
+    if(path_len){
+        *path_len = len;
+    }
+    return cost;
+}
+
+/* route_cache_clear: drop every cached result, for changes the graph
+ *     version does not track, like moving a node. Thread-safe.
+ *
+ * cache: the cache
+ */
+void route_cache_clear(route_cache_t *cache)
+{
+    for(int i = 0; i < cache->num_shards; i++){
+        shard_t *s = &cache->shards[i];
+        pthread_mutex_lock(&s->lock);
+        shard_drop_all(s);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+/* route_cache_get_stats: read the counters of a cache. Thread-safe.
+ *
+ * cache: the cache
+ * stats: filled in with the counters since the cache was created
+ */
+void route_cache_get_stats(route_cache_t *cache, route_cache_stats_t *stats)
+{
+    memset(stats, 0, sizeof(route_cache_stats_t));
+    for(int i = 0; i < cache->num_shards; i++){
+        shard_t *s = &cache->shards[i];
+        pthread_mutex_lock(&s->lock);
+        shard_sync(s, cache->graph);
+        stats->hits += s->hits;
+        stats->misses += s->misses;
+        stats->evictions += s->evictions;
+        stats->invalidations += s->invalidations;
+        stats->entries += s->size;
+        stats->path_bytes += s->path_bytes;
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+/* route_cache_free: free a cache
+ *
+ * cache: the cache
+ */
+void route_cache_free(route_cache_t *cache)
+{
+    for(int i = 0; i < cache->num_shards; i++){
+        shard_t *s = &cache->shards[i];
+        shard_drop_all(s);
+        free(s->buckets);
+        pthread_mutex_destroy(&s->lock);
+    }
+    free(cache->shards);
+    free(cache);
+}
@@ -0,0 +1,815 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "a_star.h"
+#include "csr.h"
+#include "parallel.h"
+#include "route_server.h"
+
+/********* ROUTE SERVER *********/
+
+#define MAX_EVENTS (64)
+#define READ_CHUNK (4096)
+
+typedef struct frame frame_t;
+typedef struct conn conn_t;
+typedef struct job job_t;
+
+struct frame {
+    uint32_t magic;
+    uint32_t count;
+};
+
+struct conn {
+    int fd;
+    uint32_t events;   // what epoll is watching for
+    conn_t *next;      // open connections, then connections to free
+
+    // bytes read and not yet parsed
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+
+    // the answer being written
+    char *out;
+    size_t out_len;
+    size_t out_pos;
+
+    bool busy;      // a batch is with the workers, reading is paused
+    bool closing;   // closed while busy, freed when the batch comes back
+};
+
+struct job {
+    conn_t *conn;
+    int count;
+    int32_t *pairs;   // start and end of each query
+    char *answer;     // frame and costs, filled in by a worker
+    size_t answer_len;
+    job_t *next;
+};
+
+struct route_server {
+    csr_t *csr;
+    char *path;
+    bool bound;       // the socket at path is ours to remove
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;      // eventfd the workers and route_server_stop write to
+    tpool_t *pool;
+    atomic_bool stop;
+
+    // batches waiting for a worker and batches answered, guarded by lock
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    job_t *queue_head;
+    job_t *queue_tail;
+    job_t *done;
+    bool quit;        // workers return once the queue is empty
+
+    // the rest is only touched by the event loop
+    conn_t *conns;
+    conn_t *dead;     // closed during this round of events
+    int in_flight;
+};
+
+/* route_server_create: create a server listening on a socket path
+ *
+ * csr: the graph, which must outlive the server
+ * path: the socket path, replaced if a socket is already there. Any
+ *     other kind of file there is left alone.
+ * num_threads: number of threads, including the one running the event
+ *     loop, 0 for one per core. With 1 the loop runs the searches itself.
+ *
+ * Returns: the server, NULL if the socket could not be set up or path
+ *     is a file other than a socket
+ */
+route_server_t *route_server_create(csr_t *csr, const char *path, int num_threads)
+{
+    struct sockaddr_un addr;
+    if(strlen(path) >= sizeof(addr.sun_path)){
+        return NULL;
+    }
+    // a socket left by an earlier server is replaced, nothing else is
+    struct stat st;
+    if(lstat(path, &st) == 0){
+        if(!S_ISSOCK(st.st_mode)){
+            return NULL;
+        }
+        unlink(path);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    route_server_t *server = (route_server_t*)calloc(1, sizeof(route_server_t));
+    if(server == NULL){
+        fprintf(stderr, "route_server_create: malloc failed\n");
+        exit(1);
+    }
+    server->csr = csr;
+    server->path = strdup(path);
+    if(server->path == NULL){
+        fprintf(stderr, "route_server_create - path: malloc failed\n");
+        exit(1);
+    }
+    atomic_init(&server->stop, false);
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->work, NULL);
+
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event listen_ev = { .events = EPOLLIN, .data.ptr = &server->listen_fd };
+    struct epoll_event wake_ev = { .events = EPOLLIN, .data.ptr = &server->wake_fd };
+    if(server->listen_fd < 0 || server->epoll_fd < 0 || server->wake_fd < 0 ||
+       bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+        route_server_free(server);
+        return NULL;
+    }
+    server->bound = true;
+    if(listen(server->listen_fd, SOMAXCONN) < 0 ||
+       epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &listen_ev) < 0 ||
+       epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->wake_fd, &wake_ev) < 0){
+        route_server_free(server);
+        return NULL;
+    }
+
+    server->pool = tpool_create(num_threads);
+    return server;
+}
+
+/* Helpers for the event loop below:
+ *
+ * conn_watch: tell epoll what to wait for on a connection, reads unless a
+ *     batch is out, writes while an answer is pending
+ * conn_close: close a connection, freeing it after this round of events,
+ *     or once its batch comes back
+ */
+static void conn_watch(route_server_t *server, conn_t *conn)
+{
+    uint32_t events = (conn->busy ? 0 : EPOLLIN) |
+                      (conn->out_pos < conn->out_len ? EPOLLOUT : 0);
+    if(events != conn->events){
+        struct epoll_event ev = { .events = events, .data.ptr = conn };
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+        conn->events = events;
+    }
+}
+
+static void conn_close(route_server_t *server, conn_t *conn)
+{
+    if(conn->fd < 0){
+        return;
+    }
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    conn->fd = -1;
+
+    for(conn_t **link = &server->conns; *link; link = &(*link)->next){
+        if(*link == conn){
+            *link = conn->next;
+            break;
+        }
+    }
+    if(conn->busy){
+        conn->closing = true;
+    }else{
+        conn->next = server->dead;
+        server->dead = conn;
+    }
+}
+
+/* accept_all: accept every pending connection
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ *
+ * Output: none. function is void.
+ */
+static void accept_all(route_server_t *server)
+{
+    while(true){
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0){
+            return;
+        }
+        conn_t *conn = (conn_t*)calloc(1, sizeof(conn_t));
+        if(conn == NULL){
+            fprintf(stderr, "accept_all: malloc failed\n");
+            exit(1);
+        }
+        conn->fd = fd;
+        conn->events = EPOLLIN;
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = conn };
+        if(epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0){
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = server->conns;
+        server->conns = conn;
+    }
+}
+
+/* conn_flush: write as much of the pending answer as the socket takes
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ * - conn: the connection (conn_t*)
+ *
+ * Output: none. function is void.
+ */
+static void conn_flush(route_server_t *server, conn_t *conn)
+{
+    while(conn->fd >= 0 && conn->out_pos < conn->out_len){
+        ssize_t n = send(conn->fd, conn->out + conn->out_pos,
+                         conn->out_len - conn->out_pos, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            return;
+        }
+        if(n <= 0){
+            conn_close(server, conn);
+            return;
+        }
+        conn->out_pos += n;
+    }
+}
+
+/* conn_answer: make a frame the pending answer of a connection
+ *
+ * Inputs:
+ * - conn: the connection, with no answer pending (conn_t*)
+ * - answer: the frame, owned by the connection from now on (char*)
+ * - len: its length in bytes (size_t)
+ *
+ * Output: none. function is void.
+ */
+static void conn_answer(conn_t *conn, char *answer, size_t len)
+{
+    free(conn->out);
+    conn->out = answer;
+    conn->out_len = len;
+    conn->out_pos = 0;
+}
+
+/* run_job: answer every query of a batch
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ * - job: the batch (job_t*)
+ *
+ * Output: none. function is void.
+ */
+static void run_job(route_server_t *server, job_t *job)
+{
+    job->answer_len = sizeof(frame_t) + sizeof(double) * job->count;
+    job->answer = (char*)malloc(job->answer_len);
+    if(job->answer == NULL){
+        fprintf(stderr, "run_job: malloc failed\n");
+        exit(1);
+    }
+    frame_t frame = { ROUTE_MAGIC, (uint32_t)job->count };
+    memcpy(job->answer, &frame, sizeof(frame));
+
+    double *costs = (double*)(job->answer + sizeof(frame_t));
+    for(int i = 0; i < job->count; i++){
+        int start = job->pairs[2 * i];
+        int end = job->pairs[2 * i + 1];
+        if(csr_has_node(server->csr, start) && csr_has_node(server->csr, end)){
+            costs[i] = a_star_csr(server->csr, start, end);
+        }else{
+            costs[i] = -1;
+        }
+    }
+}
+
+/* conn_serve: start on the batches read from a connection, while no batch
+ *     is out and no answer is pending
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ * - conn: the connection (conn_t*)
+ *
+ * Output: none. function is void.
+ */
+static void conn_serve(route_server_t *server, conn_t *conn)
+{
+    bool inline_jobs = tpool_size(server->pool) == 1;
+    size_t used = 0;
+
+    while(conn->fd >= 0 && !conn->busy && conn->out_pos == conn->out_len &&
+          !atomic_load(&server->stop) && conn->in_len - used >= sizeof(frame_t)){
+        frame_t frame;
+        memcpy(&frame, conn->in + used, sizeof(frame));
+        if(frame.magic != ROUTE_MAGIC || frame.count > ROUTE_MAX_BATCH){
+            conn_close(server, conn);
+            return;
+        }
+
+        // an empty batch asks for the size of the graph
+        if(frame.count == 0){
+            frame_t *answer = (frame_t*)malloc(sizeof(frame_t));
+            if(answer == NULL){
+                fprintf(stderr, "conn_serve: malloc failed\n");
+                exit(1);
+            }
+            answer->magic = ROUTE_MAGIC;
+            answer->count = (uint32_t)csr_num_nodes(server->csr);
+            conn_answer(conn, (char*)answer, sizeof(frame_t));
+            used += sizeof(frame_t);
+            conn_flush(server, conn);
+            continue;
+        }
+
+        size_t need = sizeof(frame_t) + 2 * sizeof(int32_t) * frame.count;
+        if(conn->in_len - used < need){
+            break;
+        }
+        job_t *job = (job_t*)calloc(1, sizeof(job_t));
+        if(job != NULL){
+            job->pairs = (int32_t*)malloc(2 * sizeof(int32_t) * frame.count);
+        }
+        if(job == NULL || job->pairs == NULL){
+            fprintf(stderr, "conn_serve - job: malloc failed\n");
+            exit(1);
+        }
+        job->conn = conn;
+        job->count = frame.count;
+        memcpy(job->pairs, conn->in + used + sizeof(frame_t), need - sizeof(frame_t));
+        used += need;
+
+        if(inline_jobs){
+            run_job(server, job);
+            conn_answer(conn, job->answer, job->answer_len);
+            free(job->pairs);
+            free(job);
+            conn_flush(server, conn);
+            continue;
+        }
+
+        conn->busy = true;
+        server->in_flight++;
+        pthread_mutex_lock(&server->lock);
+        if(server->queue_tail){
+            server->queue_tail->next = job;
+        }else{
+            server->queue_head = job;
+        }
+        server->queue_tail = job;
+        pthread_cond_signal(&server->work);
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    if(used > 0 && conn->fd >= 0){
+        memmove(conn->in, conn->in + used, conn->in_len - used);
+        conn->in_len -= used;
+    }
+    if(conn->fd >= 0){
+        conn_watch(server, conn);
+    }
+}
+
+/* conn_read: read everything a connection has sent
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ * - conn: the connection (conn_t*)
+ *
+ * Output: none. function is void.
+ */
+static void conn_read(route_server_t *server, conn_t *conn)
+{
+    while(conn->fd >= 0){
+        if(conn->in_cap - conn->in_len < READ_CHUNK){
+            size_t cap = conn->in_cap * 2 + READ_CHUNK;
+            char *in = (char*)realloc(conn->in, cap);
+            if(in == NULL){
+                fprintf(stderr, "conn_read: realloc failed\n");
+                exit(1);
+            }
+            conn->in = in;
+            conn->in_cap = cap;
+        }
+        ssize_t n = read(conn->fd, conn->in + conn->in_len, conn->in_cap - conn->in_len);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            return;
+        }
+        if(n <= 0){
+            conn_close(server, conn);
+            return;
+        }
+        conn->in_len += n;
+
+        // a client sending more than a batch ahead waits in the socket
+        if(conn->in_len > sizeof(frame_t) + 2 * sizeof(int32_t) * ROUTE_MAX_BATCH){
+            return;
+        }
+    }
+}
+
+/* finish_jobs: hand the answered batches back to their connections
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ *
+ * Output: none. function is void.
+ */
+static void finish_jobs(route_server_t *server)
+{
+    pthread_mutex_lock(&server->lock);
+    job_t *job = server->done;
+    server->done = NULL;
+    pthread_mutex_unlock(&server->lock);
+
+    while(job){
+        job_t *next = job->next;
+        conn_t *conn = job->conn;
+        server->in_flight--;
+        conn->busy = false;
+        if(conn->closing){
+            free(job->answer);
+            conn->next = server->dead;
+            server->dead = conn;
+        }else{
+            conn_answer(conn, job->answer, job->answer_len);
+            conn_flush(server, conn);
+            conn_serve(server, conn);
+        }
+        free(job->pairs);
+        free(job);
+        job = next;
+    }
+}
+
+/* free_dead: free the connections closed in this round of events
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ *
+ * Output: none. function is void.
+ */
+static void free_dead(route_server_t *server)
+{
+    while(server->dead){
+        conn_t *conn = server->dead;
+        server->dead = conn->next;
+        free(conn->in);
+        free(conn->out);
+        free(conn);
+    }
+}
+
+/* event_loop: body of thread 0, serves until stopped and every batch in
+ *     flight is answered
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ *
+ * Output: 0, or -1 if epoll failed (int)
+ */
+static int event_loop(route_server_t *server)
+{
+    struct epoll_event events[MAX_EVENTS];
+    bool stopping = false;
+    int status = 0;
+
+    while(!stopping || server->in_flight > 0){
+        int ready = epoll_wait(server->epoll_fd, events, MAX_EVENTS, -1);
+        if(ready < 0 && errno == EINTR){
+            continue;
+        }
+        if(ready < 0){
+            status = -1;
+            break;
+        }
+        for(int i = 0; i < ready; i++){
+            void *ptr = events[i].data.ptr;
+            if(ptr == &server->listen_fd){
+                if(!stopping){
+                    accept_all(server);
+                }
+            }else if(ptr == &server->wake_fd){
+                uint64_t count;
+                while(read(server->wake_fd, &count, sizeof(count)) > 0);
+                finish_jobs(server);
+            }else{
+                conn_t *conn = (conn_t*)ptr;
+                uint32_t ev = events[i].events;
+                if(conn->fd >= 0 && (ev & EPOLLIN)){
+                    conn_read(server, conn);
+                }
+                if(conn->fd >= 0 && (ev & EPOLLOUT)){
+                    conn_flush(server, conn);
+                }
+                if(conn->fd >= 0 && (ev & (EPOLLERR | EPOLLHUP)) && !(ev & EPOLLIN)){
+                    conn_close(server, conn);
+                }
+                if(conn->fd >= 0){
+                    conn_serve(server, conn);
+                }
+            }
+        }
+        free_dead(server);
+
+        if(!stopping && atomic_load(&server->stop)){
+            stopping = true;
+            epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, server->listen_fd, NULL);
+        }
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->quit = true;
+    pthread_cond_broadcast(&server->work);
+    pthread_mutex_unlock(&server->lock);
+
+    while(server->conns){
+        conn_close(server, server->conns);
+    }
+    free_dead(server);
+    return status;
+}
+
+/* worker_loop: body of every other thread, runs batches off the queue
+ *
+ * Inputs:
+ * - server: the server (route_server_t*)
+ *
+ * Output: none. function is void.
+ */
+static void worker_loop(route_server_t *server)
+{
+    uint64_t one = 1;
+
+    pthread_mutex_lock(&server->lock);
+    while(true){
+        while(!server->queue_head && !server->quit){
+            pthread_cond_wait(&server->work, &server->lock);
+        }
+        job_t *job = server->queue_head;
+        if(job == NULL){
+            break;
+        }
+        server->queue_head = job->next;
+        if(server->queue_head == NULL){
+            server->queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        run_job(server, job);
+
+        pthread_mutex_lock(&server->lock);
+        job->next = server->done;
+        server->done = job;
+        if(write(server->wake_fd, &one, sizeof(one)) < 0){
+            // the counter is already non-zero, the loop will wake
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+}
+
+typedef struct run_args run_args_t;
+
+struct run_args {
+    route_server_t *server;
+    int status;
+};
+
+/* server_thread: thread 0 runs the event loop, the others the searches
+ *
+ * Inputs:
+ * - tid: thread index (int)
+ * - data: the arguments (run_args_t*)
+ *
+ * Output: none. function is void.
+ */
+static void server_thread(int tid, void *data)
+{
+    run_args_t *args = (run_args_t*)data;
+    if(tid == 0){
+        args->status = event_loop(args->server);
+    }else{
+        worker_loop(args->server);
+    }
+}
+
+/* route_server_run: serve queries until route_server_stop is called
+ *
+ * server: the server
+ *
+ * Returns: 0 once stopped, -1 if the event loop failed
+ */
+int route_server_run(route_server_t *server)
+{
+    run_args_t args = { server, 0 };
+    server->quit = false;
+    tpool_run(server->pool, server_thread, &args);
+    return args.status;
+}
+
+/* route_server_stop: make route_server_run return, once the batches in
+ *     flight are answered. Safe to call from other threads and from
+ *     signal handlers.
+ *
+ * server: the server
+ */
+void route_server_stop(route_server_t *server)
+{
+    uint64_t one = 1;
+    atomic_store(&server->stop, true);
+    if(write(server->wake_fd, &one, sizeof(one)) < 0){
+        // the counter is already non-zero, the loop will wake
+    }
+}
+
+/* route_server_free: free a server and remove its socket
+ *
+ * server: the server, not running
+ */
+void route_server_free(route_server_t *server)
+{
+    if(server->pool){
+        tpool_free(server->pool);
+    }
+    if(server->listen_fd >= 0){
+        close(server->listen_fd);
+    }
+    if(server->bound){
+        unlink(server->path);
+    }
+    if(server->epoll_fd >= 0){
+        close(server->epoll_fd);
+    }
+    if(server->wake_fd >= 0){
+        close(server->wake_fd);
+    }
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->work);
+    free(server->path);
+    free(server);
+}
+
+/********* ROUTE CLIENT *********/
+
+struct route_client {
+    int fd;
+    int32_t *pairs;   // request buffer, room for ROUTE_MAX_BATCH queries
+};
+
+/* Helpers for the client below:
+ *
+ * write_all: write a whole buffer to a blocking socket, false on error
+ * read_all: read a whole buffer from a blocking socket, false on error or
+ *     if the server closed the connection
+ */
+static bool write_all(int fd, const void *buf, size_t len)
+{
+    const char *p = (const char*)buf;
+    while(len > 0){
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n <= 0){
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *buf, size_t len)
+{
+    char *p = (char*)buf;
+    while(len > 0){
+        ssize_t n = read(fd, p, len);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n <= 0){
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/* route_client_connect: connect to a server
+ *
+ * path: the socket path
+ *
+ * Returns: the client, NULL if the connection failed
+ */
+route_client_t *route_client_connect(const char *path)
+{
+    struct sockaddr_un addr;
+    if(strlen(path) >= sizeof(addr.sun_path)){
+        return NULL;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        return NULL;
+    }
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+        close(fd);
+        return NULL;
+    }
+
+    route_client_t *client = (route_client_t*)malloc(sizeof(route_client_t));
+    if(client == NULL){
+        fprintf(stderr, "route_client_connect: malloc failed\n");
+        exit(1);
+    }
+    client->fd = fd;
+    client->pairs = (int32_t*)malloc(sizeof(frame_t) + 2 * sizeof(int32_t) * ROUTE_MAX_BATCH);
+    if(client->pairs == NULL){
+        fprintf(stderr, "route_client_connect - buffer: malloc failed\n");
+        exit(1);
+    }
+    return client;
+}
+
+/* route_client_num_nodes: number of node slots of the graph of a server
+ *
+ * client: the client
+ *
+ * Returns: the number of nodes, -1 on a connection error
+ */
+int route_client_num_nodes(route_client_t *client)
+{
+    frame_t frame = { ROUTE_MAGIC, 0 };
+    if(!write_all(client->fd, &frame, sizeof(frame)) ||
+       !read_all(client->fd, &frame, sizeof(frame)) || frame.magic != ROUTE_MAGIC){
+        return -1;
+    }
+    return (int)frame.count;
+}
+
+/* route_client_query: send a batch of queries and wait for the answers
+ *
+ * client: the client
+ * count: the number of queries, 1 to ROUTE_MAX_BATCH
+ * starts: the starting node of each query
+ * ends: the ending node of each query
+ * costs: filled with the cost of each query, -1 if there is no path
+ *
+ * Returns: 0 on success, -1 on a connection error
+ */
+int route_client_query(route_client_t *client, int count, const int *starts,
+                       const int *ends, double *costs)
+{
+    assert(count >= 1 && count <= ROUTE_MAX_BATCH);
+
+    // the frame and the pairs go out in one write
+    frame_t frame = { ROUTE_MAGIC, (uint32_t)count };
+    memcpy(client->pairs, &frame, sizeof(frame));
+    int32_t *pairs = client->pairs + sizeof(frame_t) / sizeof(int32_t);
+    for(int i = 0; i < count; i++){
+        pairs[2 * i] = starts[i];
+        pairs[2 * i + 1] = ends[i];
+    }
+    if(!write_all(client->fd, client->pairs, sizeof(frame_t) + 2 * sizeof(int32_t) * count) ||
+       !read_all(client->fd, &frame, sizeof(frame)) ||
+       frame.magic != ROUTE_MAGIC || frame.count != (uint32_t)count ||
+       !read_all(client->fd, costs, sizeof(double) * count)){
+        return -1;
+    }
+    return 0;
+}
+
+/* route_client_close: close a connection
+ *
+ * client: the client
+ */
+void route_client_close(route_client_t *client)
+{
+    close(client->fd);
+    free(client->pairs);
+    free(client);
+}
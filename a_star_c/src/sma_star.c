@@ -0,0 +1,579 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "a_star.h"
+#include "sma_star.h"
+
+/********* SEARCH NODES *********/
+
+enum {OPEN, LEAVES};
+
+typedef struct record record_t;
+
+struct record {
+    int node_num;
+    int parent;         // record, -1 for the start
+    int depth;
+    int first_child;    // records whose parent this is, linked through
+    int prev_sibling;   // their siblings, -1 where the list ends
+    int next_sibling;
+    double g;
+    double f;           // never below the parent's f
+    double forgotten;   // least bound of the pruned children, INFINITY if none
+    intlist_t *next;    // next neighbor list entry to generate, NULL once
+                        // all of them are
+    int pos[2];         // place in the OPEN and LEAVES heaps, -1 if absent
+};
+
+typedef struct sma sma_t;
+
+struct sma {
+    graph_t *graph;
+    int end;
+    int max_nodes;
+    sma_star_stats_t *stats;
+
+    record_t *records;
+    int *free_list;
+    int num_free;
+
+    // node number -> record, open addressing with linear probing
+    int *map_keys;
+    int *map_records;
+    unsigned int map_mask;
+
+    // OPEN: records with successors left to generate, least bound first
+    //     and the deepest of those
+    // LEAVES: records without children but the start, highest bound
+    //     first and the shallowest of those
+    int *heaps[2];
+    int sizes[2];
+};
+
+/* bound: the least f-cost of the paths a record can still lead to
+ *
+ * Inputs:
+ * - s: the search (sma_t*)
+ * - r: the record (record_t*)
+ *
+ * Output: its own f-cost while it has successors left to generate, the
+ *     least bound of the ones it forgot after that, INFINITY if it has
+ *     nothing left. The end node is never expanded, so its bound is its
+ *     own f-cost. (double)
+ */
+static inline double bound(sma_t *s, record_t *r)
+{
+    if(r->next || r->node_num == s->end){
+        return r->f;
+    }
+    return r->forgotten;
+}
+
+/********* VERTEX MAP *********/
+
+/* Helpers for the map from node numbers to records below:
+ *
+ * map_slot: the slot of a node number, or of the empty slot that ends
+ *     its probe sequence
+ * map_get: the record of a node number, -1 if it has none
+ * map_put: give a node number without a record one
+ * map_remove: remove a node number, shifting back the entries after it
+ *     so no probe sequence is cut short
+ */
+static inline unsigned int map_slot(sma_t *s, int node_num)
+{
+    unsigned int i = ((uint32_t)node_num * 2654435761u) & s->map_mask;
+    while(s->map_keys[i] != -1 && s->map_keys[i] != node_num){
+        i = (i + 1) & s->map_mask;
+    }
+    return i;
+}
+
+static inline int map_get(sma_t *s, int node_num)
+{
+    unsigned int i = map_slot(s, node_num);
+    return s->map_keys[i] == -1 ? -1 : s->map_records[i];
+}
+
+static void map_put(sma_t *s, int node_num, int record)
+{
+    unsigned int i = map_slot(s, node_num);
+    s->map_keys[i] = node_num;
+    s->map_records[i] = record;
+}
+
+static void map_remove(sma_t *s, int node_num)
+{
+    unsigned int i = map_slot(s, node_num);
+    assert(s->map_keys[i] == node_num);
+    unsigned int j = i;
+    while(true){
+        j = (j + 1) & s->map_mask;
+        if(s->map_keys[j] == -1){
+            break;
+        }
+        // an entry may fill the hole if its home slot is not between the
+        // hole and where it sits
+        unsigned int home = ((uint32_t)s->map_keys[j] * 2654435761u) & s->map_mask;
+        if(((j - home) & s->map_mask) >= ((j - i) & s->map_mask)){
+            s->map_keys[i] = s->map_keys[j];
+            s->map_records[i] = s->map_records[j];
+            i = j;
+        }
+    }
+    s->map_keys[i] = -1;
+}
+
+/********* RECORD HEAPS *********/
+
+/* before: the order of a heap
+ *
+ * Inputs:
+ * - s: the search (sma_t*)
+ * - h: OPEN or LEAVES (int)
+ * - a, b: records (int)
+ *
+ * Output: true if a belongs above b (bool)
+ */
+static inline bool before(sma_t *s, int h, int a, int b)
+{
+    record_t *x = &s->records[a];
+    record_t *y = &s->records[b];
+    double bx = bound(s, x);
+    double by = bound(s, y);
+    if(bx != by){
+        return h == OPEN ? bx < by : bx > by;
+    }
+    return h == OPEN ? x->depth > y->depth : x->depth < y->depth;
+}
+
+/* Helpers for the heaps of records below, which know where each record
+ * sits so it can move when its bound changes:
+ *
+ * heap_place: put a record at a position of a heap
+ * sift_up: move a record up a heap until its parent belongs above it
+ * sift_down: move a record down a heap until it belongs above its
+ *     children
+ * heap_update: add a record to a heap, or move it after its bound changed
+ * heap_remove: take a record out of a heap, if it is in it
+ */
+static inline void heap_place(sma_t *s, int h, int i, int r)
+{
+    s->heaps[h][i] = r;
+    s->records[r].pos[h] = i;
+}
+
+static void sift_up(sma_t *s, int h, int i)
+{
+    int r = s->heaps[h][i];
+    while(i > 0 && before(s, h, r, s->heaps[h][(i - 1) / 2])){
+        heap_place(s, h, i, s->heaps[h][(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    heap_place(s, h, i, r);
+}
+
+static void sift_down(sma_t *s, int h, int i)
+{
+    int r = s->heaps[h][i];
+    int n = s->sizes[h];
+    while(true){
+        int c = 2 * i + 1;
+        if(c >= n){
+            break;
+        }
+        if(c + 1 < n && before(s, h, s->heaps[h][c + 1], s->heaps[h][c])){
+            c++;
+        }
+        if(!before(s, h, s->heaps[h][c], r)){
+            break;
+        }
+        heap_place(s, h, i, s->heaps[h][c]);
+        i = c;
+    }
+    heap_place(s, h, i, r);
+}
+
+static void heap_update(sma_t *s, int h, int r)
+{
+    int i = s->records[r].pos[h];
+    if(i < 0){
+        i = s->sizes[h]++;
+        heap_place(s, h, i, r);
+    }
+    sift_up(s, h, i);
+    sift_down(s, h, s->records[r].pos[h]);
+}
+
+static void heap_remove(sma_t *s, int h, int r)
+{
+    int i = s->records[r].pos[h];
+    if(i < 0){
+        return;
+    }
+    s->records[r].pos[h] = -1;
+    int last = s->heaps[h][--s->sizes[h]];
+    if(last != r){
+        heap_place(s, h, i, last);
+        sift_up(s, h, i);
+        sift_down(s, h, s->records[last].pos[h]);
+    }
+}
+
+/* refresh: put a record in the heaps it belongs in, after its bound or
+ *     children changed
+ *
+ * Inputs:
+ * - s: the search (sma_t*)
+ * - r: the record (int)
+ *
+ * Output: none. function is void.
+ */
+static void refresh(sma_t *s, int r)
+{
+    record_t *rec = &s->records[r];
+    if(bound(s, rec) < INFINITY){
+        heap_update(s, OPEN, r);
+    }else{
+        heap_remove(s, OPEN, r);
+    }
+    if(rec->first_child < 0 && rec->parent >= 0){
+        heap_update(s, LEAVES, r);
+    }else{
+        heap_remove(s, LEAVES, r);
+    }
+}
+
+/********* SMA* SEARCH *********/
+
+/* Helpers for the lists of children below:
+ *
+ * child_link: make a record the first child of another
+ * child_unlink: take a record out of its parent's children
+ */
+static void child_link(sma_t *s, int r, int parent)
+{
+    record_t *rec = &s->records[r];
+    record_t *p = &s->records[parent];
+    rec->parent = parent;
+    rec->depth = p->depth + 1;
+    rec->prev_sibling = -1;
+    rec->next_sibling = p->first_child;
+    if(p->first_child >= 0){
+        s->records[p->first_child].prev_sibling = r;
+    }
+    p->first_child = r;
+}
+
+static void child_unlink(sma_t *s, int r)
+{
+    record_t *rec = &s->records[r];
+    if(rec->prev_sibling >= 0){
+        s->records[rec->prev_sibling].next_sibling = rec->next_sibling;
+    }else{
+        s->records[rec->parent].first_child = rec->next_sibling;
+    }
+    if(rec->next_sibling >= 0){
+        s->records[rec->next_sibling].prev_sibling = rec->prev_sibling;
+    }
+}
+
+/* discard: drop a record and its descendants, without leaving bounds
+ *
+ * Inputs:
+ * - s: the search (sma_t*)
+ * - r: the record, already unlinked from its parent (int)
+ *
+ * Output: none. function is void.
+ */
+static void discard(sma_t *s, int r)
+{
+    // leaves first, so the parents are leaves once their children go
+    int c = r;
+    while(true){
+        while(s->records[c].first_child >= 0){
+            c = s->records[c].first_child;
+        }
+        int parent = s->records[c].parent;
+        if(c != r){
+            child_unlink(s, c);
+        }
+        heap_remove(s, OPEN, c);
+        heap_remove(s, LEAVES, c);
+        map_remove(s, s->records[c].node_num);
+        s->free_list[s->num_free++] = c;
+        if(c == r){
+            break;
+        }
+        c = parent;
+    }
+}
+
+/* store: make a record for a node
+ *
+ * Inputs:
+ * - s: the search, with a free record (sma_t*)
+ * - node_num: the node (int)
+ * - parent: the parent record, -1 for the start (int)
+ * - g: the cost of the path to the node (double)
+ * - f: its f-cost (double)
+ *
+ * Output: the record (int)
+ */
+static int store(sma_t *s, int node_num, int parent, double g, double f)
+{
+    int r = s->free_list[--s->num_free];
+    record_t *rec = &s->records[r];
+    rec->node_num = node_num;
+    rec->parent = -1;
+    rec->depth = 0;
+    rec->first_child = -1;
+    rec->g = g;
+    rec->f = f;
+    rec->forgotten = INFINITY;
+    rec->next = s->graph->nodes[node_num]->neighbors;
+    rec->pos[OPEN] = -1;
+    rec->pos[LEAVES] = -1;
+    map_put(s, node_num, r);
+    if(parent >= 0){
+        child_link(s, r, parent);
+        refresh(s, parent);
+    }
+    refresh(s, r);
+
+    long stored = s->max_nodes - s->num_free;
+    if(s->stats && stored > s->stats->max_stored){
+        s->stats->max_stored = stored;
+    }
+    return r;
+}
+
+/* prune: drop a leaf, leaving its bound with its parent
+ *
+ * Inputs:
+ * - s: the search (sma_t*)
+ * - r: the leaf (int)
+ *
+ * Output: none. function is void.
+ */
+static void prune(sma_t *s, int r)
+{
+    record_t *rec = &s->records[r];
+    record_t *parent = &s->records[rec->parent];
+    assert(rec->first_child < 0);
+    double b = bound(s, rec);
+    if(b < parent->forgotten){
+        parent->forgotten = b;
+    }
+    child_unlink(s, r);
+    heap_remove(s, OPEN, r);
+    heap_remove(s, LEAVES, r);
+    map_remove(s, rec->node_num);
+    s->free_list[s->num_free++] = r;
+    refresh(s, rec->parent);
+    if(s->stats){
+        s->stats->pruned++;
+    }
+}
+
+/* generate: generate the next successor of a record
+ *
+ * Inputs:
+ * - s: the search (sma_t*)
+ * - n: the record, with a successor left to generate (int)
+ *
+ * Output: none. function is void.
+ */
+static void generate(sma_t *s, int n)
+{
+    record_t *rec = &s->records[n];
+    intlist_t *nb = rec->next;
+    rec->next = nb->next;
+    node_t *from = s->graph->nodes[rec->node_num];
+    node_t *to = s->graph->nodes[nb->num];
+    node_t *end = s->graph->nodes[s->end];
+    double g = rec->g + h_calc(from, to);
+    double f = fmax(rec->f, g + h_calc(to, end));
+    if(s->stats){
+        s->stats->generated++;
+    }
+
+    int r = map_get(s, nb->num);
+    if(r >= 0){
+        record_t *old = &s->records[r];
+
+        if(old->g <= g){
+            refresh(s, n);
+            return;
+        }
+
+        // a shorter path to a stored node. Its descendants and forgotten
+        // successors were reached and bounded through the longer one, so
+        // the node moves here and starts over.
+        int prev = old->parent;
+        child_unlink(s, r);
+        while(old->first_child >= 0){
+            int c = old->first_child;
+            child_unlink(s, c);
+            discard(s, c);
+        }
+        old->g = g;
+        old->f = f;
+        old->forgotten = INFINITY;
+        old->next = to->neighbors;
+        child_link(s, r, n);
+        refresh(s, prev);
+        refresh(s, r);
+        refresh(s, n);
+        return;
+    }
+
+    if(s->num_free == 0){
+        // the worst leaf makes room, unless the only leaf is the record
+        // being expanded, when the path is too long to fit
+        heap_remove(s, LEAVES, n);
+        int leaf = s->sizes[LEAVES] > 0 ? s->heaps[LEAVES][0] : -1;
+        if(leaf >= 0){
+            prune(s, leaf);
+        }
+        refresh(s, n);
+        if(leaf < 0){
+            if(s->stats){
+                s->stats->truncated = true;
+            }
+            return;
+        }
+    }
+    store(s, nb->num, n, g, f);
+}
+
+/* sma_star: performs SMA* search, holding at most max_nodes search nodes
+ *
+ * graph: the graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * max_nodes: the most search nodes to hold at once, at least 1
+ * max_generated: the most successors to generate before giving up, 0
+ *     for no limit
+ * path: set to a new array with the node numbers from the start to the
+ *     end, to be freed by the caller, NULL if there is no path. May be
+ *     NULL when the path is not needed.
+ * path_len: set to the number of nodes on the path, 0 if there is no
+ *     path, may be NULL
+ * stats: filled in with search statistics, may be NULL
+ * 
+ * Returns: the distance of the path found between the start node and end
+ *     node, -1 if there is no path, none fits in max_nodes or the search
+ *     gave up
+ */ 
+double sma_star(graph_t *graph, int start_node_num, int end_node_num,
+                int max_nodes, long max_generated, int **path, int *path_len,
+                sma_star_stats_t *stats)
+{
+    assert(graph->nodes[start_node_num] && graph->nodes[end_node_num]);
+    assert(max_nodes >= 1);
+
+    sma_t s;
+    s.graph = graph;
+    s.end = end_node_num;
+    s.max_nodes = max_nodes;
+    s.stats = stats;
+    if(stats){
+        memset(stats, 0, sizeof(sma_star_stats_t));
+    }
+
+    // a map at most half full
+    unsigned int map_size = 16;
+    while(map_size < 2u * max_nodes){
+        map_size *= 2;
+    }
+    s.map_mask = map_size - 1;
+    s.records = (record_t*)malloc(sizeof(record_t) * max_nodes);
+    s.free_list = (int*)malloc(sizeof(int) * max_nodes);
+    s.map_keys = (int*)malloc(sizeof(int) * map_size);
+    s.map_records = (int*)malloc(sizeof(int) * map_size);
+    s.heaps[OPEN] = (int*)malloc(sizeof(int) * max_nodes);
+    s.heaps[LEAVES] = (int*)malloc(sizeof(int) * max_nodes);
+    if(!s.records || !s.free_list || !s.map_keys || !s.map_records ||
+       !s.heaps[OPEN] || !s.heaps[LEAVES]){
+        fprintf(stderr, "sma_star: malloc failed\n");
+        exit(1);
+    }
+    memset(s.map_keys, -1, sizeof(int) * map_size);
+    for(int i = 0; i < max_nodes; i++){
+        s.free_list[i] = max_nodes - 1 - i;
+    }
+    s.num_free = max_nodes;
+    s.sizes[OPEN] = 0;
+    s.sizes[LEAVES] = 0;
+
+    node_t *start = graph->nodes[start_node_num];
+    store(&s, start_node_num, -1, 0, h_calc(start, graph->nodes[end_node_num]));
+
+    int found = -1;
+    long generated = 0;
+    while(s.sizes[OPEN] > 0){
+        int n = s.heaps[OPEN][0];
+        record_t *rec = &s.records[n];
+        if(rec->node_num == end_node_num){
+            found = n;
+            break;
+        }
+        if(rec->next == NULL){
+            // every successor was generated, and the best of the ones
+            // pruned since is the best cost left, so it is backed up into
+            // the node's own f-cost, which the successors inherit
+            rec->f = fmax(rec->f, rec->forgotten);
+            rec->next = graph->nodes[rec->node_num]->neighbors;
+            rec->forgotten = INFINITY;
+            refresh(&s, n);
+            if(stats){
+                stats->regenerated++;
+            }
+            continue;
+        }
+        if(max_generated > 0 && generated++ == max_generated){
+            if(stats){
+                stats->gave_up = true;
+            }
+            break;
+        }
+        generate(&s, n);
+    }
+
+    double cost = found >= 0 ? s.records[found].g : -1;
+    int len = 0;
+    for(int r = found; r >= 0; r = s.records[r].parent){
+        len++;
+    }
+    if(path){
+        *path = NULL;
+        if(found >= 0){
+            *path = (int*)malloc(sizeof(int) * len);
+            if(*path == NULL){
+                fprintf(stderr, "sma_star - path: malloc failed\n");
+                exit(1);
+            }
+            int i = len;
+            for(int r = found; r >= 0; r = s.records[r].parent){
+                (*path)[--i] = s.records[r].node_num;
+            }
+        }
+    }
+    if(path_len){
+        *path_len = len;
+    }
+
+    free(s.records);
+    free(s.free_list);
+    free(s.map_keys);
+    free(s.map_records);
+    free(s.heaps[OPEN]);
+    free(s.heaps[LEAVES]);
+    return cost;
+}
@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "util.h"
+#include "a_star.h"
+#include "time_dep.h"
+
+/********* TIME-DEPENDENT GRAPH *********/
+
+struct td_graph {
+    int num_nodes;
+    int num_edges;
+    double period;
+
+    // neighbors of node u are to[off[u]] .. to[off[u + 1]], over the
+    // edges with the same index in edge
+    long *off;
+    int *to;
+    int *edge;
+
+    double *latitude;
+    double *longitude;
+    uint8_t *exists;
+
+    // straight-line length of each edge, its travel time without a profile
+    double *length;
+
+    // breakpoints of edge e are points prof_off[e] .. prof_off[e] +
+    // prof_len[e] of the pool
+    uint32_t *prof_off;
+    uint16_t *prof_len;
+    float *pool_time;
+    float *pool_cost;
+    long pool_size;
+    long pool_capacity;
+
+    // no edge takes less than this much time per unit of length, which
+    // scales the straight-line heuristic
+    double min_ratio;
+};
+
+/* td_graph_create: build a time-dependent snapshot of a graph, with every
+ *     edge taking its straight-line length
+ *
+ * graph: the graph
+ * period: length of the period the travel time functions repeat over,
+ *     like 86400 for a day in seconds
+ *
+ * Returns: the time-dependent graph
+ */
+td_graph_t *td_graph_create(graph_t *graph, double period)
+{
+    assert(period > 0);
+    int n = graph->num_nodes;
+    int m = graph->num_edges;
+
+    td_graph_t *td = (td_graph_t*)malloc(sizeof(td_graph_t));
+    if(td == NULL){
+        fprintf(stderr, "td_graph_create: malloc failed\n");
+        exit(1);
+    }
+    td->num_nodes = n;
+    td->num_edges = m;
+    td->period = period;
+    td->off = (long*)calloc(n + 1, sizeof(long));
+    td->latitude = (double*)malloc(sizeof(double) * (n + 1));
+    td->longitude = (double*)malloc(sizeof(double) * (n + 1));
+    td->exists = (uint8_t*)malloc(n + 1);
+    td->length = (double*)calloc(m + 1, sizeof(double));
+    td->prof_off = (uint32_t*)calloc(m + 1, sizeof(uint32_t));
+    td->prof_len = (uint16_t*)calloc(m + 1, sizeof(uint16_t));
+    td->pool_size = 0;
+    td->pool_capacity = 64;
+    td->pool_time = (float*)malloc(sizeof(float) * td->pool_capacity);
+    td->pool_cost = (float*)malloc(sizeof(float) * td->pool_capacity);
+    td->min_ratio = 1;
+    if(!td->off || !td->latitude || !td->longitude || !td->exists ||
+       !td->length || !td->prof_off || !td->prof_len || !td->pool_time ||
+       !td->pool_cost){
+        fprintf(stderr, "td_graph_create - arrays: malloc failed\n");
+        exit(1);
+    }
+
+    for(int u = 0; u < n; u++){
+        node_t *node = graph->nodes[u];
+        td->exists[u] = node != NULL;
+        td->latitude[u] = node ? node->latitude : 0;
+        td->longitude[u] = node ? node->longitude : 0;
+        td->off[u + 1] = td->off[u];
+        if(!node){
+            continue;
+        }
+        for(intlist_t *nb = node->neighbors; nb; nb = nb->next){
+            td->off[u + 1]++;
+        }
+    }
+
+    td->to = (int*)malloc(sizeof(int) * (td->off[n] + 1));
+    td->edge = (int*)malloc(sizeof(int) * (td->off[n] + 1));
+    if(!td->to || !td->edge){
+        fprintf(stderr, "td_graph_create - edges: malloc failed\n");
+        exit(1);
+    }
+    for(int u = 0; u < n; u++){
+        if(!graph->nodes[u]){
+            continue;
+        }
+        long i = td->off[u];
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next){
+            td->to[i] = nb->num;
+            td->edge[i] = nb->edge_num;
+            td->length[nb->edge_num] = h_calc(graph->nodes[u], graph->nodes[nb->num]);
+            i++;
+        }
+    }
+
+    return td;
+}
+
+/* profile_eval: evaluate a periodic piecewise-linear function
+ *
+ * Inputs:
+ * - times: breakpoint times, increasing, in [0, period) (const float*)
+ * - costs: values at the breakpoints (const float*)
+ * - n: number of breakpoints, at least 1 (int)
+ * - period: the period (double)
+ * - t: where to evaluate, any time (double)
+ *
+ * Output: the interpolated value (double)
+ */
+static inline double profile_eval(const float *times, const float *costs, int n,
+                                  double period, double t)
+{
+    double x = t - period * floor(t / period);
+
+    // count the breakpoints at or before x without branching, so the loop
+    // vectorizes and does not mispredict on where x falls. Comparing in
+    // float keeps the vectors as wide as the breakpoints, and rounding x
+    // only moves it across a breakpoint the function is continuous at.
+    float xf = (float)x;
+    int k = 0;
+    for(int i = 0; i < n; i++){
+        k += times[i] <= xf;
+    }
+
+    // x lies between breakpoints k - 1 and k, which wrap around the period
+    // when k is 0 or n
+    int lo = k - 1 + n * (k == 0);
+    int hi = k - n * (k == n);
+    double t0 = times[lo] - period * (k == 0);
+    double t1 = times[hi] + period * (k == n);
+    double w = (x - t0) / (t1 - t0);
+    return costs[lo] + w * (costs[hi] - costs[lo]);
+}
+
+/* td_set_profile: set the travel time function of an edge
+ *
+ * td: the time-dependent graph
+ * edge_num: the edge, numbered as in the graph
+ * num_points: the number of breakpoints, at most 65535, 0 for the
+ *     straight-line length
+ * times: time of each breakpoint, increasing, in [0, period)
+ * costs: travel time when entering the edge at each breakpoint, not
+ *     negative
+ *
+ * Returns: 0 on success, -1 if the breakpoints are out of order or out of
+ *     range, a cost is negative, or the function is not FIFO. The edge
+ *     keeps its old function then.
+ */
+int td_set_profile(td_graph_t *td, int edge_num, int num_points,
+                   const double *times, const double *costs)
+{
+    assert(edge_num >= 0 && edge_num < td->num_edges);
+    if(num_points < 0 || num_points > UINT16_MAX){
+        return -1;
+    }
+
+    // check the points as they will be stored
+    double min_cost = INFINITY;
+    for(int i = 0; i < num_points; i++){
+        double t0 = (float)times[i];
+        double c0 = (float)costs[i];
+        double t1 = i + 1 < num_points ? (float)times[i + 1] : (float)times[0] + td->period;
+        double c1 = i + 1 < num_points ? (float)costs[i + 1] : (float)costs[0];
+        if(!(t0 >= 0 && t0 < td->period && t0 < t1 && c0 >= 0 && isfinite(c0))){
+            return -1;
+        }
+        // leaving at t1 must not arrive before leaving at t0
+        if(t1 + c1 < t0 + c0){
+            return -1;
+        }
+        min_cost = fmin(min_cost, c0);
+    }
+
+    // a function no longer than the old one is written over it
+    if(num_points > td->prof_len[edge_num]){
+        if(td->pool_size + num_points > td->pool_capacity){
+            long capacity = td->pool_capacity * 2 + num_points;
+            float *pool_time = (float*)realloc(td->pool_time, sizeof(float) * capacity);
+            float *pool_cost = (float*)realloc(td->pool_cost, sizeof(float) * capacity);
+            if(!pool_time || !pool_cost || capacity > UINT32_MAX){
+                fprintf(stderr, "td_set_profile: realloc failed\n");
+                exit(1);
+            }
+            td->pool_time = pool_time;
+            td->pool_cost = pool_cost;
+            td->pool_capacity = capacity;
+        }
+        td->prof_off[edge_num] = (uint32_t)td->pool_size;
+        td->pool_size += num_points;
+    }
+    uint32_t base = td->prof_off[edge_num];
+    for(int i = 0; i < num_points; i++){
+        td->pool_time[base + i] = (float)times[i];
+        td->pool_cost[base + i] = (float)costs[i];
+    }
+    td->prof_len[edge_num] = (uint16_t)num_points;
+
+    // the ratio only goes down, so it stays a lower bound for every edge
+    if(num_points > 0 && td->length[edge_num] > 0){
+        td->min_ratio = fmin(td->min_ratio, min_cost / td->length[edge_num]);
+    }
+    return 0;
+}
+
+/* edge_time: travel time of an edge
+ *
+ * Inputs:
+ * - td: the time-dependent graph (td_graph_t*)
+ * - e: the edge (int)
+ * - t: the time the edge is entered (double)
+ *
+ * Output: the travel time (double)
+ */
+static inline double edge_time(td_graph_t *td, int e, double t)
+{
+    int n = td->prof_len[e];
+    if(n == 0){
+        return td->length[e];
+    }
+    uint32_t base = td->prof_off[e];
+    return profile_eval(td->pool_time + base, td->pool_cost + base, n, td->period, t);
+}
+
+/* td_travel_time: travel time of an edge
+ *
+ * td: the time-dependent graph
+ * edge_num: the edge
+ * depart: the time the edge is entered, any time, not only in one period
+ *
+ * Returns: the travel time
+ */
+double td_travel_time(td_graph_t *td, int edge_num, double depart)
+{
+    assert(edge_num >= 0 && edge_num < td->num_edges);
+    return edge_time(td, edge_num, depart);
+}
+
+/* td_h: lower bound on the travel time between two nodes
+ *
+ * Inputs:
+ * - td: the time-dependent graph (td_graph_t*)
+ * - u, v: node numbers (int)
+ *
+ * Output: the straight-line distance scaled by the smallest time per unit
+ *     of length (double)
+ */
+static inline double td_h(td_graph_t *td, int u, int v)
+{
+    double dx = td->longitude[u] - td->longitude[v];
+    double dy = td->latitude[u] - td->latitude[v];
+    return td->min_ratio * sqrt(dx * dx + dy * dy);
+}
+
+/* td_a_star: performs time-dependent A* search for the earliest arrival
+ *
+ * td: the time-dependent graph
+ * start_node_num: the staring node number
+ * end_node_num: the ending node number
+ * depart: the time of departure from the start node
+ *
+ * Returns: the earliest arrival time at the end node, -1 if there is no
+ *     path
+ */
+double td_a_star(td_graph_t *td, int start_node_num, int end_node_num,
+                 double depart)
+{
+    assert(td->exists[start_node_num] && td->exists[end_node_num]);
+
+    // the labels hold arrival times in place of path costs
+    search_labels_t arrival;
+    search_labels_init(&arrival, td->num_nodes);
+    heap_t *open = heap_create(1024);
+    double result = -1;
+
+    search_labels_improve(&arrival, start_node_num, depart);
+    heap_push(open, start_node_num, depart + td_h(td, start_node_num, end_node_num));
+
+    while(!heap_is_empty(open)){
+        int curr = heap_pop(open, NULL);
+        if(!search_labels_close(&arrival, curr)){
+            continue;
+        }
+        if(curr == end_node_num){
+            result = arrival.g[curr];
+            break;
+        }
+
+        // by FIFO, leaving curr as early as possible is never worse
+        double t = arrival.g[curr];
+        for(long i = td->off[curr]; i < td->off[curr + 1]; i++){
+            int v = td->to[i];
+            if(bit_get(arrival.closed, v)){
+                continue;
+            }
+            double at = t + edge_time(td, td->edge[i], t);
+            if(search_labels_improve(&arrival, v, at)){
+                heap_push(open, v, at + td_h(td, v, end_node_num));
+            }
+        }
+    }
+
+    heap_free(open);
+    search_labels_free(&arrival);
+
+    return result;
+}
+
+/* td_graph_free: free a time-dependent graph
+ *
+ * td: the time-dependent graph
+ */
+void td_graph_free(td_graph_t *td)
+{
+    free(td->off);
+    free(td->to);
+    free(td->edge);
+    free(td->latitude);
+    free(td->longitude);
+    free(td->exists);
+    free(td->length);
+    free(td->prof_off);
+    free(td->prof_len);
+    free(td->pool_time);
+    free(td->pool_cost);
+    free(td);
+}
@@ -1,16 +1,25 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 #include "util.h"
 
 /********* SET *********/
 
-#define SIZE 20
+#define SIZE 64
+#define WORD_BITS 64
 
+// bitset that grows on demand, so node numbers are not bounded by SIZE
 struct set {
-    bool elements[SIZE];
+    int capacity;
+    uint64_t *words;
 };
 
 /* set_create: create a set
@@ -20,13 +29,46 @@ struct set {
 set_t *set_create()
 {
     set_t *set = (set_t*)malloc(sizeof(set_t));
-    for(int i = 0; i < SIZE; i++) {
-        set->elements[i] = false;
+    if(set == NULL){
+        fprintf(stderr, "set_create: malloc failed\n");
+        exit(1);
+    }
+    set->capacity = SIZE;
+    set->words = (uint64_t*)calloc(SIZE / WORD_BITS, sizeof(uint64_t));
+    if(set->words == NULL){
+        fprintf(stderr, "set_create - words: calloc failed\n");
+        exit(1);
     }
 
     return set;
 }
 
+/* set_grow: grow a set so that it can hold num
+ *
+ * set: the set
+ * num: the number that must fit
+ */ 
+static void set_grow(set_t *set, int num)
+{
+    int capacity = set->capacity;
+    while(capacity <= num){
+        capacity *= 2;
+    }
+
+    uint64_t *words = (uint64_t*)realloc(set->words, 
+                                         sizeof(uint64_t) * (capacity / WORD_BITS));
+    if(words == NULL){
+        fprintf(stderr, "set_grow: realloc failed\n");
+        exit(1);
+    }
+    for(int i = set->capacity / WORD_BITS; i < capacity / WORD_BITS; i++){
+        words[i] = 0;
+    }
+
+    set->words = words;
+    set->capacity = capacity;
+}
+
 /* set_add: add a number to the set
  *
  * set: the set
@@ -35,8 +77,11 @@ set_t *set_create()
 void set_add(set_t *set, int num)
 {
     assert(set != NULL);
-    assert(num < SIZE);
-    set->elements[num] = true;
+    assert(num >= 0);
+    if(num >= set->capacity){
+        set_grow(set, num);
+    }
+    set->words[num / WORD_BITS] |= (uint64_t)1 << (num % WORD_BITS);
 }
 
 /* set_query: determines whether a number is in the set
@@ -49,8 +94,11 @@ void set_add(set_t *set, int num)
 bool set_query(set_t *set, int num)
 {
     assert(set != NULL);
-    assert(num < SIZE);
-    return set->elements[num];
+    assert(num >= 0);
+    if(num >= set->capacity){
+        return false;
+    }
+    return (set->words[num / WORD_BITS] >> (num % WORD_BITS)) & 1;
 }
 
 /* set_free: free a set
@@ -61,6 +109,7 @@ bool set_query(set_t *set, int num)
 void set_free(set_t *set)
 {
     assert(set != NULL);
+    free(set->words);
     free(set);
 }
 
@@ -72,13 +121,43 @@ void set_free(set_t *set)
 void set_print(set_t *set)
 {
     printf("set:\n");
-    for(int i = 0; i < SIZE; i++) {
-        if(set->elements[i]) {
+    for(int i = 0; i < set->capacity; i++) {
+        if(set_query(set, i)) {
             printf("    %d\n", i);
         }
     }
 }
 
+/********* SEARCH LABELS *********/
+
+/* search_labels_init: allocate labels for a search with none seen
+ *
+ * labels: the labels
+ * num_nodes: the number of nodes in the graph
+ */ 
+void search_labels_init(search_labels_t *labels, int num_nodes)
+{
+    long words = num_nodes / 64 + 1;
+    labels->g = (double*)malloc(sizeof(double) * (num_nodes + 1));
+    labels->seen = (uint64_t*)calloc(words, sizeof(uint64_t));
+    labels->closed = (uint64_t*)calloc(words, sizeof(uint64_t));
+    if(!labels->g || !labels->seen || !labels->closed){
+        fprintf(stderr, "search_labels_init: malloc failed\n");
+        exit(1);
+    }
+}
+
+/* search_labels_free: free the arrays of labels from search_labels_init
+ *
+ * labels: the labels
+ */ 
+void search_labels_free(search_labels_t *labels)
+{
+    free(labels->g);
+    free(labels->seen);
+    free(labels->closed);
+}
+
 /********* PRIORITY QUEUE *********/
 
 typedef struct queue_element qelement_t;
@@ -279,4 +358,318 @@ void queue_print(queue_t *q)
             curr = curr->next;
         }
     }
-}
\ No newline at end of file
+}
+
+/********* BINARY HEAP *********/
+
+typedef struct heap_element helement_t;
+
+struct heap_element {
+    double priority;
+    int num;
+};
+
+struct heap {
+    int size;
+    int capacity;
+    helement_t *elements;
+};
+
+/* heap_create: create a binary min-heap
+ *
+ * capacity: initial number of elements, the heap grows past it
+ * 
+ * Returns: a heap
+ */ 
+heap_t *heap_create(int capacity)
+{
+    heap_t *h = (heap_t*)malloc(sizeof(heap_t));
+    if(h == NULL){
+        fprintf(stderr, "heap_create: malloc failed\n");
+        exit(1);
+    }
+    if(capacity < 16){
+        capacity = 16;
+    }
+    h->size = 0;
+    h->capacity = capacity;
+    h->elements = (helement_t*)malloc(sizeof(helement_t) * capacity);
+    if(h->elements == NULL){
+        fprintf(stderr, "heap_create - elements: malloc failed\n");
+        exit(1);
+    }
+    return h;
+}
+
+/* heap_push: add an element to the heap
+ * 
+ * h: the heap
+ * num: the number to add to the heap
+ * priority: priority of num, smaller comes out first
+ */ 
+void heap_push(heap_t *h, int num, double priority)
+{
+    assert(h != NULL);
+    if(h->size == h->capacity){
+        helement_t *elements = (helement_t*)realloc(h->elements, 
+                                    sizeof(helement_t) * h->capacity * 2);
+        if(elements == NULL){
+            fprintf(stderr, "heap_push: realloc failed\n");
+            exit(1);
+        }
+        h->elements = elements;
+        h->capacity *= 2;
+    }
+
+    // sift up
+    int i = h->size++;
+    while(i > 0){
+        int parent = (i - 1) / 2;
+        if(h->elements[parent].priority <= priority){
+            break;
+        }
+        h->elements[i] = h->elements[parent];
+        i = parent;
+    }
+    h->elements[i].priority = priority;
+    h->elements[i].num = num;
+}
+
+/* heap_pop: remove the element with the smallest priority
+ * 
+ * h: the heap
+ * priority: set to the priority of the removed element, may be NULL
+ * 
+ * Returns: the number removed from the heap
+ */ 
+int heap_pop(heap_t *h, double *priority)
+{
+    assert(h != NULL);
+    assert(h->size > 0); // heap is empty
+
+    helement_t top = h->elements[0];
+    helement_t last = h->elements[--h->size];
+
+    // sift down
+    int i = 0;
+    while(true){
+        int child = 2 * i + 1;
+        if(child >= h->size){
+            break;
+        }
+        if(child + 1 < h->size && 
+           h->elements[child + 1].priority < h->elements[child].priority){
+            child++;
+        }
+        if(last.priority <= h->elements[child].priority){
+            break;
+        }
+        h->elements[i] = h->elements[child];
+        i = child;
+    }
+    if(h->size > 0){
+        h->elements[i] = last;
+    }
+
+    if(priority){
+        *priority = top.priority;
+    }
+    return top.num;
+}
+
+/* heap_min_priority: the smallest priority in the heap
+ * 
+ * h: the heap, must not be empty
+ * 
+ * Returns: the priority of the element heap_pop would remove
+ */ 
+double heap_min_priority(heap_t *h)
+{
+    assert(h != NULL);
+    assert(h->size > 0);
+    return h->elements[0].priority;
+}
+
+/* heap_min_num: the number with the smallest priority in the heap
+ * 
+ * h: the heap, must not be empty
+ * 
+ * Returns: the number heap_pop would remove
+ */ 
+int heap_min_num(heap_t *h)
+{
+    assert(h != NULL);
+    assert(h->size > 0);
+    return h->elements[0].num;
+}
+
+/* heap_size: number of elements in the heap
+ * 
+ * h: the heap
+ * 
+ * Returns: the number of elements
+ */ 
+int heap_size(heap_t *h)
+{
+    assert(h != NULL);
+    return h->size;
+}
+
+/* heap_is_empty: determines whether or not the heap is empty
+ * 
+ * h: the heap
+ * 
+ * Returns: true if the heap is empty, false otherwise
+ */ 
+bool heap_is_empty(heap_t *h)
+{
+    assert(h != NULL);
+    return h->size == 0;
+}
+
+/* heap_clear: remove every element, keeping the allocation
+ * 
+ * h: the heap
+ */ 
+void heap_clear(heap_t *h)
+{
+    assert(h != NULL);
+    h->size = 0;
+}
+
+/* heap_bytes: memory held by a heap, its element array included
+ * 
+ * h: the heap
+ * 
+ * Returns: the number of bytes, without malloc headers
+ */ 
+size_t heap_bytes(heap_t *h)
+{
+    assert(h != NULL);
+    return sizeof(heap_t) + sizeof(helement_t) * h->capacity;
+}
+
+/* heap_free: free a heap
+ * 
+ * h: the heap
+ */ 
+void heap_free(heap_t *h)
+{
+    assert(h != NULL);
+    free(h->elements);
+    free(h);
+}
+
+/********* HUGE PAGES *********/
+
+/* huge_round: round a size up to whole huge pages
+ *
+ * Inputs:
+ * - bytes: the size (size_t)
+ *
+ * Output: the rounded size, at least one huge page (size_t)
+ */
+static size_t huge_round(size_t bytes)
+{
+    if(bytes == 0){
+        bytes = 1;
+    }
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+/* huge_alloc: allocate zeroed memory backed by huge pages where possible
+ *
+ * bytes: the size, rounded up to whole huge pages
+ * 
+ * Returns: a block aligned to HUGE_PAGE_SIZE, to be freed with huge_free
+ */ 
+void *huge_alloc(size_t bytes)
+{
+    size_t size = huge_round(bytes);
+#ifdef __linux__
+    // map one huge page more than needed and trim both ends, so the block
+    // starts on a huge page boundary the kernel can back with one entry
+    char *raw = (char*)mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(raw == MAP_FAILED){
+        fprintf(stderr, "huge_alloc: mmap failed\n");
+        exit(1);
+    }
+    char *block = (char*)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    if(block > raw){
+        munmap(raw, block - raw);
+    }
+    munmap(block + size, raw + HUGE_PAGE_SIZE - block);
+
+    // only a hint, with transparent huge pages off this keeps small pages
+    madvise(block, size, MADV_HUGEPAGE);
+    return block;
+#else
+    void *block = aligned_alloc(HUGE_PAGE_SIZE, size);
+    if(block == NULL){
+        fprintf(stderr, "huge_alloc: malloc failed\n");
+        exit(1);
+    }
+    memset(block, 0, size);
+    return block;
+#endif
+}
+
+/* huge_free: free memory from huge_alloc
+ * 
+ * ptr: the block, may be NULL
+ * bytes: the size it was allocated with
+ */ 
+void huge_free(void *ptr, size_t bytes)
+{
+    if(ptr == NULL){
+        return;
+    }
+#ifdef __linux__
+    munmap(ptr, huge_round(bytes));
+#else
+    (void)bytes;
+    free(ptr);
+#endif
+}
+
+/********* MEMORY ACCOUNTING *********/
+
+/* malloc_bytes: memory one malloc call takes from the heap, the size
+ *     asked for plus the header and rounding of a 64-bit glibc malloc.
+ *     Other allocators differ a little, so reports built on it are
+ *     estimates.
+ *
+ * bytes: the size asked for
+ * 
+ * Returns: the number of bytes
+ */ 
+size_t malloc_bytes(size_t bytes)
+{
+    // a size_t header, then rounded up to 16 bytes, 32 at the least
+    size_t chunk = (bytes + sizeof(size_t) + 15) & ~(size_t)15;
+    return chunk < 32 ? 32 : chunk;
+}
+
+/********* FILES *********/
+
+/* file_bytes_left: the number of bytes from the position of a file to its
+ *     end, so loaders can bound the sizes a header claims before they
+ *     allocate anything
+ *
+ * file: a file open for binary reading, left at the same position
+ * 
+ * Returns: the number of bytes, -1 if the file cannot seek
+ */ 
+long file_bytes_left(FILE *file)
+{
+    long pos = ftell(file);
+    if(pos < 0 || fseek(file, 0, SEEK_END) != 0){
+        return -1;
+    }
+    long end = ftell(file);
+    if(fseek(file, pos, SEEK_SET) != 0 || end < pos){
+        return -1;
+    }
+    return end - pos;
+}
@@ -0,0 +1,428 @@
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "a_star.h"
+#include "util.h"
+#include "compress.h"
+#include "csr.h"
+#include "compact.h"
+#include "parallel.h"
+#include "a_star_engine.h"
+
+/* Benchmark for the A* engines on jittered grid graphs.
+ *
+ * usage: bench_a_star [width] [queries]
+ *
+ * The graph has width x width nodes numbered row by row, with each grid
+ * edge present with probability 4/5. Every engine answers the same
+ * random queries and must agree on the cost.
+ *
+ * The CSR search runs once on malloc memory and once on huge pages, with
+ * data TLB misses counted by perf where the kernel allows it. Build with
+ * `make bench PREFETCH=0` to compare against a search without software
+ * prefetching, on a width past the last level cache.
+ */
+
+#define LIST_QUEUE_MAX_NODES (40000)
+
+/* next_rand: small deterministic generator
+ *
+ * state: generator state
+ * 
+ * Returns: a pseudo-random number in [0, 2^31)
+ */
+static unsigned int next_rand(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 1) & 0x7fffffff;
+}
+
+/* grid_graph_create: a width x height grid with jittered coordinates
+ *
+ * width: nodes per row
+ * height: nodes per column
+ * seed: random seed
+ * 
+ * Returns: the graph
+ */
+static graph_t *grid_graph_create(int width, int height, unsigned int seed)
+{
+    graph_t *graph = graph_create(width * height);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            double jx = (next_rand(&seed) % 1000) / 2500.0;
+            double jy = (next_rand(&seed) % 1000) / 2500.0;
+            node_create(graph, y * width + x, "grid", y + jy, x + jx);
+        }
+    }
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            if(x + 1 < width && next_rand(&seed) % 5 != 0) {
+                add_edge(graph, y * width + x, y * width + x + 1);
+            }
+            if(y + 1 < height && next_rand(&seed) % 5 != 0) {
+                add_edge(graph, y * width + x, (y + 1) * width + x);
+            }
+        }
+    }
+    return graph;
+}
+
+/* now: wall clock time
+ *
+ * Returns: seconds
+ */
+static double now()
+{
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* report: print one result line
+ *
+ * engine: engine name
+ * seconds: total time
+ * queries: number of queries
+ * bytes_per_edge: adjacency bytes per directed edge, 0 if not applicable
+ * mismatches: number of costs that differ from the reference
+ */
+static void report(char *engine, double seconds, int queries, 
+                   double bytes_per_edge, int mismatches)
+{
+    printf("%-28s %10.3f ms/query %8.2f bytes/edge %6d mismatches\n", 
+           engine, seconds * 1000 / queries, bytes_per_edge, mismatches);
+}
+
+/* tlb_counter_open: open a counter of data TLB load misses in this thread
+ *
+ * Returns: the counter, -1 if perf counters are not available
+ */
+static int tlb_counter_open()
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+/* tlb_counter_start: zero and start a counter
+ *
+ * fd: the counter, -1 to do nothing
+ */
+static void tlb_counter_start(int fd)
+{
+#ifdef __linux__
+    if(fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+/* tlb_counter_stop: stop a counter and read it
+ *
+ * fd: the counter
+ * 
+ * Returns: the misses since tlb_counter_start, -1 if not available
+ */
+static long long tlb_counter_stop(int fd)
+{
+    long long count = -1;
+#ifdef __linux__
+    if(fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if(read(fd, &count, sizeof(count)) != sizeof(count)) {
+            count = -1;
+        }
+    }
+#endif
+    return count;
+}
+
+/* anon_huge_kb: anonymous memory of this process on transparent huge pages
+ *
+ * Returns: the size in kB, -1 if the kernel does not say
+ */
+static long anon_huge_kb()
+{
+    FILE *file = fopen("/proc/self/smaps_rollup", "r");
+    if(file == NULL) {
+        return -1;
+    }
+    char line[256];
+    long kb = -1;
+    while(fgets(line, sizeof(line), file)) {
+        if(sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) {
+            break;
+        }
+    }
+    fclose(file);
+    return kb;
+}
+
+typedef struct {
+    csr_builder_t *builder;
+    long num_edges;
+    int *from;
+    int *to;
+} bench_edges_t;
+
+/* add_edges: add a block of the edges to a builder, run by every thread
+ *     of a pool
+ *
+ * tid: thread index, used as the builder buffer
+ * arg: the edges (bench_edges_t*)
+ */
+static void add_edges(int tid, void *arg)
+{
+    bench_edges_t *e = (bench_edges_t*)arg;
+    int threads = csr_builder_num_buffers(e->builder);
+    long lo = e->num_edges * tid / threads;
+    long hi = e->num_edges * (tid + 1) / threads;
+    for(long i = lo; i < hi; i++) {
+        csr_builder_add_edge(e->builder, tid, e->from[i], e->to[i]);
+    }
+}
+
+/* time_builder: build a CSR graph of the grid straight from its edges
+ *
+ * graph: the grid, to take the nodes and edges from
+ * num_threads: builder threads, 0 for one per core
+ * clean: also look for self-loops and duplicate edges, to time the check
+ */
+static void time_builder(graph_t *graph, int num_threads, bool clean)
+{
+    bench_edges_t e = {NULL, 0, NULL, NULL};
+    e.from = (int*)malloc(sizeof(int) * graph->num_edges);
+    e.to = (int*)malloc(sizeof(int) * graph->num_edges);
+    for(int u = 0; u < graph->num_nodes; u++) {
+        for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next) {
+            if(nb->num > u) {
+                e.from[e.num_edges] = u;
+                e.to[e.num_edges] = nb->num;
+                e.num_edges++;
+            }
+        }
+    }
+
+    double t = now();
+    e.builder = csr_builder_create(graph->num_nodes, num_threads);
+    num_threads = csr_builder_num_buffers(e.builder);
+    for(int u = 0; u < graph->num_nodes; u++) {
+        csr_builder_add_node(e.builder, u, graph->nodes[u]->latitude, graph->nodes[u]->longitude);
+    }
+    tpool_t *pool = tpool_create(num_threads);
+    tpool_run(pool, add_edges, &e);
+    tpool_free(pool);
+    graph_clean_t dropped = {0, 0};
+    csr_t *csr = csr_builder_finish(e.builder, CSR_ALLOC_DEFAULT, clean ? &dropped : NULL);
+    printf("csr_builder, %d threads%s: %.1f ms\n", num_threads, 
+           clean ? ", cleaning" : "", (now() - t) * 1000);
+
+    csr_free(csr);
+    free(e.from);
+    free(e.to);
+}
+
+int main(int argc, char **argv)
+{
+    int width = argc > 1 ? atoi(argv[1]) : 300;
+    int num_queries = argc > 2 ? atoi(argv[2]) : 50;
+
+    double t = now();
+    graph_t *graph = grid_graph_create(width, width, 1);
+    long num_edges = 2L * graph->num_edges;
+    printf("graph: %d nodes, %ld directed edges, built in %.1f ms\n", 
+           graph->num_nodes, num_edges, (now() - t) * 1000);
+    printf("a_star_csr prefetch distance: %d\n", CSR_PREFETCH_DISTANCE);
+
+    // the same CSR graph through a graph_t, and straight from the edges
+    t = now();
+    csr_t *built = csr_create(graph);
+    printf("csr_create: %.1f ms after the graph_t\n", (now() - t) * 1000);
+    csr_free(built);
+    time_builder(graph, 1, false);
+    time_builder(graph, 1, true);
+    if(num_cores() > 1) {
+        time_builder(graph, 0, false);
+        time_builder(graph, 0, true);
+    }
+
+    int *starts = (int*)malloc(sizeof(int) * num_queries);
+    int *ends = (int*)malloc(sizeof(int) * num_queries);
+    double *expected = (double*)malloc(sizeof(double) * num_queries);
+    unsigned int seed = 42;
+    for(int i = 0; i < num_queries; i++) {
+        starts[i] = next_rand(&seed) % graph->num_nodes;
+        ends[i] = next_rand(&seed) % graph->num_nodes;
+    }
+
+    // the reference: pooled search contexts with a binary heap
+    t = now();
+    for(int i = 0; i < num_queries; i++) {
+        expected[i] = a_star_masked(graph, starts[i], ends[i], NULL);
+    }
+    // intlist entries plus the per-node list head pointer
+    double list_bytes = (num_edges * sizeof(intlist_t) + 
+                         graph->num_nodes * sizeof(intlist_t*)) / (double)num_edges;
+    report("a_star_masked (heap)", now() - t, num_queries, list_bytes, 0);
+
+    if(graph->num_nodes <= LIST_QUEUE_MAX_NODES) {
+        int mismatches = 0;
+        t = now();
+        for(int i = 0; i < num_queries; i++) {
+            double cost = a_star(graph, starts[i], ends[i]);
+            mismatches += cost < expected[i] - 1e-9 || cost > expected[i] + 1e-9;
+        }
+        report("a_star (list queue)", now() - t, num_queries, list_bytes, mismatches);
+    }
+
+    // every edge stored once, iterated through out and in rows, first on
+    // malloc memory and then on huge pages
+    int tlb = tlb_counter_open();
+    csr_alloc_t allocs[] = {CSR_ALLOC_DEFAULT, CSR_ALLOC_HUGE_PAGES};
+    char *alloc_names[] = {"a_star_csr", "a_star_csr (huge pages)"};
+    for(int a = 0; a < 2; a++) {
+        long huge_kb = anon_huge_kb();
+        csr_t *csr = csr_create_alloc(graph, allocs[a]);
+        if(allocs[a] == CSR_ALLOC_HUGE_PAGES && huge_kb >= 0) {
+            printf("huge pages: %ld kB of the graph backed\n", anon_huge_kb() - huge_kb);
+        }
+        int mismatches = 0;
+        tlb_counter_start(tlb);
+        t = now();
+        for(int i = 0; i < num_queries; i++) {
+            double cost = a_star_csr(csr, starts[i], ends[i]);
+            mismatches += cost < expected[i] - 1e-9 || cost > expected[i] + 1e-9;
+        }
+        double seconds = now() - t;
+        long long misses = tlb_counter_stop(tlb);
+        report(alloc_names[a], seconds, num_queries, 
+               csr_adjacency_bytes(csr) / (double)num_edges, mismatches);
+        if(misses >= 0) {
+            printf("%-28s %10.0f dTLB load misses/query\n", "", misses / (double)num_queries);
+        }else {
+            printf("%-28s %10s dTLB load misses/query, no perf counters\n", "", "n/a");
+        }
+        csr_free(csr);
+    }
+#ifdef __linux__
+    if(tlb >= 0) {
+        close(tlb);
+    }
+#endif
+
+    // the C++ template instantiations
+    int mismatches = 0;
+    t = now();
+    for(int i = 0; i < num_queries; i++) {
+        double cost = a_star_engine(graph, starts[i], ends[i]);
+        mismatches += cost < expected[i] - 1e-9 || cost > expected[i] + 1e-9;
+    }
+    report("a_star_engine (list, double)", now() - t, num_queries, list_bytes, mismatches);
+
+    // the edges on each reference path, outside the timings, as integer
+    // costs round every edge up by at most one unit of 1 / scale
+    int *hops = (int*)malloc(sizeof(int) * num_queries);
+    for(int i = 0; i < num_queries; i++) {
+        search_ctx_t *ctx = search_begin(graph, starts[i], ends[i]);
+        while(search_step(ctx, 1 << 20) == SEARCH_IN_PROGRESS);
+        int path_len;
+        search_result(ctx, NULL, &path_len);
+        search_end(ctx);
+        hops[i] = path_len > 0 ? path_len - 1 : 0;
+    }
+
+    csr_engine_cost_t costs[] = {CSR_ENGINE_DOUBLE, CSR_ENGINE_FLOAT, CSR_ENGINE_INT};
+    char *cost_names[] = {"csr_engine (double)", "csr_engine (float)", "csr_engine (int, 1e4)"};
+    for(int c = 0; c < 3; c++) {
+        csr_engine_t *engine = csr_engine_create(graph, costs[c], 10000);
+        int mismatches = 0;
+        t = now();
+        for(int i = 0; i < num_queries; i++) {
+            double cost = csr_engine_query(engine, starts[i], ends[i]);
+            // float costs match to a relative 1e-4, integer ones to a
+            // unit per edge
+            double slack = costs[c] == CSR_ENGINE_FLOAT ? 1e-4 * expected[i] + 1e-9 :
+                           costs[c] == CSR_ENGINE_INT ? hops[i] / 10000.0 + 1e-9 : 1e-9;
+            mismatches += cost < expected[i] - slack || cost > expected[i] + slack;
+        }
+        report(cost_names[c], now() - t, num_queries, 
+               csr_engine_bytes(engine) / (double)num_edges, mismatches);
+        csr_engine_free(engine);
+    }
+
+    double quanta[] = {0, 0.001};
+    for(int q = 0; q < 2; q++) {
+        cgraph_t *cg = cgraph_create(graph, quanta[q]);
+        double bytes = cgraph_adjacency_bytes(cg) / (double)cgraph_num_edges(cg);
+        int mismatches = 0;
+        t = now();
+        for(int i = 0; i < num_queries; i++) {
+            double cost = a_star_compressed(cg, starts[i], ends[i]);
+            // quantized costs may overestimate by one quantum per edge
+            double slack = quanta[q] * graph->num_nodes + 1e-9;
+            mismatches += cost < expected[i] - 1e-9 || cost > expected[i] + slack;
+        }
+        report(quanta[q] ? "a_star_compressed (quantized)" : "a_star_compressed", 
+               now() - t, num_queries, bytes, mismatches);
+        cgraph_free(cg);
+    }
+
+    // fixed-point coordinates, costs differ from the reference by rounding
+    compact_t *compact = compact_create(graph);
+    mismatches = 0;
+    t = now();
+    for(int i = 0; i < num_queries; i++) {
+        double cost = a_star_compact(compact, starts[i], ends[i]);
+        double slack = 1e-6 * expected[i] + 1e-9;
+        mismatches += cost < expected[i] - slack || cost > expected[i] + slack;
+    }
+    graph_memory_t memory;
+    compact_memory_report(compact, &memory);
+    report("a_star_compact", now() - t, num_queries, 
+           memory.neighbors / (double)num_edges, mismatches);
+
+    // where the bytes of each representation go
+    char *memory_names[] = {"graph_t", "compact_t"};
+    graph_memory_report(graph, &memory);
+    for(int r = 0; r < 2; r++) {
+        if(r == 1) {
+            compact_memory_report(compact, &memory);
+        }
+        printf("%-10s %8.1f MB: table %.1f, nodes %.1f, neighbors %.1f, names %.1f, "
+               "search %.1f, malloc %.1f, %.1f bytes/node\n", memory_names[r], memory.total / 1e6, 
+               memory.table / 1e6, memory.nodes / 1e6, memory.neighbors / 1e6, memory.names / 1e6, 
+               memory.search / 1e6, memory.overhead / 1e6, memory.total / (double)graph->num_nodes);
+    }
+    compact_free(compact);
+
+    free(starts);
+    free(ends);
+    free(expected);
+    free(hops);
+    graph_free(graph);
+    return 0;
+}
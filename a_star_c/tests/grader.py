@@ -14,7 +14,30 @@ RUBRIC = [
           ("Create a node in a graph", "node_create", 5),
           ("Add an edge between nodes", "add_edge", 15),
           ("A* search cost", "a_star", 30),
-          ("A* search parent", "a_star_parent", 5)
+          ("A* search parent", "a_star_parent", 5),
+          ("A* search statistics", "a_star_traced", 5),
+          ("Hash-distributed parallel A*", "hda_star", 10),
+          ("Delta-stepping shortest paths", "delta_stepping", 10),
+          ("Reachability within a budget", "reachable_within", 5),
+          ("Nearest of several targets", "a_star_nearest", 5),
+          ("K shortest loopless paths", "k_shortest_paths", 10),
+          ("A* search with exclusion masks", "a_star_masked", 5),
+          ("A* search on a compressed graph", "a_star_compressed", 5),
+          ("A* search on a directed CSR graph", "a_star_csr", 5),
+          ("Hub label distance queries", "hub_labels", 10),
+          ("Customizable multilevel overlay", "crp", 10),
+          ("All-pairs distance matrix", "apsp", 5),
+          ("Cached route queries", "route_cache", 5),
+          ("Resumable search in slices", "search_step", 5),
+          ("Node lookup by city name", "graph_find_node", 5),
+          ("Specialized A* engines", "a_star_engine", 5),
+          ("CSR graphs on huge pages", "huge_pages", 5),
+          ("Time-dependent travel times", "time_dependent", 5),
+          ("Route query server", "route_server", 5),
+          ("Compact graphs and memory reports", "compact_graph", 5),
+          ("Parallel CSR builder", "csr_builder", 5),
+          ("Remove duplicate edges and self-loops", "graph_clean", 5),
+          ("Memory-bounded search", "sma_star", 5)
 
          ]
 
@@ -0,0 +1,176 @@
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "a_star.h"
+#include "csr.h"
+#include "route_server.h"
+
+/* Load generator for serve_a_star: every connection runs on its own
+ * thread and sends batches of random queries back to back, then the
+ * throughput and the latency percentiles of the batches are printed.
+ *
+ * usage: load_a_star socket [-c connections] [-b batch] [-n batches]
+ *
+ * Defaults are 4 connections sending 100 batches of 16 queries each.
+ */
+
+typedef struct {
+    char *path;
+    int batch;
+    int num_batches;
+    unsigned int seed;
+    double *latency;   // seconds per batch
+    bool failed;
+} connection_t;
+
+/* next_rand: small deterministic generator
+ *
+ * state: generator state
+ *
+ * Returns: a pseudo-random number in [0, 2^31)
+ */
+static unsigned int next_rand(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 1) & 0x7fffffff;
+}
+
+/* now: wall clock time
+ *
+ * Returns: seconds
+ */
+static double now()
+{
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* compare_doubles: qsort order for doubles
+ *
+ * a, b: the doubles
+ *
+ * Returns: negative, zero or positive as a is below, equal to or above b
+ */
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* run_connection: send the batches of one connection
+ *
+ * arg: the connection (connection_t*)
+ *
+ * Returns: NULL
+ */
+static void *run_connection(void *arg)
+{
+    connection_t *c = (connection_t*)arg;
+    route_client_t *client = route_client_connect(c->path);
+    int num_nodes = client ? route_client_num_nodes(client) : -1;
+    if(num_nodes <= 0) {
+        c->failed = true;
+        if(client) {
+            route_client_close(client);
+        }
+        return NULL;
+    }
+
+    int *starts = (int*)malloc(sizeof(int) * c->batch);
+    int *ends = (int*)malloc(sizeof(int) * c->batch);
+    double *costs = (double*)malloc(sizeof(double) * c->batch);
+    for(int b = 0; b < c->num_batches; b++) {
+        for(int i = 0; i < c->batch; i++) {
+            starts[i] = next_rand(&c->seed) % num_nodes;
+            ends[i] = next_rand(&c->seed) % num_nodes;
+        }
+        double t = now();
+        if(route_client_query(client, c->batch, starts, ends, costs) != 0) {
+            c->failed = true;
+            break;
+        }
+        c->latency[b] = now() - t;
+    }
+
+    free(starts);
+    free(ends);
+    free(costs);
+    route_client_close(client);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2 || argv[1][0] == '-') {
+        fprintf(stderr, "usage: %s socket [-c connections] [-b batch] [-n batches]\n", argv[0]);
+        return 2;
+    }
+    int num_connections = 4;
+    int batch = 16;
+    int num_batches = 100;
+
+    int opt;
+    optind = 2;
+    while((opt = getopt(argc, argv, "c:b:n:")) != -1) {
+        switch(opt) {
+            case 'c': num_connections = atoi(optarg); break;
+            case 'b': batch = atoi(optarg); break;
+            case 'n': num_batches = atoi(optarg); break;
+            default: return 2;
+        }
+    }
+    if(num_connections < 1 || batch < 1 || batch > ROUTE_MAX_BATCH || num_batches < 1) {
+        fprintf(stderr, "%s: need at least one connection and batch, at most %d queries a batch\n",
+                argv[0], ROUTE_MAX_BATCH);
+        return 2;
+    }
+
+    connection_t *conns = (connection_t*)calloc(num_connections, sizeof(connection_t));
+    pthread_t *threads = (pthread_t*)malloc(sizeof(pthread_t) * num_connections);
+    double *latency = (double*)malloc(sizeof(double) * num_connections * num_batches);
+    if(!conns || !threads || !latency) {
+        fprintf(stderr, "%s: malloc failed\n", argv[0]);
+        return 1;
+    }
+
+    double t = now();
+    for(int i = 0; i < num_connections; i++) {
+        conns[i].path = argv[1];
+        conns[i].batch = batch;
+        conns[i].num_batches = num_batches;
+        conns[i].seed = 42 + i;
+        conns[i].latency = latency + (long)i * num_batches;
+        pthread_create(&threads[i], NULL, run_connection, &conns[i]);
+    }
+    bool failed = false;
+    for(int i = 0; i < num_connections; i++) {
+        pthread_join(threads[i], NULL);
+        failed |= conns[i].failed;
+    }
+    double seconds = now() - t;
+    if(failed) {
+        fprintf(stderr, "%s: a connection to %s failed\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    long num_queries = (long)num_connections * num_batches * batch;
+    long n = (long)num_connections * num_batches;
+    qsort(latency, n, sizeof(double), compare_doubles);
+    printf("%d connections, %ld batches of %d queries in %.2f s\n",
+           num_connections, n, batch, seconds);
+    printf("throughput: %.0f queries/s\n", num_queries / seconds);
+    printf("batch latency: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n",
+           latency[n / 2] * 1000, latency[n * 90 / 100] * 1000, latency[n * 99 / 100] * 1000,
+           latency[n * 999 / 1000] * 1000, latency[n - 1] * 1000);
+
+    free(conns);
+    free(threads);
+    free(latency);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "a_star.h"
+#include "csr.h"
+#include "route_server.h"
+
+/* Route query daemon: loads a graph once and answers batches of queries
+ * on a Unix domain socket until interrupted, see route_server.h.
+ *
+ * usage: serve_a_star socket [-g graph_file | -w width] [-t threads] [-H]
+ *            [-o graph_file]
+ *
+ * -g loads a graph saved with csr_save, -w builds a width x width jittered
+ * grid like bench_a_star instead (300 by default). -t sets the number of
+ * threads, one per core by default. -H keeps the graph and the search
+ * state on huge pages. -o saves the graph, to load it with -g next time.
+ */
+
+static route_server_t *server;
+
+/* next_rand: small deterministic generator
+ *
+ * state: generator state
+ *
+ * Returns: a pseudo-random number in [0, 2^31)
+ */
+static unsigned int next_rand(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 1) & 0x7fffffff;
+}
+
+/* grid_graph_create: a width x height grid with jittered coordinates
+ *
+ * width: nodes per row
+ * height: nodes per column
+ * seed: random seed
+ *
+ * Returns: the graph
+ */
+static graph_t *grid_graph_create(int width, int height, unsigned int seed)
+{
+    graph_t *graph = graph_create(width * height);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            double jx = (next_rand(&seed) % 1000) / 2500.0;
+            double jy = (next_rand(&seed) % 1000) / 2500.0;
+            node_create(graph, y * width + x, "grid", y + jy, x + jx);
+        }
+    }
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            if(x + 1 < width && next_rand(&seed) % 5 != 0) {
+                add_edge(graph, y * width + x, y * width + x + 1);
+            }
+            if(y + 1 < height && next_rand(&seed) % 5 != 0) {
+                add_edge(graph, y * width + x, (y + 1) * width + x);
+            }
+        }
+    }
+    return graph;
+}
+
+/* on_signal: stop serving on SIGINT and SIGTERM
+ *
+ * sig: the signal
+ */
+static void on_signal(int sig)
+{
+    (void)sig;
+    route_server_stop(server);
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2 || argv[1][0] == '-') {
+        fprintf(stderr, "usage: %s socket [-g graph_file | -w width] [-t threads] [-H] [-o graph_file]\n", argv[0]);
+        return 2;
+    }
+    char *path = argv[1];
+    char *graph_file = NULL;
+    char *out_file = NULL;
+    int width = 300;
+    int num_threads = 0;
+    csr_alloc_t alloc = CSR_ALLOC_DEFAULT;
+
+    int opt;
+    optind = 2;
+    while((opt = getopt(argc, argv, "g:w:t:Ho:")) != -1) {
+        switch(opt) {
+            case 'g': graph_file = optarg; break;
+            case 'w': width = atoi(optarg); break;
+            case 't': num_threads = atoi(optarg); break;
+            case 'H': alloc = CSR_ALLOC_HUGE_PAGES; break;
+            case 'o': out_file = optarg; break;
+            default: return 2;
+        }
+    }
+
+    csr_t *csr;
+    if(graph_file) {
+        FILE *file = fopen(graph_file, "rb");
+        csr = file ? csr_load(file, alloc) : NULL;
+        if(file) {
+            fclose(file);
+        }
+        if(csr == NULL) {
+            fprintf(stderr, "%s: cannot load a graph from %s\n", argv[0], graph_file);
+            return 1;
+        }
+    }else {
+        graph_t *graph = grid_graph_create(width, width, 1);
+        csr = csr_create_alloc(graph, alloc);
+        graph_free(graph);
+    }
+    if(out_file) {
+        FILE *file = fopen(out_file, "wb");
+        if(file == NULL || csr_save(csr, file) != 0) {
+            fprintf(stderr, "%s: cannot save the graph to %s\n", argv[0], out_file);
+            return 1;
+        }
+        fclose(file);
+    }
+
+    server = route_server_create(csr, path, num_threads);
+    if(server == NULL) {
+        fprintf(stderr, "%s: cannot listen on %s\n", argv[0], path);
+        return 1;
+    }
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("serving %d nodes, %ld edges on %s\n", csr_num_nodes(csr), csr_num_edges(csr), path);
+    fflush(stdout);
+    int status = route_server_run(server);
+
+    route_server_free(server);
+    csr_free(csr);
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,719 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "a_star.h"
+#include "util.h"
+#include "hda_star.h"
+#include "delta_step.h"
+#include "compress.h"
+#include "csr.h"
+#include "hub_label.h"
+#include "crp.h"
+#include "apsp.h"
+#include "route_cache.h"
+#include "a_star_engine.h"
+#include "time_dep.h"
+#include "compact.h"
+#include "sma_star.h"
+
+/* Differential stress and scaling harness for every shortest path engine.
+ *
+ * usage: stress_a_star [-n nodes,...] [-q queries] [-t threads] [-s seed]
+ *            [-f family]
+ *
+ * For each graph family and size, a random graph is built and every
+ * engine answers the same random queries, which are checked against a
+ * plain Dijkstra written here. Engines that need preprocessing or memory
+ * that grows faster than the graph skip the sizes past their limit. One
+ * line per engine gives its preprocessing time, query time and the number
+ * of wrong costs. The exit status is 1 if any cost was wrong, so the
+ * harness can gate changes to the search code.
+ *
+ * Families:
+ *   grid      jittered grid, each grid edge present with probability 4/5
+ *   directed  like grid, but a fifth of the edges are one-way arcs
+ *   holes     like grid, with a tenth of the node numbers left unused
+ *   geometric random points, each linked to up to 3 points nearby, with
+ *             some long edges between far apart points
+ */
+
+#define MAX_SIZES (16)
+
+typedef enum {FAMILY_GRID, FAMILY_DIRECTED, FAMILY_HOLES, FAMILY_GEOMETRIC, NUM_FAMILIES} family_t;
+
+static char *family_names[] = {"grid", "directed", "holes", "geometric"};
+
+/********* GRAPHS *********/
+
+/* next_rand: small deterministic generator
+ *
+ * state: generator state
+ *
+ * Returns: a pseudo-random number in [0, 2^31)
+ */
+static unsigned int next_rand(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 1) & 0x7fffffff;
+}
+
+/* grid_family_create: a jittered grid of about num_nodes nodes
+ *
+ * family: FAMILY_GRID, FAMILY_DIRECTED or FAMILY_HOLES
+ * num_nodes: the size wanted
+ * seed: random seed
+ *
+ * Returns: the graph
+ */
+static graph_t *grid_family_create(family_t family, int num_nodes, unsigned int seed)
+{
+    int width = (int)ceil(sqrt(num_nodes));
+    graph_t *graph = graph_create(width * width);
+    for(int u = 0; u < width * width; u++) {
+        double jx = (next_rand(&seed) % 1000) / 2500.0;
+        double jy = (next_rand(&seed) % 1000) / 2500.0;
+        if(family == FAMILY_HOLES && next_rand(&seed) % 10 == 0) {
+            continue;
+        }
+        node_create(graph, u, "grid", u / width + jy, u % width + jx);
+    }
+    for(int u = 0; u < width * width; u++) {
+        for(int dir = 0; dir < 2; dir++) {
+            int v = dir ? u + width : u + 1;
+            bool inside = dir ? v < width * width : (u + 1) % width != 0;
+            if(!inside || next_rand(&seed) % 5 == 0 || !graph->nodes[u] || !graph->nodes[v]) {
+                continue;
+            }
+            int kind = family == FAMILY_DIRECTED ? next_rand(&seed) % 10 : 9;
+            switch(kind) {
+                case 0:  add_arc(graph, u, v); break;
+                case 1:  add_arc(graph, v, u); break;
+                default: add_edge(graph, u, v); break;
+            }
+        }
+    }
+    return graph;
+}
+
+/* geometric_create: random points in a square with one point per unit of
+ *     area, each linked to up to 3 points in its own or the next cells,
+ *     and one long edge per 100 nodes
+ *
+ * num_nodes: the number of nodes
+ * seed: random seed
+ *
+ * Returns: the graph
+ */
+static graph_t *geometric_create(int num_nodes, unsigned int seed)
+{
+    int side = (int)ceil(sqrt(num_nodes));
+    graph_t *graph = graph_create(num_nodes);
+
+    // bucket the points by unit cell, nodes of a cell are consecutive
+    int *cell_start = (int*)calloc(side * side + 1, sizeof(int));
+    int *cell_of = (int*)malloc(sizeof(int) * num_nodes);
+    double *x = (double*)malloc(sizeof(double) * num_nodes);
+    double *y = (double*)malloc(sizeof(double) * num_nodes);
+    if(!cell_start || !cell_of || !x || !y) {
+        fprintf(stderr, "geometric_create: malloc failed\n");
+        exit(1);
+    }
+    for(int i = 0; i < num_nodes; i++) {
+        x[i] = (next_rand(&seed) % 1000000) / 1000000.0 * side;
+        y[i] = (next_rand(&seed) % 1000000) / 1000000.0 * side;
+        cell_of[i] = (int)y[i] * side + (int)x[i];
+        cell_start[cell_of[i] + 1]++;
+    }
+    for(int c = 0; c < side * side; c++) {
+        cell_start[c + 1] += cell_start[c];
+    }
+    int *fill = (int*)malloc(sizeof(int) * side * side);
+    memcpy(fill, cell_start, sizeof(int) * side * side);
+    for(int i = 0; i < num_nodes; i++) {
+        int u = fill[cell_of[i]]++;
+        node_create(graph, u, "point", y[i], x[i]);
+    }
+
+    for(int u = 0; u < num_nodes; u++) {
+        int cx = (int)graph->nodes[u]->longitude;
+        int cy = (int)graph->nodes[u]->latitude;
+        for(int k = 0; k < 3; k++) {
+            int nx = cx + (int)(next_rand(&seed) % 2);
+            int ny = cy + (int)(next_rand(&seed) % 2);
+            if(nx >= side || ny >= side) {
+                continue;
+            }
+            int c = ny * side + nx;
+            int count = cell_start[c + 1] - cell_start[c];
+            if(count == 0) {
+                continue;
+            }
+            int v = cell_start[c] + next_rand(&seed) % count;
+            if(v != u) {
+                add_edge(graph, u, v);
+            }
+        }
+    }
+    for(int i = 0; i < num_nodes / 100; i++) {
+        add_edge(graph, next_rand(&seed) % num_nodes, next_rand(&seed) % num_nodes);
+    }
+
+    free(cell_start);
+    free(cell_of);
+    free(fill);
+    free(x);
+    free(y);
+    return graph;
+}
+
+/* family_create: a random graph of a family
+ *
+ * family: the family
+ * num_nodes: the size wanted
+ * seed: random seed
+ *
+ * Returns: the graph
+ */
+static graph_t *family_create(family_t family, int num_nodes, unsigned int seed)
+{
+    if(family == FAMILY_GEOMETRIC) {
+        return geometric_create(num_nodes, seed);
+    }
+    return grid_family_create(family, num_nodes, seed);
+}
+
+/********* REFERENCE *********/
+
+/* dijkstra: distance from one node to every node, on the neighbor lists
+ *     with straight-line edge costs, without sharing any search code
+ *
+ * graph: the graph
+ * start_node_num: the source
+ * dist: filled with the distance to every node, -1 if unreachable
+ * hops: filled with the number of edges on the shortest path found to
+ *     every node
+ */
+static void dijkstra(graph_t *graph, int start_node_num, double *dist, int *hops)
+{
+    for(int i = 0; i < graph->num_nodes; i++) {
+        dist[i] = -1;
+    }
+    heap_t *open = heap_create(1024);
+    dist[start_node_num] = 0;
+    hops[start_node_num] = 0;
+    heap_push(open, start_node_num, 0);
+    while(!heap_is_empty(open)) {
+        double d;
+        int u = heap_pop(open, &d);
+        if(d > dist[u]) {
+            continue;
+        }
+        node_t *node = graph->nodes[u];
+        for(intlist_t *nb = node->neighbors; nb; nb = nb->next) {
+            node_t *next = graph->nodes[nb->num];
+            double dx = node->longitude - next->longitude;
+            double dy = node->latitude - next->latitude;
+            double nd = d + sqrt(dx * dx + dy * dy);
+            if(dist[nb->num] < 0 || nd < dist[nb->num]) {
+                dist[nb->num] = nd;
+                hops[nb->num] = hops[u] + 1;
+                heap_push(open, nb->num, nd);
+            }
+        }
+    }
+    heap_free(open);
+}
+
+/********* ENGINES *********/
+
+typedef struct {
+    graph_t *graph;
+    int num_threads;
+    void *data;    // whatever the engine built in setup
+    double *dist;  // scratch for engines that answer from a whole tree
+} run_t;
+
+typedef struct {
+    char *name;
+    int max_nodes;      // larger graphs are skipped
+    double rel_tol;     // costs may differ by this much relative
+    double hop_tol;     // and by this much per edge of the reference path
+    void (*setup)(run_t *run);
+    double (*query)(run_t *run, int start, int end);
+    void (*teardown)(run_t *run);
+} engine_t;
+
+/* Engines, one setup, query and teardown per engine where needed:
+ *
+ * Inputs:
+ * - run: the graph and the engine state (run_t*)
+ * - start, end: the query (int)
+ *
+ * Output: the cost, -1 if there is no path (double)
+ */
+static double q_a_star(run_t *run, int start, int end)
+{
+    return a_star(run->graph, start, end);
+}
+
+static double q_masked(run_t *run, int start, int end)
+{
+    return a_star_masked(run->graph, start, end, NULL);
+}
+
+static double q_step(run_t *run, int start, int end)
+{
+    search_ctx_t *ctx = search_begin(run->graph, start, end);
+    while(search_step(ctx, 100) == SEARCH_IN_PROGRESS);
+    double cost = search_result(ctx, NULL, NULL);
+    search_end(ctx);
+    return cost;
+}
+
+static double q_nearest(run_t *run, int start, int end)
+{
+    return a_star_nearest(run->graph, start, &end, 1, NULL);
+}
+
+static double q_sma_star(run_t *run, int start, int end)
+{
+    // room for every node, so the cost is the shortest
+    return sma_star(run->graph, start, end, run->graph->num_nodes, 0, NULL, NULL, NULL);
+}
+
+static double q_hda(run_t *run, int start, int end)
+{
+    return hda_star(run->graph, start, end, run->num_threads);
+}
+
+static void s_delta(run_t *run)
+{
+    run->data = malloc(sizeof(int));
+    *(int*)run->data = -1;
+}
+
+static double q_delta(run_t *run, int start, int end)
+{
+    // the queries are sorted by start, so one tree serves several
+    int *source = (int*)run->data;
+    if(*source != start) {
+        delta_stepping(run->graph, start, 0, run->num_threads, run->dist, NULL);
+        *source = start;
+    }
+    return run->dist[end];
+}
+
+static void s_csr(run_t *run)
+{
+    run->data = csr_create(run->graph);
+}
+
+static void s_csr_huge(run_t *run)
+{
+    run->data = csr_create_alloc(run->graph, CSR_ALLOC_HUGE_PAGES);
+}
+
+static double q_csr(run_t *run, int start, int end)
+{
+    return a_star_csr((csr_t*)run->data, start, end);
+}
+
+static void s_csr_reverse(run_t *run)
+{
+    // the view shares the arrays of the graph, so both are kept
+    csr_t **pair = (csr_t**)malloc(sizeof(csr_t*) * 2);
+    pair[0] = csr_create(run->graph);
+    pair[1] = csr_reverse(pair[0]);
+    run->data = pair;
+}
+
+static double q_csr_reverse(run_t *run, int start, int end)
+{
+    return a_star_csr(((csr_t**)run->data)[1], end, start);
+}
+
+static void t_csr_reverse(run_t *run)
+{
+    csr_t **pair = (csr_t**)run->data;
+    csr_free(pair[1]);
+    csr_free(pair[0]);
+    free(pair);
+}
+
+static void t_csr(run_t *run)
+{
+    csr_free((csr_t*)run->data);
+}
+
+static void s_compressed(run_t *run)
+{
+    run->data = cgraph_create(run->graph, 0);
+}
+
+static double q_compressed(run_t *run, int start, int end)
+{
+    return a_star_compressed((cgraph_t*)run->data, start, end);
+}
+
+static void t_compressed(run_t *run)
+{
+    cgraph_free((cgraph_t*)run->data);
+}
+
+static double q_engine(run_t *run, int start, int end)
+{
+    return a_star_engine(run->graph, start, end);
+}
+
+static void s_compact(run_t *run)
+{
+    run->data = compact_create(run->graph);
+}
+
+static double q_compact(run_t *run, int start, int end)
+{
+    return a_star_compact((compact_t*)run->data, start, end);
+}
+
+static void t_compact(run_t *run)
+{
+    compact_free((compact_t*)run->data);
+}
+
+static void s_engine_double(run_t *run)
+{
+    run->data = csr_engine_create(run->graph, CSR_ENGINE_DOUBLE, 1);
+}
+
+static void s_engine_float(run_t *run)
+{
+    run->data = csr_engine_create(run->graph, CSR_ENGINE_FLOAT, 1);
+}
+
+static void s_engine_int(run_t *run)
+{
+    run->data = csr_engine_create(run->graph, CSR_ENGINE_INT, 10000);
+}
+
+static double q_csr_engine(run_t *run, int start, int end)
+{
+    return csr_engine_query((csr_engine_t*)run->data, start, end);
+}
+
+static void t_csr_engine(run_t *run)
+{
+    csr_engine_free((csr_engine_t*)run->data);
+}
+
+static void s_hub_labels(run_t *run)
+{
+    run->data = hub_labels_create(run->graph, run->num_threads);
+}
+
+static double q_hub_labels(run_t *run, int start, int end)
+{
+    return hub_labels_query((hub_labels_t*)run->data, start, end);
+}
+
+static void t_hub_labels(run_t *run)
+{
+    hub_labels_free((hub_labels_t*)run->data);
+}
+
+static void s_crp(run_t *run)
+{
+    run->data = crp_create(run->graph, 64, run->num_threads);
+}
+
+static double q_crp(run_t *run, int start, int end)
+{
+    return crp_query((crp_t*)run->data, start, end);
+}
+
+static void t_crp(run_t *run)
+{
+    crp_free((crp_t*)run->data);
+}
+
+static void s_apsp(run_t *run)
+{
+    run->data = apsp_create(run->graph, run->num_threads);
+}
+
+static double q_apsp(run_t *run, int start, int end)
+{
+    return apsp_query((apsp_t*)run->data, start, end);
+}
+
+static void t_apsp(run_t *run)
+{
+    apsp_free((apsp_t*)run->data);
+}
+
+static void s_route_cache(run_t *run)
+{
+    run->data = route_cache_create(run->graph, 1024);
+}
+
+static double q_route_cache(run_t *run, int start, int end)
+{
+    // the second lookup is a hit, and must agree with the search
+    route_cache_t *cache = (route_cache_t*)run->data;
+    double cost = route_cache_a_star(cache, start, end, NULL, NULL, NULL);
+    double again = route_cache_a_star(cache, start, end, NULL, NULL, NULL);
+    return cost == again ? cost : NAN;
+}
+
+static void t_route_cache(run_t *run)
+{
+    route_cache_free((route_cache_t*)run->data);
+}
+
+static void s_time_dep(run_t *run)
+{
+    run->data = td_graph_create(run->graph, 86400);
+}
+
+static double q_time_dep(run_t *run, int start, int end)
+{
+    // without profiles an edge takes its length at any time
+    double arrival = td_a_star((td_graph_t*)run->data, start, end, 3600);
+    return arrival < 0 ? -1 : arrival - 3600;
+}
+
+static void t_time_dep(run_t *run)
+{
+    td_graph_free((td_graph_t*)run->data);
+}
+
+static void t_free(run_t *run)
+{
+    free(run->data);
+}
+
+static engine_t engines[] = {
+    {"a_star (list queue)",      40000,    0,        0,        NULL,             q_a_star,      NULL},
+    {"a_star_masked",            1 << 30,  0,        0,        NULL,             q_masked,      NULL},
+    {"search_step",              1 << 30,  0,        0,        NULL,             q_step,        NULL},
+    {"a_star_nearest",           1 << 30,  0,        0,        NULL,             q_nearest,     NULL},
+    {"sma_star",                 1 << 30,  0,        0,        NULL,             q_sma_star,    NULL},
+    {"hda_star",                 1 << 30,  0,        0,        NULL,             q_hda,         NULL},
+    {"delta_stepping",           1 << 30,  0,        0,        s_delta,          q_delta,       t_free},
+    {"a_star_csr",               1 << 30,  0,        0,        s_csr,            q_csr,         t_csr},
+    {"a_star_csr (reversed)",    1 << 30,  0,        0,        s_csr_reverse,    q_csr_reverse, t_csr_reverse},
+    {"a_star_csr (huge pages)",  1 << 30,  0,        0,        s_csr_huge,       q_csr,         t_csr},
+    {"a_star_compressed",        1 << 30,  0,        0,        s_compressed,     q_compressed,  t_compressed},
+    {"a_star_compact",           1 << 30,  1e-6,     0,        s_compact,        q_compact,     t_compact},
+    {"a_star_engine",            1 << 30,  0,        0,        NULL,             q_engine,      NULL},
+    {"csr_engine (double)",      1 << 30,  0,        0,        s_engine_double,  q_csr_engine,  t_csr_engine},
+    {"csr_engine (float)",       1 << 30,  1e-4,     0,        s_engine_float,   q_csr_engine,  t_csr_engine},
+    {"csr_engine (int 1e4)",     1 << 30,  0,        1e-4,     s_engine_int,     q_csr_engine,  t_csr_engine},
+    {"route_cache",              1 << 30,  0,        0,        s_route_cache,    q_route_cache, t_route_cache},
+    {"td_a_star (no profiles)",  1 << 30,  0,        0,        s_time_dep,       q_time_dep,    t_time_dep},
+    {"crp",                      1 << 30,  0,        0,        s_crp,            q_crp,         t_crp},
+    {"hub_labels",               20000,    0,        0,        s_hub_labels,     q_hub_labels,  t_hub_labels},
+    {"apsp",                     2500,     0,        0,        s_apsp,           q_apsp,        t_apsp},
+};
+
+#define NUM_ENGINES ((int)(sizeof(engines) / sizeof(engines[0])))
+
+/********* HARNESS *********/
+
+/* now: wall clock time
+ *
+ * Returns: seconds
+ */
+static double now()
+{
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* cost_matches: compare a cost with the reference
+ *
+ * cost: the cost from an engine
+ * expected: the reference, -1 if there is no path
+ * hops: the number of edges on the reference path
+ * engine: the engine, for its tolerances
+ *
+ * Returns: true if they agree
+ */
+static bool cost_matches(double cost, double expected, int hops, engine_t *engine)
+{
+    if(expected < 0 || cost < 0) {
+        return cost == expected;
+    }
+    return fabs(cost - expected) <= 1e-6 + engine->rel_tol * expected + engine->hop_tol * hops;
+}
+
+/* compare_queries: qsort order for (start, end) pairs, by start
+ *
+ * a, b: the pairs
+ *
+ * Returns: negative, zero or positive
+ */
+static int compare_queries(const void *a, const void *b)
+{
+    const int *x = (const int*)a, *y = (const int*)b;
+    return x[0] != y[0] ? (x[0] > y[0]) - (x[0] < y[0]) : (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+/* stress: run every engine on one graph
+ *
+ * family: the graph family
+ * num_nodes: the size
+ * num_queries: number of random queries
+ * num_threads: threads for the parallel engines
+ * seed: random seed
+ *
+ * Returns: the number of wrong costs over all engines
+ */
+static long stress(family_t family, int num_nodes, int num_queries, int num_threads,
+                   unsigned int seed)
+{
+    double t = now();
+    graph_t *graph = family_create(family, num_nodes, seed);
+    printf("\n%s, %d nodes, %d edges, built in %.1f ms\n", family_names[family],
+           graph->num_nodes, graph->num_edges, (now() - t) * 1000);
+
+    // queries between existing nodes, a few sources share several queries
+    // so the tree engines can be checked too
+    int *queries = (int*)malloc(sizeof(int) * 2 * num_queries);
+    double *expected = (double*)malloc(sizeof(double) * num_queries);
+    int *expected_hops = (int*)malloc(sizeof(int) * num_queries);
+    double *dist = (double*)malloc(sizeof(double) * graph->num_nodes);
+    int *hops = (int*)malloc(sizeof(int) * graph->num_nodes);
+    if(!queries || !expected || !expected_hops || !dist || !hops) {
+        fprintf(stderr, "stress: malloc failed\n");
+        exit(1);
+    }
+    for(int i = 0; i < num_queries; i++) {
+        for(int k = 0; k < 2; k++) {
+            int u;
+            do {
+                u = next_rand(&seed) % graph->num_nodes;
+            } while(!graph->nodes[u]);
+            queries[2 * i + k] = k == 0 && i % 4 != 0 ? queries[2 * (i - i % 4)] : u;
+        }
+    }
+    qsort(queries, num_queries, 2 * sizeof(int), compare_queries);
+
+    t = now();
+    for(int i = 0; i < num_queries; i++) {
+        if(i == 0 || queries[2 * i] != queries[2 * i - 2]) {
+            dijkstra(graph, queries[2 * i], dist, hops);
+        }
+        expected[i] = dist[queries[2 * i + 1]];
+        expected_hops[i] = hops[queries[2 * i + 1]];
+    }
+    printf("  %-26s %10s %12.3f ms/query\n", "reference dijkstra", "", (now() - t) * 1000 / num_queries);
+
+    long wrong = 0;
+    for(int e = 0; e < NUM_ENGINES; e++) {
+        engine_t *engine = &engines[e];
+        if(graph->num_nodes > engine->max_nodes) {
+            printf("  %-26s skipped past %d nodes\n", engine->name, engine->max_nodes);
+            continue;
+        }
+        run_t run = {graph, num_threads, NULL, dist};
+        t = now();
+        if(engine->setup) {
+            engine->setup(&run);
+        }
+        double setup = now() - t;
+
+        int mismatches = 0;
+        int first = -1;
+        t = now();
+        for(int i = 0; i < num_queries; i++) {
+            double cost = engine->query(&run, queries[2 * i], queries[2 * i + 1]);
+            if(!cost_matches(cost, expected[i], expected_hops[i], engine)) {
+                mismatches++;
+                first = first < 0 ? i : first;
+            }
+        }
+        double seconds = now() - t;
+        if(engine->teardown) {
+            engine->teardown(&run);
+        }
+
+        printf("  %-26s %7.1f ms %12.3f ms/query %6d wrong\n", engine->name,
+               setup * 1000, seconds * 1000 / num_queries, mismatches);
+        if(first >= 0) {
+            printf("    first wrong: %d -> %d, expected %f\n", queries[2 * first],
+                   queries[2 * first + 1], expected[first]);
+        }
+        wrong += mismatches;
+    }
+
+    free(queries);
+    free(expected);
+    free(expected_hops);
+    free(dist);
+    free(hops);
+    graph_free(graph);
+    return wrong;
+}
+
+int main(int argc, char **argv)
+{
+    int sizes[MAX_SIZES] = {1000, 10000, 100000};
+    int num_sizes = 3;
+    int num_queries = 40;
+    int num_threads = 0;
+    unsigned int seed = 1;
+    int only_family = -1;
+
+    for(int i = 1; i < argc; i++) {
+        char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if(strcmp(argv[i], "-n") == 0 && value) {
+            num_sizes = 0;
+            for(char *tok = strtok(value, ","); tok && num_sizes < MAX_SIZES; tok = strtok(NULL, ",")) {
+                sizes[num_sizes++] = atoi(tok);
+            }
+        }else if(strcmp(argv[i], "-q") == 0 && value) {
+            num_queries = atoi(value);
+        }else if(strcmp(argv[i], "-t") == 0 && value) {
+            num_threads = atoi(value);
+        }else if(strcmp(argv[i], "-s") == 0 && value) {
+            seed = (unsigned int)atoi(value);
+        }else if(strcmp(argv[i], "-f") == 0 && value) {
+            for(int f = 0; f < NUM_FAMILIES; f++) {
+                if(strcmp(value, family_names[f]) == 0) {
+                    only_family = f;
+                }
+            }
+            if(only_family < 0) {
+                fprintf(stderr, "%s: unknown family %s\n", argv[0], value);
+                return 2;
+            }
+        }else {
+            fprintf(stderr, "usage: %s [-n nodes,...] [-q queries] [-t threads] [-s seed] [-f family]\n", argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if(num_queries < 1) {
+        fprintf(stderr, "%s: need at least one query\n", argv[0]);
+        return 2;
+    }
+
+    long wrong = 0;
+    for(int f = 0; f < NUM_FAMILIES; f++) {
+        if(only_family >= 0 && f != only_family) {
+            continue;
+        }
+        for(int s = 0; s < num_sizes; s++) {
+            wrong += stress((family_t)f, sizes[s], num_queries, num_threads, seed + s);
+        }
+    }
+
+    printf("\n%ld wrong costs\n", wrong);
+    return wrong == 0 ? 0 : 1;
+}
@@ -1,10 +1,32 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <criterion/criterion.h>
 
 #include "a_star.h"
 #include "util.h"
+#include "hda_star.h"
+#include "delta_step.h"
+#include "ksp.h"
+#include "compress.h"
+#include "csr.h"
+#include "hub_label.h"
+#include "crp.h"
+#include "apsp.h"
+#include "route_cache.h"
+#include "a_star_engine.h"
+#include "time_dep.h"
+#include "parallel.h"
+#include "route_server.h"
+#include "compact.h"
+#include "sma_star.h"
 
 #define EPSILON (0.000001)
 #define ERR_MSG_LEN (1000)
@@ -615,4 +637,3441 @@ Test(a_star_parent, testD)
     helper_a_star_parent(graph, 0, 3, 2, test, "a_star_parent/testD");
 
     graph_free(graph);
-}
\ No newline at end of file
+}
+
+/* count_expand: a_star_expand_fn counting expanded nodes
+ *
+ * node: the expanded node
+ * data: pointer to the counter (int*)
+ */
+void count_expand(node_t *node, void *data)
+{
+    (void)node;
+    (*(int*)data)++;
+}
+
+/* helper_a_star_traced
+ *
+ * graph: the graph
+ * start_node: start node
+ * end_node: send node
+ * expected: expected output
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_a_star_traced(graph_t *graph, int start_node, int end_node, double expected, char *test_string, char *test_name)
+{
+    a_star_stats_t stats;
+    int expanded = 0;
+    double actual = a_star_traced(graph, start_node, end_node, &stats, count_expand, &expanded);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> a_star_traced(g, %d, %d, &stats, count_expand, &n);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, end_node, test_name);
+
+    cr_assert_float_eq(actual, expected, 0.01, " %s\n      Actual: %.1f\n      Expected: %.1f ", err_msg, actual, expected);
+
+#ifdef A_STAR_STATS
+    cr_assert_eq(stats.nodes_expanded, expanded, " %s\n      Actual nodes_expanded: %ld\n      Expected nodes_expanded: %d ", err_msg, stats.nodes_expanded, expanded);
+    cr_assert(stats.pushes >= stats.nodes_expanded, " %s\n      pushes (%ld) < nodes_expanded (%ld)", err_msg, stats.pushes, stats.nodes_expanded);
+    cr_assert(stats.heuristic_evals >= stats.pushes, " %s\n      heuristic_evals (%ld) < pushes (%ld)", err_msg, stats.heuristic_evals, stats.pushes);
+    cr_assert(stats.max_open_size >= 1, " %s\n      max_open_size: %ld", err_msg, stats.max_open_size);
+    cr_assert(stats.wall_time >= 0, " %s\n      wall_time: %f", err_msg, stats.wall_time);
+#else
+    cr_assert_eq(expanded, 0, " %s\n      expand called without A_STAR_STATS", err_msg);
+    cr_assert_eq(stats.nodes_expanded, 0, " %s\n      stats filled without A_STAR_STATS", err_msg);
+#endif
+}
+
+TestSuite(a_star_traced, .timeout=60);
+
+Test(a_star_traced, testA) 
+{   
+    graph_t *graph = graph_create(3);
+    node_create(graph, 0, "A", 1, 0);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 0, 1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 2);
+
+    char *test = "      graph_t *g = graph_create(3);\n"
+                 "      node_create(g, 0, 'A', 1, 0);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 0, 1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 1, 2);";
+    helper_a_star_traced(graph, 0, 2, 2, test, "a_star_traced/testA");
+
+    graph_free(graph);
+}
+
+Test(a_star_traced, testB) 
+{   
+    graph_t *graph = graph_create(8);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 1, 0);
+    node_create(graph, 2, "C", 2, 0);
+    node_create(graph, 3, "D", 3, 0);
+    node_create(graph, 4, "E", 1, 1);
+    node_create(graph, 5, "F", 2, 1);
+    node_create(graph, 6, "G", 3, 1);
+    node_create(graph, 7, "H", 3, 2);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 4);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 1, 4);
+    add_edge(graph, 2, 3);
+    add_edge(graph, 2, 4);
+    add_edge(graph, 2, 5);
+    add_edge(graph, 4, 5);
+    add_edge(graph, 3, 6);
+    add_edge(graph, 6, 7);
+
+    char *test = "      graph_t *g = graph_create(8);\n"
+                 "      node_create(g, 0, 'A', 0, 0);\n"
+                 "      node_create(g, 1, 'B', 1, 0);\n"
+                 "      node_create(g, 2, 'C', 2, 0);\n"
+                 "      node_create(g, 3, 'D', 3, 0);\n"
+                 "      node_create(g, 4, 'E', 1, 1);\n"
+                 "      node_create(g, 5, 'F', 2, 1);\n"
+                 "      node_create(g, 6, 'G', 3, 1);\n"
+                 "      node_create(g, 7, 'H', 3, 2);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 4);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 1, 4);\n"
+                 "      add_edge(g, 2, 3);\n"
+                 "      add_edge(g, 2, 4);\n"
+                 "      add_edge(g, 4, 5);\n"
+                 "      add_edge(g, 3, 6);\n"
+                 "      add_edge(g, 6, 7);";
+    helper_a_star_traced(graph, 0, 7, 5, test, "a_star_traced/testB");
+
+    graph_free(graph);
+}
+
+
+/* next_rand: small deterministic generator so test graphs are 
+ *     identical on every platform
+ *
+ * state: generator state
+ * 
+ * Returns: a pseudo-random number in [0, 2^31)
+ */
+unsigned int next_rand(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 1) & 0x7fffffff;
+}
+
+/* grid_graph_create: a width x height grid with jittered coordinates,
+ *     each grid edge present with probability 4/5
+ *
+ * width: nodes per row
+ * height: nodes per column
+ * seed: random seed
+ * 
+ * Returns: the graph, nodes numbered row by row
+ */
+graph_t *grid_graph_create(int width, int height, unsigned int seed)
+{
+    graph_t *graph = graph_create(width * height);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            double jx = (next_rand(&seed) % 1000) / 2500.0;
+            double jy = (next_rand(&seed) % 1000) / 2500.0;
+            node_create(graph, y * width + x, "grid", y + jy, x + jx);
+        }
+    }
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            if(x + 1 < width && next_rand(&seed) % 5 != 0) {
+                add_edge(graph, y * width + x, y * width + x + 1);
+            }
+            if(y + 1 < height && next_rand(&seed) % 5 != 0) {
+                add_edge(graph, y * width + x, (y + 1) * width + x);
+            }
+        }
+    }
+    return graph;
+}
+
+/* directed_graph_create: like grid_graph_create, but a fifth of the grid
+ *     edges are one-way arcs in either direction
+ *
+ * width: nodes per row
+ * height: nodes per column
+ * seed: random seed
+ * 
+ * Returns: the graph, nodes numbered row by row
+ */
+graph_t *directed_graph_create(int width, int height, unsigned int seed)
+{
+    graph_t *graph = graph_create(width * height);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            double jx = (next_rand(&seed) % 1000) / 2500.0;
+            double jy = (next_rand(&seed) % 1000) / 2500.0;
+            node_create(graph, y * width + x, "grid", y + jy, x + jx);
+        }
+    }
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            int u = y * width + x;
+            for(int dir = 0; dir < 2; dir++) {
+                int v = dir ? u + width : u + 1;
+                if((dir ? y + 1 >= height : x + 1 >= width) || next_rand(&seed) % 5 == 0) {
+                    continue;
+                }
+                switch(next_rand(&seed) % 10) {
+                    case 0:  add_arc(graph, u, v); break;
+                    case 1:  add_arc(graph, v, u); break;
+                    default: add_edge(graph, u, v); break;
+                }
+            }
+        }
+    }
+    return graph;
+}
+
+/* helper_hda_star
+ *
+ * graph: the graph
+ * start_node: start node
+ * end_node: send node
+ * num_threads: number of worker threads
+ * expected: expected output
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_hda_star(graph_t *graph, int start_node, int end_node, int num_threads, double expected, char *test_string, char *test_name)
+{
+    double actual = hda_star(graph, start_node, end_node, num_threads);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> hda_star(g, %d, %d, %d);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, end_node, num_threads, test_name);
+
+    cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+}
+
+TestSuite(hda_star, .timeout=60);
+
+Test(hda_star, testA) 
+{   
+    graph_t *graph = graph_create(4);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(4);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);";
+    helper_hda_star(graph, 0, 3, 4, 2.414213, test, "hda_star/testA");
+    cr_assert_eq(graph->nodes[3]->parent->node_num, 2, "\n      Actual parent: %d\n      Expected parent: 2 ", graph->nodes[3]->parent->node_num);
+
+    graph_free(graph);
+}
+
+Test(hda_star, testB) 
+{   
+    graph_t *graph = graph_create(3);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 0, 1);
+    node_create(graph, 2, "C", 0, 2);
+    add_edge(graph, 0, 1);
+
+    char *test = "      graph_t *g = graph_create(3);\n"
+                 "      node_create(g, 0, 'A', 0, 0);\n"
+                 "      node_create(g, 1, 'B', 0, 1);\n"
+                 "      node_create(g, 2, 'C', 0, 2);\n"
+                 "      add_edge(g, 0, 1);";
+    helper_hda_star(graph, 0, 2, 3, -1, test, "hda_star/testB");
+
+    graph_free(graph);
+}
+
+Test(hda_star, testC) 
+{   
+    graph_t *graph = grid_graph_create(30, 30, 7);
+    char *test = "      graph_t *g = grid_graph_create(30, 30, 7);";
+    int queries[][2] = {{0, 899}, {29, 870}, {450, 15}, {5, 5}};
+
+    for(int i = 0; i < 4; i++) {
+        double expected = a_star(graph, queries[i][0], queries[i][1]);
+        for(int threads = 1; threads <= 4; threads++) {
+            helper_hda_star(graph, queries[i][0], queries[i][1], threads, expected, test, "hda_star/testC");
+        }
+    }
+
+    graph_free(graph);
+}
+
+/* helper_delta_stepping: checks every distance against a_star() and
+ *     that every parent lies on a shortest path back to the source
+ *
+ * graph: the graph
+ * source: source node
+ * delta: bucket width
+ * num_threads: number of worker threads
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_delta_stepping(graph_t *graph, int source, double delta, int num_threads, char *test_string, char *test_name)
+{
+    int n = graph->num_nodes;
+    double *dist = (double*)malloc(sizeof(double) * n);
+    int *parent = (int*)malloc(sizeof(int) * n);
+    delta_stepping(graph, source, delta, num_threads, dist, parent);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> delta_stepping(g, %d, %.1f, %d, dist, parent);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, source, delta, num_threads, test_name);
+
+    for(int v = 0; v < n; v++) {
+        if(graph->nodes[v] == NULL) {
+            continue;
+        }
+        double expected = a_star(graph, source, v);
+        cr_assert_float_eq(dist[v], expected, 0.000001, " %s\n      Actual dist[%d]: %f\n      Expected dist[%d]: %f ", err_msg, v, dist[v], v, expected);
+
+        if(v == source || dist[v] < 0) {
+            cr_assert_eq(parent[v], -1, " %s\n      Actual parent[%d]: %d\n      Expected parent[%d]: -1 ", err_msg, v, parent[v], v);
+        } else {
+            int p = parent[v];
+            cr_assert(p >= 0, " %s\n      parent[%d] not set", err_msg, v);
+            bool arc = false;
+            for(intlist_t *nb = graph->nodes[p]->neighbors; nb; nb = nb->next) {
+                arc = arc || nb->num == v;
+            }
+            cr_assert(arc, " %s\n      parent[%d] = %d has no edge to %d", err_msg, v, p, v);
+            cr_assert_float_eq(dist[p] + h_calc(graph->nodes[p], graph->nodes[v]), dist[v], 0.000001, " %s\n      parent[%d] = %d is not on a shortest path", err_msg, v, p);
+
+            int steps = 0;
+            for(int u = v; u != source && steps <= n; u = parent[u]) {
+                steps++;
+            }
+            cr_assert(steps <= n, " %s\n      the parents from %d do not lead back to the source", err_msg, v);
+        }
+    }
+
+    free(dist);
+    free(parent);
+}
+
+TestSuite(delta_stepping, .timeout=60);
+
+Test(delta_stepping, testA) 
+{   
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);";
+    helper_delta_stepping(graph, 0, 1.2, 2, test, "delta_stepping/testA");
+
+    graph_free(graph);
+}
+
+Test(delta_stepping, testB) 
+{   
+    graph_t *graph = grid_graph_create(20, 20, 11);
+    char *test = "      graph_t *g = grid_graph_create(20, 20, 11);";
+
+    helper_delta_stepping(graph, 0, 0, 4, test, "delta_stepping/testB");
+    helper_delta_stepping(graph, 210, 0.5, 3, test, "delta_stepping/testB");
+    helper_delta_stepping(graph, 399, 4, 1, test, "delta_stepping/testB");
+
+    graph_free(graph);
+}
+
+Test(delta_stepping, testC) 
+{   
+    graph_t *graph = directed_graph_create(20, 20, 13);
+    char *test = "      graph_t *g = directed_graph_create(20, 20, 13);";
+
+    helper_delta_stepping(graph, 0, 0, 4, test, "delta_stepping/testC");
+    helper_delta_stepping(graph, 210, 0.5, 2, test, "delta_stepping/testC");
+
+    graph_free(graph);
+}
+
+Test(delta_stepping, testD) 
+{   
+    // nodes 0 and 1 at the same place, each at the same distance as the
+    // other over the zero-length edge between them
+    graph_t *graph = graph_create(4);
+    node_create(graph, 0, "U", 0, 2);
+    node_create(graph, 1, "V", 0, 2);
+    node_create(graph, 2, "A", 0, 1);
+    node_create(graph, 3, "S", 0, 0);
+    add_edge(graph, 3, 2);
+    add_edge(graph, 2, 0);
+    add_edge(graph, 2, 1);
+    add_edge(graph, 0, 1);
+
+    char *test = "      graph_t *g = graph_create(4);\n"
+                 "      node_create(g, 0, 'U', 0, 2);\n"
+                 "      node_create(g, 1, 'V', 0, 2);\n"
+                 "      node_create(g, 2, 'A', 0, 1);\n"
+                 "      node_create(g, 3, 'S', 0, 0);\n"
+                 "      add_edge(g, 3, 2);\n"
+                 "      add_edge(g, 2, 0);\n"
+                 "      add_edge(g, 2, 1);\n"
+                 "      add_edge(g, 0, 1);";
+    helper_delta_stepping(graph, 3, 0, 1, test, "delta_stepping/testD");
+    helper_delta_stepping(graph, 3, 0, 2, test, "delta_stepping/testD");
+    graph_free(graph);
+
+    // node 0 is only reached over the zero-length edges from 1, and
+    // node 2 only over those from 0
+    graph = graph_create(4);
+    node_create(graph, 0, "U", 0, 2);
+    node_create(graph, 1, "V", 0, 2);
+    node_create(graph, 2, "W", 0, 2);
+    node_create(graph, 3, "S", 0, 0);
+    add_edge(graph, 3, 1);
+    add_arc(graph, 1, 0);
+    add_arc(graph, 0, 2);
+    add_arc(graph, 2, 1);
+
+    test = "      graph_t *g = graph_create(4);\n"
+           "      node_create(g, 0, 'U', 0, 2);\n"
+           "      node_create(g, 1, 'V', 0, 2);\n"
+           "      node_create(g, 2, 'W', 0, 2);\n"
+           "      node_create(g, 3, 'S', 0, 0);\n"
+           "      add_edge(g, 3, 1);\n"
+           "      add_arc(g, 1, 0);\n"
+           "      add_arc(g, 0, 2);\n"
+           "      add_arc(g, 2, 1);";
+    helper_delta_stepping(graph, 3, 0, 2, test, "delta_stepping/testD");
+    graph_free(graph);
+}
+
+/* helper_reachable_within: checks the nodes found against a_star()
+ *
+ * graph: the graph
+ * start_node: start node
+ * budget: cost budget
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_reachable_within(graph_t *graph, int start_node, double budget, char *test_string, char *test_name)
+{
+    int n = graph->num_nodes;
+    int *out = (int*)malloc(sizeof(int) * n);
+    size_t found = n;
+    reachable_within(graph, start_node, budget, out, &found);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> reachable_within(g, %d, %.2f, out, &n);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, budget, test_name);
+
+    bool *in_out = (bool*)calloc(n, sizeof(bool));
+    double prev = 0;
+    for(size_t i = 0; i < found; i++) {
+        double cost = a_star(graph, start_node, out[i]);
+        cr_assert(cost >= 0 && cost <= budget + EPSILON, " %s\n      Node %d costs %f", err_msg, out[i], cost);
+        cr_assert(cost >= prev - EPSILON, " %s\n      Node %d out of cost order", err_msg, out[i]);
+        in_out[out[i]] = true;
+        prev = cost;
+    }
+
+    size_t expected = 0;
+    for(int v = 0; v < n; v++) {
+        if(graph->nodes[v] == NULL) {
+            continue;
+        }
+        double cost = a_star(graph, start_node, v);
+        if(cost >= 0 && cost <= budget) {
+            expected++;
+            cr_assert(in_out[v], " %s\n      Missing node %d with cost %f", err_msg, v, cost);
+        }
+    }
+    cr_assert_eq(found, expected, " %s\n      Actual n: %zu\n      Expected n: %zu ", err_msg, found, expected);
+
+    free(in_out);
+    free(out);
+}
+
+TestSuite(reachable_within, .timeout=60);
+
+Test(reachable_within, testA) 
+{   
+    graph_t *graph = graph_create(9);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 1, 0);
+    node_create(graph, 2, "C", 2, 0);
+    node_create(graph, 3, "D", 3, 0);
+    node_create(graph, 4, "E", 3, 1);
+    node_create(graph, 5, "F", 3, 2);
+    node_create(graph, 6, "G", 2, 2);
+    node_create(graph, 7, "H", 1, 2);
+    node_create(graph, 8, "I", 0, 2);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+    add_edge(graph, 3, 4);
+    add_edge(graph, 4, 5);
+    add_edge(graph, 5, 6);
+    add_edge(graph, 6, 7);
+    add_edge(graph, 7, 8);
+
+    char *test = "      graph_t *g = graph_create(9);\n"
+                 "      node_create(g, 0, 'A', 0, 0);\n"
+                 "      ...\n"
+                 "      node_create(g, 8, 'I', 0, 2);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      ...\n"
+                 "      add_edge(g, 7, 8);";
+    helper_reachable_within(graph, 2, 0, test, "reachable_within/testA");
+    helper_reachable_within(graph, 2, 2.5, test, "reachable_within/testA");
+    helper_reachable_within(graph, 2, 100, test, "reachable_within/testA");
+
+    int out[2];
+    size_t n = 2;
+    reachable_within(graph, 4, 1, out, &n);
+    cr_assert_eq(n, 3, "\n      reachable_within(g, 4, 1, out, &n) with room for 2\n      Actual n: %zu\n      Expected n: 3 ", n);
+    cr_assert_eq(out[0], 4, "\n      Actual out[0]: %d\n      Expected out[0]: 4 ", out[0]);
+
+    graph_free(graph);
+}
+
+Test(reachable_within, testB) 
+{   
+    graph_t *graph = grid_graph_create(25, 25, 5);
+    char *test = "      graph_t *g = grid_graph_create(25, 25, 5);";
+
+    for(int i = 0; i < 5; i++) {
+        helper_reachable_within(graph, 312, 2.0 * i, test, "reachable_within/testB");
+    }
+
+    graph_free(graph);
+}
+
+/* helper_a_star_nearest: checks against a_star() to every target
+ *
+ * graph: the graph
+ * start_node: start node
+ * targets: target nodes
+ * n: number of targets
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_a_star_nearest(graph_t *graph, int start_node, int *targets, int n, char *test_string, char *test_name)
+{
+    int which;
+    double actual = a_star_nearest(graph, start_node, targets, n, &which);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> a_star_nearest(g, %d, targets, %d, &which);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, n, test_name);
+
+    double expected = -1;
+    bool is_target = false;
+    for(int i = 0; i < n; i++) {
+        double cost = a_star(graph, start_node, targets[i]);
+        if(cost >= 0 && (expected < 0 || cost < expected)) {
+            expected = cost;
+        }
+        is_target = is_target || targets[i] == which;
+    }
+
+    cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+    if(expected < 0) {
+        cr_assert_eq(which, -1, " %s\n      Actual which: %d\n      Expected which: -1 ", err_msg, which);
+    } else {
+        cr_assert(is_target, " %s\n      which = %d is not a target", err_msg, which);
+        cr_assert_float_eq(a_star(graph, start_node, which), expected, 0.000001, " %s\n      which = %d is not the nearest target", err_msg, which);
+    }
+}
+
+TestSuite(a_star_nearest, .timeout=60);
+
+Test(a_star_nearest, testA) 
+{   
+    graph_t *graph = graph_create(4);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(4);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);";
+    int targetsA[] = {3, 1};
+    helper_a_star_nearest(graph, 0, targetsA, 2, test, "a_star_nearest/testA");
+    int targetsB[] = {3};
+    helper_a_star_nearest(graph, 0, targetsB, 1, test, "a_star_nearest/testA");
+    int targetsC[] = {2, 0};
+    helper_a_star_nearest(graph, 0, targetsC, 2, test, "a_star_nearest/testA");
+
+    graph_free(graph);
+}
+
+Test(a_star_nearest, testB) 
+{   
+    graph_t *graph = grid_graph_create(30, 30, 13);
+    char *test = "      graph_t *g = grid_graph_create(30, 30, 13);";
+    unsigned int seed = 3;
+    int targets[40];
+
+    for(int i = 0; i < 40; i++) {
+        targets[i] = next_rand(&seed) % 900;
+    }
+    helper_a_star_nearest(graph, 0, targets, 40, test, "a_star_nearest/testB");
+    helper_a_star_nearest(graph, 465, targets, 40, test, "a_star_nearest/testB");
+    helper_a_star_nearest(graph, 899, targets, 5, test, "a_star_nearest/testB");
+
+    graph_free(graph);
+}
+
+/* simple_path_costs: collects the cost of every loopless path between
+ *     two nodes by depth-first search
+ *
+ * graph: the graph
+ * curr: current node
+ * end: end node
+ * cost: cost so far
+ * on_path: nodes on the current path
+ * costs: collected costs
+ * n: number of collected costs
+ */
+void simple_path_costs(graph_t *graph, int curr, int end, double cost, bool *on_path, double *costs, int *n)
+{
+    if(curr == end) {
+        costs[(*n)++] = cost;
+        return;
+    }
+    on_path[curr] = true;
+    for(intlist_t *nb = graph->nodes[curr]->neighbors; nb; nb = nb->next) {
+        if(!on_path[nb->num]) {
+            simple_path_costs(graph, nb->num, end, cost + h_calc(graph->nodes[curr], graph->nodes[nb->num]), on_path, costs, n);
+        }
+    }
+    on_path[curr] = false;
+}
+
+/* cmp_double: qsort comparator */
+int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* helper_k_shortest_paths: checks the paths are valid, loopless, 
+ *     distinct and match the cheapest loopless paths found by brute force
+ *
+ * graph: the graph
+ * start_node: start node
+ * end_node: send node
+ * k: number of paths
+ * num_threads: number of threads
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_k_shortest_paths(graph_t *graph, int start_node, int end_node, int k, int num_threads, char *test_string, char *test_name)
+{
+    double *costs = (double*)malloc(sizeof(double) * k);
+    int **paths = (int**)malloc(sizeof(int*) * k);
+    int *lengths = (int*)malloc(sizeof(int) * k);
+    int found = k_shortest_paths(graph, start_node, end_node, k, num_threads, costs, paths, lengths);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> k_shortest_paths(g, %d, %d, %d, %d, costs, paths, lengths);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, end_node, k, num_threads, test_name);
+
+    int n = graph->num_nodes;
+    double *all = (double*)malloc(sizeof(double) * 100000);
+    bool *on_path = (bool*)calloc(n, sizeof(bool));
+    int num_all = 0;
+    simple_path_costs(graph, start_node, end_node, 0, on_path, all, &num_all);
+    qsort(all, num_all, sizeof(double), cmp_double);
+
+    int expected = num_all < k ? num_all : k;
+    cr_assert_eq(found, expected, " %s\n      Actual paths: %d\n      Expected paths: %d ", err_msg, found, expected);
+
+    for(int i = 0; i < found; i++) {
+        cr_assert_float_eq(costs[i], all[i], 0.000001, " %s\n      Actual costs[%d]: %f\n      Expected costs[%d]: %f ", err_msg, i, costs[i], i, all[i]);
+        cr_assert_eq(paths[i][0], start_node, " %s\n      Path %d does not start at %d", err_msg, i, start_node);
+        cr_assert_eq(paths[i][lengths[i] - 1], end_node, " %s\n      Path %d does not end at %d", err_msg, i, end_node);
+
+        double cost = 0;
+        for(int j = 0; j < lengths[i]; j++) {
+            cr_assert_not(on_path[paths[i][j]], " %s\n      Path %d visits %d twice", err_msg, i, paths[i][j]);
+            on_path[paths[i][j]] = true;
+            if(j > 0) {
+                cost += h_calc(graph->nodes[paths[i][j - 1]], graph->nodes[paths[i][j]]);
+            }
+        }
+        for(int j = 0; j < lengths[i]; j++) {
+            on_path[paths[i][j]] = false;
+        }
+        cr_assert_float_eq(cost, costs[i], 0.000001, " %s\n      Path %d costs %f, reported %f", err_msg, i, cost, costs[i]);
+
+        for(int p = 0; p < i; p++) {
+            bool same = lengths[p] == lengths[i] && memcmp(paths[p], paths[i], sizeof(int) * lengths[i]) == 0;
+            cr_assert_not(same, " %s\n      Paths %d and %d are the same", err_msg, p, i);
+        }
+    }
+
+    for(int i = 0; i < found; i++) {
+        free(paths[i]);
+    }
+    free(all);
+    free(on_path);
+    free(costs);
+    free(paths);
+    free(lengths);
+}
+
+TestSuite(k_shortest_paths, .timeout=60);
+
+Test(k_shortest_paths, testA) 
+{   
+    graph_t *graph = graph_create(8);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 1, 0);
+    node_create(graph, 2, "C", 2, 0);
+    node_create(graph, 3, "D", 3, 0);
+    node_create(graph, 4, "E", 1, 1);
+    node_create(graph, 5, "F", 2, 1);
+    node_create(graph, 6, "G", 3, 1);
+    node_create(graph, 7, "H", 3, 2);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 4);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 1, 4);
+    add_edge(graph, 2, 3);
+    add_edge(graph, 2, 4);
+    add_edge(graph, 2, 5);
+    add_edge(graph, 4, 5);
+    add_edge(graph, 3, 6);
+    add_edge(graph, 6, 7);
+
+    char *test = "      graph_t *g = graph_create(8);\n"
+                 "      node_create(g, 0, 'A', 0, 0);\n"
+                 "      node_create(g, 1, 'B', 1, 0);\n"
+                 "      node_create(g, 2, 'C', 2, 0);\n"
+                 "      node_create(g, 3, 'D', 3, 0);\n"
+                 "      node_create(g, 4, 'E', 1, 1);\n"
+                 "      node_create(g, 5, 'F', 2, 1);\n"
+                 "      node_create(g, 6, 'G', 3, 1);\n"
+                 "      node_create(g, 7, 'H', 3, 2);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 4);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 1, 4);\n"
+                 "      add_edge(g, 2, 3);\n"
+                 "      add_edge(g, 2, 4);\n"
+                 "      add_edge(g, 4, 5);\n"
+                 "      add_edge(g, 3, 6);\n"
+                 "      add_edge(g, 6, 7);";
+    helper_k_shortest_paths(graph, 0, 7, 1, 1, test, "k_shortest_paths/testA");
+    helper_k_shortest_paths(graph, 0, 7, 20, 2, test, "k_shortest_paths/testA");
+    helper_k_shortest_paths(graph, 7, 7, 3, 2, test, "k_shortest_paths/testA");
+
+    graph_free(graph);
+}
+
+Test(k_shortest_paths, testB) 
+{   
+    graph_t *graph = grid_graph_create(4, 5, 17);
+    char *test = "      graph_t *g = grid_graph_create(4, 5, 17);";
+
+    helper_k_shortest_paths(graph, 0, 19, 12, 4, test, "k_shortest_paths/testB");
+    helper_k_shortest_paths(graph, 3, 16, 5, 1, test, "k_shortest_paths/testB");
+
+    graph_free(graph);
+}
+
+/* filtered_copy: rebuilds a graph without some nodes and edges, the
+ *     slow way a_star_masked replaces
+ *
+ * graph: the graph
+ * no_node: nodes to leave out
+ * no_edge: edge numbers to leave out
+ * 
+ * Returns: the copy
+ */
+graph_t *filtered_copy(graph_t *graph, bool *no_node, bool *no_edge)
+{
+    graph_t *copy = graph_create(graph->num_nodes);
+    for(int v = 0; v < graph->num_nodes; v++) {
+        node_t *node = graph->nodes[v];
+        if(node) {
+            node_create(copy, v, node->city_name, node->latitude, node->longitude);
+        }
+    }
+    for(int v = 0; v < graph->num_nodes; v++) {
+        if(graph->nodes[v] == NULL || no_node[v]) {
+            continue;
+        }
+        for(intlist_t *nb = graph->nodes[v]->neighbors; nb; nb = nb->next) {
+            if(v < nb->num && !no_node[nb->num] && !no_edge[nb->edge_num]) {
+                add_edge(copy, v, nb->num);
+            }
+        }
+    }
+    return copy;
+}
+
+/* helper_a_star_masked: checks a_star_masked against a_star() on a
+ *     copy of the graph without the excluded nodes and edges
+ *
+ * graph: the graph
+ * mask: the search mask
+ * no_node: nodes excluded by mask
+ * no_edge: edge numbers excluded by mask
+ * start_node: start node
+ * end_node: send node
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_a_star_masked(graph_t *graph, search_mask_t *mask, bool *no_node, bool *no_edge, int start_node, int end_node, char *test_string, char *test_name)
+{
+    double actual = a_star_masked(graph, start_node, end_node, mask);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> a_star_masked(g, %d, %d, mask);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, end_node, test_name);
+
+    double expected = -1;
+    if(!no_node[start_node] && !no_node[end_node]) {
+        graph_t *copy = filtered_copy(graph, no_node, no_edge);
+        expected = a_star(copy, start_node, end_node);
+        graph_free(copy);
+    }
+
+    cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+}
+
+TestSuite(a_star_masked, .timeout=60);
+
+Test(a_star_masked, testA) 
+{   
+    graph_t *graph = graph_create(4);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(4);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);\n"
+                 "      search_mask_t *mask = mask_create(g);\n"
+                 "      mask_exclude_edge(mask, g, 2, 0);";
+
+    search_mask_t *mask = mask_create(graph);
+    mask_exclude_edge(mask, graph, 2, 0);
+
+    double actual = a_star_masked(graph, 0, 3, mask);
+    cr_assert_float_eq(actual, 3, 0.000001, "\n%s\n   -> a_star_masked(g, 0, 3, mask);\n      Actual: %f\n      Expected: 3.0 ", test, actual);
+    cr_assert_eq(graph->nodes[2]->parent->node_num, 1, "\n%s\n   -> a_star_masked(g, 0, 3, mask);\n      Actual parent of 2: %d\n      Expected parent of 2: 1 ", test, graph->nodes[2]->parent->node_num);
+
+    mask_exclude_node(mask, 1);
+    actual = a_star_masked(graph, 0, 3, mask);
+    cr_assert_float_eq(actual, -1, 0.000001, "\n%s\n      mask_exclude_node(mask, 1);\n   -> a_star_masked(g, 0, 3, mask);\n      Actual: %f\n      Expected: -1 ", test, actual);
+
+    mask_clear(mask);
+    actual = a_star_masked(graph, 0, 3, mask);
+    cr_assert_float_eq(actual, 2.414213, 0.000001, "\n%s\n      mask_clear(mask);\n   -> a_star_masked(g, 0, 3, mask);\n      Actual: %f\n      Expected: 2.414213 ", test, actual);
+
+    mask_free(mask);
+    graph_free(graph);
+}
+
+Test(a_star_masked, testB) 
+{   
+    graph_t *graph = grid_graph_create(20, 20, 23);
+    char *test = "      graph_t *g = grid_graph_create(20, 20, 23);\n"
+                 "      search_mask_t *mask = mask_create(g);\n"
+                 "      (random nodes and edges excluded)";
+    bool *no_node = (bool*)calloc(graph->num_nodes, sizeof(bool));
+    bool *no_edge = (bool*)calloc(graph->num_edges, sizeof(bool));
+    search_mask_t *mask = mask_create(graph);
+    unsigned int seed = 29;
+
+    for(int i = 0; i < 30; i++) {
+        int v = next_rand(&seed) % graph->num_nodes;
+        no_node[v] = true;
+        mask_exclude_node(mask, v);
+
+        int u = next_rand(&seed) % graph->num_nodes;
+        intlist_t *nb = graph->nodes[u]->neighbors;
+        if(nb) {
+            no_edge[nb->edge_num] = true;
+            mask_exclude_edge(mask, graph, nb->num, u);
+        }
+    }
+
+    helper_a_star_masked(graph, mask, no_node, no_edge, 0, 399, test, "a_star_masked/testB");
+    helper_a_star_masked(graph, mask, no_node, no_edge, 19, 380, test, "a_star_masked/testB");
+    helper_a_star_masked(graph, mask, no_node, no_edge, 205, 14, test, "a_star_masked/testB");
+    helper_a_star_masked(graph, mask, no_node, no_edge, 205, 205, test, "a_star_masked/testB");
+
+    mask_free(mask);
+    free(no_node);
+    free(no_edge);
+    graph_free(graph);
+}
+
+/* helper_a_star_compressed: checks a compressed graph against a_star()
+ *
+ * graph: the graph
+ * quantum: cost quantum passed to cgraph_create
+ * start_node: start node
+ * end_node: send node
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_a_star_compressed(graph_t *graph, double quantum, int start_node, int end_node, char *test_string, char *test_name)
+{
+    cgraph_t *cg = cgraph_create(graph, quantum);
+    double actual = a_star_compressed(cg, start_node, end_node);
+    double expected = a_star(graph, start_node, end_node);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n      cgraph_t *cg = cgraph_create(g, %f);\n   -> a_star_compressed(cg, %d, %d);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, quantum, start_node, end_node, test_name);
+
+    cr_assert_eq(cgraph_num_edges(cg), 2L * graph->num_edges, " %s\n      Actual edges: %ld\n      Expected edges: %ld ", err_msg, cgraph_num_edges(cg), 2L * graph->num_edges);
+
+    if(quantum == 0 || expected < 0) {
+        cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+    } else {
+        // costs are rounded up by less than one quantum per edge
+        cr_assert(actual >= expected - EPSILON && actual <= expected + quantum * graph->num_nodes, 
+                  " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+    }
+
+    cgraph_free(cg);
+}
+
+TestSuite(a_star_compressed, .timeout=60);
+
+Test(a_star_compressed, testA) 
+{   
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);";
+    helper_a_star_compressed(graph, 0, 0, 3, test, "a_star_compressed/testA");
+    helper_a_star_compressed(graph, 0, 3, 1, test, "a_star_compressed/testA");
+    helper_a_star_compressed(graph, 0.01, 0, 3, test, "a_star_compressed/testA");
+
+    graph_free(graph);
+}
+
+Test(a_star_compressed, testB) 
+{   
+    graph_t *graph = grid_graph_create(40, 40, 31);
+    char *test = "      graph_t *g = grid_graph_create(40, 40, 31);";
+    unsigned int seed = 37;
+
+    for(int i = 0; i < 10; i++) {
+        int start = next_rand(&seed) % 1600;
+        int end = next_rand(&seed) % 1600;
+        helper_a_star_compressed(graph, 0, start, end, test, "a_star_compressed/testB");
+        helper_a_star_compressed(graph, 0.001, start, end, test, "a_star_compressed/testB");
+    }
+
+    graph_free(graph);
+}
+
+Test(a_star_compressed, testC) 
+{   
+    // long edges, each a few million quanta
+    graph_t *graph = graph_create(3);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 0, 5000);
+    node_create(graph, 2, "C", 0, 10000);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 2);
+
+    char *test = "      graph_t *g = graph_create(3);\n"
+                 "      node_create(g, 0, 'A', 0, 0);\n"
+                 "      node_create(g, 1, 'B', 0, 5000);\n"
+                 "      node_create(g, 2, 'C', 0, 10000);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 1, 2);";
+    helper_a_star_compressed(graph, 0.001, 0, 2, test, "a_star_compressed/testC");
+    helper_a_star_compressed(graph, 0.000002, 2, 0, test, "a_star_compressed/testC");
+
+    graph_free(graph);
+}
+
+Test(a_star_compressed, testD, .exit_code = 1) 
+{   
+    // 5000 / 0.000001 quanta do not fit in 32 bits, which must stop the
+    // program rather than wrap
+    graph_t *graph = graph_create(3);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 0, 5000);
+    node_create(graph, 2, "C", 0, 10000);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 2);
+    cgraph_create(graph, 0.000001);
+    graph_free(graph);
+}
+
+/* helper_a_star_csr: checks a CSR graph and its reversed view against
+ *     a_star()
+ *
+ * graph: the graph
+ * start_node: start node
+ * end_node: send node
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_a_star_csr(graph_t *graph, int start_node, int end_node, char *test_string, char *test_name)
+{
+    csr_t *csr = csr_create(graph);
+    csr_t *reverse = csr_reverse(csr);
+    double actual = a_star_csr(csr, start_node, end_node);
+    double backward = a_star_csr(reverse, end_node, start_node);
+    double expected = a_star(graph, start_node, end_node);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n      csr_t *csr = csr_create(g);\n   -> a_star_csr(csr, %d, %d);\n   -> a_star_csr(csr_reverse(csr), %d, %d);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, end_node, end_node, start_node, test_name);
+
+    cr_assert_eq(csr_num_edges(csr), (long)graph->num_edges, " %s\n      Actual edges: %ld\n      Expected edges: %ld ", err_msg, csr_num_edges(csr), (long)graph->num_edges);
+    cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+    cr_assert_float_eq(backward, expected, 0.000001, " %s\n      Actual reversed: %f\n      Expected: %f ", err_msg, backward, expected);
+
+    csr_free(reverse);
+    csr_free(csr);
+}
+
+TestSuite(a_star_csr, .timeout=60);
+
+Test(a_star_csr, testA) 
+{   
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_arc(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_arc(graph, 3, 2);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_arc(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_arc(g, 3, 2);";
+
+    // arcs are only followed forwards
+    double cost = a_star(graph, 3, 0);
+    cr_assert_float_eq(cost, 3, 0.000001, "\n      a_star(g, 3, 0)\n      Actual: %f\n      Expected: 3 ", cost);
+    cost = a_star(graph, 0, 3);
+    cr_assert_float_eq(cost, -1, 0.000001, "\n      a_star(g, 0, 3)\n      Actual: %f\n      Expected: -1 ", cost);
+
+    helper_a_star_csr(graph, 3, 0, test, "a_star_csr/testA");
+    helper_a_star_csr(graph, 0, 3, test, "a_star_csr/testA");
+    helper_a_star_csr(graph, 2, 0, test, "a_star_csr/testA");
+
+    // C is reached from A, B and D, but only leads back to B
+    csr_t *csr = csr_create(graph);
+    csr_t *reverse = csr_reverse(csr);
+    int out[4];
+    int n = csr_neighbors(csr, 2, out);
+    cr_assert(n == 1 && out[0] == 1, "\n      csr_neighbors(csr, 2, out)\n      Actual count: %d\n      Expected: 1 neighbor, B ", n);
+    n = csr_neighbors(reverse, 2, out);
+    cr_assert_eq(n, 3, "\n      csr_neighbors(csr_reverse(csr), 2, out)\n      Actual count: %d\n      Expected count: 3 ", n);
+    csr_free(reverse);
+    csr_free(csr);
+
+    graph_free(graph);
+}
+
+Test(a_star_csr, testB) 
+{   
+    graph_t *graph = directed_graph_create(30, 30, 41);
+    char *test = "      graph_t *g = directed_graph_create(30, 30, 41);";
+    unsigned int seed = 43;
+
+    for(int i = 0; i < 10; i++) {
+        int start = next_rand(&seed) % 900;
+        int end = next_rand(&seed) % 900;
+        helper_a_star_csr(graph, start, end, test, "a_star_csr/testB");
+    }
+
+    graph_free(graph);
+}
+
+Test(a_star_csr, testC) 
+{   
+    graph_t *graph = directed_graph_create(20, 20, 257);
+    char *test = "      graph_t *g = directed_graph_create(20, 20, 257);";
+    unsigned int seed = 263;
+
+    // a saved graph searches the same once loaded, in either memory
+    csr_t *csr = csr_create(graph);
+    FILE *file = tmpfile();
+    cr_assert(file != NULL, "\n      tmpfile() failed");
+    cr_assert_eq(csr_save(csr, file), 0, "\n%s\n   -> csr_save(csr_create(g), file);\n      csr_save failed ", test);
+    for(int a = 0; a < 2; a++) {
+        rewind(file);
+        csr_alloc_t alloc = a ? CSR_ALLOC_HUGE_PAGES : CSR_ALLOC_DEFAULT;
+        csr_t *loaded = csr_load(file, alloc);
+        cr_assert(loaded != NULL, "\n%s\n   -> csr_load(file, %d);\n      Actual: NULL\n      Expected: the graph ", test, a);
+        cr_assert_eq(csr_num_edges(loaded), csr_num_edges(csr), "\n%s\n   -> csr_num_edges(csr_load(file, %d));\n      Actual: %ld\n      Expected: %ld ", test, a, csr_num_edges(loaded), csr_num_edges(csr));
+        for(int i = 0; i < 10; i++) {
+            int start = next_rand(&seed) % 400;
+            int end = next_rand(&seed) % 400;
+            double expected = a_star_csr(csr, start, end);
+            double actual = a_star_csr(loaded, start, end);
+            cr_assert_float_eq(actual, expected, 0.000001, "\n%s\n      csr_t *loaded = csr_load(file, %d);\n   -> a_star_csr(loaded, %d, %d);\n      Actual: %f\n      Expected: %f ", test, a, start, end, actual, expected);
+        }
+        csr_free(loaded);
+    }
+
+    // a cut short file is not a graph
+    rewind(file);
+    FILE *cut = tmpfile();
+    char buf[100];
+    cr_assert_eq(fread(buf, 1, sizeof(buf), file), sizeof(buf), "\n      fread failed");
+    fwrite(buf, 1, sizeof(buf), cut);
+    rewind(cut);
+    csr_t *loaded = csr_load(cut, CSR_ALLOC_DEFAULT);
+    cr_assert(loaded == NULL, "\n%s\n   -> csr_load(first 100 bytes of the file);\n      Actual: a graph\n      Expected: NULL ", test);
+    fclose(cut);
+
+    // nor is a header claiming far more edges than the file holds
+    cut = tmpfile();
+    int32_t header[3] = {0x47525343, 1, 1};
+    int64_t m = (int64_t)1 << 42;
+    fwrite(header, sizeof(int32_t), 3, cut);
+    fwrite(&m, sizeof(int64_t), 1, cut);
+    rewind(cut);
+    loaded = csr_load(cut, CSR_ALLOC_DEFAULT);
+    cr_assert(loaded == NULL, "\n   -> csr_load(a header with 1 node and 2^42 edges);\n      Actual: a graph\n      Expected: NULL ");
+    fclose(cut);
+    fclose(file);
+
+    csr_free(csr);
+    graph_free(graph);
+}
+
+/* helper_hub_labels: checks label queries against a_star(), before and
+ *     after a save and load round trip
+ *
+ * graph: the graph
+ * num_threads: number of worker threads
+ * num_queries: number of random node pairs to check
+ * seed: random seed for the pairs
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_hub_labels(graph_t *graph, int num_threads, int num_queries, unsigned int seed, char *test_string, char *test_name)
+{
+    hub_labels_t *hl = hub_labels_create(graph, num_threads);
+    FILE *file = tmpfile();
+    cr_assert(file != NULL, "\n      tmpfile() failed");
+    cr_assert_eq(hub_labels_save(hl, file), 0, "\n      hub_labels_save failed");
+    rewind(file);
+    hub_labels_t *loaded = hub_labels_load(file);
+    fclose(file);
+    cr_assert(loaded != NULL, "\n      hub_labels_load returned NULL");
+    cr_assert_eq(hub_labels_size(loaded), hub_labels_size(hl), "\n      Actual loaded size: %ld\n      Expected size: %ld ", hub_labels_size(loaded), hub_labels_size(hl));
+
+    for(int i = 0; i < num_queries; i++) {
+        int start = next_rand(&seed) % graph->num_nodes;
+        int end = next_rand(&seed) % graph->num_nodes;
+        if(graph->nodes[start] == NULL || graph->nodes[end] == NULL) {
+            continue;
+        }
+        double expected = a_star(graph, start, end);
+        double actual = hub_labels_query(hl, start, end);
+        double reloaded = hub_labels_query(loaded, start, end);
+        char err_msg[ERR_MSG_LEN];
+
+        snprintf(err_msg, ERR_MSG_LEN-1,
+                 ("\n  Functions called in failed test:\n%s\n      hub_labels_t *hl = hub_labels_create(g, %d);\n   -> hub_labels_query(hl, %d, %d);\n"
+                  "\n  The filter to run this specific test is: --filter %s"), test_string, num_threads, start, end, test_name);
+
+        cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+        cr_assert_float_eq(reloaded, expected, 0.000001, " %s\n      Actual after reload: %f\n      Expected: %f ", err_msg, reloaded, expected);
+    }
+
+    hub_labels_free(loaded);
+    hub_labels_free(hl);
+}
+
+TestSuite(hub_labels, .timeout=60);
+
+Test(hub_labels, testA) 
+{   
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);";
+    hub_labels_t *hl = hub_labels_create(graph, 2);
+    double cost = hub_labels_query(hl, 0, 3);
+    cr_assert_float_eq(cost, 2.414213, 0.000001, "\n%s\n   -> hub_labels_query(hl, 0, 3);\n      Actual: %f\n      Expected: 2.414213 ", test, cost);
+    cost = hub_labels_query(hl, 4, 0);
+    cr_assert_float_eq(cost, -1, 0.000001, "\n%s\n   -> hub_labels_query(hl, 4, 0);\n      Actual: %f\n      Expected: -1 ", test, cost);
+    hub_labels_free(hl);
+
+    helper_hub_labels(graph, 1, 20, 3, test, "hub_labels/testA");
+
+    graph_free(graph);
+}
+
+Test(hub_labels, testB) 
+{   
+    graph_t *graph = grid_graph_create(25, 25, 47);
+    char *test = "      graph_t *g = grid_graph_create(25, 25, 47);";
+
+    helper_hub_labels(graph, 1, 100, 53, test, "hub_labels/testB");
+    helper_hub_labels(graph, 4, 100, 59, test, "hub_labels/testB");
+
+    graph_free(graph);
+}
+
+Test(hub_labels, testC) 
+{   
+    graph_t *graph = directed_graph_create(25, 25, 61);
+    char *test = "      graph_t *g = directed_graph_create(25, 25, 61);";
+
+    helper_hub_labels(graph, 1, 100, 67, test, "hub_labels/testC");
+    helper_hub_labels(graph, 3, 100, 71, test, "hub_labels/testC");
+
+    // a file that is not a label file
+    FILE *file = tmpfile();
+    fputs("not hub labels", file);
+    rewind(file);
+    cr_assert(hub_labels_load(file) == NULL, "\n      hub_labels_load should reject a file without the header");
+    fclose(file);
+
+    // a header and offsets that claim more labels than the file holds,
+    // one so many that their size overflows
+    long claims[] = {(1L << 62) + 1, 3};
+    for(int i = 0; i < 2; i++) {
+        file = tmpfile();
+        int32_t header[4] = {0x4c425548, 1, 1, 0};
+        long off[2] = {0, claims[i]};
+        int hub[1] = {0};
+        fwrite(header, sizeof(int32_t), 4, file);
+        fwrite(off, sizeof(long), 2, file);
+        fwrite(hub, sizeof(int), 1, file);
+        rewind(file);
+        cr_assert(hub_labels_load(file) == NULL, "\n      hub_labels_load should reject a file with %ld labels and room for none", claims[i]);
+        fclose(file);
+    }
+
+    graph_free(graph);
+}
+
+/* costs_dijkstra: reference shortest path cost with edge costs given by
+ *     edge number
+ *
+ * graph: the graph
+ * costs: cost of every edge by edge number
+ * start_node: start node
+ * end_node: end node
+ * 
+ * Returns: the cost, -1 if there is no path
+ */
+double costs_dijkstra(graph_t *graph, double *costs, int start_node, int end_node)
+{
+    int n = graph->num_nodes;
+    double *dist = (double*)malloc(sizeof(double) * n);
+    for(int v = 0; v < n; v++) {
+        dist[v] = INFINITY;
+    }
+    heap_t *open = heap_create(64);
+    dist[start_node] = 0;
+    heap_push(open, start_node, 0);
+    while(!heap_is_empty(open)) {
+        double d;
+        int v = heap_pop(open, &d);
+        if(d > dist[v]) {
+            continue;
+        }
+        for(intlist_t *nb = graph->nodes[v]->neighbors; nb; nb = nb->next) {
+            if(d + costs[nb->edge_num] < dist[nb->num]) {
+                dist[nb->num] = d + costs[nb->edge_num];
+                heap_push(open, nb->num, dist[nb->num]);
+            }
+        }
+    }
+    double cost = dist[end_node] == INFINITY ? -1 : dist[end_node];
+    heap_free(open);
+    free(dist);
+    return cost;
+}
+
+/* helper_crp: checks overlay queries against costs_dijkstra()
+ *
+ * graph: the graph
+ * crp: the overlay, customized with costs
+ * costs: cost of every edge by edge number
+ * num_queries: number of random node pairs to check
+ * seed: random seed for the pairs
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_crp(graph_t *graph, crp_t *crp, double *costs, int num_queries, unsigned int seed, char *test_string, char *test_name)
+{
+    for(int i = 0; i < num_queries; i++) {
+        int start = next_rand(&seed) % graph->num_nodes;
+        int end = next_rand(&seed) % graph->num_nodes;
+        if(graph->nodes[start] == NULL || graph->nodes[end] == NULL) {
+            continue;
+        }
+        double expected = costs_dijkstra(graph, costs, start, end);
+        double actual = crp_query(crp, start, end);
+        char err_msg[ERR_MSG_LEN];
+
+        snprintf(err_msg, ERR_MSG_LEN-1,
+                 ("\n  Functions called in failed test:\n%s\n      crp_customize(crp, costs, n);\n   -> crp_query(crp, %d, %d);\n"
+                  "\n  The filter to run this specific test is: --filter %s"), test_string, start, end, test_name);
+
+        cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+    }
+}
+
+/* straight_costs: the straight-line cost of every edge by edge number
+ *
+ * graph: the graph
+ * 
+ * Returns: graph->num_edges costs
+ */
+double *straight_costs(graph_t *graph)
+{
+    double *costs = (double*)malloc(sizeof(double) * (graph->num_edges + 1));
+    for(int v = 0; v < graph->num_nodes; v++) {
+        if(graph->nodes[v] == NULL) {
+            continue;
+        }
+        for(intlist_t *nb = graph->nodes[v]->neighbors; nb; nb = nb->next) {
+            costs[nb->edge_num] = h_calc(graph->nodes[v], graph->nodes[nb->num]);
+        }
+    }
+    return costs;
+}
+
+TestSuite(crp, .timeout=60);
+
+Test(crp, testA) 
+{   
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);\n"
+                 "      crp_t *crp = crp_create(g, 1, 2);";
+    crp_t *crp = crp_create(graph, 1, 2);
+    double cost = crp_query(crp, 0, 3);
+    cr_assert_float_eq(cost, 2.414213, 0.000001, "\n%s\n   -> crp_query(crp, 0, 3);\n      Actual: %f\n      Expected: 2.414213 ", test, cost);
+
+    // make the direct edge A-C expensive
+    double costs[] = {1, 5, 1, 1};
+    crp_customize(crp, costs, 2);
+    helper_crp(graph, crp, costs, 20, 73, test, "crp/testA");
+
+    crp_free(crp);
+    graph_free(graph);
+}
+
+Test(crp, testB) 
+{   
+    graph_t *graph = grid_graph_create(30, 30, 79);
+    char *test = "      graph_t *g = grid_graph_create(30, 30, 79);\n"
+                 "      crp_t *crp = crp_create(g, 16, 3);";
+    crp_t *crp = crp_create(graph, 16, 3);
+    cr_assert(crp_num_levels(crp) > 1, "\n      Expected more than one level, got %d ", crp_num_levels(crp));
+
+    double *costs = straight_costs(graph);
+    helper_crp(graph, crp, costs, 50, 83, test, "crp/testB");
+
+    // traffic: slow down a random tenth of the edges, then clear it
+    unsigned int seed = 89;
+    for(int e = 0; e < graph->num_edges; e++) {
+        if(next_rand(&seed) % 10 == 0) {
+            costs[e] *= 1 + next_rand(&seed) % 50;
+        }
+    }
+    crp_customize(crp, costs, 3);
+    helper_crp(graph, crp, costs, 50, 97, test, "crp/testB");
+
+    free(costs);
+    costs = straight_costs(graph);
+    crp_customize(crp, NULL, 1);
+    helper_crp(graph, crp, costs, 50, 101, test, "crp/testB");
+
+    free(costs);
+    crp_free(crp);
+    graph_free(graph);
+}
+
+Test(crp, testC) 
+{   
+    graph_t *graph = directed_graph_create(30, 30, 103);
+    char *test = "      graph_t *g = directed_graph_create(30, 30, 103);\n"
+                 "      crp_t *crp = crp_create(g, 40, 2);";
+    crp_t *crp = crp_create(graph, 40, 2);
+
+    double *costs = straight_costs(graph);
+    unsigned int seed = 107;
+    for(int e = 0; e < graph->num_edges; e++) {
+        costs[e] *= 1 + next_rand(&seed) % 4;
+    }
+    crp_customize(crp, costs, 2);
+    helper_crp(graph, crp, costs, 80, 109, test, "crp/testC");
+
+    free(costs);
+    crp_free(crp);
+    graph_free(graph);
+}
+
+/* helper_apsp: checks every distance from a few sources against
+ *     a_star(), and that the paths read back have that cost
+ *
+ * graph: the graph
+ * num_threads: number of worker threads
+ * num_sources: number of random sources to check
+ * seed: random seed for the sources
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_apsp(graph_t *graph, int num_threads, int num_sources, unsigned int seed, char *test_string, char *test_name)
+{
+    apsp_t *apsp = apsp_create(graph, num_threads);
+
+    for(int i = 0; i < num_sources; i++) {
+        int start = next_rand(&seed) % graph->num_nodes;
+        if(graph->nodes[start] == NULL) {
+            continue;
+        }
+        for(int end = 0; end < graph->num_nodes; end++) {
+            if(graph->nodes[end] == NULL) {
+                continue;
+            }
+            double expected = a_star(graph, start, end);
+            double actual = apsp_query(apsp, start, end);
+            char err_msg[ERR_MSG_LEN];
+
+            snprintf(err_msg, ERR_MSG_LEN-1,
+                     ("\n  Functions called in failed test:\n%s\n      apsp_t *apsp = apsp_create(g, %d);\n   -> apsp_query(apsp, %d, %d);\n"
+                      "\n  The filter to run this specific test is: --filter %s"), test_string, num_threads, start, end, test_name);
+
+            cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+
+            int *path;
+            int len = apsp_path(apsp, start, end, &path);
+            if(expected < 0) {
+                cr_assert(len == 0 && path == NULL, " %s\n      Expected no path, got %d nodes ", err_msg, len);
+                continue;
+            }
+            cr_assert(len > 0 && path[0] == start && path[len - 1] == end, " %s\n      Path does not join the nodes ", err_msg);
+            double cost = 0;
+            for(int j = 0; j + 1 < len; j++) {
+                bool edge = false;
+                for(intlist_t *nb = graph->nodes[path[j]]->neighbors; nb; nb = nb->next) {
+                    edge = edge || nb->num == path[j + 1];
+                }
+                cr_assert(edge, " %s\n      No edge from %d to %d on the path ", err_msg, path[j], path[j + 1]);
+                cost += h_calc(graph->nodes[path[j]], graph->nodes[path[j + 1]]);
+            }
+            cr_assert_float_eq(cost, expected, 0.000001, " %s\n      Path cost: %f\n      Expected: %f ", err_msg, cost, expected);
+            free(path);
+        }
+    }
+
+    apsp_free(apsp);
+}
+
+TestSuite(apsp, .timeout=60);
+
+Test(apsp, testA) 
+{   
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);";
+    apsp_t *apsp = apsp_create(graph, 1);
+    double cost = apsp_query(apsp, 0, 3);
+    cr_assert_float_eq(cost, 2.414213, 0.000001, "\n%s\n   -> apsp_query(apsp, 0, 3);\n      Actual: %f\n      Expected: 2.414213 ", test, cost);
+    int *path;
+    int len = apsp_path(apsp, 0, 3, &path);
+    cr_assert(len == 3 && path[1] == 2, "\n%s\n   -> apsp_path(apsp, 0, 3, &path);\n      Expected path: A C D ", test);
+    free(path);
+    apsp_free(apsp);
+
+    helper_apsp(graph, 2, 4, 113, test, "apsp/testA");
+
+    graph_free(graph);
+}
+
+Test(apsp, testB) 
+{   
+    graph_t *graph = grid_graph_create(15, 15, 127);
+    char *test = "      graph_t *g = grid_graph_create(15, 15, 127);";
+
+    helper_apsp(graph, 1, 3, 131, test, "apsp/testB");
+    helper_apsp(graph, 4, 3, 137, test, "apsp/testB");
+
+    graph_free(graph);
+}
+
+Test(apsp, testC) 
+{   
+    graph_t *graph = directed_graph_create(12, 12, 139);
+    char *test = "      graph_t *g = directed_graph_create(12, 12, 139);";
+
+    helper_apsp(graph, 3, 4, 149, test, "apsp/testC");
+
+    graph_free(graph);
+}
+
+/* helper_route_cache: checks a cached search against a_star_masked(), and
+ *     that the path it returns has that cost
+ *
+ * cache: the cache
+ * graph: the graph the cache was created for
+ * mask: the search mask, may be NULL
+ * start_node: start node
+ * end_node: send node
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_route_cache(route_cache_t *cache, graph_t *graph, search_mask_t *mask, int start_node, int end_node, char *test_string, char *test_name)
+{
+    int *path;
+    int len;
+    double actual = route_cache_a_star(cache, start_node, end_node, mask, &path, &len);
+    double expected = a_star_masked(graph, start_node, end_node, mask);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> route_cache_a_star(cache, %d, %d, mask, &path, &len);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, end_node, test_name);
+
+    cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+    if(expected < 0) {
+        cr_assert(len == 0 && path == NULL, " %s\n      Expected no path, got %d nodes ", err_msg, len);
+        return;
+    }
+
+    cr_assert(len > 0 && path[0] == start_node && path[len - 1] == end_node, " %s\n      Path does not join the nodes ", err_msg);
+    double cost = 0;
+    for(int j = 0; j + 1 < len; j++) {
+        bool edge = false;
+        for(intlist_t *nb = graph->nodes[path[j]]->neighbors; nb; nb = nb->next) {
+            edge = edge || nb->num == path[j + 1];
+        }
+        cr_assert(edge, " %s\n      No edge from %d to %d on the path ", err_msg, path[j], path[j + 1]);
+        cost += h_calc(graph->nodes[path[j]], graph->nodes[path[j + 1]]);
+    }
+    cr_assert_float_eq(cost, expected, 0.000001, " %s\n      Path cost: %f\n      Expected: %f ", err_msg, cost, expected);
+    free(path);
+}
+
+typedef struct {
+    route_cache_t *cache;
+    const int *pairs;
+    const double *expected;
+    int num_pairs;
+    unsigned int seed;
+    int wrong;
+} cache_worker_t;
+
+/* cache_worker: runs random queries from a list of pairs on a shared
+ *     cache, counting wrong answers
+ *
+ * arg: the worker (cache_worker_t*)
+ */
+void *cache_worker(void *arg)
+{
+    cache_worker_t *w = (cache_worker_t*)arg;
+    for(int i = 0; i < 300; i++) {
+        int p = next_rand(&w->seed) % w->num_pairs;
+        double cost = route_cache_a_star(w->cache, w->pairs[2 * p], w->pairs[2 * p + 1], NULL, NULL, NULL);
+        if(fabs(cost - w->expected[p]) > 0.000001) {
+            w->wrong++;
+        }
+    }
+    return NULL;
+}
+
+TestSuite(route_cache, .timeout=60);
+
+Test(route_cache, testA) 
+{   
+    graph_t *graph = graph_create(4);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(4);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);\n"
+                 "      route_cache_t *cache = route_cache_create(g, 4);";
+    route_cache_t *cache = route_cache_create(graph, 4);
+    route_cache_stats_t stats;
+
+    helper_route_cache(cache, graph, NULL, 0, 3, test, "route_cache/testA");
+    helper_route_cache(cache, graph, NULL, 0, 3, test, "route_cache/testA");
+    route_cache_get_stats(cache, &stats);
+    cr_assert(stats.hits == 1 && stats.misses == 1 && stats.entries == 1, "\n%s\n      route_cache_a_star(cache, 0, 3, NULL, &path, &len);\n      route_cache_a_star(cache, 0, 3, NULL, &path, &len);\n   -> route_cache_get_stats(cache, &stats);\n      Actual: %ld hits, %ld misses\n      Expected: 1 hit, 1 miss ", test, stats.hits, stats.misses);
+
+    // a different mask is a different key, an empty one is the same
+    search_mask_t *mask = mask_create(graph);
+    helper_route_cache(cache, graph, mask, 0, 3, test, "route_cache/testA");
+    mask_exclude_node(mask, 1);
+    helper_route_cache(cache, graph, mask, 0, 3, test, "route_cache/testA");
+    helper_route_cache(cache, graph, mask, 0, 3, test, "route_cache/testA");
+    route_cache_get_stats(cache, &stats);
+    cr_assert(stats.hits == 3 && stats.misses == 2, "\n%s\n      (same query with an empty mask, then twice with node 1 excluded)\n   -> route_cache_get_stats(cache, &stats);\n      Actual: %ld hits, %ld misses\n      Expected: 3 hits, 2 misses ", test, stats.hits, stats.misses);
+
+    // changing the graph drops the stale result
+    add_edge(graph, 0, 2);
+    double cost = route_cache_a_star(cache, 0, 3, NULL, NULL, NULL);
+    cr_assert_float_eq(cost, 2.414213, 0.000001, "\n%s\n      add_edge(g, 0, 2);\n   -> route_cache_a_star(cache, 0, 3, NULL, NULL, NULL);\n      Actual: %f\n      Expected: 2.414213 ", test, cost);
+    route_cache_get_stats(cache, &stats);
+    cr_assert(stats.invalidations == 2 && stats.entries == 1, "\n%s\n      add_edge(g, 0, 2);\n      route_cache_a_star(cache, 0, 3, NULL, NULL, NULL);\n   -> route_cache_get_stats(cache, &stats);\n      Actual: %ld invalidations, %ld entries\n      Expected: 2 invalidations, 1 entry ", test, stats.invalidations, stats.entries);
+    helper_route_cache(cache, graph, mask, 0, 3, test, "route_cache/testA");
+
+    route_cache_clear(cache);
+    route_cache_get_stats(cache, &stats);
+    cr_assert(stats.entries == 0, "\n%s\n   -> route_cache_clear(cache);\n      Actual: %ld entries\n      Expected: 0 entries ", test, stats.entries);
+
+    mask_free(mask);
+    route_cache_free(cache);
+    graph_free(graph);
+}
+
+Test(route_cache, testB) 
+{   
+    graph_t *graph = directed_graph_create(20, 20, 151);
+    char *test = "      graph_t *g = directed_graph_create(20, 20, 151);\n"
+                 "      route_cache_t *cache = route_cache_create(g, 20);";
+    route_cache_t *cache = route_cache_create(graph, 20);
+    unsigned int seed = 157;
+
+    // more pairs than the cache holds, so entries get evicted and refilled
+    int pairs[2 * 40];
+    for(int i = 0; i < 40; i++) {
+        pairs[2 * i] = next_rand(&seed) % graph->num_nodes;
+        pairs[2 * i + 1] = next_rand(&seed) % graph->num_nodes;
+    }
+    for(int round = 0; round < 3; round++) {
+        for(int i = 0; i < 40; i++) {
+            int p = round == 1 ? i % 10 : i;
+            if(graph->nodes[pairs[2 * p]] && graph->nodes[pairs[2 * p + 1]]) {
+                helper_route_cache(cache, graph, NULL, pairs[2 * p], pairs[2 * p + 1], test, "route_cache/testB");
+            }
+        }
+    }
+
+    route_cache_stats_t stats;
+    route_cache_get_stats(cache, &stats);
+    cr_assert(stats.entries <= 20 && stats.evictions > 0 && stats.hits > 0, "\n%s\n      (three rounds of queries over 40 pairs)\n   -> route_cache_get_stats(cache, &stats);\n      Actual: %ld entries, %ld evictions, %ld hits\n      Expected: at most 20 entries, some evictions and hits ", test, stats.entries, stats.evictions, stats.hits);
+
+    route_cache_free(cache);
+    graph_free(graph);
+}
+
+Test(route_cache, testC) 
+{   
+    graph_t *graph = grid_graph_create(30, 30, 163);
+    char *test = "      graph_t *g = grid_graph_create(30, 30, 163);\n"
+                 "      route_cache_t *cache = route_cache_create(g, 24);\n"
+                 "      (4 threads querying 32 pairs)";
+    route_cache_t *cache = route_cache_create(graph, 24);
+    unsigned int seed = 167;
+
+    int pairs[2 * 32];
+    double expected[32];
+    for(int i = 0; i < 32; i++) {
+        do {
+            pairs[2 * i] = next_rand(&seed) % graph->num_nodes;
+            pairs[2 * i + 1] = next_rand(&seed) % graph->num_nodes;
+        } while(!graph->nodes[pairs[2 * i]] || !graph->nodes[pairs[2 * i + 1]]);
+        expected[i] = a_star(graph, pairs[2 * i], pairs[2 * i + 1]);
+    }
+
+    pthread_t threads[4];
+    cache_worker_t workers[4];
+    for(int t = 0; t < 4; t++) {
+        workers[t] = (cache_worker_t){cache, pairs, expected, 32, 171 + t, 0};
+        pthread_create(&threads[t], NULL, cache_worker, &workers[t]);
+    }
+    int wrong = 0;
+    for(int t = 0; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+        wrong += workers[t].wrong;
+    }
+    cr_assert_eq(wrong, 0, "\n%s\n   -> route_cache_a_star(cache, ...);\n      Actual: %d wrong costs\n      Expected: 0 wrong costs ", test, wrong);
+
+    route_cache_stats_t stats;
+    route_cache_get_stats(cache, &stats);
+    cr_assert(stats.hits + stats.misses == 1200 && stats.entries <= 24, "\n%s\n   -> route_cache_get_stats(cache, &stats);\n      Actual: %ld hits, %ld misses, %ld entries\n      Expected: 1200 lookups, at most 24 entries ", test, stats.hits, stats.misses, stats.entries);
+
+    route_cache_free(cache);
+    graph_free(graph);
+}
+
+/* helper_search_step: runs a search in slices and checks the result and
+ *     path against a_star()
+ *
+ * graph: the graph
+ * start_node: start node
+ * end_node: send node
+ * max_expansions: expansions per slice
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_search_step(graph_t *graph, int start_node, int end_node, long max_expansions, char *test_string, char *test_name)
+{
+    search_ctx_t *ctx = search_begin(graph, start_node, end_node);
+    int steps = 1;
+    search_status_t status;
+    while((status = search_step(ctx, max_expansions)) == SEARCH_IN_PROGRESS) {
+        steps++;
+    }
+    int *path;
+    int len;
+    double actual = search_result(ctx, &path, &len);
+    double expected = a_star(graph, start_node, end_node);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n      search_ctx_t *ctx = search_begin(g, %d, %d);\n      while(search_step(ctx, %ld) == SEARCH_IN_PROGRESS);\n   -> search_result(ctx, &path, &len);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, end_node, max_expansions, test_name);
+
+    cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+    cr_assert_eq(status, expected < 0 ? SEARCH_UNREACHABLE : SEARCH_FOUND, " %s\n      Wrong final status %d ", err_msg, status);
+    cr_assert_eq(search_step(ctx, max_expansions), status, " %s\n      Status changed after the search ended ", err_msg);
+    if(expected < 0) {
+        cr_assert(len == 0 && path == NULL, " %s\n      Expected no path, got %d nodes ", err_msg, len);
+    }else {
+        double cost = 0;
+        for(int j = 0; j + 1 < len; j++) {
+            cost += h_calc(graph->nodes[path[j]], graph->nodes[path[j + 1]]);
+        }
+        cr_assert(len > 0 && path[0] == start_node && path[len - 1] == end_node, " %s\n      Path does not join the nodes ", err_msg);
+        cr_assert_float_eq(cost, expected, 0.000001, " %s\n      Path cost: %f\n      Expected: %f ", err_msg, cost, expected);
+        free(path);
+    }
+    search_end(ctx);
+}
+
+TestSuite(search_step, .timeout=60);
+
+Test(search_step, testA) 
+{   
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    node_create(graph, 4, "E", 5, 5);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      node_create(g, 4, 'E', 5, 5);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);";
+
+    // one expansion per step: A, then B and C in either order, then D
+    // is settled
+    search_ctx_t *ctx = search_begin(graph, 0, 3);
+    search_status_t first = search_step(ctx, 1);
+    double cost = search_result(ctx, NULL, NULL);
+    cr_assert(first == SEARCH_IN_PROGRESS && cost == -1, "\n%s\n      search_ctx_t *ctx = search_begin(g, 0, 3);\n   -> search_step(ctx, 1);\n      Expected: SEARCH_IN_PROGRESS, no result yet ", test);
+    int steps = 1;
+    search_status_t last;
+    while((last = search_step(ctx, 1)) == SEARCH_IN_PROGRESS) {
+        steps++;
+    }
+    int len;
+    cost = search_result(ctx, NULL, &len);
+    cr_assert(last == SEARCH_FOUND && len == 3 && steps <= 3, "\n%s\n      search_ctx_t *ctx = search_begin(g, 0, 3);\n   -> while(search_step(ctx, 1) == SEARCH_IN_PROGRESS);\n      Actual: %d steps, status %d, %d nodes on the path\n      Expected: at most 3 steps, SEARCH_FOUND with a path of 3 nodes ", test, steps, last, len);
+    cr_assert_float_eq(cost, 2.414213, 0.000001, "\n%s\n   -> search_result(ctx, NULL, &len);\n      Actual: %f\n      Expected: 2.414213 ", test, cost);
+    search_end(ctx);
+
+    helper_search_step(graph, 0, 3, 1, test, "search_step/testA");
+    helper_search_step(graph, 3, 0, 2, test, "search_step/testA");
+    helper_search_step(graph, 0, 0, 1, test, "search_step/testA");
+    helper_search_step(graph, 0, 4, 1, test, "search_step/testA");
+
+    graph_free(graph);
+}
+
+Test(search_step, testB) 
+{   
+    graph_t *graph = directed_graph_create(30, 30, 173);
+    char *test = "      graph_t *g = directed_graph_create(30, 30, 173);";
+    unsigned int seed = 179;
+
+    for(int i = 0; i < 20; i++) {
+        int start = next_rand(&seed) % graph->num_nodes;
+        int end = next_rand(&seed) % graph->num_nodes;
+        if(graph->nodes[start] && graph->nodes[end]) {
+            helper_search_step(graph, start, end, 1 + i * 7, test, "search_step/testB");
+        }
+    }
+
+    graph_free(graph);
+}
+
+Test(search_step, testC) 
+{   
+    graph_t *graph = grid_graph_create(40, 40, 181);
+    char *test = "      graph_t *g = grid_graph_create(40, 40, 181);\n"
+                 "      (three searches stepped in turn on one thread)";
+    int starts[3] = {0, 1599, 40};
+    int ends[3] = {1599, 0, 1559};
+
+    search_ctx_t *ctxs[3];
+    for(int i = 0; i < 3; i++) {
+        ctxs[i] = search_begin(graph, starts[i], ends[i]);
+    }
+    int running = 3;
+    int rounds = 0;
+    while(running > 0) {
+        running = 0;
+        for(int i = 0; i < 3; i++) {
+            running += search_step(ctxs[i], 16) == SEARCH_IN_PROGRESS;
+        }
+        rounds++;
+    }
+    cr_assert(rounds > 1, "\n%s\n   -> search_step(ctx, 16);\n      Expected the searches to take more than one slice ", test);
+
+    for(int i = 0; i < 3; i++) {
+        double actual = search_result(ctxs[i], NULL, NULL);
+        double expected = a_star(graph, starts[i], ends[i]);
+        cr_assert_float_eq(actual, expected, 0.000001, "\n%s\n   -> search_result(ctx, NULL, NULL);  (search %d to %d)\n      Actual: %f\n      Expected: %f ", test, starts[i], ends[i], actual, expected);
+        search_end(ctxs[i]);
+    }
+
+    graph_free(graph);
+}
+
+TestSuite(graph_find_node, .timeout=60);
+
+Test(graph_find_node, testA) 
+{   
+    char name[16] = "Paris";
+    graph_t *graph = graph_create(4);
+    node_create(graph, 0, name, 0, 1);
+    strcpy(name, "Lyon");
+    node_create(graph, 1, name, 0, 0);
+    node_create(graph, 2, "Nice", 1, 0);
+    node_create(graph, 3, "Lyon", 1, -1);
+
+    char *test = "      char name[16] = 'Paris';\n"
+                 "      graph_t *g = graph_create(4);\n"
+                 "      node_create(g, 0, name, 0, 1);\n"
+                 "      strcpy(name, 'Lyon');\n"
+                 "      node_create(g, 1, name, 0, 0);\n"
+                 "      node_create(g, 2, 'Nice', 1, 0);\n"
+                 "      node_create(g, 3, 'Lyon', 1, -1);";
+
+    // the graph keeps its own copy of the name
+    strcpy(name, "Rome");
+    cr_assert_str_eq(graph->nodes[0]->city_name, "Paris", "\n%s\n      strcpy(name, 'Rome');\n   -> g->nodes[0]->city_name\n      Actual: %s\n      Expected: Paris ", test, graph->nodes[0]->city_name);
+    cr_assert(graph->nodes[1]->city_name == graph->nodes[3]->city_name, "\n%s\n   -> g->nodes[1]->city_name == g->nodes[3]->city_name\n      Expected equal names to share one copy ", test);
+
+    const char *queries[5] = {"Paris", "Lyon", "Nice", "Rome", ""};
+    int expected[5] = {0, 1, 2, -1, -1};
+    for(int i = 0; i < 5; i++) {
+        int actual = graph_find_node(graph, queries[i]);
+        cr_assert_eq(actual, expected[i], "\n%s\n   -> graph_find_node(g, '%s');\n      Actual: %d\n      Expected: %d ", test, queries[i], actual, expected[i]);
+    }
+
+    graph_free(graph);
+}
+
+Test(graph_find_node, testB) 
+{   
+    int n = 5000;
+    graph_t *graph = graph_create(n + 1);
+    char name[32];
+    for(int i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "city %d", i);
+        node_create(graph, i, name, i / 100, i % 100);
+    }
+    // longer than a block of the pool
+    char *big = (char*)malloc(100000);
+    memset(big, 'a', 99999);
+    big[99999] = '\0';
+    node_create(graph, n, big, 0, 0);
+
+    char *test = "      graph_t *g = graph_create(5001);\n"
+                 "      node_create(g, i, 'city <i>', i / 100, i % 100);  (for i < 5000)\n"
+                 "      node_create(g, 5000, (99999 times 'a'), 0, 0);";
+
+    for(int i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "city %d", i);
+        int actual = graph_find_node(graph, name);
+        cr_assert_eq(actual, i, "\n%s\n   -> graph_find_node(g, '%s');\n      Actual: %d\n      Expected: %d ", test, name, actual, i);
+    }
+    int actual = graph_find_node(graph, big);
+    cr_assert_eq(actual, n, "\n%s\n   -> graph_find_node(g, (99999 times 'a'));\n      Actual: %d\n      Expected: %d ", test, actual, n);
+    actual = graph_find_node(graph, "city 5000");
+    cr_assert_eq(actual, -1, "\n%s\n   -> graph_find_node(g, 'city 5000');\n      Actual: %d\n      Expected: -1 ", test, actual);
+
+    free(big);
+    graph_free(graph);
+}
+
+/* helper_a_star_engine: checks the template instantiations against
+ *     a_star() on random queries
+ *
+ * graph: the graph
+ * num_queries: number of random queries
+ * seed: random seed for the queries
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_a_star_engine(graph_t *graph, int num_queries, unsigned int seed, char *test_string, char *test_name)
+{
+    // integer costs are rounded up to 1 / 10000 per edge
+    csr_engine_t *engines[3] = {csr_engine_create(graph, CSR_ENGINE_DOUBLE, 1),
+                                csr_engine_create(graph, CSR_ENGINE_FLOAT, 1),
+                                csr_engine_create(graph, CSR_ENGINE_INT, 10000)};
+    char *names[3] = {"CSR_ENGINE_DOUBLE, 1", "CSR_ENGINE_FLOAT, 1", "CSR_ENGINE_INT, 10000"};
+    double slack[3] = {0.000001, 0.001, 0.05};
+
+    for(int i = 0; i < num_queries; i++) {
+        int start = next_rand(&seed) % graph->num_nodes;
+        int end = next_rand(&seed) % graph->num_nodes;
+        if(!graph->nodes[start] || !graph->nodes[end]) {
+            continue;
+        }
+        double expected = a_star(graph, start, end);
+        char err_msg[ERR_MSG_LEN];
+
+        double actual = a_star_engine(graph, start, end);
+        snprintf(err_msg, ERR_MSG_LEN-1,
+                 ("\n  Functions called in failed test:\n%s\n   -> a_star_engine(g, %d, %d);\n"
+                  "\n  The filter to run this specific test is: --filter %s"), test_string, start, end, test_name);
+        cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+
+        for(int e = 0; e < 3; e++) {
+            actual = csr_engine_query(engines[e], start, end);
+            snprintf(err_msg, ERR_MSG_LEN-1,
+                     ("\n  Functions called in failed test:\n%s\n      csr_engine_t *engine = csr_engine_create(g, %s);\n   -> csr_engine_query(engine, %d, %d);\n"
+                      "\n  The filter to run this specific test is: --filter %s"), test_string, names[e], start, end, test_name);
+            if(expected < 0) {
+                cr_assert_float_eq(actual, -1, 0.000001, " %s\n      Actual: %f\n      Expected: -1 ", err_msg, actual);
+            }else {
+                cr_assert(actual > expected - slack[e] && actual < expected + slack[e], " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+            }
+        }
+    }
+
+    for(int e = 0; e < 3; e++) {
+        csr_engine_free(engines[e]);
+    }
+}
+
+TestSuite(a_star_engine, .timeout=60);
+
+Test(a_star_engine, testA) 
+{   
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    node_create(graph, 4, "E", 5, 5);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      node_create(g, 4, 'E', 5, 5);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 2, 3);";
+
+    double actual = a_star_engine(graph, 0, 3);
+    cr_assert_float_eq(actual, 2.414213, 0.000001, "\n%s\n   -> a_star_engine(g, 0, 3);\n      Actual: %f\n      Expected: 2.414213 ", test, actual);
+    actual = a_star_engine(graph, 0, 4);
+    cr_assert_float_eq(actual, -1, 0.000001, "\n%s\n   -> a_star_engine(g, 0, 4);\n      Actual: %f\n      Expected: -1 ", test, actual);
+
+    // each edge is rounded up to whole units, 14143 + 10000
+    csr_engine_t *engine = csr_engine_create(graph, CSR_ENGINE_INT, 10000);
+    actual = csr_engine_query(engine, 0, 3);
+    cr_assert_float_eq(actual, 2.4143, 0.000001, "\n%s\n      csr_engine_t *engine = csr_engine_create(g, CSR_ENGINE_INT, 10000);\n   -> csr_engine_query(engine, 0, 3);\n      Actual: %f\n      Expected: 2.4143 ", test, actual);
+    csr_engine_free(engine);
+
+    helper_a_star_engine(graph, 20, 191, test, "a_star_engine/testA");
+
+    graph_free(graph);
+}
+
+Test(a_star_engine, testB) 
+{   
+    graph_t *graph = grid_graph_create(30, 30, 193);
+    char *test = "      graph_t *g = grid_graph_create(30, 30, 193);";
+
+    helper_a_star_engine(graph, 40, 197, test, "a_star_engine/testB");
+
+    graph_free(graph);
+}
+
+Test(a_star_engine, testC) 
+{   
+    graph_t *graph = directed_graph_create(30, 30, 199);
+    char *test = "      graph_t *g = directed_graph_create(30, 30, 199);";
+
+    helper_a_star_engine(graph, 40, 211, test, "a_star_engine/testC");
+
+    graph_free(graph);
+}
+
+Test(a_star_engine, testD) 
+{   
+    // a path of 3e9 integer units, past what 32 bits hold
+    graph_t *graph = graph_create(3);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 0, 150000);
+    node_create(graph, 2, "C", 0, 300000);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 2);
+
+    char *test = "      graph_t *g = graph_create(3);\n"
+                 "      node_create(g, 0, 'A', 0, 0);\n"
+                 "      node_create(g, 1, 'B', 0, 150000);\n"
+                 "      node_create(g, 2, 'C', 0, 300000);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 1, 2);";
+
+    csr_engine_t *engine = csr_engine_create(graph, CSR_ENGINE_INT, 10000);
+    cr_assert(engine != NULL, "\n%s\n   -> csr_engine_create(g, CSR_ENGINE_INT, 10000);\n      Actual: NULL\n      Expected: an engine ", test);
+    double actual = csr_engine_query(engine, 0, 2);
+    cr_assert_float_eq(actual, 300000, 0.000001, "\n%s\n      csr_engine_t *engine = csr_engine_create(g, CSR_ENGINE_INT, 10000);\n   -> csr_engine_query(engine, 0, 2);\n      Actual: %f\n      Expected: 300000 ", test, actual);
+    csr_engine_free(engine);
+
+    // a scale at which the costs would overflow 64 bits
+    engine = csr_engine_create(graph, CSR_ENGINE_INT, 1e14);
+    cr_assert(engine == NULL, "\n%s\n   -> csr_engine_create(g, CSR_ENGINE_INT, 1e14);\n      Actual: an engine\n      Expected: NULL ", test);
+
+    graph_free(graph);
+}
+
+/* helper_huge_pages: checks a CSR graph on huge pages and its reversed
+ *     view against a_star()
+ *
+ * graph: the graph
+ * num_queries: number of random node pairs to check
+ * seed: random seed for the pairs
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_huge_pages(graph_t *graph, int num_queries, unsigned int seed, char *test_string, char *test_name)
+{
+    csr_t *csr = csr_create_alloc(graph, CSR_ALLOC_HUGE_PAGES);
+    csr_t *reverse = csr_reverse(csr);
+    char err_msg[ERR_MSG_LEN];
+
+    cr_assert_eq(csr_num_edges(csr), (long)graph->num_edges, "\n%s\n   -> csr_num_edges(csr_create_alloc(g, CSR_ALLOC_HUGE_PAGES));\n      Actual edges: %ld\n      Expected edges: %ld ", test_string, csr_num_edges(csr), (long)graph->num_edges);
+
+    for(int i = 0; i < num_queries; i++) {
+        int start = next_rand(&seed) % graph->num_nodes;
+        int end = next_rand(&seed) % graph->num_nodes;
+        double expected = a_star(graph, start, end);
+        double actual = a_star_csr(csr, start, end);
+        double backward = a_star_csr(reverse, end, start);
+
+        snprintf(err_msg, ERR_MSG_LEN-1,
+                 ("\n  Functions called in failed test:\n%s\n      csr_t *csr = csr_create_alloc(g, CSR_ALLOC_HUGE_PAGES);\n   -> a_star_csr(csr, %d, %d);\n   -> a_star_csr(csr_reverse(csr), %d, %d);\n"
+                  "\n  The filter to run this specific test is: --filter %s"), test_string, start, end, end, start, test_name);
+        cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+        cr_assert_float_eq(backward, expected, 0.000001, " %s\n      Actual reversed: %f\n      Expected: %f ", err_msg, backward, expected);
+    }
+
+    csr_free(reverse);
+    csr_free(csr);
+}
+
+TestSuite(huge_pages, .timeout=60);
+
+Test(huge_pages, testA) 
+{   
+    // blocks start on a huge page and come zeroed, whatever their size
+    size_t sizes[] = {0, 100, HUGE_PAGE_SIZE, HUGE_PAGE_SIZE + 1};
+    for(int i = 0; i < 4; i++) {
+        unsigned char *block = (unsigned char*)huge_alloc(sizes[i]);
+        cr_assert((uintptr_t)block % HUGE_PAGE_SIZE == 0, "\n      huge_alloc(%zu)\n      Actual address: %p\n      Expected: aligned to HUGE_PAGE_SIZE ", sizes[i], (void*)block);
+        size_t zeros = 0;
+        for(size_t b = 0; b < sizes[i]; b++) {
+            zeros += block[b] == 0;
+        }
+        cr_assert_eq(zeros, sizes[i], "\n      huge_alloc(%zu)\n      Actual zero bytes: %zu\n      Expected zero bytes: %zu ", sizes[i], zeros, sizes[i]);
+        if(sizes[i] > 0) {
+            block[sizes[i] - 1] = 1;
+        }
+        huge_free(block, sizes[i]);
+    }
+    huge_free(NULL, 0);
+}
+
+Test(huge_pages, testB) 
+{   
+    graph_t *graph = graph_create(4);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_arc(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_arc(graph, 3, 2);
+
+    char *test = "      graph_t *g = graph_create(4);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_arc(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_arc(g, 3, 2);";
+
+    csr_t *csr = csr_create_alloc(graph, CSR_ALLOC_HUGE_PAGES);
+    double actual = a_star_csr(csr, 3, 0);
+    cr_assert_float_eq(actual, 3, 0.000001, "\n%s\n      csr_t *csr = csr_create_alloc(g, CSR_ALLOC_HUGE_PAGES);\n   -> a_star_csr(csr, 3, 0);\n      Actual: %f\n      Expected: 3 ", test, actual);
+    actual = a_star_csr(csr, 0, 3);
+    cr_assert_float_eq(actual, -1, 0.000001, "\n%s\n      csr_t *csr = csr_create_alloc(g, CSR_ALLOC_HUGE_PAGES);\n   -> a_star_csr(csr, 0, 3);\n      Actual: %f\n      Expected: -1 ", test, actual);
+    int out[4];
+    int n = csr_neighbors(csr, 2, out);
+    cr_assert(n == 1 && out[0] == 1, "\n%s\n   -> csr_neighbors(csr, 2, out)\n      Actual count: %d\n      Expected: 1 neighbor, B ", test, n);
+    csr_free(csr);
+
+    helper_huge_pages(graph, 10, 223, test, "huge_pages/testB");
+
+    graph_free(graph);
+}
+
+Test(huge_pages, testC) 
+{   
+    graph_t *graph = directed_graph_create(30, 30, 227);
+    char *test = "      graph_t *g = directed_graph_create(30, 30, 227);";
+
+    helper_huge_pages(graph, 20, 229, test, "huge_pages/testC");
+
+    graph_free(graph);
+}
+
+/* td_reference: earliest arrival times by relaxing every edge until none
+ *     improves, which is exact for FIFO travel times
+ *
+ * graph: the graph
+ * td: the time-dependent snapshot of the graph
+ * start_node: start node
+ * depart: departure time
+ * arrival: filled with the arrival time at every node, INFINITY if not
+ *     reachable
+ */
+void td_reference(graph_t *graph, td_graph_t *td, int start_node, double depart, double *arrival)
+{
+    for(int i = 0; i < graph->num_nodes; i++) {
+        arrival[i] = INFINITY;
+    }
+    arrival[start_node] = depart;
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(int u = 0; u < graph->num_nodes; u++) {
+            if(!graph->nodes[u] || arrival[u] == INFINITY) {
+                continue;
+            }
+            for(intlist_t *nb = graph->nodes[u]->neighbors; nb; nb = nb->next) {
+                double at = arrival[u] + td_travel_time(td, nb->edge_num, arrival[u]);
+                if(at < arrival[nb->num] - 1e-12) {
+                    arrival[nb->num] = at;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+/* helper_time_dependent: gives every edge a random FIFO travel time
+ *     function and checks td_a_star() against td_reference()
+ *
+ * graph: the graph
+ * num_queries: number of random node pairs and departure times to check
+ * seed: random seed for the functions and queries
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_time_dependent(graph_t *graph, int num_queries, unsigned int seed, char *test_string, char *test_name)
+{
+    double period = 100;
+    td_graph_t *td = td_graph_create(graph, period);
+    double times[6], costs[6];
+    char err_msg[ERR_MSG_LEN];
+
+    // breakpoints at least period / 12 apart and costs between 0.5 and 2,
+    // which fall slower than time passes
+    for(int e = 0; e < graph->num_edges; e++) {
+        int n = 1 + next_rand(&seed) % 6;
+        for(int i = 0; i < n; i++) {
+            times[i] = (i + (next_rand(&seed) % 50) / 100.0) * period / n;
+            costs[i] = 0.5 + (next_rand(&seed) % 1000) / 666.0;
+        }
+        int status = td_set_profile(td, e, n, times, costs);
+        cr_assert_eq(status, 0, "\n%s\n   -> td_set_profile(td, %d, %d, ...);\n      Actual: %d\n      Expected: 0 ", test_string, e, n, status);
+    }
+
+    double *arrival = (double*)malloc(sizeof(double) * graph->num_nodes);
+    for(int i = 0; i < num_queries; i++) {
+        int start = next_rand(&seed) % graph->num_nodes;
+        int end = next_rand(&seed) % graph->num_nodes;
+        double depart = (next_rand(&seed) % 3000) / 10.0;
+        td_reference(graph, td, start, depart, arrival);
+        double expected = arrival[end] == INFINITY ? -1 : arrival[end];
+        double actual = td_a_star(td, start, end, depart);
+
+        snprintf(err_msg, ERR_MSG_LEN-1,
+                 ("\n  Functions called in failed test:\n%s\n      td_graph_t *td = td_graph_create(g, %.0f);\n      (random profiles)\n   -> td_a_star(td, %d, %d, %f);\n"
+                  "\n  The filter to run this specific test is: --filter %s"), test_string, period, start, end, depart, test_name);
+        cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+    }
+
+    free(arrival);
+    td_graph_free(td);
+}
+
+TestSuite(time_dependent, .timeout=60);
+
+Test(time_dependent, testA) 
+{   
+    graph_t *graph = graph_create(3);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 0, 1);
+    node_create(graph, 2, "C", 1, 0);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 2, 1);
+
+    char *test = "      graph_t *g = graph_create(3);\n"
+                 "      node_create(g, 0, 'A', 0, 0);\n"
+                 "      node_create(g, 1, 'B', 0, 1);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 2, 1);\n"
+                 "      td_graph_t *td = td_graph_create(g, 100);\n"
+                 "      td_set_profile(td, 0, 4, {0, 10, 20, 30}, {1, 1, 9, 1});";
+
+    // A-B is jammed around time 20, when going round by C is faster
+    td_graph_t *td = td_graph_create(graph, 100);
+    double times[] = {0, 10, 20, 30};
+    double costs[] = {1, 1, 9, 1};
+    int status = td_set_profile(td, 0, 4, times, costs);
+    cr_assert_eq(status, 0, "\n%s\n      Actual: %d\n      Expected: 0 ", test, status);
+
+    double at[] = {5, 15, 25, 50, -85, 115};
+    double cost[] = {1, 5, 5, 1, 5, 5};
+    for(int i = 0; i < 6; i++) {
+        double actual = td_travel_time(td, 0, at[i]);
+        cr_assert_float_eq(actual, cost[i], 0.000001, "\n%s\n   -> td_travel_time(td, 0, %.0f);\n      Actual: %f\n      Expected: %f ", test, at[i], actual, cost[i]);
+    }
+    double actual = td_travel_time(td, 2, 20);
+    cr_assert_float_eq(actual, sqrt(2), 0.000001, "\n%s\n   -> td_travel_time(td, 2, 20);\n      Actual: %f\n      Expected: 1.414214 ", test, actual);
+
+    double depart[] = {0, 15, 20, 215};
+    double arrive[] = {1, 15 + 1 + sqrt(2), 20 + 1 + sqrt(2), 215 + 1 + sqrt(2)};
+    for(int i = 0; i < 4; i++) {
+        actual = td_a_star(td, 0, 1, depart[i]);
+        cr_assert_float_eq(actual, arrive[i], 0.000001, "\n%s\n   -> td_a_star(td, 0, 1, %.0f);\n      Actual: %f\n      Expected: %f ", test, depart[i], actual, arrive[i]);
+    }
+
+    // rejected functions leave the edge as it was: falling faster than
+    // time passes, out of order, past the period, a negative cost
+    double bad_times[][2] = {{0, 10}, {10, 5}, {0, 100}, {0, 10}};
+    double bad_costs[][2] = {{20, 1}, {1, 1}, {1, 1}, {1, -1}};
+    for(int i = 0; i < 4; i++) {
+        status = td_set_profile(td, 0, 2, bad_times[i], bad_costs[i]);
+        cr_assert_eq(status, -1, "\n%s\n   -> td_set_profile(td, 0, 2, {%.0f, %.0f}, {%.0f, %.0f});\n      Actual: %d\n      Expected: -1 ", test, bad_times[i][0], bad_times[i][1], bad_costs[i][0], bad_costs[i][1], status);
+    }
+    actual = td_travel_time(td, 0, 15);
+    cr_assert_float_eq(actual, 5, 0.000001, "\n%s\n   -> td_travel_time(td, 0, 15);\n      Actual: %f\n      Expected: 5 ", test, actual);
+
+    // a fast edge lowers the heuristic, so the search stays exact
+    double fast_time = 0, fast_cost = 0.25;
+    td_set_profile(td, 1, 1, &fast_time, &fast_cost);
+    actual = td_a_star(td, 0, 1, 20);
+    cr_assert_float_eq(actual, 20 + 0.25 + sqrt(2), 0.000001, "\n%s\n      td_set_profile(td, 1, 1, {0}, {0.25});\n   -> td_a_star(td, 0, 1, 20);\n      Actual: %f\n      Expected: %f ", test, actual, 20 + 0.25 + sqrt(2));
+
+    td_graph_free(td);
+    graph_free(graph);
+}
+
+Test(time_dependent, testB) 
+{   
+    graph_t *graph = directed_graph_create(20, 20, 233);
+    char *test = "      graph_t *g = directed_graph_create(20, 20, 233);";
+
+    helper_time_dependent(graph, 30, 239, test, "time_dependent/testB");
+
+    graph_free(graph);
+}
+
+Test(time_dependent, testC) 
+{   
+    graph_t *graph = grid_graph_create(30, 30, 241);
+    char *test = "      graph_t *g = grid_graph_create(30, 30, 241);";
+    td_graph_t *td = td_graph_create(graph, 86400);
+    unsigned int seed = 251;
+
+    // without profiles every edge takes its length, as in a_star()
+    for(int i = 0; i < 20; i++) {
+        int start = next_rand(&seed) % 900;
+        int end = next_rand(&seed) % 900;
+        double expected = a_star(graph, start, end);
+        double actual = td_a_star(td, start, end, 1000);
+        if(expected >= 0) {
+            expected += 1000;
+        }
+        cr_assert_float_eq(actual, expected, 0.000001, "\n%s\n      td_graph_t *td = td_graph_create(g, 86400);\n   -> td_a_star(td, %d, %d, 1000);\n      Actual: %f\n      Expected: %f ", test, start, end, actual, expected);
+    }
+
+    td_graph_free(td);
+    graph_free(graph);
+}
+
+typedef struct {
+    char *path;
+    csr_t *csr;
+    int *pairs;
+    double *expected;
+    int num_pairs;
+    unsigned int seed;
+    int wrong;
+} server_client_t;
+
+/* server_client: sends batches of random queries from a list of pairs to
+ *     a server, counting wrong answers
+ *
+ * arg: the client (server_client_t*)
+ */
+void *server_client(void *arg)
+{
+    server_client_t *c = (server_client_t*)arg;
+    route_client_t *client = route_client_connect(c->path);
+    if(client == NULL) {
+        c->wrong = -1;
+        return NULL;
+    }
+    int starts[50], ends[50], picks[50];
+    double costs[50];
+    for(int b = 0; b < 20; b++) {
+        int count = 1 + next_rand(&c->seed) % 50;
+        for(int i = 0; i < count; i++) {
+            picks[i] = next_rand(&c->seed) % c->num_pairs;
+            starts[i] = c->pairs[2 * picks[i]];
+            ends[i] = c->pairs[2 * picks[i] + 1];
+        }
+        if(route_client_query(client, count, starts, ends, costs) != 0) {
+            c->wrong = -1;
+            break;
+        }
+        for(int i = 0; i < count; i++) {
+            c->wrong += fabs(costs[i] - c->expected[picks[i]]) > 0.000001;
+        }
+    }
+    route_client_close(client);
+    return NULL;
+}
+
+/* serve_thread: runs a server until it is stopped
+ *
+ * arg: the server (route_server_t*)
+ */
+void *serve_thread(void *arg)
+{
+    route_server_run((route_server_t*)arg);
+    return NULL;
+}
+
+/* helper_route_server: serves a graph with a number of threads and checks
+ *     the answers of concurrent clients against a_star_csr()
+ *
+ * graph: the graph
+ * num_threads: number of server threads
+ * num_clients: number of clients, each on its own thread
+ * seed: random seed for the queries
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_route_server(graph_t *graph, int num_threads, int num_clients, unsigned int seed, char *test_string, char *test_name)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/a_star_test_%d.sock", (int)getpid());
+    csr_t *csr = csr_create(graph);
+    route_server_t *server = route_server_create(csr, path, num_threads);
+    cr_assert(server != NULL, "\n      route_server_create(csr, \"%s\", %d) failed ", path, num_threads);
+    pthread_t server_thread;
+    pthread_create(&server_thread, NULL, serve_thread, server);
+
+    // a node that does not exist, or out of range, gets -1
+    int pairs[64];
+    double expected[32];
+    for(int p = 0; p < 32; p++) {
+        pairs[2 * p] = next_rand(&seed) % graph->num_nodes;
+        pairs[2 * p + 1] = p == 0 ? -5 : p == 1 ? graph->num_nodes : (int)(next_rand(&seed) % graph->num_nodes);
+        expected[p] = p < 2 ? -1 : a_star_csr(csr, pairs[2 * p], pairs[2 * p + 1]);
+    }
+
+    pthread_t threads[8];
+    server_client_t clients[8];
+    for(int t = 0; t < num_clients; t++) {
+        clients[t] = (server_client_t){path, csr, pairs, expected, 32, seed + t, 0};
+        pthread_create(&threads[t], NULL, server_client, &clients[t]);
+    }
+    int wrong = 0;
+    for(int t = 0; t < num_clients; t++) {
+        pthread_join(threads[t], NULL);
+        cr_assert(clients[t].wrong >= 0, "\n%s\n      route_server_create(csr, path, %d);\n   -> client %d: connection failed\n\n  The filter to run this specific test is: --filter %s", test_string, num_threads, t, test_name);
+        wrong += clients[t].wrong;
+    }
+    cr_assert_eq(wrong, 0, "\n%s\n      route_server_create(csr, path, %d);\n   -> route_client_query(client, ...);\n      Actual: %d wrong costs\n      Expected: 0 wrong costs\n\n  The filter to run this specific test is: --filter %s", test_string, num_threads, wrong, test_name);
+
+    route_client_t *client = route_client_connect(path);
+    int n = route_client_num_nodes(client);
+    cr_assert_eq(n, graph->num_nodes, "\n%s\n   -> route_client_num_nodes(client);\n      Actual: %d\n      Expected: %d ", test_string, n, graph->num_nodes);
+    route_client_close(client);
+
+    route_server_stop(server);
+    pthread_join(server_thread, NULL);
+    route_server_free(server);
+    csr_free(csr);
+}
+
+TestSuite(route_server, .timeout=60);
+
+Test(route_server, testA) 
+{   
+    graph_t *graph = graph_create(4);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 2);
+
+    char *test = "      graph_t *g = graph_create(4);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      route_server_t *server = route_server_create(csr_create(g), path, 1);";
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/a_star_test_%d.sock", (int)getpid());
+    csr_t *csr = csr_create(graph);
+    route_server_t *server = route_server_create(csr, path, 1);
+    cr_assert(server != NULL, "\n%s\n      route_server_create failed ", test);
+    pthread_t server_thread;
+    pthread_create(&server_thread, NULL, serve_thread, server);
+
+    route_client_t *client = route_client_connect(path);
+    cr_assert(client != NULL, "\n%s\n   -> route_client_connect(path);\n      Actual: NULL ", test);
+    int starts[] = {0, 2, 0, 3, 7};
+    int ends[] = {2, 0, 3, 3, 0};
+    double expected[] = {2, 2, -1, 0, -1};
+    double costs[5];
+    int status = route_client_query(client, 5, starts, ends, costs);
+    cr_assert_eq(status, 0, "\n%s\n   -> route_client_query(client, 5, ...);\n      Actual: %d\n      Expected: 0 ", test, status);
+    for(int i = 0; i < 5; i++) {
+        cr_assert_float_eq(costs[i], expected[i], 0.000001, "\n%s\n   -> route_client_query(client, 5, ...);\n      Actual cost %d to %d: %f\n      Expected: %f ", test, starts[i], ends[i], costs[i], expected[i]);
+    }
+
+    // a frame with a bad magic closes that connection only
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strcpy(addr.sun_path, path);
+    cr_assert_eq(connect(fd, (struct sockaddr*)&addr, sizeof(addr)), 0, "\n      connect failed ");
+    uint32_t bad[2] = {0x12345678, 1};
+    cr_assert_eq(write(fd, bad, sizeof(bad)), (ssize_t)sizeof(bad), "\n      write failed ");
+    char byte;
+    ssize_t got = read(fd, &byte, 1);
+    cr_assert_eq(got, 0, "\n%s\n   -> send a frame with a bad magic\n      Actual read: %zd\n      Expected: 0, closed ", test, got);
+    close(fd);
+
+    status = route_client_query(client, 5, starts, ends, costs);
+    cr_assert(status == 0 && costs[0] == 2, "\n%s\n   -> route_client_query(client, 5, ...) after another client was dropped\n      Actual: %d, %f\n      Expected: 0, 2 ", test, status, costs[0]);
+    route_client_close(client);
+
+    route_server_stop(server);
+    pthread_join(server_thread, NULL);
+    route_server_free(server);
+    client = route_client_connect(path);
+    cr_assert(client == NULL, "\n%s\n      route_server_free(server);\n   -> route_client_connect(path);\n      Actual: connected\n      Expected: NULL ", test);
+
+    csr_free(csr);
+    graph_free(graph);
+}
+
+Test(route_server, testB) 
+{   
+    graph_t *graph = directed_graph_create(25, 25, 269);
+    char *test = "      graph_t *g = directed_graph_create(25, 25, 269);";
+
+    helper_route_server(graph, 1, 3, 271, test, "route_server/testB");
+
+    graph_free(graph);
+}
+
+Test(route_server, testC) 
+{   
+    graph_t *graph = grid_graph_create(25, 25, 277);
+    char *test = "      graph_t *g = grid_graph_create(25, 25, 277);";
+
+    helper_route_server(graph, 4, 6, 281, test, "route_server/testC");
+
+    graph_free(graph);
+}
+
+Test(route_server, testD) 
+{   
+    graph_t *graph = grid_graph_create(5, 5, 283);
+    csr_t *csr = csr_create(graph);
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/a_star_test_%d.sock", (int)getpid());
+
+    // a regular file at the path is not the server's to replace
+    FILE *file = fopen(path, "w");
+    cr_assert(file != NULL, "\n      fopen failed ");
+    fputs("a graph", file);
+    fclose(file);
+    route_server_t *server = route_server_create(csr, path, 1);
+    cr_assert(server == NULL, "\n      (a regular file at path)\n   -> route_server_create(csr, path, 1);\n      Actual: a server\n      Expected: NULL ");
+    char buf[16] = {0};
+    file = fopen(path, "r");
+    cr_assert(file != NULL && fgets(buf, sizeof(buf), file) && strcmp(buf, "a graph") == 0,
+              "\n      (a regular file at path)\n      route_server_create(csr, path, 1);\n      Expected the file to be left alone ");
+    fclose(file);
+    unlink(path);
+
+    // a socket left behind by an earlier server is replaced
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strcpy(addr.sun_path, path);
+    cr_assert_eq(bind(fd, (struct sockaddr*)&addr, sizeof(addr)), 0, "\n      bind failed ");
+    close(fd);
+    server = route_server_create(csr, path, 1);
+    cr_assert(server != NULL, "\n      (a stale socket at path)\n   -> route_server_create(csr, path, 1);\n      Actual: NULL\n      Expected: a server ");
+    route_server_free(server);
+
+    csr_free(csr);
+    graph_free(graph);
+}
+
+/* helper_a_star_compact: checks a compact graph against a_star()
+ *
+ * graph: the graph
+ * start_node: start node
+ * end_node: send node
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_a_star_compact(graph_t *graph, int start_node, int end_node, char *test_string, char *test_name)
+{
+    compact_t *cg = compact_create(graph);
+    double actual = a_star_compact(cg, start_node, end_node);
+    double expected = a_star(graph, start_node, end_node);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n      compact_t *cg = compact_create(g);\n   -> a_star_compact(cg, %d, %d);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, start_node, end_node, test_name);
+
+    // the rounded coordinates move each cost by far less than 1e-6
+    cr_assert_float_eq(actual, expected, 0.000001, " %s\n      Actual: %f\n      Expected: %f ", err_msg, actual, expected);
+
+    compact_free(cg);
+}
+
+TestSuite(compact_graph, .timeout=60);
+
+Test(compact_graph, testA) 
+{   
+    graph_t *graph = graph_create(6);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    node_create(graph, 5, "E", 3, 3);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 0, 2);
+    add_edge(graph, 1, 2);
+    add_arc(graph, 2, 3);
+
+    char *test = "      graph_t *g = graph_create(6);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      node_create(g, 5, 'E', 3, 3);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 0, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_arc(g, 2, 3);";
+    helper_a_star_compact(graph, 0, 3, test, "compact_graph/testA");
+    helper_a_star_compact(graph, 3, 0, test, "compact_graph/testA");
+    helper_a_star_compact(graph, 0, 5, test, "compact_graph/testA");
+    helper_a_star_compact(graph, 1, 1, test, "compact_graph/testA");
+    graph_free(graph);
+
+    graph = grid_graph_create(40, 40, 41);
+    test = "      graph_t *g = grid_graph_create(40, 40, 41);";
+    unsigned int seed = 43;
+    for(int i = 0; i < 10; i++) {
+        int start = next_rand(&seed) % 1600;
+        int end = next_rand(&seed) % 1600;
+        helper_a_star_compact(graph, start, end, test, "compact_graph/testA");
+    }
+    graph_free(graph);
+}
+
+Test(compact_graph, testB) 
+{   
+    graph_t *graph = graph_create(6);
+    node_create(graph, 0, "Paris", 48.8566, 2.3522);
+    node_create(graph, 1, "Lyon", 45.7640, 4.8357);
+    node_create(graph, 2, "Paris", 48.8600, 2.3400);
+    node_create(graph, 4, NULL, 43.2965, 5.3698);
+    node_create(graph, 5, "Nice", 43.7102, 7.2620);
+    compact_t *cg = compact_create(graph);
+    char *test = "      graph_t *g = graph_create(6);\n"
+                 "      node_create(g, 0, 'Paris', 48.8566, 2.3522);\n"
+                 "      node_create(g, 1, 'Lyon', 45.7640, 4.8357);\n"
+                 "      node_create(g, 2, 'Paris', 48.8600, 2.3400);\n"
+                 "      node_create(g, 4, NULL, 43.2965, 5.3698);\n"
+                 "      node_create(g, 5, 'Nice', 43.7102, 7.2620);\n"
+                 "      compact_t *cg = compact_create(g);";
+
+    char *names[] = {"Paris", "Lyon", "Paris", NULL, NULL, "Nice"};
+    for(int u = 0; u < 6; u++) {
+        const char *actual = compact_node_name(cg, u);
+        if(names[u] == NULL) {
+            cr_assert_null(actual, "\n%s\n   -> compact_node_name(cg, %d);\n      Actual: %s\n      Expected: NULL ", test, u, actual);
+        }else {
+            cr_assert(actual && strcmp(actual, names[u]) == 0, "\n%s\n   -> compact_node_name(cg, %d);\n      Actual: %s\n      Expected: %s ", test, u, actual ? actual : "NULL", names[u]);
+        }
+    }
+    cr_assert_eq(compact_node_name(cg, 0), compact_node_name(cg, 2), "\n%s\n   -> compact_node_name(cg, 0) == compact_node_name(cg, 2);\n      Expected the two nodes to share one copy of the name ", test);
+
+    // rounded to 1 / 2^32 of the 4.9 degree side of the box
+    for(int u = 0; u < 6; u++) {
+        if(graph->nodes[u] == NULL) {
+            continue;
+        }
+        double lat, lon;
+        compact_coordinates(cg, u, &lat, &lon);
+        cr_assert_float_eq(lat, graph->nodes[u]->latitude, 1e-8, "\n%s\n   -> compact_coordinates(cg, %d, &lat, &lon);\n      Actual latitude: %.10f\n      Expected: %.10f ", test, u, lat, graph->nodes[u]->latitude);
+        cr_assert_float_eq(lon, graph->nodes[u]->longitude, 1e-8, "\n%s\n   -> compact_coordinates(cg, %d, &lat, &lon);\n      Actual longitude: %.10f\n      Expected: %.10f ", test, u, lon, graph->nodes[u]->longitude);
+    }
+
+    compact_free(cg);
+    graph_free(graph);
+}
+
+Test(compact_graph, testC) 
+{   
+    graph_t *graph = grid_graph_create(30, 30, 47);
+    char *test = "      graph_t *g = grid_graph_create(30, 30, 47);\n"
+                 "      graph_memory_t m;";
+    graph_memory_t m;
+    graph_memory_report(graph, &m);
+
+    size_t nodes = 900 * sizeof(node_t);
+    size_t neighbors = 2 * graph->num_edges * sizeof(intlist_t);
+    size_t sum = m.table + m.nodes + m.neighbors + m.names + m.search + m.overhead;
+    cr_assert_eq(m.nodes, nodes, "\n%s\n   -> graph_memory_report(g, &m);\n      Actual m.nodes: %zu\n      Expected: %zu ", test, m.nodes, nodes);
+    cr_assert_eq(m.neighbors, neighbors, "\n%s\n   -> graph_memory_report(g, &m);\n      Actual m.neighbors: %zu\n      Expected: %zu ", test, m.neighbors, neighbors);
+    cr_assert(m.table >= 900 * sizeof(node_t*) && m.names > 0 && m.overhead > 0, "\n%s\n   -> graph_memory_report(g, &m);\n      Actual m.table: %zu, m.names: %zu, m.overhead: %zu\n      Expected every component counted ", test, m.table, m.names, m.overhead);
+    cr_assert_eq(m.total, sum, "\n%s\n   -> graph_memory_report(g, &m);\n      Actual m.total: %zu\n      Expected the sum of the components: %zu ", test, m.total, sum);
+
+    // a search leaves its context in the pool
+    size_t search = m.search;
+    a_star_masked(graph, 0, 899, NULL);
+    graph_memory_report(graph, &m);
+    cr_assert(m.search >= search + 900 * sizeof(double), "\n%s\n      a_star_masked(g, 0, 899, NULL);\n   -> graph_memory_report(g, &m);\n      Actual m.search: %zu\n      Expected at least: %zu ", test, m.search, search + 900 * sizeof(double));
+
+    graph_memory_t c;
+    compact_t *cg = compact_create(graph);
+    compact_memory_report(cg, &c);
+    sum = c.table + c.nodes + c.neighbors + c.names + c.search + c.overhead;
+    cr_assert_eq(c.total, sum, "\n%s\n      compact_t *cg = compact_create(g);\n   -> compact_memory_report(cg, &c);\n      Actual c.total: %zu\n      Expected the sum of the components: %zu ", test, c.total, sum);
+    size_t graph_bytes = m.total - m.search;
+    cr_assert(c.total * 4 < graph_bytes, "\n%s\n      compact_t *cg = compact_create(g);\n   -> compact_memory_report(cg, &c);\n      Actual c.total: %zu\n      Expected under a quarter of the graph's %zu bytes without search state ", test, c.total, graph_bytes);
+
+    compact_free(cg);
+    graph_free(graph);
+}
+
+/* The edges of a graph for csr_builder tests, and how to deal them out
+ * to the threads adding them
+ */
+typedef struct {
+    csr_builder_t *builder;
+    int num_edges;
+    int *from;
+    int *to;
+    bool *two_way;
+    bool round_robin;   // edge i to thread i % threads, else in blocks
+} build_edges_t;
+
+/* build_edges_create: list the edges of a graph, each once, like
+ *     csr_create sees them
+ *
+ * graph: the graph
+ * 
+ * Returns: the edges, without a builder yet
+ */
+build_edges_t build_edges_create(graph_t *graph)
+{
+    build_edges_t e = {NULL, 0, NULL, NULL, NULL, false};
+    int *uses = (int*)calloc(graph->num_edges + 1, sizeof(int));
+    e.from = (int*)malloc(sizeof(int) * (graph->num_edges + 1));
+    e.to = (int*)malloc(sizeof(int) * (graph->num_edges + 1));
+    e.two_way = (bool*)malloc(sizeof(bool) * (graph->num_edges + 1));
+    for(int u = 0; u < graph->num_nodes; u++) {
+        for(intlist_t *nb = graph->nodes[u] ? graph->nodes[u]->neighbors : NULL; nb; nb = nb->next) {
+            uses[nb->edge_num]++;
+        }
+    }
+    bool *listed = (bool*)calloc(graph->num_edges + 1, sizeof(bool));
+    for(int u = 0; u < graph->num_nodes; u++) {
+        for(intlist_t *nb = graph->nodes[u] ? graph->nodes[u]->neighbors : NULL; nb; nb = nb->next) {
+            if(!listed[nb->edge_num]) {
+                listed[nb->edge_num] = true;
+                e.from[e.num_edges] = u;
+                e.to[e.num_edges] = nb->num;
+                e.two_way[e.num_edges] = uses[nb->edge_num] > 1;
+                e.num_edges++;
+            }
+        }
+    }
+    free(uses);
+    free(listed);
+    return e;
+}
+
+/* build_edges_add: add a share of the edges, run by every thread of a pool
+ *
+ * tid: thread index, used as the builder buffer
+ * arg: the edges (build_edges_t*)
+ */
+void build_edges_add(int tid, void *arg)
+{
+    build_edges_t *e = (build_edges_t*)arg;
+    int threads = csr_builder_num_buffers(e->builder);
+    for(int i = 0; i < e->num_edges; i++) {
+        int owner = e->round_robin ? i % threads : (int)((long)i * threads / e->num_edges);
+        if(owner != tid) {
+            continue;
+        }
+        if(e->two_way[i]) {
+            csr_builder_add_edge(e->builder, tid, e->to[i], e->from[i]);
+        }else {
+            csr_builder_add_arc(e->builder, tid, e->from[i], e->to[i]);
+        }
+    }
+}
+
+/* build_from_graph: build a CSR graph from the nodes and edges of a graph
+ *     with csr_builder, adding the edges from several threads at once
+ *
+ * graph: the graph
+ * num_threads: builder threads
+ * round_robin: deal the edges round robin rather than in blocks
+ * alloc: memory of the graph
+ * clean: NULL to keep every edge, else filled with the edges dropped
+ * 
+ * Returns: the CSR graph
+ */
+csr_t *build_from_graph(graph_t *graph, int num_threads, bool round_robin, csr_alloc_t alloc, graph_clean_t *clean)
+{
+    build_edges_t e = build_edges_create(graph);
+    e.builder = csr_builder_create(graph->num_nodes, num_threads);
+    e.round_robin = round_robin;
+    for(int u = graph->num_nodes - 1; u >= 0; u--) {
+        if(graph->nodes[u]) {
+            csr_builder_add_node(e.builder, u, graph->nodes[u]->latitude, graph->nodes[u]->longitude);
+        }
+    }
+    tpool_t *pool = tpool_create(csr_builder_num_buffers(e.builder));
+    tpool_run(pool, build_edges_add, &e);
+    tpool_free(pool);
+    csr_t *csr = csr_builder_finish(e.builder, alloc, clean);
+    free(e.from);
+    free(e.to);
+    free(e.two_way);
+    return csr;
+}
+
+/* helper_csr_builder: checks a CSR graph built with csr_builder against
+ *     csr_create on the same graph
+ *
+ * graph: the graph
+ * num_threads: builder threads
+ * num_queries: random queries to compare
+ * seed: random seed
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_csr_builder(graph_t *graph, int num_threads, int num_queries, unsigned int seed, char *test_string, char *test_name)
+{
+    csr_t *expected_csr = csr_create(graph);
+    csr_t *csr = build_from_graph(graph, num_threads, false, CSR_ALLOC_DEFAULT, NULL);
+    csr_t *reverse = csr_reverse(csr);
+    char err_msg[ERR_MSG_LEN];
+
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n      csr_builder_t *b = csr_builder_create(g->num_nodes, %d);\n"
+              "      (nodes and edges of g added from %d threads)\n   -> csr_t *csr = csr_builder_finish(b, CSR_ALLOC_DEFAULT, NULL);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, num_threads, num_threads, test_name);
+
+    cr_assert_eq(csr_num_edges(csr), csr_num_edges(expected_csr), " %s\n      Actual edges: %ld\n      Expected edges: %ld ", err_msg, csr_num_edges(csr), csr_num_edges(expected_csr));
+
+    // the same neighbors, in any order
+    int n = graph->num_nodes;
+    int *actual_nb = (int*)malloc(sizeof(int) * (2 * graph->num_edges + 1));
+    int *expected_nb = (int*)malloc(sizeof(int) * (2 * graph->num_edges + 1));
+    for(int u = 0; u < n; u++) {
+        cr_assert_eq(csr_has_node(csr, u), graph->nodes[u] != NULL, " %s\n   -> csr_has_node(csr, %d);\n      Actual: %d ", err_msg, u, csr_has_node(csr, u));
+        if(!graph->nodes[u]) {
+            continue;
+        }
+        int count = csr_neighbors(csr, u, actual_nb);
+        int expected_count = csr_neighbors(expected_csr, u, expected_nb);
+        cr_assert_eq(count, expected_count, " %s\n   -> csr_neighbors(csr, %d, out);\n      Actual count: %d\n      Expected count: %d ", err_msg, u, count, expected_count);
+        long sum = 0, expected_sum = 0;
+        for(int i = 0; i < count; i++) {
+            sum += (long)actual_nb[i] * actual_nb[i] + 1;
+            expected_sum += (long)expected_nb[i] * expected_nb[i] + 1;
+        }
+        cr_assert_eq(sum, expected_sum, " %s\n   -> csr_neighbors(csr, %d, out);\n      Expected the neighbors csr_create gives ", err_msg, u);
+    }
+    free(actual_nb);
+    free(expected_nb);
+
+    for(int i = 0; i < num_queries; i++) {
+        int start, end;
+        do {
+            start = next_rand(&seed) % n;
+            end = next_rand(&seed) % n;
+        } while(!graph->nodes[start] || !graph->nodes[end]);
+        double expected = a_star_csr(expected_csr, start, end);
+        double actual = a_star_csr(csr, start, end);
+        double backward = a_star_csr(reverse, end, start);
+        cr_assert_float_eq(actual, expected, 0.000001, " %s\n   -> a_star_csr(csr, %d, %d);\n      Actual: %f\n      Expected: %f ", err_msg, start, end, actual, expected);
+        cr_assert_float_eq(backward, expected, 0.000001, " %s\n   -> a_star_csr(csr_reverse(csr), %d, %d);\n      Actual: %f\n      Expected: %f ", err_msg, end, start, backward, expected);
+    }
+
+    csr_free(reverse);
+    csr_free(csr);
+    csr_free(expected_csr);
+}
+
+TestSuite(csr_builder, .timeout=60);
+
+Test(csr_builder, testA) 
+{   
+    graph_t *graph = graph_create(6);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 3, "D", 1, -1);
+    node_create(graph, 5, "E", 2, -1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 2, 0);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 3, 3);
+    add_arc(graph, 2, 3);
+    add_arc(graph, 5, 3);
+
+    char *test = "      graph_t *g = graph_create(6);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 3, 'D', 1, -1);\n"
+                 "      node_create(g, 5, 'E', 2, -1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 2, 0);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 1, 2);\n"
+                 "      add_edge(g, 3, 3);\n"
+                 "      add_arc(g, 2, 3);\n"
+                 "      add_arc(g, 5, 3);";
+    helper_csr_builder(graph, 1, 20, 269, test, "csr_builder/testA");
+    helper_csr_builder(graph, 3, 20, 271, test, "csr_builder/testA");
+
+    graph_free(graph);
+}
+
+Test(csr_builder, testB) 
+{   
+    graph_t *graph = directed_graph_create(40, 40, 277);
+    char *test = "      graph_t *g = directed_graph_create(40, 40, 277);";
+    helper_csr_builder(graph, 4, 20, 281, test, "csr_builder/testB");
+    graph_free(graph);
+
+    graph = grid_graph_create(30, 30, 283);
+    test = "      graph_t *g = grid_graph_create(30, 30, 283);";
+    helper_csr_builder(graph, 2, 20, 293, test, "csr_builder/testB");
+    graph_free(graph);
+}
+
+Test(csr_builder, testC) 
+{   
+    graph_t *graph = directed_graph_create(25, 25, 307);
+    char *test = "      graph_t *g = directed_graph_create(25, 25, 307);";
+
+    // the graph does not depend on the threads or how edges are dealt out
+    char *saved[3];
+    size_t sizes[3];
+    int threads[] = {1, 4, 3};
+    for(int k = 0; k < 3; k++) {
+        csr_t *csr = build_from_graph(graph, threads[k], k == 2, k == 2 ? CSR_ALLOC_HUGE_PAGES : CSR_ALLOC_DEFAULT, NULL);
+        FILE *file = tmpfile();
+        cr_assert(file != NULL, "\n      tmpfile() failed");
+        cr_assert_eq(csr_save(csr, file), 0, "\n%s\n   -> csr_save(csr, file);\n      csr_save failed ", test);
+        sizes[k] = ftell(file);
+        saved[k] = (char*)malloc(sizes[k]);
+        rewind(file);
+        cr_assert_eq(fread(saved[k], 1, sizes[k], file), sizes[k], "\n      fread failed");
+        fclose(file);
+        csr_free(csr);
+    }
+    for(int k = 1; k < 3; k++) {
+        cr_assert(sizes[k] == sizes[0] && memcmp(saved[k], saved[0], sizes[0]) == 0,
+                  "\n%s\n      (built with csr_builder from 1 and from %d threads%s)\n   -> csr_save(csr, file);\n      Expected the same bytes both times ",
+                  test, threads[k], k == 2 ? ", edges dealt round robin, on huge pages" : "");
+    }
+    for(int k = 0; k < 3; k++) {
+        free(saved[k]);
+    }
+
+    graph_free(graph);
+}
+
+/* add_clutter: add arcs repeating neighbor list entries, and self-loops,
+ *     each of which graph_clean removes
+ *
+ * graph: the graph
+ * count: the number of arcs and self-loops to add
+ * seed: random seed
+ * duplicates: set to the number of repeated arcs added
+ * self_loops: set to the number of self-loops added
+ */
+void add_clutter(graph_t *graph, int count, unsigned int seed, long *duplicates, long *self_loops)
+{
+    *duplicates = 0;
+    *self_loops = 0;
+    for(int i = 0; i < count; i++) {
+        int u;
+        do {
+            u = next_rand(&seed) % graph->num_nodes;
+        } while(!graph->nodes[u] || !graph->nodes[u]->neighbors);
+        switch(next_rand(&seed) % 3) {
+            case 0:  add_arc(graph, u, graph->nodes[u]->neighbors->num); (*duplicates)++; break;
+            case 1:  add_arc(graph, u, u); (*self_loops)++; break;
+            default: add_edge(graph, u, u); (*self_loops)++; break;
+        }
+    }
+}
+
+/* helper_graph_clean: cleans a graph with csr_builder and graph_clean,
+ *     and checks the edges removed, and that costs do not change
+ *
+ * graph: the graph, cleaned
+ * num_threads: builder threads
+ * num_queries: random queries to compare
+ * seed: random seed
+ * duplicates: expected duplicates
+ * self_loops: expected self-loops
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_graph_clean(graph_t *graph, int num_threads, int num_queries, unsigned int seed, long duplicates, long self_loops, char *test_string, char *test_name)
+{
+    char err_msg[ERR_MSG_LEN];
+    snprintf(err_msg, ERR_MSG_LEN-1,
+             ("\n  Functions called in failed test:\n%s\n   -> graph_clean(g, &report);\n"
+              "\n  The filter to run this specific test is: --filter %s"), test_string, test_name);
+
+    int n = graph->num_nodes;
+    int *starts = (int*)malloc(sizeof(int) * (num_queries + 1));
+    int *ends = (int*)malloc(sizeof(int) * (num_queries + 1));
+    double *costs = (double*)malloc(sizeof(double) * (num_queries + 1));
+    for(int i = 0; i < num_queries; i++) {
+        do {
+            starts[i] = next_rand(&seed) % n;
+            ends[i] = next_rand(&seed) % n;
+        } while(!graph->nodes[starts[i]] || !graph->nodes[ends[i]]);
+        costs[i] = a_star(graph, starts[i], ends[i]);
+    }
+
+    graph_clean_t built_report;
+    csr_t *built = build_from_graph(graph, num_threads, true, CSR_ALLOC_DEFAULT, &built_report);
+
+    graph_clean_t report;
+    unsigned long version = graph->version;
+    graph_clean(graph, &report);
+    cr_assert_eq(report.duplicates, duplicates, " %s\n      Actual duplicates: %ld\n      Expected duplicates: %ld ", err_msg, report.duplicates, duplicates);
+    cr_assert_eq(report.self_loops, self_loops, " %s\n      Actual self-loops: %ld\n      Expected self-loops: %ld ", err_msg, report.self_loops, self_loops);
+    cr_assert(graph->version != version || duplicates + self_loops == 0, " %s\n      Expected the graph version to change ", err_msg);
+    cr_assert(built_report.duplicates == duplicates && built_report.self_loops == self_loops,
+              " %s\n   -> csr_builder_finish(b, CSR_ALLOC_DEFAULT, &report);\n      (nodes and edges of g added from %d threads)\n"
+              "      Actual: %ld duplicates, %ld self-loops\n      Expected: %ld duplicates, %ld self-loops ",
+              err_msg, num_threads, built_report.duplicates, built_report.self_loops, duplicates, self_loops);
+
+    // nothing is left to remove
+    graph_clean(graph, &report);
+    cr_assert(report.duplicates == 0 && report.self_loops == 0,
+              " %s\n   -> graph_clean(g, &report);\n      (a second time)\n      Actual: %ld duplicates, %ld self-loops\n      Expected: none ",
+              err_msg, report.duplicates, report.self_loops);
+
+    // the builder drops the edges graph_clean removes
+    csr_t *expected_csr = csr_create(graph);
+    cr_assert_eq(csr_num_edges(built), csr_num_edges(expected_csr),
+                 " %s\n   -> csr_builder_finish(b, CSR_ALLOC_DEFAULT, &report);\n      Actual edges: %ld\n      Expected edges: %ld ",
+                 err_msg, csr_num_edges(built), csr_num_edges(expected_csr));
+
+    for(int i = 0; i < num_queries; i++) {
+        double actual = a_star(graph, starts[i], ends[i]);
+        double actual_csr = a_star_csr(built, starts[i], ends[i]);
+        cr_assert_float_eq(actual, costs[i], 0.000001, " %s\n   -> a_star(g, %d, %d);\n      Actual: %f\n      Expected: %f ",
+                           err_msg, starts[i], ends[i], actual, costs[i]);
+        cr_assert_float_eq(actual_csr, costs[i], 0.000001,
+                           " %s\n   -> a_star_csr(csr, %d, %d);\n      (csr built with csr_builder, dropping the same edges)\n      Actual: %f\n      Expected: %f ",
+                           err_msg, starts[i], ends[i], actual_csr, costs[i]);
+    }
+
+    free(starts);
+    free(ends);
+    free(costs);
+    csr_free(built);
+    csr_free(expected_csr);
+}
+
+TestSuite(graph_clean, .timeout=60);
+
+Test(graph_clean, testA)
+{
+    graph_t *graph = graph_create(5);
+    node_create(graph, 0, "A", 0, 1);
+    node_create(graph, 1, "B", 0, 0);
+    node_create(graph, 2, "C", 1, 0);
+    node_create(graph, 4, "D", 1, -1);
+    add_arc(graph, 0, 1);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 0);
+    add_arc(graph, 1, 0);
+    add_arc(graph, 1, 2);
+    add_arc(graph, 2, 1);
+    add_arc(graph, 1, 2);
+    add_edge(graph, 2, 2);
+    add_arc(graph, 4, 4);
+    add_edge(graph, 2, 4);
+
+    char *test = "      graph_t *g = graph_create(5);\n"
+                 "      node_create(g, 0, 'A', 0, 1);\n"
+                 "      node_create(g, 1, 'B', 0, 0);\n"
+                 "      node_create(g, 2, 'C', 1, 0);\n"
+                 "      node_create(g, 4, 'D', 1, -1);\n"
+                 "      add_arc(g, 0, 1);\n"
+                 "      add_edge(g, 0, 1);\n"
+                 "      add_edge(g, 1, 0);\n"
+                 "      add_arc(g, 1, 0);\n"
+                 "      add_arc(g, 1, 2);\n"
+                 "      add_arc(g, 2, 1);\n"
+                 "      add_arc(g, 1, 2);\n"
+                 "      add_edge(g, 2, 2);\n"
+                 "      add_arc(g, 4, 4);\n"
+                 "      add_edge(g, 2, 4);";
+    helper_graph_clean(graph, 2, 10, 311, 4, 2, test, "graph_clean/testA");
+
+    // the first two-way edge between 0 and 1 is kept over the arcs, and
+    // the first arc from 1 to 2
+    int expected[][3] = {{0, 1, 1}, {1, 0, 1}, {1, 2, 4}, {2, 1, 5}, {2, 4, 9}, {4, 2, 9}};
+    int count = 0;
+    for(int u = 0; u < graph->num_nodes; u++) {
+        for(intlist_t *nb = graph->nodes[u] ? graph->nodes[u]->neighbors : NULL; nb; nb = nb->next) {
+            cr_assert(count < 6, "\n%s\n   -> graph_clean(g, &report);\n      More neighbor list entries left than expected ", test);
+            cr_assert(u == expected[count][0] && nb->num == expected[count][1] && nb->edge_num == expected[count][2],
+                      "\n%s\n   -> graph_clean(g, &report);\n      Actual entry: %d -> %d, edge %d\n      Expected entry: %d -> %d, edge %d ",
+                      test, u, nb->num, nb->edge_num, expected[count][0], expected[count][1], expected[count][2]);
+            count++;
+        }
+    }
+    cr_assert_eq(count, 6, "\n%s\n   -> graph_clean(g, &report);\n      Actual entries left: %d\n      Expected entries left: 6 ", test, count);
+
+    graph_free(graph);
+}
+
+Test(graph_clean, testB)
+{
+    long duplicates, self_loops;
+    graph_t *graph = grid_graph_create(30, 30, 313);
+    add_clutter(graph, 400, 317, &duplicates, &self_loops);
+    char *test = "      graph_t *g = grid_graph_create(30, 30, 313);\n"
+                 "      (400 repeated arcs and self-loops added)";
+    helper_graph_clean(graph, 3, 20, 331, duplicates, self_loops, test, "graph_clean/testB");
+    graph_free(graph);
+
+    graph = directed_graph_create(40, 40, 337);
+    add_clutter(graph, 1000, 347, &duplicates, &self_loops);
+    test = "      graph_t *g = directed_graph_create(40, 40, 337);\n"
+           "      (1000 repeated arcs and self-loops added)";
+    helper_graph_clean(graph, 4, 20, 349, duplicates, self_loops, test, "graph_clean/testB");
+    graph_free(graph);
+}
+
+Test(graph_clean, testC)
+{
+    // nothing to remove
+    graph_t *graph = directed_graph_create(25, 25, 353);
+    char *test = "      graph_t *g = directed_graph_create(25, 25, 353);";
+    helper_graph_clean(graph, 2, 20, 359, 0, 0, test, "graph_clean/testC");
+    graph_free(graph);
+
+    // every edge is a self-loop
+    graph = graph_create(3);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 2, "B", 1, 1);
+    add_edge(graph, 0, 0);
+    add_edge(graph, 0, 0);
+    add_arc(graph, 2, 2);
+    test = "      graph_t *g = graph_create(3);\n"
+           "      node_create(g, 0, 'A', 0, 0);\n"
+           "      node_create(g, 2, 'B', 1, 1);\n"
+           "      add_edge(g, 0, 0);\n"
+           "      add_edge(g, 0, 0);\n"
+           "      add_arc(g, 2, 2);";
+    helper_graph_clean(graph, 3, 4, 367, 0, 3, test, "graph_clean/testC");
+    cr_assert(graph->nodes[0]->neighbors == NULL && graph->nodes[2]->neighbors == NULL,
+              "\n%s\n   -> graph_clean(g, &report);\n      Expected no neighbor list entries left ", test);
+    graph_free(graph);
+}
+
+/* helper_sma_star: checks sma_star against a_star on random queries, and
+ *     that the paths it returns are paths of the graph with that cost
+ *
+ * graph: the graph
+ * max_nodes: search nodes sma_star may hold
+ * max_generated: successors sma_star may generate
+ * num_queries: random queries to compare
+ * seed: random seed
+ * test_string: string representation of graph call
+ * test_name: test name in error messages
+ */
+void helper_sma_star(graph_t *graph, int max_nodes, long max_generated, int num_queries, unsigned int seed, char *test_string, char *test_name)
+{
+    char err_msg[ERR_MSG_LEN];
+    snprintf(err_msg, ERR_MSG_LEN-1, "\n  Functions called in failed test:\n%s\n\n  The filter to run this specific test is: --filter %s", test_string, test_name);
+
+    int n = graph->num_nodes;
+    for(int i = 0; i < num_queries; i++) {
+        int start, end;
+        do {
+            start = next_rand(&seed) % n;
+            end = next_rand(&seed) % n;
+        } while(!graph->nodes[start] || !graph->nodes[end]);
+        double expected = a_star(graph, start, end);
+
+        int *path;
+        int len;
+        sma_star_stats_t stats;
+        double actual = sma_star(graph, start, end, max_nodes, max_generated, &path, &len, &stats);
+        cr_assert(stats.max_stored <= max_nodes, " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      Actual nodes held: %ld\n      Expected at most: %d ",
+                  err_msg, start, end, max_nodes, max_generated, stats.max_stored, max_nodes);
+        cr_assert(max_generated == 0 || stats.generated <= max_generated, " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      Actual successors generated: %ld ",
+                  err_msg, start, end, max_nodes, max_generated, stats.generated);
+
+        // the shortest cost whenever nothing was cut short, which room for
+        // every node rules out, and never below it
+        cr_assert(max_nodes < n || max_generated > 0 || (!stats.truncated && !stats.gave_up),
+                  " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      Expected room for every node to find the shortest path ",
+                  err_msg, start, end, max_nodes, max_generated);
+        if(!stats.truncated && !stats.gave_up) {
+            cr_assert_float_eq(actual, expected, 0.000001, " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      Actual: %f\n      Expected: %f ",
+                               err_msg, start, end, max_nodes, max_generated, actual, expected);
+        }
+        cr_assert(actual < 0 || actual >= expected - 0.000001, " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      Actual: %f\n      Expected at least: %f ",
+                  err_msg, start, end, max_nodes, max_generated, actual, expected);
+        if(actual < 0) {
+            cr_assert(path == NULL && len == 0, " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      Expected no path ", err_msg, start, end, max_nodes, max_generated);
+            continue;
+        }
+        cr_assert(len >= 1 && path[0] == start && path[len - 1] == end, " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      Expected a path from %d to %d ",
+                  err_msg, start, end, max_nodes, max_generated, start, end);
+        double cost = 0;
+        for(int k = 0; k + 1 < len; k++) {
+            bool edge = false;
+            for(intlist_t *nb = graph->nodes[path[k]]->neighbors; nb; nb = nb->next) {
+                edge |= nb->num == path[k + 1];
+            }
+            cr_assert(edge, " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      No edge from %d to %d on the path ",
+                      err_msg, start, end, max_nodes, max_generated, path[k], path[k + 1]);
+            cost += h_calc(graph->nodes[path[k]], graph->nodes[path[k + 1]]);
+        }
+        cr_assert_float_eq(cost, actual, 0.000001, " %s\n   -> sma_star(g, %d, %d, %d, %ld, &path, &len, &stats);\n      Actual path cost: %f\n      Expected: %f ",
+                           err_msg, start, end, max_nodes, max_generated, cost, actual);
+        free(path);
+    }
+}
+
+TestSuite(sma_star, .timeout=60);
+
+Test(sma_star, testA)
+{
+    graph_t *graph = graph_create(6);
+    node_create(graph, 0, "A", 0, 0);
+    node_create(graph, 1, "B", 0, 1);
+    node_create(graph, 2, "C", 0, 2);
+    node_create(graph, 3, "D", 1, 0);
+    node_create(graph, 4, "E", 1, 1);
+    node_create(graph, 5, "F", 1, 2);
+    add_edge(graph, 0, 1);
+    add_edge(graph, 1, 2);
+    add_edge(graph, 0, 3);
+    add_edge(graph, 3, 4);
+    add_edge(graph, 4, 5);
+    add_edge(graph, 2, 5);
+    add_arc(graph, 5, 5);
+    char *test = "      graph_t *g = graph_create(6);\n"
+                 "      (a 2 x 3 ring, 0 - 1 - 2 - 5 - 4 - 3 - 0, and an arc from 5 to 5)";
+
+    // a path of 4 nodes fits in 4 search nodes, not in 3
+    int *path;
+    int len;
+    sma_star_stats_t stats;
+    double actual = sma_star(graph, 0, 5, 4, 0, &path, &len, &stats);
+    cr_assert_float_eq(actual, 3, 0.000001, "\n%s\n   -> sma_star(g, 0, 5, 4, 0, &path, &len, &stats);\n      Actual: %f\n      Expected: 3 ", test, actual);
+    cr_assert(len == 4 && path[0] == 0 && path[3] == 5, "\n%s\n   -> sma_star(g, 0, 5, 4, 0, &path, &len, &stats);\n      Actual path length: %d\n      Expected: 4 ", test, len);
+    cr_assert(stats.max_stored <= 4 && !stats.truncated && !stats.gave_up, "\n%s\n   -> sma_star(g, 0, 5, 4, 0, &path, &len, &stats);\n      Actual nodes held: %ld ", test, stats.max_stored);
+    free(path);
+
+    actual = sma_star(graph, 0, 5, 3, 0, &path, &len, &stats);
+    cr_assert(actual == -1 && path == NULL && len == 0 && stats.truncated,
+              "\n%s\n   -> sma_star(g, 0, 5, 3, 0, &path, &len, &stats);\n      Actual: %f\n      Expected: -1, no path fits ", test, actual);
+
+    // one node is enough when the start is the end
+    actual = sma_star(graph, 4, 4, 1, 0, &path, &len, NULL);
+    cr_assert(actual == 0 && len == 1 && path[0] == 4, "\n%s\n   -> sma_star(g, 4, 4, 1, 0, &path, &len, NULL);\n      Actual: %f\n      Expected: 0 ", test, actual);
+    free(path);
+
+    // the search stops after max_generated successors
+    actual = sma_star(graph, 0, 5, 6, 2, NULL, NULL, &stats);
+    cr_assert(actual == -1 && stats.gave_up && stats.generated == 2,
+              "\n%s\n   -> sma_star(g, 0, 5, 6, 2, NULL, NULL, &stats);\n      Actual: %f, %ld successors generated\n      Expected: -1, after 2 ", test, actual, stats.generated);
+
+    helper_sma_star(graph, 6, 0, 10, 373, test, "sma_star/testA");
+    helper_sma_star(graph, 4, 0, 10, 379, test, "sma_star/testA");
+
+    graph_free(graph);
+}
+
+Test(sma_star, testB)
+{
+    // room for every node, and then for a few times the longest path
+    graph_t *graph = grid_graph_create(20, 20, 383);
+    char *test = "      graph_t *g = grid_graph_create(20, 20, 383);";
+    helper_sma_star(graph, 400, 0, 30, 389, test, "sma_star/testB");
+    helper_sma_star(graph, 150, 1000000, 30, 397, test, "sma_star/testB");
+    graph_free(graph);
+
+    graph = directed_graph_create(20, 20, 401);
+    test = "      graph_t *g = directed_graph_create(20, 20, 401);";
+    helper_sma_star(graph, 400, 0, 30, 409, test, "sma_star/testB");
+    helper_sma_star(graph, 150, 1000000, 30, 419, test, "sma_star/testB");
+    graph_free(graph);
+}
+
+Test(sma_star, testC)
+{
+    // a node that can only be left, which sma_star cannot rule out as an
+    // end without room for every node it reaches
+    graph_t *graph = graph_create(145);
+    for(int u = 0; u < 144; u++) {
+        node_create(graph, u, "grid", u / 12, u % 12);
+    }
+    node_create(graph, 144, "out", -1, -1);
+    for(int u = 0; u < 144; u++) {
+        if(u % 12 < 11) {
+            add_edge(graph, u, u + 1);
+        }
+        if(u < 132) {
+            add_edge(graph, u, u + 12);
+        }
+    }
+    add_arc(graph, 144, 0);
+    char *test = "      graph_t *g = graph_create(145);\n"
+                 "      (a 12 x 12 grid of nodes 0 to 143, and an arc from node 144 to 0)";
+
+    sma_star_stats_t stats;
+    double actual = sma_star(graph, 5, 144, 145, 0, NULL, NULL, &stats);
+    cr_assert(actual == -1 && !stats.gave_up, "\n%s\n   -> sma_star(g, 5, 144, 145, 0, NULL, NULL, &stats);\n      Actual: %f\n      Expected: -1 ", test, actual);
+    actual = sma_star(graph, 5, 144, 20, 100000, NULL, NULL, &stats);
+    cr_assert(actual == -1 && stats.gave_up && stats.generated == 100000,
+              "\n%s\n   -> sma_star(g, 5, 144, 20, 100000, NULL, NULL, &stats);\n      Actual: %f, %ld successors generated\n      Expected: -1, after 100000 ", test, actual, stats.generated);
+
+    actual = sma_star(graph, 144, 143, 40, 0, NULL, NULL, &stats);
+    cr_assert_float_eq(actual, 22 + sqrt(2), 0.000001, "\n%s\n   -> sma_star(g, 144, 143, 40, 0, NULL, NULL, &stats);\n      Actual: %f\n      Expected: %f ", test, actual, 22 + sqrt(2));
+    helper_sma_star(graph, 40, 200000, 20, 431, test, "sma_star/testC");
+    graph_free(graph);
+}